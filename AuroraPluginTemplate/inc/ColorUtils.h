@@ -51,6 +51,37 @@ void HSVtoRGB(HSV_t hsv, RGB_t* rgb);
  */
 void RGBtoHSV(RGB_t rgb, HSV_t* hsv);
 
+/**
+ * @description: HSVtoRGB in integer arithmetic, with the hue weights looked up in a table built at compile time.
+ * Falls back to HSVtoRGB when S or V is outside 0..100. Exact halves are always rounded up, where the floating
+ * point HSVtoRGB can go either way, so the two can differ by 1 on those colours
+ */
+void HSVtoRGBFast(HSV_t hsv, RGB_t* rgb);
+
+/**
+ * @description: RGBtoHSV in integer arithmetic. Falls back to RGBtoHSV when a channel is outside 0..255.
+ * Like HSVtoRGBFast it rounds exact halves consistently, so it can differ from RGBtoHSV by 1, 1 degree for the hue
+ */
+void RGBtoHSVFast(RGB_t rgb, HSV_t* hsv);
+
+/**
+ * @description: convert n colours from HSV to RGB with HSVtoRGBFast
+ */
+void HSVtoRGB(const HSV_t* hsv, RGB_t* rgb, int n);
+
+/**
+ * @description: convert n colours from RGB to HSV with RGBtoHSVFast
+ */
+void RGBtoHSV(const RGB_t* rgb, HSV_t* hsv, int n);
+
+/**
+ * @description: colour at a position along a palette, blending linearly between neighbouring colours.
+ * Positions below 0 give the first colour, positions past the last colour give the last colour.
+ * An empty palette gives half white
+ * @params position: 0 is the first colour of the palette, 1 the second and so on
+ */
+RGB_t getPaletteColour(const RGB_t* palette, int nColours, float position);
+
 /**
  * helper function
  */
@@ -0,0 +1,61 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PackedFrame.h
+ *
+ *  Compact form of Frame_t for sending frames on. Frame_t spends five ints, 20 bytes, on a panel
+ *  while the values fit in a 16 bit panelId, three 8 bit channels and a 16 bit transTime, so a
+ *  PackedFrame_t takes 8 bytes: a frame for 255 panels fits in 2kB, and a buffer of them can be
+ *  handed to a socket or shared memory as it is.
+ *
+ *  A plugin can fill packed frames itself by exporting, next to getPluginFrame,
+ *      void getPluginFramePacked(PackedFrame_t* frames, int* nFrames, int* sleepTime);
+ *  which the PluginHost calls instead of getPluginFrame when packed frames are requested.
+ */
+
+#ifndef INC_PACKEDFRAME_H_
+#define INC_PACKEDFRAME_H_
+
+#include "AuroraPlugin.h"
+#include <stdint.h>
+
+#define PACKED_FRAME_MAX_PANEL_ID 0xFFFF
+#define PACKED_FRAME_MAX_TRANS_TIME 0xFFFF
+
+struct PackedFrame_t {
+	uint16_t panelId;
+	uint8_t r, g, b;
+	uint8_t flags;			/*reserved, 0*/
+	uint16_t transTime;		/*in multiples of 100ms*/
+};
+
+static_assert(sizeof(PackedFrame_t) == 8, "PackedFrame_t must stay 8 bytes");
+
+/**
+ * @description: pack frames, clamping every channel to 0..255 and transTime to 0..PACKED_FRAME_MAX_TRANS_TIME.
+ * Entries whose panelId does not fit in 16 bits are left out
+ * @params packed: room for nFrames entries
+ * @return: the number of entries written to packed
+ */
+int packFrames(const Frame_t* frames, int nFrames, PackedFrame_t* packed);
+
+/**
+ * @description: unpack nPacked entries into frames
+ */
+void unpackFrames(const PackedFrame_t* packed, int nPacked, Frame_t* frames);
+
+#endif /* INC_PACKEDFRAME_H_ */
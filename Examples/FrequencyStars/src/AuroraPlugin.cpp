@@ -21,8 +21,8 @@
     Description:
     Layout processing based on ShootingStars by Tom Rodinger.
     Each source colour is taken from the user's palette and tracks an associated FFT bin.
-    Trigger points for adding new sources are taken when a beat is detected in each individual bin.
-    The intensity of the source is based on a log scale comparing with the highest beat detected in that bin over all time.
+    Trigger points for adding new sources are taken when the library detects an onset in each individual bin.
+    The intensity of the source is based on how far the rise of that bin exceeds its recent rises.
  */
 
 
@@ -30,6 +30,7 @@
 #include "LayoutProcessingUtils.h"
 #include "ColorUtils.h"
 #include "DataManager.h"
+#include "ParticleEngine.h"
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
@@ -55,58 +56,33 @@ extern "C" {
 #define BASE_COLOUR_R 0 // these three settings defined the background colour; set to black
 #define BASE_COLOUR_G 0
 #define BASE_COLOUR_B 0
-#define ADJACENT_PANEL_DISTANCE 86.599995   // hard coded distance between adjacent panels; this ideally should be autodetected
 #define TRANSITION_TIME 1  // the transition time to send to panels; set to 100ms currently
 #define MINIMUM_INTENSITY 0.2  // the minimum intensity of a source
-#define TRIGGER_THRESHOLD 0.7 // used to calculate whether to add a source
+#define MAX_TRAJECTORY_PANELS 64   // up to this many panels, a trajectory is precomputed for every ordered pair of panels
+#define N_CACHED_TRAJECTORIES 4096   // with more panels, a trajectory is computed when its pair is first picked and this many are kept
 
 
-// Here we store the information accociated with each light source like current
-// position, velocity and colour. The information is stored in a list called sources.
-typedef struct {
-    float x;
-    float y;
-    float vx;
-    float vy;
-    int R;
-    int G;
-    int B;
-} source_t;
-
-/** Here we store the information accociated with each frequency bin. This 
- allows for tracking a degree of historical information.
- */
-typedef struct {
-    uint32_t latest_minimum;
-    uint32_t soundPower;
-    int16_t colour;
-    uint32_t runningMax;
-    uint32_t runningMin;
-    uint32_t maximumTrigger;
-    uint32_t previousPower;
-    uint32_t secondPreviousPower;
-} freq_bin;
-
 static RGB_t* paletteColours = NULL; // this is our saved pointer to the colour palette
 static int nColours = 0;             // the number of colours in the palette
 static LayoutData *layoutData; // this is our saved pointer to the panel layout information
-static source_t sources[MAX_PALETTE_COLOURS]; // this is our array for sources
-static int nSources = 0;
-static freq_bin freq_bins[MAX_PALETTE_COLOURS]; // this is our array for frequency bin historical information.
+static double adjacentPanelDistance;  // distance between the centroids of panels that share an edge, from the layout
+static ParticleSystem_t sources; // the light sources with their position, velocity and colour, oldest first
+static const RGB_t baseColour = {BASE_COLOUR_R, BASE_COLOUR_G, BASE_COLOUR_B};
 
-/** 
-  * @description: add a value to a running max.
-  * @param: runningMax is current runningMax, valueToAdd is added to runningMax, effectiveTrail  
-  *         defines how many values are effectively tracked. Note this is an approximation. 
-  * @return: int returned as new runningMax.
-  */
-int addToRunningMax(int runningMax, int valueToAdd, int effectiveTrail) {
-    int trail = effectiveTrail;
-    if (valueToAdd > runningMax && effectiveTrail > 1) {
-        trail = trail / 2;
-    }
-    return runningMax - ((float)runningMax / effectiveTrail) + ((float)valueToAdd / trail);
-}
+// the path of a "shooting star" through two panels: its direction and the panel it enters the layout at
+typedef struct {
+    float dx;               // vector from the first panel to the second, not normalized
+    float dy;
+    float normalization;    // 1 / length of (dx, dy)
+    int entryPanel;         // panel near the line that is closest to the edge of the layout
+} trajectory_t;
+
+static trajectory_t *trajectories = NULL; // indexed by n1 * nPanels + n2 if allPairs, else by (n1 * nPanels + n2) % N_CACHED_TRAJECTORIES
+static int *trajectoryPairs = NULL;       // if not allPairs, the n1 * nPanels + n2 of the trajectory cached in each entry, -1 if none
+static int nTrajectories = 0;
+static bool allPairs = false;
+
+void computeTrajectories();
 
 /**
  * @description: Initialize the plugin. Called once, when the plugin is loaded.
@@ -131,6 +107,7 @@ void initPlugin() {
     }
     
     layoutData = getLayoutData(); // grab the layout data and store a pointer to it for later use
+    adjacentPanelDistance = layoutData->adjacency.adjacentDistance;
   
     
     PRINTLOG("The layout has %d panels:\n", layoutData->nPanels);
@@ -139,28 +116,22 @@ void initPlugin() {
                layoutData->panels[i].shape->getCentroid().x, layoutData->panels[i].shape->getCentroid().y);
     }
     
-    // here we initialize our freqency bin values so that the plugin starts working reasonably well right away
-    for (int i = 0; i < MAX_PALETTE_COLOURS; i++) {
-        freq_bins[i].latest_minimum = 0;
-        freq_bins[i].runningMax = 3;
-        freq_bins[i].maximumTrigger = 1;
-    }
+    // one fft bin per colour, the library detects the onsets in every bin for us
     enableFft(nColours);
-}
-
-/** Removes a light source from the list of light sources */
-void removeSource(int idx)
-{
-    memmove(sources + idx, sources + idx + 1, sizeof(source_t) * (nSources - idx - 1));
-    nSources--;
-}
-
-/** Compute cartesian distance between two points */
-float distance(float x1, float y1, float x2, float y2)
-{
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    return sqrt(dx * dx + dy * dy);
+    enableBandOnsets();
+
+    // the fraction of a source's colour mixed into a panel is 1 / (1.5 * d * d + 1), d in units of the distance between
+    // adjacent panels. The formula is not based on physics, it is fudged to get a good effect. Sources fly in a straight
+    // line until they are far away from the origin
+    initParticleSystem(&sources, MAX_SOURCES);
+    sources.config.kernel = PARTICLE_KERNEL_INVERSE_SQUARE;
+    sources.config.distanceScale = 1.0 / adjacentPanelDistance;
+    sources.config.k = 1.5;
+    sources.config.motion = PARTICLE_MOTION_LINEAR;
+    sources.config.expiry = PARTICLE_EXPIRE_DISTANCE;
+    sources.config.maxDistance = 20.0 * adjacentPanelDistance;
+
+    computeTrajectories();
 }
 
 
@@ -185,59 +156,36 @@ void point2line(float x3, float y3, float x1, float y1, float x2, float y2, floa
     *dist = sqrt(dx * dx + dy * dy);
 }
 
-/** 
-  * @description: Adds a light source to the list of light sources. The light source will have a particular colour
-  * and intensity and will move at a particular speed.
-*/
-void addSource(int paletteIndex, float intensity, float speed)
+/**
+  * @description: compute the trajectory of a light source that flies from panel n1 towards panel n2
+  * @param: n1, n2 are two different panel indices
+  *         trajectory is filled in
+  */
+void computeTrajectory(int n1, int n2, trajectory_t *trajectory)
 {
-    float x;
-    float y;
-    float vx = 0;
-    float vy = 0;
-    int i;
-
-    // we need at least two panels to do anything meaningful in here
-    if(layoutData->nPanels < 2) {
-        return;
-    }
-
-    // first, pick two panels at random and make sure they are not the same panel
-    int n1;
-    int n2;
-    while(1) {
-        n1 = drand48() * layoutData->nPanels;
-        n2 = drand48() * layoutData->nPanels;
-        if(n1 != n2) {
-            break;
-        }
-    }
-    
     // find a vector pointing from one of the panels to the other
-    float x1 = layoutData->panels[n1].shape->getCentroid().x;
-    float y1 = layoutData->panels[n1].shape->getCentroid().y;
-    float x2 = layoutData->panels[n2].shape->getCentroid().x;
-    float y2 = layoutData->panels[n2].shape->getCentroid().y;
-    vx = x2 - x1;
-    vy = y2 - y1;
-    // normalize the vector to be length 1.0
-    float normalization = 1.0 / sqrt(vx * vx + vy * vy);
-    // compute a velocity vector based on the desired speed and normalize to the panel size
-    vx *= normalization * speed * ADJACENT_PANEL_DISTANCE;
-    vy *= normalization * speed * ADJACENT_PANEL_DISTANCE;
-    
+    PanelCentroids_t *centroids = &layoutData->centroids;
+    float x1 = centroids->x[n1];
+    float y1 = centroids->y[n1];
+    float x2 = centroids->x[n2];
+    float y2 = centroids->y[n2];
+    float vx = x2 - x1;
+    float vy = y2 - y1;
+    trajectory->dx = vx;
+    trajectory->dy = vy;
+    // the factor that normalizes the vector to be length 1.0
+    trajectory->normalization = 1.0 / sqrt(vx * vx + vy * vy);
+
     // iterate through all panels and find the one that is closest to the edge of the
     // Aurora setup and near the line where the "shooting star" will traverse; this
     // will be the starting point of the light source
     float min_t = 1.0e20;
     int min_t_idx = -1;
-    for(i = 0; i < layoutData->nPanels; i++) {
-        x = layoutData->panels[i].shape->getCentroid().x;
-        y = layoutData->panels[i].shape->getCentroid().y;
+    for(int i = 0; i < layoutData->nPanels; i++) {
         float dist;
         float t;
-        point2line(x, y, x1, y1, x2, y2, &dist, &t);
-        dist *= ADJACENT_PANEL_DISTANCE;
+        point2line(centroids->x[i], centroids->y[i], x1, y1, x2, y2, &dist, &t);
+        dist *= adjacentPanelDistance;
         if(dist < 1.0) {
             if(t < min_t) {
                 min_t = t;
@@ -245,115 +193,106 @@ void addSource(int paletteIndex, float intensity, float speed)
             }
         }
     }
-    x = layoutData->panels[min_t_idx].shape->getCentroid().x;
-    y = layoutData->panels[min_t_idx].shape->getCentroid().y;
-
-    // decide in the colour of this light source and factor in the intensity to arrive at an RGB value
-    int R = paletteColours[paletteIndex].R;
-    int G = paletteColours[paletteIndex].G;
-    int B = paletteColours[paletteIndex].B;
-    R *= intensity;
-    G *= intensity;
-    B *= intensity;
-
-    // if we have a lot of light sources already, let's bump off the oldest one
-    if(nSources >= MAX_SOURCES) {
-        removeSource(0);
-    }
-    
-    // add all the information to the list of light sources
-    sources[nSources].x = x;
-    sources[nSources].y = y;
-    sources[nSources].vx = vx;
-    sources[nSources].vy = vy;
-    sources[nSources].R = (int)R;
-    sources[nSources].G = (int)G;
-    sources[nSources].B = (int)B;
-    nSources++;
+    trajectory->entryPanel = min_t_idx;
 }
 
 /**
-  * @description: This function will render the colour of the given single panel given
-  * the positions of all the lights in the light source list.
+  * @description: set up the trajectories for the layout, so that adding a light source does not
+  * have to search all the panels. Small layouts get every ordered pair of panels precomputed, which
+  * costs nPanels^2 entries; large ones get an empty cache of N_CACHED_TRAJECTORIES entries that
+  * addSource fills as pairs are picked, which bounds both the memory and the time spent here.
   */
-void renderPanel(Panel *panel, int *returnR, int *returnG, int *returnB)
+void computeTrajectories()
 {
-    float R = BASE_COLOUR_R;
-    float G = BASE_COLOUR_G;
-    float B = BASE_COLOUR_B;
-    int i;
-
-    // Iterate through all the sources
-    // Depending how close the source is to the panel, we take some fraction of its colour and mix it into an
-    // accumulator. Newest sources have the most weight. Old sources die away until they are gone.
-    for(i = 0; i < nSources; i++) {
-        float d = distance(panel->shape->getCentroid().x, panel->shape->getCentroid().y, sources[i].x, sources[i].y);
-        d = d / ADJACENT_PANEL_DISTANCE;
-        float d2 = d * d;
-        float factor = 1.0 / (d2 * 1.5 + 1.0); // determines how much of the source's colour we mix in (depends on distance)
-                                               // the formula is not based on physics, it is fudged to get a good effect
-                                               // the formula yields a number between 0 and 1
-        R = R * (1.0 - factor) + sources[i].R * factor;
-        G = G * (1.0 - factor) + sources[i].G * factor;
-        B = B * (1.0 - factor) + sources[i].B * factor;
+    int nPanels = layoutData->nPanels;
+    free(trajectories);
+    free(trajectoryPairs);
+    trajectories = NULL;
+    trajectoryPairs = NULL;
+    nTrajectories = 0;
+    if(nPanels < 2) {
+        return;
     }
-    *returnR = (int)R;
-    *returnG = (int)G;
-    *returnB = (int)B;
-}
 
-/**
-  * Move the positions of all the light sources based on their velocities. If any particular
-  * light source has moved far from the origin then it will be removed from the light source list.
-  */
-void propogateSources(void)
-{
-    int i;
-
-    for(i = 0; i < nSources; i++) {
-        sources[i].x += sources[i].vx;
-        sources[i].y += sources[i].vy;
-        float d = distance(0.0, 0.0, sources[i].x, sources[i].y);
-        if(d > 20.0 * ADJACENT_PANEL_DISTANCE) {
-            removeSource(i);
-            i--;
+    allPairs = nPanels <= MAX_TRAJECTORY_PANELS;
+    nTrajectories = allPairs ? nPanels * nPanels : N_CACHED_TRAJECTORIES;
+    trajectories = (trajectory_t *)malloc(nTrajectories * sizeof(trajectory_t));
+    if(allPairs) {
+        for(int n1 = 0; n1 < nPanels; n1++) {
+            for(int n2 = 0; n2 < nPanels; n2++) {
+                if(n1 != n2) {
+                    computeTrajectory(n1, n2, &trajectories[n1 * nPanels + n2]);
+                }
+            }
         }
     }
+    else {
+        trajectoryPairs = (int *)malloc(nTrajectories * sizeof(int));
+        for(int i = 0; i < nTrajectories; i++) {
+            trajectoryPairs[i] = -1;
+        }
+    }
+    PRINTLOG("%d %s trajectories for %d panels, %d bytes\n", nTrajectories, allPairs ? "precomputed" : "cached",
+             nPanels, (int)(nTrajectories * (sizeof(trajectory_t) + (allPairs ? 0 : sizeof(int)))));
 }
 
-/**
-  * A simple algorithm to detect beats. It finds a strong signal after a period of quietness.
-  * Actually, it doesn't detect just beats. For example, classical music often doesn't have
-  * strong beats but it has strong instrumental sections. Those would also get detected. 
-  */
-int16_t beat_detector(int i)
+/** 
+  * @description: Adds a light source to the list of light sources. The light source will have a particular colour
+  * and intensity and will move at a particular speed.
+*/
+void addSource(int paletteIndex, float intensity, float speed)
 {
-    int16_t beat_detected = 0;
-    
-    //Check for local maximum and if observed, add to running average
-    if((freq_bins[i].soundPower + (freq_bins[i].runningMax / 4) < freq_bins[i].previousPower) && (freq_bins[i].previousPower > freq_bins[i].secondPreviousPower)){
-        freq_bins[i].runningMax = addToRunningMax(freq_bins[i].runningMax, freq_bins[i].previousPower, 4);
+    // we need at least two panels to do anything meaningful in here
+    if(nTrajectories == 0) {
+        return;
     }
-    
-    // update latest minimum.
-    if(freq_bins[i].soundPower < freq_bins[i].latest_minimum) {
-        freq_bins[i].latest_minimum = freq_bins[i].soundPower;
+
+    // first, pick two panels at random and make sure they are not the same panel
+    int n1;
+    int n2;
+    while(1) {
+        n1 = drand48() * layoutData->nPanels;
+        n2 = drand48() * layoutData->nPanels;
+        if(n1 != n2) {
+            break;
+        }
     }
-    else if(freq_bins[i].latest_minimum > 0) {
-        freq_bins[i].latest_minimum--;
+
+    // then look up the trajectory through them, computing it the first time the pair is picked
+    int pair = n1 * layoutData->nPanels + n2;
+    trajectory_t *trajectory;
+    if(allPairs) {
+        trajectory = &trajectories[pair];
     }
-    
-    // criteria for a "beat"; value must exceed minimum plus a threshold of the runningMax.
-    if(freq_bins[i].soundPower > freq_bins[i].latest_minimum + (freq_bins[i].runningMax * TRIGGER_THRESHOLD)) {
-        freq_bins[i].latest_minimum = freq_bins[i].soundPower;
-        beat_detected = 1;
+    else {
+        int entry = pair % N_CACHED_TRAJECTORIES;
+        trajectory = &trajectories[entry];
+        if(trajectoryPairs[entry] != pair) {
+            computeTrajectory(n1, n2, trajectory);
+            trajectoryPairs[entry] = pair;
+        }
     }
-    
-    // update historical information
-    freq_bins[i].secondPreviousPower = freq_bins[i].previousPower;
-    freq_bins[i].previousPower = freq_bins[i].soundPower;
-    
-    return beat_detected;
+
+    // compute a velocity vector based on the desired speed and normalize to the panel size
+    float vx = trajectory->dx;
+    float vy = trajectory->dy;
+    vx *= trajectory->normalization * speed * adjacentPanelDistance;
+    vy *= trajectory->normalization * speed * adjacentPanelDistance;
+    float x = layoutData->centroids.x[trajectory->entryPanel];
+    float y = layoutData->centroids.y[trajectory->entryPanel];
+
+    // decide in the colour of this light source and factor in the intensity to arrive at an RGB value
+    int R = paletteColours[paletteIndex].R;
+    int G = paletteColours[paletteIndex].G;
+    int B = paletteColours[paletteIndex].B;
+    R *= intensity;
+    G *= intensity;
+    B *= intensity;
+
+    // add all the information to the list of light sources, bumping off the oldest one if there are a lot already
+    int idx = spawnParticle(&sources, x, y, R, G, B);
+    sources.vx[idx] = vx;
+    sources.vy[idx] = vy;
 }
 
 /**
@@ -371,53 +310,28 @@ int16_t beat_detector(int i)
  * @param sleepTime: specify interval after which this function is called again, NULL if sound visualization plugin
  */
 void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime) {
-    int R;
-    int G;
-    int B;
-    int i;
-    uint8_t * fftBins = getFftBins();
-
-
-    // Compute the sound power (or volume) in each bin
-    for(i = 0; i < nColours; i++) {
-        freq_bins[i].soundPower = fftBins[i];
-        uint8_t beat_detected = beat_detector(i);
-        
-        if(beat_detected) {
-            if (freq_bins[i].soundPower > freq_bins[i].maximumTrigger) {
-                freq_bins[i].maximumTrigger = freq_bins[i].soundPower;
-            }
-            
+    const uint8_t * onsets = getBandOnsets();
+    const float * strengths = getBandOnsetStrengths();
+
+    // add a new light source for each bin with an onset
+    for(int i = 0; onsets != NULL && i < nColours; i++) {
+        if(onsets[i]) {
             float speed = 0.5;
-            float intensity = 1.0;
-            
-            //calculate an intensity ranging from minimum to 1, using log scale
-            if (freq_bins[i].soundPower > 1 && freq_bins[i].runningMax > 1){
-                intensity = ((log((float)freq_bins[i].soundPower) / log((float)freq_bins[i].runningMax)) * (1.0 - MINIMUM_INTENSITY)) + MINIMUM_INTENSITY;
-            }
-            
-            if (intensity > 1.0) {
-                intensity = 1.0;
-            }
-            
-            // add a new light source for each beat detected
+
+            // the strength is above 1 on an onset, map it to an intensity ranging from minimum to 1
+            float intensity = MINIMUM_INTENSITY + (1.0 - MINIMUM_INTENSITY) * (1.0 - 1.0 / strengths[i]);
+
             addSource(i, intensity, speed);
         }
     }
 
 
-    // iterate through all the panels and render each one
-    for(i = 0; i < layoutData->nPanels; i++) {
-        renderPanel(&layoutData->panels[i], &R, &G, &B);
-        frames[i].panelId = layoutData->panels[i].panelId;
-        frames[i].r = R;
-        frames[i].g = G;
-        frames[i].b = B;
-        frames[i].transTime = TRANSITION_TIME;
-    }
+    // render all the panels at once. Depending how close a source is to a panel, we take some fraction of its colour and mix it into
+    // the panel. Newest sources have the most weight. Old sources die away until they are gone.
+    renderParticles(&sources, &layoutData->centroids, baseColour, TRANSITION_TIME, frames);
 
-    // move all the light sources so they are ready for the next frame
-    propogateSources();
+    // move all the light sources so they are ready for the next frame, dropping the ones that are far away
+    updateParticles(&sources);
 
     // this algorithm renders every panel at every frame
     *nFrames = layoutData->nPanels;
@@ -428,5 +342,9 @@ void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime) {
  * Do all deallocation for memory allocated in initplugin here
  */
 void pluginCleanup() {
-    // do deallocation here, but there is nothing to deallocate
+    free(trajectories);
+    free(trajectoryPairs);
+    trajectories = NULL;
+    trajectoryPairs = NULL;
+    nTrajectories = 0;
 }
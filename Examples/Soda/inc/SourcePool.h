@@ -0,0 +1,318 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+/*
+ * SourcePool.h
+ *
+ *  Fixed capacity storage for the light sources of a plugin, e.g.
+ *
+ *      static SourcePool<source_t, MAX_SOURCES> sources;
+ *
+ *      for (int i = sources.first(); i != SOURCE_POOL_NONE; ) {
+ *          if (expired(sources[i])) {
+ *              i = sources.erase(i);
+ *          }
+ *          else {
+ *              i = sources.next(i);
+ *          }
+ *      }
+ *
+ *  The sources are kept packed at the front of an array. Removing one moves the last source into
+ *  its place instead of shifting the tail, so adding and removing are O(1) and nothing is ever
+ *  allocated. Indices are therefore only valid until the next removal; a SourceHandle_t stays valid
+ *  for the life of its source and is detected as stale once the source is gone.
+ *
+ *  With Ordered set the pool also keeps a linked order over the sources, which first()/next()
+ *  walk and insertBefore() inserts into, e.g. oldest first or sorted by intensity. Without it
+ *  first()/next() walk the array, in no particular order.
+ */
+
+#ifndef INC_SOURCEPOOL_H_
+#define INC_SOURCEPOOL_H_
+
+#include <stdint.h>
+
+#define SOURCE_POOL_NONE -1
+
+/**
+ * Refers to one source of a pool for as long as it lives
+ */
+struct SourceHandle_t {
+	int slot;
+	uint32_t generation;
+};
+
+template <typename T, int N, bool Ordered = false>
+class SourcePool {
+	T items[N];					/*items[0..count) are the live sources*/
+	int count;
+	int denseToSlot[N];
+	int slotToDense[N];
+	uint32_t generations[N];	/*bumped whenever the source of a slot is removed*/
+	int freeSlots[N];
+	int nFree;
+	int prevIndex[N];			/*order links between indices into items, when Ordered*/
+	int nextIndex[N];
+	int head;
+	int tail;
+
+	void link(int index, int before) {
+		int after = before == SOURCE_POOL_NONE ? tail : prevIndex[before];
+		prevIndex[index] = after;
+		nextIndex[index] = before;
+		if (after == SOURCE_POOL_NONE) {
+			head = index;
+		}
+		else {
+			nextIndex[after] = index;
+		}
+		if (before == SOURCE_POOL_NONE) {
+			tail = index;
+		}
+		else {
+			prevIndex[before] = index;
+		}
+	}
+
+	void unlink(int index) {
+		if (prevIndex[index] == SOURCE_POOL_NONE) {
+			head = nextIndex[index];
+		}
+		else {
+			nextIndex[prevIndex[index]] = nextIndex[index];
+		}
+		if (nextIndex[index] == SOURCE_POOL_NONE) {
+			tail = prevIndex[index];
+		}
+		else {
+			prevIndex[nextIndex[index]] = prevIndex[index];
+		}
+	}
+
+	/**
+	 * @description: the source at from moved to to, point its neighbours at its new index
+	 */
+	void relink(int from, int to) {
+		prevIndex[to] = prevIndex[from];
+		nextIndex[to] = nextIndex[from];
+		if (prevIndex[to] == SOURCE_POOL_NONE) {
+			head = to;
+		}
+		else {
+			nextIndex[prevIndex[to]] = to;
+		}
+		if (nextIndex[to] == SOURCE_POOL_NONE) {
+			tail = to;
+		}
+		else {
+			prevIndex[nextIndex[to]] = to;
+		}
+	}
+
+public:
+	SourcePool() {
+		count = 0;
+		for (int i = 0; i < N; i++) {
+			generations[i] = 0;
+			denseToSlot[i] = SOURCE_POOL_NONE;
+			slotToDense[i] = 0;
+		}
+		clear();
+	}
+
+	/**
+	 * @description: remove all sources, their handles become stale
+	 */
+	void clear() {
+		for (int i = 0; i < count; i++) {
+			generations[denseToSlot[i]]++;
+		}
+		count = 0;
+		nFree = N;
+		for (int i = 0; i < N; i++) {
+			freeSlots[i] = N - 1 - i;
+		}
+		head = SOURCE_POOL_NONE;
+		tail = SOURCE_POOL_NONE;
+	}
+
+	int size() const {
+		return count;
+	}
+
+	int capacity() const {
+		return N;
+	}
+
+	bool isEmpty() const {
+		return count == 0;
+	}
+
+	bool isFull() const {
+		return count == N;
+	}
+
+	T& operator[](int index) {
+		return items[index];
+	}
+
+	const T& operator[](int index) const {
+		return items[index];
+	}
+
+	/**
+	 * @description: the first source in order, SOURCE_POOL_NONE if the pool is empty
+	 */
+	int first() const {
+		if (Ordered) {
+			return head;
+		}
+		return count > 0 ? 0 : SOURCE_POOL_NONE;
+	}
+
+	/**
+	 * @description: the last source in order, SOURCE_POOL_NONE if the pool is empty
+	 */
+	int last() const {
+		if (Ordered) {
+			return tail;
+		}
+		return count - 1;
+	}
+
+	/**
+	 * @description: the source after index in order, SOURCE_POOL_NONE after the last one
+	 */
+	int next(int index) const {
+		if (Ordered) {
+			return nextIndex[index];
+		}
+		return index + 1 < count ? index + 1 : SOURCE_POOL_NONE;
+	}
+
+	/**
+	 * @description: the source before index in order, SOURCE_POOL_NONE before the first one
+	 */
+	int prev(int index) const {
+		if (Ordered) {
+			return prevIndex[index];
+		}
+		return index - 1;
+	}
+
+	/**
+	 * @description: add a source in front of another one in order, or at the end of the order
+	 * @params before: index of the source to insert in front of, SOURCE_POOL_NONE for the end.
+	 * Ignored by unordered pools
+	 * @return: index of the new source, SOURCE_POOL_NONE if the pool is full
+	 */
+	int insertBefore(int before, const T& item) {
+		if (count == N) {
+			return SOURCE_POOL_NONE;
+		}
+		int index = count++;
+		int slot = freeSlots[--nFree];
+		denseToSlot[index] = slot;
+		slotToDense[slot] = index;
+		items[index] = item;
+		if (Ordered) {
+			link(index, before);
+		}
+		return index;
+	}
+
+	/**
+	 * @description: add a source at the end of the order
+	 * @return: index of the new source, SOURCE_POOL_NONE if the pool is full
+	 */
+	int add(const T& item) {
+		return insertBefore(SOURCE_POOL_NONE, item);
+	}
+
+	/**
+	 * @description: remove a source by moving the last one of the array into its place
+	 */
+	void remove(int index) {
+		int slot = denseToSlot[index];
+		generations[slot]++;
+		freeSlots[nFree++] = slot;
+		if (Ordered) {
+			unlink(index);
+		}
+		int lastIndex = --count;
+		if (index != lastIndex) {
+			items[index] = items[lastIndex];
+			int movedSlot = denseToSlot[lastIndex];
+			denseToSlot[index] = movedSlot;
+			slotToDense[movedSlot] = index;
+			if (Ordered) {
+				relink(lastIndex, index);
+			}
+		}
+	}
+
+	/**
+	 * @description: remove a source while walking the pool with first()/next()
+	 * @return: the source that followed it in order, which is where the walk continues
+	 */
+	int erase(int index) {
+		int following = Ordered ? nextIndex[index] : index;
+		remove(index);
+		if (Ordered) {
+			return following == count ? index : following;
+		}
+		return following < count ? following : SOURCE_POOL_NONE;
+	}
+
+	SourceHandle_t getHandle(int index) const {
+		SourceHandle_t handle;
+		handle.slot = denseToSlot[index];
+		handle.generation = generations[handle.slot];
+		return handle;
+	}
+
+	bool isValid(SourceHandle_t handle) const {
+		return handle.slot >= 0 && handle.slot < N && generations[handle.slot] == handle.generation
+				&& slotToDense[handle.slot] < count && denseToSlot[slotToDense[handle.slot]] == handle.slot;
+	}
+
+	/**
+	 * @description: current index of a source, SOURCE_POOL_NONE if its handle is stale
+	 */
+	int indexOf(SourceHandle_t handle) const {
+		return isValid(handle) ? slotToDense[handle.slot] : SOURCE_POOL_NONE;
+	}
+
+	/**
+	 * @description: the source of a handle, NULL if the handle is stale
+	 */
+	T* get(SourceHandle_t handle) {
+		return isValid(handle) ? &items[slotToDense[handle.slot]] : 0;
+	}
+
+	/**
+	 * @description: remove the source of a handle, if it still exists
+	 */
+	void remove(SourceHandle_t handle) {
+		int index = indexOf(handle);
+		if (index != SOURCE_POOL_NONE) {
+			remove(index);
+		}
+	}
+};
+
+#endif /* INC_SOURCEPOOL_H_ */
@@ -4,16 +4,13 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/AuroraPlugin.cpp \
-../src/AveragingFilter.cpp
+../src/AuroraPlugin.cpp
 
 OBJS += \
-./src/AuroraPlugin.o \
-./src/AveragingFilter.o 
+./src/AuroraPlugin.o 
 
 CPP_DEPS += \
-./src/AuroraPlugin.d \
-./src/AveragingFilter.d
+./src/AuroraPlugin.d
 
 # Each subdirectory must supply rules for building sources it contributes
 src/%.o: ../src/%.cpp
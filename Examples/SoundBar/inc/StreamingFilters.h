@@ -0,0 +1,665 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * StreamingFilters.h
+ *
+ *  Sliding window filters over a stream of samples: running mean, exponential moving average,
+ *  running min/max and running median.
+ *
+ *  The window length is either a template argument, in which case the window lives inside the
+ *  filter, or FILTER_DYNAMIC_WINDOW, in which case it is passed to the constructor and the window
+ *  is allocated on the heap, e.g.
+ *
+ *      RunningMean<uint16_t, 10> energyFilter;
+ *      RunningMax<float> peakFilter(windowLength);
+ *
+ *  Until a window has been filled the filters work on the samples seen so far.
+ *
+ *  The *Bank variants run one filter per channel, e.g. one per fft bin, and take a whole row of
+ *  channels per call. Their state is laid out channel-minor so every update is a straight loop
+ *  over the channels that the compiler can vectorise. They are meant for float samples.
+ */
+
+#ifndef INC_STREAMINGFILTERS_H_
+#define INC_STREAMINGFILTERS_H_
+
+#include <stdint.h>
+#include <limits>
+#include <set>
+#include <vector>
+
+#define FILTER_DYNAMIC_WINDOW 0
+
+/**
+ * Window storage, inline for a compile time length
+ */
+template <typename T, int N>
+class FilterWindow {
+	T data[N];
+public:
+	FilterWindow(int length) {
+		(void)length;
+		for (int i = 0; i < N; i++) {
+			data[i] = T();
+		}
+	}
+
+	int getLength() const {
+		return N;
+	}
+
+	T& operator[](int index) {
+		return data[index];
+	}
+
+	const T& operator[](int index) const {
+		return data[index];
+	}
+};
+
+/**
+ * Window storage, on the heap for a length given at run time
+ */
+template <typename T>
+class FilterWindow<T, FILTER_DYNAMIC_WINDOW> {
+	std::vector<T> data;
+public:
+	FilterWindow(int length) : data(length < 1 ? 1 : length) {
+	}
+
+	int getLength() const {
+		return (int)data.size();
+	}
+
+	T& operator[](int index) {
+		return data[index];
+	}
+
+	const T& operator[](int index) const {
+		return data[index];
+	}
+};
+
+/**
+ * Type the running sum of a filter is kept in: 64 bit integers for integer samples so the sum
+ * is exact, double otherwise
+ */
+template <typename T, bool isInteger = std::numeric_limits<T>::is_integer>
+struct FilterAccumulator {
+	typedef double type;
+};
+
+template <typename T>
+struct FilterAccumulator<T, true> {
+	typedef int64_t type;
+};
+
+/**
+ * Mean of the last N samples. The sum is updated incrementally, so a new sample costs O(1)
+ * whatever the window length.
+ */
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMean {
+	typedef typename FilterAccumulator<T>::type Acc;
+	FilterWindow<T, N> window;
+	int head;		/*slot the next sample is written to*/
+	int count;
+	Acc sum;
+public:
+	RunningMean(int length = N) : window(length) {
+		reset();
+	}
+
+	void reset() {
+		head = 0;
+		count = 0;
+		sum = 0;
+	}
+
+	void feedFilter(T sample) {
+		int length = window.getLength();
+		if (count == length) {
+			sum -= window[head];
+		}
+		else {
+			count++;
+		}
+		window[head] = sample;
+		sum += sample;
+		head++;
+		if (head == length) {
+			head = 0;
+			if (!std::numeric_limits<T>::is_integer) {
+				// re-add the window once per lap so rounding errors in the float sum do not pile up
+				sum = 0;
+				for (int i = 0; i < count; i++) {
+					sum += window[i];
+				}
+			}
+		}
+	}
+
+	double getMean() const {
+		return count == 0 ? 0 : (double)sum / count;
+	}
+
+	int getCount() const {
+		return count;
+	}
+
+	int getLength() const {
+		return window.getLength();
+	}
+};
+
+/**
+ * Exponential moving average, value += alpha * (sample - value). The first sample initialises
+ * the average.
+ */
+template <typename T>
+class Ema {
+	double alpha;
+	double value;
+	bool primed;
+public:
+	Ema(double alpha = 0.1) {
+		this->alpha = alpha;
+		reset();
+	}
+
+	void reset() {
+		value = 0;
+		primed = false;
+	}
+
+	void setAlpha(double alpha) {
+		this->alpha = alpha;
+	}
+
+	void feedFilter(T sample) {
+		if (!primed) {
+			value = sample;
+			primed = true;
+			return;
+		}
+		value += alpha * ((double)sample - value);
+	}
+
+	double getValue() const {
+		return value;
+	}
+};
+
+/**
+ * Extremum of the last N samples using a monotonic deque: the deque only keeps the samples that
+ * can still become the extremum, so each sample is pushed and popped at most once, O(1) amortised.
+ * Compare(a, b) must be true when a should replace b, e.g. std::greater for a running max.
+ */
+template <typename T, typename Compare, int N = FILTER_DYNAMIC_WINDOW>
+class RunningExtremum {
+	FilterWindow<T, N> values;		/*deque, as a ring buffer*/
+	FilterWindow<int64_t, N> ages;	/*sample number of each deque entry*/
+	int front;
+	int size;
+	int64_t nSamples;
+	Compare compare;
+public:
+	RunningExtremum(int length = N) : values(length), ages(length) {
+		reset();
+	}
+
+	void reset() {
+		front = 0;
+		size = 0;
+		nSamples = 0;
+	}
+
+	void feedFilter(T sample) {
+		int length = values.getLength();
+		// drop the entry that leaves the window
+		if (size > 0 && ages[front] <= nSamples - length) {
+			front++;
+			if (front == length) {
+				front = 0;
+			}
+			size--;
+		}
+		// drop the entries that can no longer be the extremum
+		while (size > 0) {
+			int back = front + size - 1;
+			if (back >= length) {
+				back -= length;
+			}
+			if (compare(values[back], sample)) {
+				break;
+			}
+			size--;
+		}
+		int slot = front + size;
+		if (slot >= length) {
+			slot -= length;
+		}
+		values[slot] = sample;
+		ages[slot] = nSamples;
+		size++;
+		nSamples++;
+	}
+
+	T getValue() const {
+		return size == 0 ? T() : values[front];
+	}
+
+	int getLength() const {
+		return values.getLength();
+	}
+};
+
+template <typename T>
+struct FilterGreater {
+	bool operator()(const T& a, const T& b) const {
+		return a > b;
+	}
+};
+
+template <typename T>
+struct FilterLess {
+	bool operator()(const T& a, const T& b) const {
+		return a < b;
+	}
+};
+
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMax : public RunningExtremum<T, FilterGreater<T>, N> {
+public:
+	RunningMax(int length = N) : RunningExtremum<T, FilterGreater<T>, N>(length) {
+	}
+};
+
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMin : public RunningExtremum<T, FilterLess<T>, N> {
+public:
+	RunningMin(int length = N) : RunningExtremum<T, FilterLess<T>, N>(length) {
+	}
+};
+
+/**
+ * Median of the last N samples, O(log N) per sample. The window is split in a lower and an upper
+ * half kept in two ordered multisets, the upper half is never smaller than the lower one.
+ * For an even number of samples this returns the upper of the two middle samples.
+ */
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMedian {
+	FilterWindow<T, N> window;
+	int head;
+	int count;
+	std::multiset<T> lower;
+	std::multiset<T> upper;
+public:
+	RunningMedian(int length = N) : window(length) {
+		reset();
+	}
+
+	void reset() {
+		head = 0;
+		count = 0;
+		lower.clear();
+		upper.clear();
+	}
+
+	void feedFilter(T sample) {
+		int length = window.getLength();
+		if (count == length) {
+			T oldest = window[head];
+			if (!upper.empty() && !(oldest < *upper.begin())) {
+				upper.erase(upper.find(oldest));
+			}
+			else {
+				lower.erase(lower.find(oldest));
+			}
+		}
+		else {
+			count++;
+		}
+		window[head] = sample;
+		head++;
+		if (head == length) {
+			head = 0;
+		}
+
+		if (upper.empty() || !(sample < *upper.begin())) {
+			upper.insert(sample);
+		}
+		else {
+			lower.insert(sample);
+		}
+		// rebalance so that upper holds the middle sample
+		while (lower.size() > upper.size()) {
+			typename std::multiset<T>::iterator last = --lower.end();
+			upper.insert(*last);
+			lower.erase(last);
+		}
+		while (upper.size() > lower.size() + 1) {
+			lower.insert(*upper.begin());
+			upper.erase(upper.begin());
+		}
+	}
+
+	T getValue() const {
+		return upper.empty() ? T() : *upper.begin();
+	}
+
+	int getLength() const {
+		return window.getLength();
+	}
+};
+
+/**
+ * One RunningMean per channel. The window is a ring of rows of nChannels samples.
+ */
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMeanBank {
+	int nChannels;
+	int length;
+	int head;
+	int count;
+	std::vector<T> window;		/*length rows of nChannels*/
+	std::vector<T> sums;
+	std::vector<T> means;
+public:
+	RunningMeanBank(int nChannels, int length = N) {
+		this->nChannels = nChannels;
+		this->length = (N != FILTER_DYNAMIC_WINDOW) ? N : (length < 1 ? 1 : length);
+		window.resize(this->length * nChannels);
+		sums.resize(nChannels);
+		means.resize(nChannels);
+		reset();
+	}
+
+	void reset() {
+		head = 0;
+		count = 0;
+		for (int c = 0; c < nChannels; c++) {
+			sums[c] = 0;
+			means[c] = 0;
+		}
+	}
+
+	void feedFilter(const T* samples) {
+		T* row = &window[head * nChannels];
+		T* sum = sums.data();
+		T* mean = means.data();
+		if (count == length) {
+			for (int c = 0; c < nChannels; c++) {
+				sum[c] -= row[c];
+			}
+		}
+		else {
+			count++;
+		}
+		T scale = (T)1 / count;
+		for (int c = 0; c < nChannels; c++) {
+			row[c] = samples[c];
+			sum[c] += samples[c];
+			mean[c] = sum[c] * scale;
+		}
+		head++;
+		if (head == length) {
+			head = 0;
+			// re-add the window once per lap so rounding errors in the sums do not pile up
+			for (int c = 0; c < nChannels; c++) {
+				sum[c] = 0;
+			}
+			for (int i = 0; i < count; i++) {
+				const T* r = &window[i * nChannels];
+				for (int c = 0; c < nChannels; c++) {
+					sum[c] += r[c];
+				}
+			}
+		}
+	}
+
+	const T* getMeans() const {
+		return means.data();
+	}
+};
+
+/**
+ * One Ema per channel
+ */
+template <typename T>
+class EmaBank {
+	int nChannels;
+	T alpha;
+	bool primed;
+	std::vector<T> values;
+public:
+	EmaBank(int nChannels, T alpha = 0.1) {
+		this->nChannels = nChannels;
+		this->alpha = alpha;
+		values.resize(nChannels);
+		reset();
+	}
+
+	void reset() {
+		primed = false;
+		for (int c = 0; c < nChannels; c++) {
+			values[c] = 0;
+		}
+	}
+
+	void feedFilter(const T* samples) {
+		T* value = values.data();
+		if (!primed) {
+			for (int c = 0; c < nChannels; c++) {
+				value[c] = samples[c];
+			}
+			primed = true;
+			return;
+		}
+		for (int c = 0; c < nChannels; c++) {
+			value[c] += alpha * (samples[c] - value[c]);
+		}
+	}
+
+	const T* getValues() const {
+		return values.data();
+	}
+};
+
+/**
+ * One running extremum per channel. A monotonic deque per channel does not vectorise, so this uses
+ * the van Herk / Gil-Werman split instead: the stream is cut into blocks of the window length,
+ * and the window ending at slot j of the current block is covered by the suffix of the previous
+ * block from j + 1 plus the prefix of the current block up to j. The prefix is updated with every
+ * sample, the suffixes are computed once per block, so a sample costs O(1) amortised and every
+ * step is an elementwise loop over the channels.
+ */
+template <typename T, typename Compare, int N = FILTER_DYNAMIC_WINDOW>
+class RunningExtremumBank {
+	int nChannels;
+	int length;
+	int slot;				/*slot of the next sample in the current block*/
+	T identity;				/*value that never wins a comparison*/
+	std::vector<T> block;		/*length rows, samples of the current block*/
+	std::vector<T> suffixes;	/*length + 1 rows, suffix extrema of the previous block*/
+	std::vector<T> prefix;		/*extremum of the current block so far*/
+	std::vector<T> values;
+	Compare compare;
+public:
+	RunningExtremumBank(int nChannels, T identity, int length = N) {
+		this->nChannels = nChannels;
+		this->length = (N != FILTER_DYNAMIC_WINDOW) ? N : (length < 1 ? 1 : length);
+		this->identity = identity;
+		block.resize(this->length * nChannels);
+		suffixes.resize((this->length + 1) * nChannels);
+		prefix.resize(nChannels);
+		values.resize(nChannels);
+		reset();
+	}
+
+	void reset() {
+		slot = 0;
+		for (size_t i = 0; i < suffixes.size(); i++) {
+			suffixes[i] = identity;
+		}
+		for (int c = 0; c < nChannels; c++) {
+			prefix[c] = identity;
+			values[c] = identity;
+		}
+	}
+
+	void feedFilter(const T* samples) {
+		T* row = &block[slot * nChannels];
+		T* pre = prefix.data();
+		T* value = values.data();
+		const T* suf = &suffixes[(slot + 1) * nChannels];
+		for (int c = 0; c < nChannels; c++) {
+			T s = samples[c];
+			row[c] = s;
+			T p = compare(s, pre[c]) ? s : pre[c];
+			pre[c] = p;
+			value[c] = compare(suf[c], p) ? suf[c] : p;
+		}
+		slot++;
+		if (slot == length) {
+			// the block is complete: its suffixes cover the next windows, start a new prefix
+			T* next = &suffixes[length * nChannels];
+			for (int c = 0; c < nChannels; c++) {
+				next[c] = identity;
+			}
+			for (int i = length - 1; i >= 0; i--) {
+				T* cur = &suffixes[i * nChannels];
+				const T* r = &block[i * nChannels];
+				for (int c = 0; c < nChannels; c++) {
+					cur[c] = compare(r[c], next[c]) ? r[c] : next[c];
+				}
+				next = cur;
+			}
+			for (int c = 0; c < nChannels; c++) {
+				pre[c] = identity;
+			}
+			slot = 0;
+		}
+	}
+
+	const T* getValues() const {
+		return values.data();
+	}
+};
+
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMaxBank : public RunningExtremumBank<T, FilterGreater<T>, N> {
+public:
+	RunningMaxBank(int nChannels, int length = N)
+		: RunningExtremumBank<T, FilterGreater<T>, N>(nChannels, std::numeric_limits<T>::lowest(), length) {
+	}
+};
+
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMinBank : public RunningExtremumBank<T, FilterLess<T>, N> {
+public:
+	RunningMinBank(int nChannels, int length = N)
+		: RunningExtremumBank<T, FilterLess<T>, N>(nChannels, std::numeric_limits<T>::max(), length) {
+	}
+};
+
+/**
+ * One running median per channel. Each channel keeps its window sorted, one row per rank, and a
+ * new sample replaces the oldest one with a branch free compare and select over the ranks:
+ * ranks between the old and the new sample shift by one towards the old one, the new sample lands
+ * in the gap. That is O(N) per channel instead of O(log N), but for the short windows used on fft
+ * bins a vectorised pass over all channels is much cheaper than per channel trees.
+ * Like RunningMedian this returns the upper of the two middle samples for an even count.
+ */
+template <typename T, int N = FILTER_DYNAMIC_WINDOW>
+class RunningMedianBank {
+	int nChannels;
+	int length;
+	int head;
+	int count;
+	T low;				/*sentinel below every sample*/
+	T high;				/*sentinel above every sample, fills the ranks not used yet*/
+	std::vector<T> window;		/*length rows, samples in arrival order*/
+	std::vector<T> sorted;		/*length + 2 rows, sentinel, ranks 0 .. length - 1, sentinel*/
+	std::vector<T> scratch;
+public:
+	RunningMedianBank(int nChannels, int length = N) {
+		this->nChannels = nChannels;
+		this->length = (N != FILTER_DYNAMIC_WINDOW) ? N : (length < 1 ? 1 : length);
+		low = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+		high = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+		window.resize(this->length * nChannels);
+		sorted.resize((this->length + 2) * nChannels);
+		scratch.resize(this->length * nChannels);
+		reset();
+	}
+
+	void reset() {
+		head = 0;
+		count = 0;
+		for (int c = 0; c < nChannels; c++) {
+			sorted[c] = low;
+		}
+		for (size_t i = nChannels; i < sorted.size(); i++) {
+			sorted[i] = high;
+		}
+	}
+
+	void feedFilter(const T* samples) {
+		T* oldRow = &window[head * nChannels];
+		bool full = (count == length);
+		for (int r = 0; r < length; r++) {
+			const T* below = &sorted[r * nChannels];
+			const T* cur = below + nChannels;
+			const T* above = cur + nChannels;
+			T* out = &scratch[r * nChannels];
+			for (int c = 0; c < nChannels; c++) {
+				T v = samples[c];
+				T o = full ? oldRow[c] : high;
+				T s = cur[c];
+				// the new sample is above the old one: ranks from the old one up to the new one move down
+				T down = (s < o) ? s : ((above[c] <= v) ? above[c] : (s > v ? s : v));
+				// the new sample is below the old one: ranks from the new one up to the old one move up
+				T up = (s > o) ? s : ((below[c] >= v) ? below[c] : (s < v ? s : v));
+				out[c] = (v >= o) ? down : up;
+			}
+		}
+		for (int i = 0; i < length * nChannels; i++) {
+			sorted[nChannels + i] = scratch[i];
+		}
+		for (int c = 0; c < nChannels; c++) {
+			oldRow[c] = samples[c];
+		}
+		if (!full) {
+			count++;
+		}
+		head++;
+		if (head == length) {
+			head = 0;
+		}
+	}
+
+	/**
+	 * @description: median of every channel
+	 * @return: row of nChannels values, valid until the next call to feedFilter
+	 */
+	const T* getValues() const {
+		return &sorted[(1 + count / 2) * nChannels];
+	}
+};
+
+#endif /* INC_STREAMINGFILTERS_H_ */
@@ -24,7 +24,7 @@
 #include "Logger.h"
 #include <stdio.h>
 #include <limits.h>
-#include "AveragingFilter.h"
+#include "StreamingFilters.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,10 +39,13 @@ extern "C" {
 #endif
 
 LayoutData* layoutData;
-FrameSlice_t* frameSlices = NULL;
+FrameSliceSet_t frameSliceSet;
+FrameSliceView_t frameSlices;
 int nFrameSlices = 0;
 
-AveragingFilter af;
+#define ENERGY_FILTER_LENGTH 10
+
+RunningMean<uint16_t, ENERGY_FILTER_LENGTH> af;
 
 static int currentAuroraRotation = 0;
 
@@ -78,8 +81,8 @@ int findMaxExpanse(){
         }
         int angleToRotateBy = 30;
         rotateAuroraPanels(layoutData, &angleToRotateBy);
-        printf ("Max expanse : %d\n", maxExpanse);
-        printf ("d %d\n", d);
+        PRINTLOG("Max expanse : %d\n", maxExpanse);
+        PRINTLOG("d %d\n", d);
     }
     
     //turn the layout back to the maDegrees
@@ -100,10 +103,12 @@ void initPlugin(){
     //do allocation here
     //rotate the layout so that right to left have the maximum number of frame slices
     currentAuroraRotation = findMaxExpanse();
-    printf ("max expanse found at angle %d", currentAuroraRotation);
+    PRINTLOG("max expanse found at angle %d\n", currentAuroraRotation);
     
-    //quantizes the layout into frameslices. See SDK documentation for more information
-    getFrameSlicesFromLayoutForTriangle(layoutData, &frameSlices, &nFrameSlices, currentAuroraRotation);
+    //quantizes the layout into frameslices, for every rotation at once. See SDK documentation for more information
+    buildFrameSliceSet(layoutData, currentAuroraRotation, &frameSliceSet);
+    frameSlices = getFrameSliceView(&frameSliceSet, 0);
+    nFrameSlices = frameSlices.nSlices;
     
     getColorPalette(&colorPalette, &nColors);
     
@@ -141,18 +146,14 @@ void initPlugin(){
  */
 void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime){
     //	static int rotationCounter = 0;
+    //	static int turn = 0;
     //	if (rotationCounter == 100){
-    //		int angle = 30; //the angle to rotate the layout by
-    //		rotateAuroraPanels(layoutData, &angle);
-    //		currentAuroraRotation += angle; //update the currentAuroraRotation by the new angle
-    //		//call getFrameSlicesFromLayoutForTriangle to get the new frameSlices as per the new layout
-    //		//always call freeFrameSlices before calling getFrameSlicesFromLayoutForTriangle. (safe to call with NULL pointer
-    //		//getFrameSlicesFromLayoutForTriangle allocates memory, and hence is important to ensure that the memory allocated from a previous call is properly deallocated
-    //		//to ensure no memory leaks occur
-    //		freeFrameSlices(frameSlices);
-    //		getFrameSlicesFromLayoutForTriangle(layoutData, &frameSlices, &nFrameSlices, currentAuroraRotation);
+    //		//the slices of every rotation were computed in initPlugin, so turning the bar
+    //		//only picks another view of them, without touching the layout or allocating
+    //		turn += 30;
+    //		frameSlices = getFrameSliceView(&frameSliceSet, turn);
+    //		nFrameSlices = frameSlices.nSlices;
     //		rotationCounter = 0;
-    //		currentAuroraRotation = currentAuroraRotation % 360;
     //	}
     ////	rotationCounter++;
     
@@ -186,7 +187,7 @@ void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime){
     uint16_t energy = getEnergy();
     
     af.feedFilter(energy);
-    double avgEnergy = af.getAverage();
+    double avgEnergy = af.getMean();
     
     static double maxEnergy = energy;
     if (avgEnergy > maxEnergy){
@@ -224,8 +225,8 @@ void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime){
         //In other words the bar color fades into the base color
         netColor = (((barColor*x_t)/255) + ((baseColor*(255-x_t)))/255);
         netColor = limitRGB(netColor, 255, 0);
-        for (unsigned int j = 0; j < frameSlices[i].panelIds.size(); j++){
-            frames[frameIndex].panelId = frameSlices[i].panelIds[j];
+        for (int j = frameSlices.sliceOffsets[i]; j < frameSlices.sliceOffsets[i + 1]; j++){
+            frames[frameIndex].panelId = frameSlices.panelIds[j];
             frames[frameIndex].r = netColor.R;
             frames[frameIndex].g = netColor.G;
             frames[frameIndex].b = netColor.B;
@@ -234,8 +235,8 @@ void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime){
         }
     }
     for (int i = nFramesAffected; i < nFrameSlices; i++){
-        for (unsigned int j = 0; j < frameSlices[i].panelIds.size(); j++){
-            frames[frameIndex].panelId = frameSlices[i].panelIds[j];
+        for (int j = frameSlices.sliceOffsets[i]; j < frameSlices.sliceOffsets[i + 1]; j++){
+            frames[frameIndex].panelId = frameSlices.panelIds[j];
             frames[frameIndex].r = baseColor.R;
             frames[frameIndex].g = baseColor.G;
             frames[frameIndex].b = baseColor.B;
@@ -262,5 +263,4 @@ void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime){
  */
 void pluginCleanup(){
 	//do deallocation here
-    freeFrameSlices(frameSlices);
 }
@@ -68,10 +68,11 @@ void initPlugin(){
  * Note that the FrameSlice_t structure is just a vector of panels at that frame slice
  */
 void fillUpFramesArray(FrameSlice_t* frameSlice, Frame_t* frame, int* frameIndex, int hue){
-    static RGB_t rgb;
+    //every panel of the slice gets the same colour, so convert it once
+    RGB_t rgb;
+    HSVtoRGBFast((HSV_t){hue, 100, 100}, &rgb);
     for (unsigned int i = 0; i < frameSlice->panelIds.size(); i++){
         frame[*frameIndex].panelId = frameSlice->panelIds[i];
-        HSVtoRGB((HSV_t){hue, 100, 100}, &rgb);
         frame[*frameIndex].r = rgb.R;
         frame[*frameIndex].g = rgb.G;
         frame[*frameIndex].b = rgb.B;
@@ -0,0 +1,32 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../../PluginUtilities/src/BeatEngine.cpp \
+../../PluginUtilities/src/BeatTracker.cpp \
+../../PluginUtilities/src/BeatUtilities.cpp \
+../../PluginUtilities/src/OnsetDetector.cpp 
+
+OBJS += \
+./PluginUtilities/BeatEngine.o \
+./PluginUtilities/BeatTracker.o \
+./PluginUtilities/BeatUtilities.o \
+./PluginUtilities/OnsetDetector.o 
+
+CPP_DEPS += \
+./PluginUtilities/BeatEngine.d \
+./PluginUtilities/BeatTracker.d \
+./PluginUtilities/BeatUtilities.d \
+./PluginUtilities/OnsetDetector.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+PluginUtilities/%.o: ../../PluginUtilities/src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../inc -I../../PluginUtilities/inc -I../../PluginHost/inc -O3 -g -Wall -c -fmessage-length=0 -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
@@ -0,0 +1,29 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/FeatureExtractor.cpp \
+../src/WavReader.cpp \
+../src/main.cpp 
+
+OBJS += \
+./src/FeatureExtractor.o \
+./src/WavReader.o \
+./src/main.o 
+
+CPP_DEPS += \
+./src/FeatureExtractor.d \
+./src/WavReader.d \
+./src/main.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/%.o: ../src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../inc -I../../PluginUtilities/inc -I../../PluginHost/inc -O3 -g -Wall -c -fmessage-length=0 -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
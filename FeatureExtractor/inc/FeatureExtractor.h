@@ -0,0 +1,120 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureExtractor.h
+ *
+ *  Streaming extraction of the sound features that music_processor.py sends to the simulator:
+ *  the energy and fft bins of every hop of audio, plus the beat, onset and tempo of the beat engine
+ *  of the utilities library.
+ *
+ *  A hop is FEATURE_HOP_SAMPLES mono samples at the input sample rate. It is low pass filtered and
+ *  decimated by FEATURE_DECIMATION, the FEATURE_N_FFT decimated samples go through a Hann window and
+ *  an fft, and the squared magnitudes of the lower half are averaged into the output bins with the
+ *  same scaling and 8 bit saturation as music_processor.py. The filter keeps its history across hops.
+ *
+ *  The fft plan, the filter and every buffer are allocated by initFeatureExtractor, processing a hop
+ *  does not allocate.
+ */
+
+#ifndef INC_FEATUREEXTRACTOR_H_
+#define INC_FEATUREEXTRACTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FEATURE_HOP_SAMPLES 2048		/*music_processor.py reads 2048 samples per buffer*/
+#define FEATURE_DECIMATION 4
+#define FEATURE_N_FFT (FEATURE_HOP_SAMPLES / FEATURE_DECIMATION)
+#define FEATURE_MAX_FFT_BINS (FEATURE_N_FFT / 2)
+#define FEATURE_N_TAPS 64				/*taps of the decimation filter, a multiple of 4*/
+#define FEATURE_ENERGY_SCALE 32.0f		/*2**5 in music_processor.py*/
+#define FEATURE_FFT_SCALE 8.0f			/*2**3 in music_processor.py*/
+
+class BeatEngine;
+
+/**
+ * The features of one hop. fftBins points into the extractor and is overwritten by the next hop
+ */
+struct FeatureFrame_t {
+	uint16_t energy;
+	const uint8_t* fftBins;
+	uint16_t nFftBins;
+	bool beat;
+	bool onset;
+	float tempo;			/*bpm*/
+	float beatPhase;		/*0 on the beat, rising to 1 before the next*/
+	float beatConfidence;	/*0 to 1*/
+};
+
+struct FeatureExtractor_t {
+	float sampleRate;
+	int nFftBins;
+	int binStep;			/*fft bins averaged into one output bin*/
+	float* taps;			/*FEATURE_N_TAPS*/
+	float* history;			/*the last FEATURE_N_TAPS - 1 samples of the previous hop, then the current hop*/
+	float* window;			/*FEATURE_N_FFT*/
+	float* re;				/*FEATURE_N_FFT, fft work buffers*/
+	float* im;
+	float* cosTable;		/*FEATURE_N_FFT / 2 twiddles*/
+	float* sinTable;
+	int* bitReverse;		/*FEATURE_N_FFT*/
+	float* power;			/*FEATURE_MAX_FFT_BINS*/
+	uint8_t* fftBins;		/*nFftBins*/
+	BeatEngine* beatEngine;
+	uint64_t nHops;
+	FeatureExtractor_t() {
+		sampleRate = 0;
+		nFftBins = 0;
+		binStep = 0;
+		taps = history = window = re = im = cosTable = sinTable = power = NULL;
+		bitReverse = NULL;
+		fftBins = NULL;
+		beatEngine = NULL;
+		nHops = 0;
+	}
+	~FeatureExtractor_t();
+};
+
+/**
+ * @description: plan the fft, design the decimation filter and allocate every buffer
+ * @params sampleRate: sample rate of the input in Hz
+ * @params nFftBins: number of output bins, 1 to FEATURE_MAX_FFT_BINS, as asked for by the simulator
+ * @return: 0 on success, -1 if nFftBins is out of range
+ */
+int initFeatureExtractor(FeatureExtractor_t* extractor, float sampleRate, int nFftBins);
+
+/**
+ * @description: free everything initFeatureExtractor allocated
+ */
+void freeFeatureExtractor(FeatureExtractor_t* extractor);
+
+/**
+ * @description: extract the features of one hop and tick the beat engine
+ * @params samples: FEATURE_HOP_SAMPLES mono samples in [-1, 1]
+ * @params frame: receives the features, valid until the next call
+ */
+void processFeatureHop(FeatureExtractor_t* extractor, const float* samples, FeatureFrame_t* frame);
+
+/**
+ * @description: write the features as music_processor.py sends them: the uint8 bins followed by the
+ * little endian uint16 energy
+ * @params packet: at least nFftBins + 2 bytes
+ * @return: the length of the packet
+ */
+int packFeaturePacket(const FeatureFrame_t* frame, uint8_t* packet);
+
+#endif /* INC_FEATUREEXTRACTOR_H_ */
@@ -0,0 +1,78 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * WavReader.h
+ *
+ *  Streaming reader of PCM audio from a WAV file or stdin, mixed down to mono floats in [-1, 1].
+ *  Integer PCM of 8, 16, 24 and 32 bits and 32 bit float are read, plain or WAVE_FORMAT_EXTENSIBLE.
+ *  Input that does not start with a RIFF header is read as raw signed 16 bit mono at the sample
+ *  rate given to openWav, so `arecord -f S16_LE -c 1` or `sox ... -t raw -` can be piped in.
+ */
+
+#ifndef INC_WAVREADER_H_
+#define INC_WAVREADER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+struct WavReader_t {
+	FILE* fp;
+	bool ownsFile;
+	float sampleRate;
+	int nChannels;
+	int bitsPerSample;
+	bool isFloat;
+	uint64_t bytesLeft;			/*of the data chunk, UINT64_MAX for raw input and streamed WAV*/
+	uint8_t* buffer;			/*one block of interleaved samples*/
+	int bufferFrames;
+	uint8_t pending[4];			/*bytes read while probing a raw stream for a header*/
+	int nPending;
+	WavReader_t() {
+		fp = NULL;
+		ownsFile = false;
+		sampleRate = 0;
+		nChannels = 0;
+		bitsPerSample = 0;
+		isFloat = false;
+		bytesLeft = 0;
+		buffer = NULL;
+		bufferFrames = 0;
+		nPending = 0;
+	}
+	~WavReader_t();
+};
+
+/**
+ * @description: open a WAV file, or stdin if path is "-", and parse its header
+ * @params rawSampleRate: sample rate of raw input without a header
+ * @params maxFrames: the most frames a single readWav call will ask for, sizes the read buffer
+ * @return: 0 on success, -1 if the file cannot be opened or its format is not supported
+ */
+int openWav(WavReader_t* reader, const char* path, float rawSampleRate, int maxFrames);
+
+/**
+ * @description: read up to nFrames frames, mixed down to mono
+ * @return: the number of frames read, less than nFrames only at the end of the input
+ */
+int readWav(WavReader_t* reader, float* out, int nFrames);
+
+/**
+ * @description: close the input and free the read buffer
+ */
+void closeWav(WavReader_t* reader);
+
+#endif /* INC_WAVREADER_H_ */
@@ -0,0 +1,213 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureExtractor.cpp
+ */
+
+#include "FeatureExtractor.h"
+#include "BeatEngine.h"
+#include <string.h>
+#include <math.h>
+
+#define DECIMATION_CUTOFF (0.9 * 0.5 / FEATURE_DECIMATION)	/*cycles per input sample, just below the new nyquist*/
+#define MAX_ENERGY 65535.0f
+#define MAX_BIN 255.0f
+
+FeatureExtractor_t::~FeatureExtractor_t() {
+	freeFeatureExtractor(this);
+}
+
+/**
+ * @description: windowed sinc low pass filter with unit gain at 0 Hz, so the energy of the bins is not scaled
+ */
+static void designDecimationFilter(float* taps) {
+	double sum = 0;
+	for (int k = 0; k < FEATURE_N_TAPS; k++) {
+		double t = k - (FEATURE_N_TAPS - 1) / 2.0;
+		double x = 2 * M_PI * DECIMATION_CUTOFF * t;
+		double sinc = t == 0 ? 1 : sin(x) / x;
+		double phase = 2 * M_PI * k / (FEATURE_N_TAPS - 1);
+		double blackman = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+		taps[k] = sinc * blackman;
+		sum += taps[k];
+	}
+	for (int k = 0; k < FEATURE_N_TAPS; k++) {
+		taps[k] /= sum;
+	}
+}
+
+/**
+ * @description: twiddles and the bit reversed order of a radix 2 fft of FEATURE_N_FFT points
+ */
+static void planFft(FeatureExtractor_t* extractor) {
+	for (int k = 0; k < FEATURE_N_FFT / 2; k++) {
+		extractor->cosTable[k] = cos(2 * M_PI * k / FEATURE_N_FFT);
+		extractor->sinTable[k] = sin(2 * M_PI * k / FEATURE_N_FFT);
+	}
+	int nBits = 0;
+	while ((1 << nBits) < FEATURE_N_FFT) {
+		nBits++;
+	}
+	for (int i = 0; i < FEATURE_N_FFT; i++) {
+		int r = 0;
+		for (int b = 0; b < nBits; b++) {
+			r |= ((i >> b) & 1) << (nBits - 1 - b);
+		}
+		extractor->bitReverse[i] = r;
+	}
+	// periodic Hann window, as librosa.stft uses
+	for (int i = 0; i < FEATURE_N_FFT; i++) {
+		extractor->window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / FEATURE_N_FFT);
+	}
+}
+
+/**
+ * @description: in place forward fft of re/im, which already hold the input in bit reversed order
+ */
+static void runFft(FeatureExtractor_t* extractor) {
+	float* re = extractor->re;
+	float* im = extractor->im;
+	for (int size = 2; size <= FEATURE_N_FFT; size <<= 1) {
+		int half = size >> 1;
+		int stride = FEATURE_N_FFT / size;
+		for (int start = 0; start < FEATURE_N_FFT; start += size) {
+			for (int k = 0; k < half; k++) {
+				float c = extractor->cosTable[k * stride];
+				float s = extractor->sinTable[k * stride];
+				int a = start + k;
+				int b = a + half;
+				float tr = re[b] * c + im[b] * s;
+				float ti = im[b] * c - re[b] * s;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+
+int initFeatureExtractor(FeatureExtractor_t* extractor, float sampleRate, int nFftBins) {
+	if (nFftBins < 1 || nFftBins > FEATURE_MAX_FFT_BINS) {
+		return -1;
+	}
+	freeFeatureExtractor(extractor);
+	extractor->sampleRate = sampleRate;
+	extractor->nFftBins = nFftBins;
+	extractor->binStep = FEATURE_MAX_FFT_BINS / nFftBins;
+	extractor->taps = new float[FEATURE_N_TAPS];
+	extractor->history = new float[FEATURE_N_TAPS - 1 + FEATURE_HOP_SAMPLES];
+	extractor->window = new float[FEATURE_N_FFT];
+	extractor->re = new float[FEATURE_N_FFT];
+	extractor->im = new float[FEATURE_N_FFT];
+	extractor->cosTable = new float[FEATURE_N_FFT / 2];
+	extractor->sinTable = new float[FEATURE_N_FFT / 2];
+	extractor->bitReverse = new int[FEATURE_N_FFT];
+	extractor->power = new float[FEATURE_MAX_FFT_BINS];
+	extractor->fftBins = new uint8_t[nFftBins];
+	memset(extractor->history, 0, (FEATURE_N_TAPS - 1 + FEATURE_HOP_SAMPLES) * sizeof(float));
+	memset(extractor->fftBins, 0, nFftBins);
+	designDecimationFilter(extractor->taps);
+	planFft(extractor);
+	extractor->beatEngine = new BeatEngine;
+	extractor->beatEngine->beatEngineInit(nFftBins, 1000.0f * FEATURE_HOP_SAMPLES / sampleRate);
+	extractor->nHops = 0;
+	return 0;
+}
+
+void freeFeatureExtractor(FeatureExtractor_t* extractor) {
+	delete [] extractor->taps;
+	delete [] extractor->history;
+	delete [] extractor->window;
+	delete [] extractor->re;
+	delete [] extractor->im;
+	delete [] extractor->cosTable;
+	delete [] extractor->sinTable;
+	delete [] extractor->bitReverse;
+	delete [] extractor->power;
+	delete [] extractor->fftBins;
+	delete extractor->beatEngine;
+	extractor->taps = extractor->history = extractor->window = extractor->re = extractor->im = NULL;
+	extractor->cosTable = extractor->sinTable = extractor->power = NULL;
+	extractor->bitReverse = NULL;
+	extractor->fftBins = NULL;
+	extractor->beatEngine = NULL;
+	extractor->nFftBins = 0;
+}
+
+void processFeatureHop(FeatureExtractor_t* extractor, const float* samples, FeatureFrame_t* frame) {
+	float* hop = extractor->history + FEATURE_N_TAPS - 1;
+	float energy = 0;
+	for (int i = 0; i < FEATURE_HOP_SAMPLES; i++) {
+		hop[i] = samples[i];
+		energy += samples[i] * samples[i];
+	}
+	energy *= FEATURE_ENERGY_SCALE;
+
+	// filter and keep every FEATURE_DECIMATION-th sample, windowed and in bit reversed order for the fft.
+	// The taps are symmetric, so they need not be reversed. Four partial sums keep the adds independent
+	for (int m = 0; m < FEATURE_N_FFT; m++) {
+		const float* x = extractor->history + m * FEATURE_DECIMATION;
+		const float* taps = extractor->taps;
+		float acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+		for (int k = 0; k < FEATURE_N_TAPS; k += 4) {
+			acc0 += taps[k] * x[k];
+			acc1 += taps[k + 1] * x[k + 1];
+			acc2 += taps[k + 2] * x[k + 2];
+			acc3 += taps[k + 3] * x[k + 3];
+		}
+		int r = extractor->bitReverse[m];
+		extractor->re[r] = ((acc0 + acc1) + (acc2 + acc3)) * extractor->window[m];
+		extractor->im[r] = 0;
+	}
+	memmove(extractor->history, extractor->history + FEATURE_HOP_SAMPLES, (FEATURE_N_TAPS - 1) * sizeof(float));
+
+	runFft(extractor);
+	for (int j = 0; j < FEATURE_MAX_FFT_BINS; j++) {
+		extractor->power[j] = (extractor->re[j] * extractor->re[j] + extractor->im[j] * extractor->im[j]) * FEATURE_FFT_SCALE;
+	}
+
+	// average into the output bins like get_output_fft_bins of music_processor.py, the top bins are
+	// dropped when nFftBins does not divide the spectrum
+	for (int i = 0; i < extractor->nFftBins; i++) {
+		const float* p = extractor->power + i * extractor->binStep;
+		float acc = 0;
+		for (int j = 0; j < extractor->binStep; j++) {
+			acc += p[j];
+		}
+		acc /= extractor->binStep;
+		extractor->fftBins[i] = acc > MAX_BIN ? MAX_BIN : acc;
+	}
+
+	frame->energy = energy > MAX_ENERGY ? MAX_ENERGY : energy;
+	extractor->beatEngine->beatEngineTick(frame->energy, extractor->fftBins);
+	frame->fftBins = extractor->fftBins;
+	frame->nFftBins = extractor->nFftBins;
+	frame->beat = extractor->beatEngine->isBeat();
+	frame->onset = extractor->beatEngine->isOnset();
+	frame->tempo = extractor->beatEngine->getTempo();
+	frame->beatPhase = extractor->beatEngine->getBeatPhase();
+	frame->beatConfidence = extractor->beatEngine->getBeatConfidence();
+	extractor->nHops++;
+}
+
+int packFeaturePacket(const FeatureFrame_t* frame, uint8_t* packet) {
+	memcpy(packet, frame->fftBins, frame->nFftBins);
+	packet[frame->nFftBins] = frame->energy & 0xff;
+	packet[frame->nFftBins + 1] = frame->energy >> 8;
+	return frame->nFftBins + 2;
+}
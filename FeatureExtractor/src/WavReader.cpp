@@ -0,0 +1,218 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * WavReader.cpp
+ */
+
+#include "WavReader.h"
+#include <string.h>
+
+#define WAVE_FORMAT_PCM 1
+#define WAVE_FORMAT_IEEE_FLOAT 3
+#define WAVE_FORMAT_EXTENSIBLE 0xfffe
+#define STREAMED_SIZE 0xffffffffu		/*data size written by tools that stream a WAV to a pipe*/
+
+WavReader_t::~WavReader_t() {
+	closeWav(this);
+}
+
+static uint16_t readLe16(const uint8_t* p) {
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t readLe32(const uint8_t* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @description: skip bytes without seeking, stdin may be a pipe
+ * @return: true if all of them could be skipped
+ */
+static bool skipBytes(FILE* fp, uint32_t n) {
+	uint8_t scratch[256];
+	while (n > 0) {
+		size_t chunk = n < sizeof(scratch) ? n : sizeof(scratch);
+		if (fread(scratch, 1, chunk, fp) != chunk) {
+			return false;
+		}
+		n -= chunk;
+	}
+	return true;
+}
+
+/**
+ * @description: read the chunks after "RIFF" up to the start of the data chunk
+ * @return: 0 on success, -1 if the header is malformed or the format is not supported
+ */
+static int parseWavHeader(WavReader_t* reader) {
+	uint8_t header[16];
+	if (fread(header, 1, 8, reader->fp) != 8 || memcmp(header + 4, "WAVE", 4) != 0) {
+		fprintf(stderr, "not a WAVE file\n");
+		return -1;
+	}
+	int formatTag = -1;
+	while (fread(header, 1, 8, reader->fp) == 8) {
+		uint32_t size = readLe32(header + 4);
+		uint32_t padded = size + (size & 1);
+		if (memcmp(header, "fmt ", 4) == 0) {
+			uint8_t fmt[40];
+			memset(fmt, 0, sizeof(fmt));
+			uint32_t n = size < sizeof(fmt) ? size : sizeof(fmt);
+			if (size < 16 || fread(fmt, 1, n, reader->fp) != n || !skipBytes(reader->fp, padded - n)) {
+				fprintf(stderr, "malformed fmt chunk\n");
+				return -1;
+			}
+			formatTag = readLe16(fmt);
+			reader->nChannels = readLe16(fmt + 2);
+			reader->sampleRate = readLe32(fmt + 4);
+			reader->bitsPerSample = readLe16(fmt + 14);
+			if (formatTag == WAVE_FORMAT_EXTENSIBLE && size >= 40) {
+				formatTag = readLe16(fmt + 24);	/*first two bytes of the sub format GUID*/
+			}
+		}
+		else if (memcmp(header, "data", 4) == 0) {
+			reader->bytesLeft = (size == 0 || size == STREAMED_SIZE) ? UINT64_MAX : size;
+			break;
+		}
+		else if (!skipBytes(reader->fp, padded)) {
+			break;
+		}
+	}
+	if (reader->bytesLeft == 0) {
+		fprintf(stderr, "no data chunk\n");
+		return -1;
+	}
+	bool pcm = formatTag == WAVE_FORMAT_PCM && (reader->bitsPerSample == 8 || reader->bitsPerSample == 16 ||
+			reader->bitsPerSample == 24 || reader->bitsPerSample == 32);
+	bool ieee = formatTag == WAVE_FORMAT_IEEE_FLOAT && reader->bitsPerSample == 32;
+	if ((!pcm && !ieee) || reader->nChannels < 1 || reader->sampleRate <= 0) {
+		fprintf(stderr, "unsupported WAV format %d, %d bits, %d channels\n", formatTag, reader->bitsPerSample,
+				reader->nChannels);
+		return -1;
+	}
+	reader->isFloat = ieee;
+	return 0;
+}
+
+int openWav(WavReader_t* reader, const char* path, float rawSampleRate, int maxFrames) {
+	closeWav(reader);
+	if (strcmp(path, "-") == 0) {
+		reader->fp = stdin;
+		reader->ownsFile = false;
+	}
+	else {
+		reader->fp = fopen(path, "rb");
+		reader->ownsFile = true;
+		if (reader->fp == NULL) {
+			fprintf(stderr, "could not open %s\n", path);
+			return -1;
+		}
+	}
+
+	reader->nPending = fread(reader->pending, 1, 4, reader->fp);
+	if (reader->nPending == 4 && memcmp(reader->pending, "RIFF", 4) == 0) {
+		reader->nPending = 0;
+		if (parseWavHeader(reader) < 0) {
+			closeWav(reader);
+			return -1;
+		}
+	}
+	else {
+		reader->sampleRate = rawSampleRate;
+		reader->nChannels = 1;
+		reader->bitsPerSample = 16;
+		reader->isFloat = false;
+		reader->bytesLeft = UINT64_MAX;
+	}
+	reader->bufferFrames = maxFrames;
+	reader->buffer = new uint8_t[(size_t)maxFrames * reader->nChannels * (reader->bitsPerSample / 8)];
+	return 0;
+}
+
+/**
+ * @description: one sample as a float in [-1, 1]
+ */
+static float decodeSample(const WavReader_t* reader, const uint8_t* p) {
+	switch (reader->bitsPerSample) {
+	case 8:
+		return (p[0] - 128) / 128.0f;
+	case 16:
+		return (int16_t)readLe16(p) / 32768.0f;
+	case 24:
+		return (int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) / 2147483648.0f;
+	default:
+		if (reader->isFloat) {
+			float f;
+			memcpy(&f, p, sizeof(f));
+			return f;
+		}
+		return (int32_t)readLe32(p) / 2147483648.0f;
+	}
+}
+
+int readWav(WavReader_t* reader, float* out, int nFrames) {
+	if (reader->fp == NULL) {
+		return 0;
+	}
+	nFrames = nFrames < reader->bufferFrames ? nFrames : reader->bufferFrames;
+	int bytesPerSample = reader->bitsPerSample / 8;
+	int bytesPerFrame = reader->nChannels * bytesPerSample;
+	uint64_t wanted = (uint64_t)nFrames * bytesPerFrame;
+	wanted = wanted < reader->bytesLeft ? wanted : reader->bytesLeft;
+
+	size_t got = 0;
+	if (reader->nPending > 0) {
+		got = (size_t)reader->nPending < wanted ? reader->nPending : wanted;
+		memcpy(reader->buffer, reader->pending, got);
+		memmove(reader->pending, reader->pending + got, reader->nPending - got);
+		reader->nPending -= got;
+	}
+	while (got < wanted) {
+		size_t n = fread(reader->buffer + got, 1, wanted - got, reader->fp);
+		if (n == 0) {
+			break;
+		}
+		got += n;
+	}
+	if (reader->bytesLeft != UINT64_MAX) {
+		reader->bytesLeft -= got;
+	}
+
+	int nRead = got / bytesPerFrame;
+	float gain = 1.0f / reader->nChannels;
+	for (int i = 0; i < nRead; i++) {
+		const uint8_t* frame = reader->buffer + (size_t)i * bytesPerFrame;
+		float acc = 0;
+		for (int c = 0; c < reader->nChannels; c++) {
+			acc += decodeSample(reader, frame + c * bytesPerSample);
+		}
+		out[i] = acc * gain;
+	}
+	return nRead;
+}
+
+void closeWav(WavReader_t* reader) {
+	if (reader->fp && reader->ownsFile) {
+		fclose(reader->fp);
+	}
+	reader->fp = NULL;
+	delete [] reader->buffer;
+	reader->buffer = NULL;
+	reader->bufferFrames = 0;
+	reader->bytesLeft = 0;
+	reader->nPending = 0;
+}
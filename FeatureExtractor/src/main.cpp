@@ -0,0 +1,411 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * main.cpp
+ *
+ *  Stand-in for music_processor.py. Reads PCM from a WAV file or stdin, extracts the energy, fft
+ *  bins, beat, onset and tempo of every hop, and sends them to the simulator on port 27182, publishes
+ *  them in a shared memory ring for PluginHost -S, writes them as a trace that PluginHost replays, or
+ *  prints them. Without pacing it runs as fast as the
+ *  extraction allows and reports how many times faster than real time that is.
+ *
+ *  With -u -w it answers both kinds of request on port 27184: the "b i b" text of the simulator, after
+ *  which it sends the bare packets of music_processor.py, and the binary request of FeatureProtocol.h,
+ *  after which it streams versioned frames to the socket that asked. A consumer that asks again later,
+ *  e.g. PluginHost -U for its next plugin, gets the same bins and the stream moves to it.
+ */
+
+#include "FeatureExtractor.h"
+#include "WavReader.h"
+#include "LatencyHistogram.h"
+#include "FeatureRing.h"
+#include "FeatureProtocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define SOUND_FEATURE_HOST "127.0.0.1"
+#define SOUND_FEATURE_DATA_PORT 27182		/*the simulator receives features on this port*/
+#define SOUND_FEATURE_REQUEST_PORT FEATURE_PROTOCOL_REQUEST_PORT	/*the simulator sends its "b i b" request here*/
+#define DEFAULT_N_FFT_BINS 32
+#define DEFAULT_RAW_SAMPLE_RATE 44100
+#define SOUND_FRAME_INTERVAL_MS 50			/*music_processor.py sends at most one packet every 50ms*/
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_MS 1000000ULL
+
+struct ExtractorConfig_t {
+	const char* inputPath;
+	const char* tracePath;
+	const char* ringName;	/*NULL to not publish to shared memory*/
+	float rawSampleRate;
+	int nFftBins;
+	bool udp;
+	bool waitForRequest;
+	int intervalMs;			/*-1 for the default of the output*/
+	bool verbose;
+};
+
+/**
+ * A request on the request port, in either protocol
+ */
+struct ExtractorRequest_t {
+	bool binary;
+	FeatureCapabilities_t capabilities;	/*for a text request only the mask and bins are set*/
+	struct sockaddr_in from;
+};
+
+static uint64_t nowNs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void sleepUntilNs(uint64_t deadline) {
+	struct timespec ts;
+	ts.tv_sec = deadline / NS_PER_SEC;
+	ts.tv_nsec = deadline % NS_PER_SEC;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+	}
+}
+
+static void usage(const char* name) {
+	fprintf(stderr,
+			"usage: %s [options] input.wav|-\n"
+			"  -s hz     sample rate of raw signed 16 bit mono input (default %d)\n"
+			"  -k N      number of fft bins, 1 to %d (default %d)\n"
+			"  -u        send the features to %s:%d like music_processor.py\n"
+			"  -w        with -u, first wait for the request of the simulator or PluginHost -U on port %d\n"
+			"  -m name   publish the features in the shared memory ring name, - for %s\n"
+			"  -r ms     time between hops, 0 for as fast as possible (default %d with -u or -m, otherwise 0)\n"
+			"  -t file   write the features as a trace for PluginHost -t\n"
+			"  -v        print the features of every hop\n",
+			name, DEFAULT_RAW_SAMPLE_RATE, FEATURE_MAX_FFT_BINS, DEFAULT_N_FFT_BINS, SOUND_FEATURE_HOST,
+			SOUND_FEATURE_DATA_PORT, SOUND_FEATURE_REQUEST_PORT, FEATURE_RING_DEFAULT_NAME, SOUND_FRAME_INTERVAL_MS);
+}
+
+/**
+ * @description: open the port that the simulator sends its "b i b" request to
+ * @return: the socket, or -1 on failure
+ */
+static int openRequestSocket() {
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return -1;
+	}
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(SOUND_FEATURE_REQUEST_PORT);
+	inet_pton(AF_INET, SOUND_FEATURE_HOST, &local.sin_addr);
+	if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+		perror("bind");
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+/**
+ * @description: read a binary request, or the "b i b" request (fft enabled, number of bins, energy
+ * enabled) that the simulator sends to music_processor.py
+ * @params flags: MSG_DONTWAIT to only look for a request that already arrived
+ * @return: 1 if a request was read, 0 if there was none, -1 on failure
+ */
+static int readRequest(int sock, int flags, ExtractorRequest_t* request) {
+	uint8_t buffer[FEATURE_PROTOCOL_MAX_DATAGRAM + 1];	/*a newer consumer may send a longer request*/
+	socklen_t fromLength = sizeof(request->from);
+	ssize_t n = recvfrom(sock, buffer, sizeof(buffer) - 1, flags, (struct sockaddr*)&request->from, &fromLength);
+	if (n < 0) {
+		if (flags & MSG_DONTWAIT) {
+			return 0;
+		}
+		perror("recv");
+		return -1;
+	}
+	int type;
+	int err = decodeFeatureCapabilities(buffer, n, &type, &request->capabilities);
+	if (err == FEATURE_PROTOCOL_OK && type == FEATURE_MESSAGE_REQUEST) {
+		request->binary = true;
+		return 1;
+	}
+	if (err != FEATURE_PROTOCOL_NOT_OURS) {
+		fprintf(stderr, "malformed binary request, error %d\n", err);
+		return -1;
+	}
+	buffer[n] = '\0';
+	int fft, bins, energy;
+	if (sscanf((const char*)buffer, "%d %d %d", &fft, &bins, &energy) != 3) {
+		fprintf(stderr, "malformed request \"%s\"\n", (const char*)buffer);
+		return -1;
+	}
+	request->binary = false;
+	request->capabilities.featureMask = (fft ? FEATURE_MASK_FFT : 0) | (energy ? FEATURE_MASK_ENERGY : 0);
+	request->capabilities.nFftBins = bins;
+	request->capabilities.intervalMs = 0;
+	return 1;
+}
+
+/**
+ * @description: answer a binary request with what will be sent
+ */
+static void acceptRequest(int sock, const ExtractorRequest_t* request, const FeatureCapabilities_t* granted) {
+	uint8_t accept[FEATURE_PROTOCOL_PREFIX_BYTES + FEATURE_CAPABILITIES_BYTES];
+	int length = encodeFeatureCapabilities(FEATURE_MESSAGE_ACCEPT, granted, accept, sizeof(accept));
+	if (sendto(sock, accept, length, 0, (struct sockaddr*)&request->from, sizeof(request->from)) < 0) {
+		perror("sendto");
+	}
+}
+
+int main(int argc, char** argv) {
+	ExtractorConfig_t config;
+	config.inputPath = NULL;
+	config.tracePath = NULL;
+	config.ringName = NULL;
+	config.rawSampleRate = DEFAULT_RAW_SAMPLE_RATE;
+	config.nFftBins = DEFAULT_N_FFT_BINS;
+	config.udp = false;
+	config.waitForRequest = false;
+	config.intervalMs = -1;
+	config.verbose = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "s:k:uwm:r:t:v")) != -1) {
+		switch (opt) {
+		case 's': config.rawSampleRate = atof(optarg); break;
+		case 'k': config.nFftBins = atoi(optarg); break;
+		case 'u': config.udp = true; break;
+		case 'w': config.waitForRequest = true; break;
+		case 'm': config.ringName = strcmp(optarg, "-") ? optarg : FEATURE_RING_DEFAULT_NAME; break;
+		case 'r': config.intervalMs = atoi(optarg); break;
+		case 't': config.tracePath = optarg; break;
+		case 'v': config.verbose = true; break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	config.inputPath = argv[optind];
+	bool intervalGiven = config.intervalMs >= 0;
+	if (!intervalGiven) {
+		config.intervalMs = config.udp || config.ringName ? SOUND_FRAME_INTERVAL_MS : 0;
+	}
+
+	bool fftEnabled = true;
+	bool energyEnabled = true;
+	int requestSock = -1;
+	ExtractorRequest_t request;
+	FeatureCapabilities_t granted;
+	memset(&granted, 0, sizeof(granted));
+	if (config.udp && config.waitForRequest) {
+		requestSock = openRequestSocket();
+		if (requestSock < 0) {
+			return 1;
+		}
+		fprintf(stderr, "waiting for a request on port %d\n", SOUND_FEATURE_REQUEST_PORT);
+		if (readRequest(requestSock, 0, &request) < 0) {
+			return 1;
+		}
+		fftEnabled = request.capabilities.featureMask & FEATURE_MASK_FFT;
+		energyEnabled = request.capabilities.featureMask & FEATURE_MASK_ENERGY;
+		if (fftEnabled || !request.binary) {
+			config.nFftBins = request.capabilities.nFftBins;
+		}
+		if (request.binary) {
+			// grant what is known, bins that fit and the interval asked for unless -r set one
+			granted.featureMask = request.capabilities.featureMask & FEATURE_MASK_KNOWN;
+			if (config.nFftBins < 1) {
+				config.nFftBins = 1;
+			} else if (config.nFftBins > FEATURE_MAX_FFT_BINS) {
+				config.nFftBins = FEATURE_MAX_FFT_BINS;
+			}
+			if (!intervalGiven && request.capabilities.intervalMs > 0) {
+				config.intervalMs = request.capabilities.intervalMs;
+			}
+			granted.nFftBins = fftEnabled ? config.nFftBins : 0;
+			granted.intervalMs = config.intervalMs;
+			acceptRequest(requestSock, &request, &granted);
+		} else {
+			close(requestSock);
+			requestSock = -1;
+		}
+	}
+
+	WavReader_t reader;
+	if (openWav(&reader, config.inputPath, config.rawSampleRate, FEATURE_HOP_SAMPLES) < 0) {
+		return 1;
+	}
+	FeatureExtractor_t extractor;
+	if (initFeatureExtractor(&extractor, reader.sampleRate, config.nFftBins) < 0) {
+		fprintf(stderr, "the number of fft bins must be between 1 and %d\n", FEATURE_MAX_FFT_BINS);
+		return 1;
+	}
+	fprintf(stderr, "%s: %.0f Hz, %d channels, %d bits%s, %d fft bins\n", config.inputPath, reader.sampleRate,
+			reader.nChannels, reader.bitsPerSample, reader.isFloat ? " float" : "", config.nFftBins);
+
+	int sock = -1;
+	struct sockaddr_in remote;
+	if (config.udp) {
+		sock = socket(AF_INET, SOCK_DGRAM, 0);
+		if (sock < 0) {
+			perror("socket");
+			return 1;
+		}
+		memset(&remote, 0, sizeof(remote));
+		remote.sin_family = AF_INET;
+		remote.sin_port = htons(SOUND_FEATURE_DATA_PORT);
+		inet_pton(AF_INET, SOUND_FEATURE_HOST, &remote.sin_addr);
+		if (requestSock >= 0) {
+			remote = request.from;
+		}
+	}
+	FeatureRing_t ring;
+	ring.shared = NULL;
+	if (config.ringName && createFeatureRing(&ring, config.ringName) < 0) {
+		return 1;
+	}
+	FILE* trace = NULL;
+	if (config.tracePath) {
+		trace = fopen(config.tracePath, "w");
+		if (trace == NULL) {
+			fprintf(stderr, "could not write %s\n", config.tracePath);
+			return 1;
+		}
+		fprintf(trace, "# %s, %d fft bins\n", config.inputPath, config.nFftBins);
+	}
+
+	float samples[FEATURE_HOP_SAMPLES];
+	uint8_t packet[FEATURE_PROTOCOL_MAX_BYTES];
+	uint32_t nSent = 0;
+	FeatureRingFrame_t ringFrame;
+	memset(&ringFrame, 0, sizeof(ringFrame));
+	uint8_t zeroBins[FEATURE_MAX_FFT_BINS];
+	memset(zeroBins, 0, sizeof(zeroBins));
+	LatencyHistogram hopLatency;
+	uint64_t period = (uint64_t)config.intervalMs * NS_PER_MS;
+	uint64_t deadline = nowNs();
+	uint64_t wallStart = deadline;
+	uint64_t nBeats = 0;
+	uint64_t nOnsets = 0;
+	float tempo = 0;
+
+	int n;
+	while ((n = readWav(&reader, samples, FEATURE_HOP_SAMPLES)) > 0) {
+		// when paced, the audio of the hop is taken to arrive at the deadline
+		if (period) {
+			deadline += period;
+			sleepUntilNs(deadline);
+		}
+		// the last hop is padded with silence
+		memset(samples + n, 0, (FEATURE_HOP_SAMPLES - n) * sizeof(float));
+		FeatureFrame_t frame;
+		uint64_t start = nowNs();
+		processFeatureHop(&extractor, samples, &frame);
+		hopLatency.record(nowNs() - start);
+		if (!fftEnabled) {
+			frame.fftBins = zeroBins;
+		}
+		if (!energyEnabled) {
+			frame.energy = 0;
+		}
+		nBeats += frame.beat;
+		nOnsets += frame.onset;
+		tempo = frame.tempo;
+
+		if (requestSock >= 0 && readRequest(requestSock, MSG_DONTWAIT, &request) > 0 && request.binary) {
+			acceptRequest(requestSock, &request, &granted);
+			remote = request.from;
+		}
+		if (sock >= 0) {
+			int length;
+			if (requestSock >= 0) {
+				FeaturePacket_t message;
+				memset(&message, 0, sizeof(message));
+				message.sequence = nSent++;
+				message.featureMask = granted.featureMask;
+				message.captureNs = start;
+				message.energy = frame.energy;
+				message.nFftBins = granted.nFftBins;
+				message.fftBins = frame.fftBins;
+				message.beat = frame.beat;
+				message.onset = frame.onset;
+				message.tempo = frame.tempo;
+				message.beatPhase = frame.beatPhase;
+				message.beatConfidence = frame.beatConfidence;
+				length = encodeFeaturePacket(&message, packet, sizeof(packet));
+			} else {
+				length = packFeaturePacket(&frame, packet);
+			}
+			if (sendto(sock, packet, length, 0, (struct sockaddr*)&remote, sizeof(remote)) < 0) {
+				perror("sendto");
+			}
+		}
+		if (ring.shared) {
+			ringFrame.captureNs = start;
+			ringFrame.energy = frame.energy;
+			ringFrame.nFftBins = frame.nFftBins;
+			ringFrame.beat = frame.beat;
+			ringFrame.onset = frame.onset;
+			ringFrame.tempo = frame.tempo;
+			ringFrame.beatPhase = frame.beatPhase;
+			ringFrame.beatConfidence = frame.beatConfidence;
+			memcpy(ringFrame.fftBins, frame.fftBins, frame.nFftBins);
+			publishFeatureFrame(&ring, &ringFrame);
+		}
+		if (trace) {
+			fprintf(trace, "%u", frame.energy);
+			for (int i = 0; i < frame.nFftBins; i++) {
+				fprintf(trace, " %u", frame.fftBins[i]);
+			}
+			fprintf(trace, "\n");
+		}
+		if (config.verbose) {
+			printf("%6llu energy %5u beat %d onset %d tempo %5.1f phase %.2f confidence %.2f\n",
+					(unsigned long long)extractor.nHops, frame.energy, frame.beat, frame.onset, frame.tempo, frame.beatPhase,
+					frame.beatConfidence);
+		}
+	}
+	uint64_t wallNs = nowNs() - wallStart;
+
+	if (trace) {
+		fclose(trace);
+	}
+	if (sock >= 0) {
+		close(sock);
+	}
+	if (requestSock >= 0) {
+		close(requestSock);
+	}
+	closeFeatureRing(&ring);
+
+	double audioSec = (double)extractor.nHops * FEATURE_HOP_SAMPLES / reader.sampleRate;
+	double wallSec = wallNs / (double)NS_PER_SEC;
+	fprintf(stderr, "%llu hops, %.1f s of audio in %.3f s, %.0fx real time\n", (unsigned long long)extractor.nHops,
+			audioSec, wallSec, wallSec > 0 ? audioSec / wallSec : 0);
+	fprintf(stderr, "hop latency p50 %.1f us, p99 %.1f us, max %.1f us\n", hopLatency.getPercentile(0.5) / 1e3,
+			hopLatency.getPercentile(0.99) / 1e3, hopLatency.getMax() / 1e3);
+	fprintf(stderr, "%llu beats, %llu onsets, tempo %.1f bpm\n", (unsigned long long)nBeats,
+			(unsigned long long)nOnsets, tempo);
+	return 0;
+}
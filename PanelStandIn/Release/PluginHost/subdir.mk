@@ -0,0 +1,29 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../../PluginHost/src/FeatureProtocol.cpp \
+../../PluginHost/src/LatencyHistogram.cpp \
+../../PluginHost/src/PanelStream.cpp 
+
+OBJS += \
+./PluginHost/FeatureProtocol.o \
+./PluginHost/LatencyHistogram.o \
+./PluginHost/PanelStream.o 
+
+CPP_DEPS += \
+./PluginHost/FeatureProtocol.d \
+./PluginHost/LatencyHistogram.d \
+./PluginHost/PanelStream.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+PluginHost/%.o: ../../PluginHost/src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../../PluginHost/inc -O3 -g -Wall -c -fmessage-length=0 -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
@@ -0,0 +1,300 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * main.cpp
+ *
+ *  Stand-in for the panel controllers that PluginHost -D streams frames to. Receives the packets of
+ *  every device on one port with recvmmsg and reports, every interval and at the end, the packets,
+ *  bytes and panel frames per second, the packets lost and reordered per device from their sequence
+ *  numbers, the latency from the send time in the header, and the jitter of the arrivals.
+ *
+ *  The jitter is the estimator of RFC 3550: for every packet of a device, D is how much later or
+ *  earlier it arrived relative to its predecessor than it was sent, and J moves by (|D| - J) / 16.
+ *  Sender and receiver read the same CLOCK_MONOTONIC, so the latency is one way.
+ */
+
+#include "PanelStream.h"
+#include "FeatureProtocol.h"
+#include "LatencyHistogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define DEFAULT_BATCH 64
+#define DEFAULT_REPORT_MS 1000
+#define DEFAULT_IDLE_MS 2000			/*stop when nothing arrived for this long after the first packet*/
+#define RECEIVE_BUFFER_BYTES (8 << 20)
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_MS 1000000ULL
+
+struct StandInConfig_t {
+	int port;
+	int batchSize;
+	int reportMs;
+	int idleMs;
+};
+
+/**
+ * Sequence numbers and arrival times of one device
+ */
+struct DeviceStats_t {
+	bool seen;
+	FeatureSequence_t sequence;		/*counts lost and late packets the same way as for features*/
+	uint64_t lastSendNs;
+	uint64_t lastArrivalNs;
+	double jitterNs;
+};
+
+struct StreamTotals_t {
+	uint64_t nPackets;
+	uint64_t nBytes;
+	uint64_t nFrames;
+	uint64_t nMalformed;
+	LatencyHistogram latency;		/*send to arrival*/
+	LatencyHistogram deviation;		/*|D| of every packet after the first of its device*/
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+	stopRequested = 1;
+}
+
+static uint64_t nowNs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void usage(const char* name) {
+	fprintf(stderr,
+			"usage: %s [options]\n"
+			"  -p port   port to receive on (default %d)\n"
+			"  -b N      packets per recvmmsg, 1 to %d (default %d)\n"
+			"  -i ms     time between reports, 0 for only the final one (default %d)\n"
+			"  -t ms     stop when nothing arrived for this long (default %d)\n",
+			name, PANEL_STREAM_PORT, PANEL_STREAM_MAX_BATCH, DEFAULT_BATCH, DEFAULT_REPORT_MS, DEFAULT_IDLE_MS);
+}
+
+/**
+ * @description: account for one packet
+ */
+static void receivePacket(const uint8_t* buffer, int length, uint64_t arrivalNs, DeviceStats_t* devices,
+		StreamTotals_t* totals) {
+	PanelHeader_t header;
+	if (decodePanelHeader(buffer, length, &header) != PANEL_STREAM_OK || header.device >= PANEL_STREAM_MAX_DEVICES) {
+		totals->nMalformed++;
+		return;
+	}
+	totals->nPackets++;
+	totals->nBytes += length;
+	totals->nFrames += header.nFrames;
+	totals->latency.record(arrivalNs > header.sendNs ? arrivalNs - header.sendNs : 0);
+
+	DeviceStats_t* device = &devices[header.device];
+	if (!device->seen) {
+		device->seen = true;
+		resetFeatureSequence(&device->sequence);
+	}
+	else {
+		int64_t d = (int64_t)(arrivalNs - device->lastArrivalNs) - (int64_t)(header.sendNs - device->lastSendNs);
+		uint64_t magnitude = d < 0 ? -d : d;
+		totals->deviation.record(magnitude);
+		device->jitterNs += (magnitude - device->jitterNs) / 16;
+	}
+	device->lastSendNs = header.sendNs;
+	device->lastArrivalNs = arrivalNs;
+	trackFeatureSequence(&device->sequence, header.sequence);
+}
+
+/**
+ * @description: print the counts since the last report, and the latency, deviation and jitter so far
+ * @params since: totals at the last report, set to the current ones
+ */
+static void printReport(const char* label, uint64_t elapsedNs, const DeviceStats_t* devices, const StreamTotals_t* totals,
+		StreamTotals_t* since) {
+	int nDevices = 0;
+	uint64_t nLost = 0;
+	uint64_t nLate = 0;
+	uint64_t nDuplicate = 0;
+	double jitterSum = 0;
+	double jitterMax = 0;
+	for (int d = 0; d < PANEL_STREAM_MAX_DEVICES; d++) {
+		if (devices[d].seen) {
+			nDevices++;
+			nLost += devices[d].sequence.nLost;
+			nLate += devices[d].sequence.nLate;
+			nDuplicate += devices[d].sequence.nDuplicate;
+			jitterSum += devices[d].jitterNs;
+			if (devices[d].jitterNs > jitterMax) {
+				jitterMax = devices[d].jitterNs;
+			}
+		}
+	}
+	double seconds = elapsedNs / (double)NS_PER_SEC;
+	uint64_t nPackets = totals->nPackets - since->nPackets;
+	uint64_t nBytes = totals->nBytes - since->nBytes;
+	uint64_t nFrames = totals->nFrames - since->nFrames;
+	const LatencyHistogram& l = totals->latency;
+	const LatencyHistogram& v = totals->deviation;
+	printf("%s: %d devices, %.0f packets/s, %.2f MB/s, %.0f panel frames/s, %llu lost, %llu late, %llu duplicate, %llu malformed\n",
+			label, nDevices, seconds > 0 ? nPackets / seconds : 0.0, seconds > 0 ? nBytes / seconds / 1e6 : 0.0,
+			seconds > 0 ? nFrames / seconds : 0.0, (unsigned long long)nLost, (unsigned long long)nLate,
+			(unsigned long long)nDuplicate, (unsigned long long)totals->nMalformed);
+	printf("  latency us p50 %.1f p99 %.1f max %.1f, deviation us p50 %.1f p99 %.1f, jitter us mean %.1f max %.1f\n",
+			l.getPercentile(0.50) / 1e3, l.getPercentile(0.99) / 1e3, l.getMax() / 1e3, v.getPercentile(0.50) / 1e3,
+			v.getPercentile(0.99) / 1e3, nDevices ? jitterSum / nDevices / 1e3 : 0.0, jitterMax / 1e3);
+	fflush(stdout);
+	since->nPackets = totals->nPackets;
+	since->nBytes = totals->nBytes;
+	since->nFrames = totals->nFrames;
+}
+
+int main(int argc, char** argv) {
+	StandInConfig_t config;
+	config.port = PANEL_STREAM_PORT;
+	config.batchSize = DEFAULT_BATCH;
+	config.reportMs = DEFAULT_REPORT_MS;
+	config.idleMs = DEFAULT_IDLE_MS;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:b:i:t:h")) != -1) {
+		switch (opt) {
+		case 'p': config.port = atoi(optarg); break;
+		case 'b': config.batchSize = atoi(optarg); break;
+		case 'i': config.reportMs = atoi(optarg); break;
+		case 't': config.idleMs = atoi(optarg); break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+	if (optind != argc || config.batchSize < 1 || config.batchSize > PANEL_STREAM_MAX_BATCH || config.idleMs < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return 1;
+	}
+	// a burst of many devices arrives at once, give the kernel room to hold it
+	int bufferBytes = RECEIVE_BUFFER_BYTES;
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(config.port);
+	local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+		perror("bind");
+		close(sock);
+		return 1;
+	}
+
+	// SIGINT interrupts poll instead of restarting it, so the final report is still printed
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onSignal;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	uint8_t* buffers = (uint8_t*)malloc((size_t)config.batchSize * PANEL_STREAM_MAX_BYTES);
+	struct iovec* iov = (struct iovec*)calloc(config.batchSize, sizeof(struct iovec));
+	struct mmsghdr* messages = (struct mmsghdr*)calloc(config.batchSize, sizeof(struct mmsghdr));
+	DeviceStats_t* devices = (DeviceStats_t*)calloc(PANEL_STREAM_MAX_DEVICES, sizeof(DeviceStats_t));
+	StreamTotals_t* totals = new StreamTotals_t();
+	StreamTotals_t* since = new StreamTotals_t();
+	if (buffers == NULL || iov == NULL || messages == NULL || devices == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (int i = 0; i < config.batchSize; i++) {
+		iov[i].iov_base = buffers + (size_t)i * PANEL_STREAM_MAX_BYTES;
+		iov[i].iov_len = PANEL_STREAM_MAX_BYTES;
+		messages[i].msg_hdr.msg_iov = &iov[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	fprintf(stderr, "waiting for frames on port %d\n", config.port);
+	uint64_t firstNs = 0;
+	uint64_t lastNs = 0;
+	uint64_t reportNs = 0;
+	uint64_t nSyscalls = 0;
+	while (!stopRequested) {
+		int timeoutMs = config.reportMs > 0 && config.reportMs < config.idleMs ? config.reportMs : config.idleMs;
+		struct pollfd pfd;
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		int ready = poll(&pfd, 1, firstNs ? timeoutMs : -1);
+		if (ready < 0 && errno != EINTR) {
+			perror("poll");
+			break;
+		}
+		uint64_t now = nowNs();
+		if (ready > 0) {
+			// drain everything that is queued before looking at the clock again
+			while (true) {
+				int n = recvmmsg(sock, messages, config.batchSize, MSG_DONTWAIT, NULL);
+				if (n <= 0) {
+					break;
+				}
+				nSyscalls++;
+				uint64_t arrivalNs = nowNs();
+				for (int i = 0; i < n; i++) {
+					receivePacket((const uint8_t*)iov[i].iov_base, messages[i].msg_len, arrivalNs, devices, totals);
+				}
+			}
+			now = nowNs();
+			if (firstNs == 0) {
+				firstNs = now;
+				reportNs = now;
+			}
+			lastNs = now;
+		}
+		if (firstNs && config.reportMs > 0 && now - reportNs >= (uint64_t)config.reportMs * NS_PER_MS) {
+			char label[32];
+			snprintf(label, sizeof(label), "%6.1f s", (now - firstNs) / (double)NS_PER_SEC);
+			printReport(label, now - reportNs, devices, totals, since);
+			reportNs = now;
+		}
+		if (firstNs && now - lastNs >= (uint64_t)config.idleMs * NS_PER_MS) {
+			break;
+		}
+	}
+
+	if (firstNs) {
+		StreamTotals_t* none = new StreamTotals_t();
+		printReport("total", lastNs - firstNs, devices, totals, none);
+		printf("  %.1f packets per recvmmsg\n", nSyscalls ? (double)totals->nPackets / nSyscalls : 0.0);
+		delete none;
+	}
+	delete totals;
+	delete since;
+	free(devices);
+	free(messages);
+	free(iov);
+	free(buffers);
+	close(sock);
+	return 0;
+}
@@ -0,0 +1,26 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../../PluginUtilities/src/FrameDiffer.cpp \
+../../PluginUtilities/src/PackedFrame.cpp 
+
+OBJS += \
+./PluginUtilities/FrameDiffer.o \
+./PluginUtilities/PackedFrame.o 
+
+CPP_DEPS += \
+./PluginUtilities/FrameDiffer.d \
+./PluginUtilities/PackedFrame.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+PluginUtilities/%.o: ../../PluginUtilities/src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../inc -O2 -g -Wall -c -fmessage-length=0 -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
@@ -0,0 +1,50 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/FeatureChecks.cpp \
+../src/FeatureProtocol.cpp \
+../src/FeatureReceiver.cpp \
+../src/FeatureRing.cpp \
+../src/FeatureTrace.cpp \
+../src/LatencyHistogram.cpp \
+../src/LayoutGenerator.cpp \
+../src/PanelStream.cpp \
+../src/PluginHost.cpp \
+../src/main.cpp 
+
+OBJS += \
+./src/FeatureChecks.o \
+./src/FeatureProtocol.o \
+./src/FeatureReceiver.o \
+./src/FeatureRing.o \
+./src/FeatureTrace.o \
+./src/LatencyHistogram.o \
+./src/LayoutGenerator.o \
+./src/PanelStream.o \
+./src/PluginHost.o \
+./src/main.o 
+
+CPP_DEPS += \
+./src/FeatureChecks.d \
+./src/FeatureProtocol.d \
+./src/FeatureReceiver.d \
+./src/FeatureRing.d \
+./src/FeatureTrace.d \
+./src/LatencyHistogram.d \
+./src/LayoutGenerator.d \
+./src/PanelStream.d \
+./src/PluginHost.d \
+./src/main.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/%.o: ../src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../inc -O2 -g -Wall -c -fmessage-length=0 -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
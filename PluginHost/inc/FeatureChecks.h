@@ -0,0 +1,46 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureChecks.h
+ *
+ *  Self checks of the ways features reach the host, run by PluginHost -X. They exercise the real
+ *  code under the conditions a plugin run rarely meets, and print one line per check.
+ */
+
+#ifndef INC_FEATURECHECKS_H_
+#define INC_FEATURECHECKS_H_
+
+#define FEATURE_CHECK_RING_READERS 3
+
+/**
+ * @description: fork a producer that publishes into a private feature ring as fast as it can and
+ * FEATURE_CHECK_RING_READERS readers that copy frames out of it for the given time. Every frame carries
+ * a checksum of its contents, a reader that copies a frame whose checksum does not match saw a torn frame
+ * @params seconds: how long the producer and the readers run
+ * @return: 0 if no reader saw a torn frame, -1 otherwise or if a process could not be started
+ */
+int checkFeatureRing(double seconds);
+
+/**
+ * @description: encode and decode feature protocol messages: every combination of the mask bits, messages
+ * cut short or with a wrong magic or version, headers and payloads longer than this version writes, and
+ * sequence numbers that wrap at 2^32, arrive late or arrive twice
+ * @return: 0 if every check passed, -1 otherwise
+ */
+int checkFeatureProtocol();
+
+#endif /* INC_FEATURECHECKS_H_ */
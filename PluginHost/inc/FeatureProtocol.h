@@ -0,0 +1,149 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureProtocol.h
+ *
+ *  Binary protocol for sound features over UDP, replacing the "b i b" text request and the bare
+ *  bins + energy packets of music_processor.py. Every message starts with the same 8 bytes: a magic,
+ *  the protocol version, the message type, the header length and the payload length. All fields are
+ *  little endian.
+ *
+ *  A consumer sends FEATURE_MESSAGE_REQUEST with the features, bins and interval it would like to the
+ *  request port, from the socket it wants the features on. The producer answers FEATURE_MESSAGE_ACCEPT
+ *  with what it will actually send and then streams FEATURE_MESSAGE_FRAME messages to that socket:
+ *
+ *  	offset  0  uint16 magic, uint8 version, uint8 type, uint16 header bytes, uint16 payload bytes
+ *  	offset  8  uint32 sequence, counting frames from 0 and wrapping
+ *  	offset 12  uint32 feature mask, the FEATURE_MASK_ bits of the fields in the payload
+ *  	offset 16  uint64 capture time, CLOCK_MONOTONIC ns of the producer
+ *  	offset 24  uint16 number of fft bins, uint8 FEATURE_FLAG_ bits, uint8 reserved
+ *  	offset 28  payload: the fields of the mask, lowest bit first
+ *
+ *  A decoder skips header bytes it does not know and payload fields of mask bits it does not know,
+ *  as long as they come after the ones it does, so a producer can add fields without a new version.
+ *  The version only changes when a field that exists changes. The capture time is only comparable on
+ *  the machine of the producer.
+ */
+
+#ifndef INC_FEATUREPROTOCOL_H_
+#define INC_FEATUREPROTOCOL_H_
+
+#include <stdint.h>
+
+#define FEATURE_PROTOCOL_REQUEST_PORT 27184	/*where producers listen for requests, as for "b i b"*/
+#define FEATURE_PROTOCOL_MAGIC 0x4641		/*"AF"*/
+#define FEATURE_PROTOCOL_VERSION 1
+#define FEATURE_PROTOCOL_PREFIX_BYTES 8		/*magic, version, type and the two lengths*/
+#define FEATURE_FRAME_HEADER_BYTES 28
+#define FEATURE_CAPABILITIES_BYTES 8
+#define FEATURE_PROTOCOL_MAX_BINS 256
+#define FEATURE_PROTOCOL_MAX_BYTES (FEATURE_FRAME_HEADER_BYTES + 2 + FEATURE_PROTOCOL_MAX_BINS + 12)
+#define FEATURE_PROTOCOL_MAX_DATAGRAM 65536	/*receive buffers, a newer producer may send longer headers and payloads*/
+
+#define FEATURE_MESSAGE_REQUEST 1
+#define FEATURE_MESSAGE_ACCEPT 2
+#define FEATURE_MESSAGE_FRAME 3
+
+#define FEATURE_MASK_ENERGY 0x1			/*uint16 energy*/
+#define FEATURE_MASK_FFT 0x2				/*one uint8 per fft bin*/
+#define FEATURE_MASK_BEAT 0x4				/*float32 tempo, beat phase and beat confidence, and the flags*/
+#define FEATURE_MASK_KNOWN (FEATURE_MASK_ENERGY | FEATURE_MASK_FFT | FEATURE_MASK_BEAT)
+
+#define FEATURE_FLAG_BEAT 0x1
+#define FEATURE_FLAG_ONSET 0x2
+
+#define FEATURE_PROTOCOL_OK 0
+#define FEATURE_PROTOCOL_TRUNCATED -1		/*shorter than its header says*/
+#define FEATURE_PROTOCOL_NOT_OURS -2		/*wrong magic, e.g. a "b i b" text request*/
+#define FEATURE_PROTOCOL_BAD_VERSION -3
+#define FEATURE_PROTOCOL_BAD_TYPE -4
+#define FEATURE_PROTOCOL_TOO_LARGE -5		/*does not fit the buffer, or more than FEATURE_PROTOCOL_MAX_BINS bins*/
+
+/**
+ * What a consumer asks for, and what the producer grants
+ */
+struct FeatureCapabilities_t {
+	uint32_t featureMask;
+	uint16_t nFftBins;
+	uint16_t intervalMs;		/*time between frames*/
+};
+
+struct FeaturePacket_t {
+	uint32_t sequence;
+	uint32_t featureMask;		/*the fields below that are valid*/
+	uint64_t captureNs;
+	uint16_t energy;
+	uint16_t nFftBins;
+	const uint8_t* fftBins;		/*points into the decoded buffer*/
+	bool beat;
+	bool onset;
+	float tempo;
+	float beatPhase;
+	float beatConfidence;
+};
+
+/**
+ * Loss and reordering of the frames of one producer, from their sequence numbers
+ */
+struct FeatureSequence_t {
+	bool started;
+	uint32_t next;				/*sequence expected next*/
+	uint64_t nReceived;
+	uint64_t nLost;				/*skipped over, reduced again when a late one turns up*/
+	uint64_t nLate;				/*arrived after a newer frame*/
+	uint64_t nDuplicate;		/*the newest frame again*/
+};
+
+/**
+ * @description: write a request or accept message
+ * @params type: FEATURE_MESSAGE_REQUEST or FEATURE_MESSAGE_ACCEPT
+ * @return: the length of the message, or FEATURE_PROTOCOL_TOO_LARGE if it does not fit in size bytes
+ */
+int encodeFeatureCapabilities(int type, const FeatureCapabilities_t* capabilities, uint8_t* buffer, int size);
+
+/**
+ * @description: read a request or accept message
+ * @params type: receives the type of the message
+ * @return: FEATURE_PROTOCOL_OK or one of the errors
+ */
+int decodeFeatureCapabilities(const uint8_t* buffer, int length, int* type, FeatureCapabilities_t* capabilities);
+
+/**
+ * @description: write a frame message with the fields in packet->featureMask
+ * @return: the length of the message, or FEATURE_PROTOCOL_TOO_LARGE
+ */
+int encodeFeaturePacket(const FeaturePacket_t* packet, uint8_t* buffer, int size);
+
+/**
+ * @description: read a frame message. Fields the message does not have are cleared and their bits are
+ * not set in packet->featureMask
+ * @return: FEATURE_PROTOCOL_OK or one of the errors
+ */
+int decodeFeaturePacket(const uint8_t* buffer, int length, FeaturePacket_t* packet);
+
+/**
+ * @description: start counting a new stream of frames
+ */
+void resetFeatureSequence(FeatureSequence_t* sequence);
+
+/**
+ * @description: account for the sequence number of a received frame, in 32 bit serial arithmetic
+ * @return: true if it is newer than every frame before, false for a late or duplicate one
+ */
+bool trackFeatureSequence(FeatureSequence_t* sequence, uint32_t number);
+
+#endif /* INC_FEATUREPROTOCOL_H_ */
@@ -0,0 +1,68 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureReceiver.h
+ *
+ *  Consumer side of the binary feature protocol. The receiver asks a producer on the local machine
+ *  for features, then on every call drains whatever frames arrived and keeps the newest one. Frames
+ *  that arrive after a newer one, and frames older than the maximum age, are dropped instead of being
+ *  rendered, and counted.
+ */
+
+#ifndef INC_FEATURERECEIVER_H_
+#define INC_FEATURERECEIVER_H_
+
+#include "FeatureProtocol.h"
+#include <netinet/in.h>
+
+struct FeatureReceiver_t {
+	int sock;
+	struct sockaddr_in producer;		/*request port of the producer*/
+	FeatureCapabilities_t granted;
+	FeatureSequence_t sequence;
+	uint64_t maxAgeNs;
+	uint64_t nStale;					/*dropped for being older than maxAgeNs when they arrived*/
+	uint64_t nMalformed;
+	bool hasFrame;
+	FeaturePacket_t latest;				/*newest frame, its fftBins point into bins*/
+	uint8_t bins[FEATURE_PROTOCOL_MAX_BINS];
+	uint8_t buffer[FEATURE_PROTOCOL_MAX_DATAGRAM];
+};
+
+/**
+ * @description: open a socket on an ephemeral port of 127.0.0.1 for the features
+ * @params maxAgeMs: frames captured longer ago than this are dropped
+ * @return: 0 on success, -1 on failure
+ */
+int openFeatureReceiver(FeatureReceiver_t* receiver, int maxAgeMs);
+
+/**
+ * @description: send a request to the producer until it accepts, and start counting a new stream
+ * @params wanted: the features, bins and interval to ask for
+ * @return: 0 once the producer accepted, receiver->granted holds what it will send, -1 on timeout
+ */
+int requestFeatures(FeatureReceiver_t* receiver, const FeatureCapabilities_t* wanted, int timeoutMs);
+
+/**
+ * @description: read every frame that arrived, waiting up to timeoutMs if there is none
+ * @return: 1 if receiver->latest is a new frame, 0 if none arrived, -1 on a socket error
+ */
+int receiveFeatures(FeatureReceiver_t* receiver, int timeoutMs);
+
+void closeFeatureReceiver(FeatureReceiver_t* receiver);
+
+#endif /* INC_FEATURERECEIVER_H_ */
@@ -0,0 +1,122 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureRing.h
+ *
+ *  Sound features in shared memory, from one producer to any number of readers in other processes.
+ *  The producer maps a POSIX shared memory object and writes every feature frame into the next of
+ *  FEATURE_RING_SLOTS slots. A reader maps the same object read only and copies the newest frame, or
+ *  a given one, out of it with plain loads: no syscall, no socket buffer, and readers never block the
+ *  producer or each other.
+ *
+ *  Every slot is guarded by a seqlock. The producer makes the slot count odd before it writes the
+ *  frame and even again after, and a reader retries when the count was odd or changed under its copy,
+ *  so it never returns a torn frame. The ring gives a slow reader FEATURE_RING_SLOTS frames of slack
+ *  before the frame it wants is overwritten.
+ *
+ *  There is one producer at a time. The object is kept when the producer exits, and the next one
+ *  reuses it, so readers can stay attached across a restart of the producer. The sequence numbers
+ *  start again from 0 when it does.
+ */
+
+#ifndef INC_FEATURERING_H_
+#define INC_FEATURERING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FEATURE_RING_DEFAULT_NAME "/aurora-features"
+#define FEATURE_RING_SLOTS 16
+#define FEATURE_RING_MAX_BINS 256
+#define FEATURE_RING_MAGIC 0x46524e47		/*"FRNG"*/
+#define FEATURE_RING_VERSION 1
+
+#define FEATURE_RING_OK 0
+#define FEATURE_RING_EMPTY 1				/*nothing published yet, or the frame asked for is not yet*/
+#define FEATURE_RING_OVERWRITTEN 2			/*the frame asked for was overwritten by a newer one*/
+#define FEATURE_RING_BUSY 3					/*the producer kept the slot busy for every retry*/
+
+/**
+ * One frame of sound features, as published and as read back
+ */
+struct FeatureRingFrame_t {
+	uint64_t sequence;			/*number of the frame since the producer started, set by publishFeatureFrame*/
+	uint64_t captureNs;			/*CLOCK_MONOTONIC when the audio of the frame was captured*/
+	uint16_t energy;
+	uint16_t nFftBins;
+	bool beat;
+	bool onset;
+	float tempo;				/*bpm*/
+	float beatPhase;			/*0 on the beat, rising to 1 before the next*/
+	float beatConfidence;		/*0 to 1*/
+	uint8_t fftBins[FEATURE_RING_MAX_BINS];
+};
+
+struct FeatureRingShared_t;
+
+struct FeatureRing_t {
+	FeatureRingShared_t* shared;	/*the mapping, NULL when closed*/
+	size_t size;
+	bool producer;
+	uint64_t nPublished;			/*producer only, frames published so far*/
+};
+
+/**
+ * @description: create the shared memory object, or reuse it if it exists, map it for writing and
+ * reset it to no frames
+ * @params name: name of the object, starting with '/'
+ * @return: 0 on success, -1 on failure or if another producer that is still running has it
+ */
+int createFeatureRing(FeatureRing_t* ring, const char* name);
+
+/**
+ * @description: map an existing ring for reading
+ * @return: 0 on success, -1 if it does not exist or was made by an incompatible producer
+ */
+int openFeatureRing(FeatureRing_t* ring, const char* name);
+
+/**
+ * @description: unmap the ring. The shared memory object itself is kept
+ */
+void closeFeatureRing(FeatureRing_t* ring);
+
+/**
+ * @description: write a frame into the next slot and make it the newest. Never blocks
+ * @params frame: the sequence is ignored, the ring numbers the frames itself
+ * @return: the sequence number given to the frame
+ */
+uint64_t publishFeatureFrame(FeatureRing_t* ring, const FeatureRingFrame_t* frame);
+
+/**
+ * @description: number of frames published so far, the newest has this minus 1 as its sequence.
+ * A single load, for polling without copying a frame
+ */
+uint64_t getFeatureRingCount(const FeatureRing_t* ring);
+
+/**
+ * @description: copy the newest frame
+ * @return: FEATURE_RING_OK, FEATURE_RING_EMPTY or FEATURE_RING_BUSY
+ */
+int readLatestFeatureFrame(const FeatureRing_t* ring, FeatureRingFrame_t* frame);
+
+/**
+ * @description: copy the frame with the given sequence number, for readers that want every frame
+ * @return: FEATURE_RING_OK, FEATURE_RING_EMPTY, FEATURE_RING_OVERWRITTEN or FEATURE_RING_BUSY
+ */
+int readFeatureFrame(const FeatureRing_t* ring, uint64_t sequence, FeatureRingFrame_t* frame);
+
+#endif /* INC_FEATURERING_H_ */
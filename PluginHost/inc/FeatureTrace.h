@@ -0,0 +1,82 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureTrace.h
+ *
+ *  A sequence of sound feature frames (energy + fft bins) that the host replays into
+ *  the PluginFeatures getters, one frame per call to getPluginFrame.
+ *
+ *  Trace files are plain text, one frame per line:
+ *  	<energy> <bin 0> <bin 1> ... <bin n-1>
+ *  Lines starting with '#' are ignored. Every line must have the same number of bins.
+ */
+
+#ifndef INC_FEATURETRACE_H_
+#define INC_FEATURETRACE_H_
+
+#include <stdint.h>
+#include <vector>
+
+struct FeatureTrace_t {
+	int nFrames;
+	int nFftBins;
+	std::vector<uint16_t> energy;	/*nFrames entries*/
+	std::vector<uint8_t> fftBins;	/*nFrames * nFftBins entries, frame major*/
+};
+
+/**
+ * @description: load a trace from a text file in the format described above
+ * @return: 0 on success, -1 if the file could not be read or is malformed
+ */
+int loadFeatureTrace(const char* path, FeatureTrace_t* trace);
+
+/**
+ * @description: write a trace in the same format loadFeatureTrace reads
+ * @return: 0 on success, -1 on failure
+ */
+int saveFeatureTrace(const char* path, const FeatureTrace_t* trace);
+
+/**
+ * @description: generate a deterministic synthetic trace: a kick on every beat at the given tempo,
+ * a decaying spectral envelope between beats and some broadband noise
+ * @params nFrames: number of frames to generate
+ * @params nFftBins: number of fft bins per frame
+ * @params bpm: tempo of the generated beats
+ * @params frameIntervalMs: time between frames, 50ms for the sound module
+ * @params seed: seed for the noise
+ */
+void generateFeatureTrace(FeatureTrace_t* trace, int nFrames, int nFftBins, float bpm, int frameIntervalMs, unsigned int seed);
+
+/**
+ * @description: record a trace from music_processor.py. Sends the same handshake as the simulator
+ * to port 27184 and records the packets arriving on port 27182.
+ * @return: 0 on success, -1 on failure
+ */
+int recordFeatureTrace(FeatureTrace_t* trace, int nFrames, int nFftBins);
+
+/**
+ * @description: resample one frame of a trace into the number of bins a plugin asked for.
+ * Bins are averaged when downsampling and repeated when upsampling.
+ */
+void resampleFftBins(const uint8_t* in, int nIn, uint8_t* out, int nOut);
+
+/**
+ * @description: same as resampleFftBins, but the averages are kept as floats instead of being truncated
+ */
+void resampleFftBinsFloat(const uint8_t* in, int nIn, float* out, int nOut);
+
+#endif /* INC_FEATURETRACE_H_ */
@@ -0,0 +1,70 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LatencyHistogram.h
+ *
+ *  Fixed size log-linear histogram of durations in nanoseconds. Every power of two is split
+ *  into LATENCY_SUB_BUCKETS linear buckets so percentiles are accurate to about 3%, and
+ *  recording a sample never allocates.
+ */
+
+#ifndef INC_LATENCYHISTOGRAM_H_
+#define INC_LATENCYHISTOGRAM_H_
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_N_BUCKETS (2 * LATENCY_SUB_BUCKETS + (64 - LATENCY_SUB_BUCKET_BITS - 1) * LATENCY_SUB_BUCKETS)
+
+class LatencyHistogram {
+	uint64_t buckets[LATENCY_N_BUCKETS];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+
+	static int bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(int index);
+public:
+	LatencyHistogram();
+
+	/**
+	 * @description: clear all recorded samples
+	 */
+	void reset();
+
+	/**
+	 * @description: record one sample
+	 * @params ns: the duration in nanoseconds
+	 */
+	void record(uint64_t ns);
+
+	/**
+	 * @description: get the value below which the given fraction of samples fall
+	 * @params quantile: between 0.0 and 1.0, e.g. 0.99 for p99
+	 * @return: the upper bound of the bucket holding the quantile, clamped to the recorded max
+	 */
+	uint64_t getPercentile(double quantile) const;
+
+	uint64_t getCount() const;
+	uint64_t getMin() const;
+	uint64_t getMax() const;
+	double getMean() const;
+};
+
+#endif /* INC_LATENCYHISTOGRAM_H_ */
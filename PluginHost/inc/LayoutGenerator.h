@@ -0,0 +1,70 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LayoutGenerator.h
+ *
+ *  Builds the layout and palette byte streams that the host passes to passLayoutData and
+ *  passColorPalette.
+ *
+ *  Layout stream: globalOrientation, sideLength, then 4 ints per panel: panelId, x, y, orientation.
+ *  The shape of a panel is panelId / 256, see the SHAPE_* defines in Shape.h, so at most
+ *  MAX_PANELS_PER_SHAPE panels of each shape fit in one layout.
+ *
+ *  Layout files are the same stream as whitespace separated ints.
+ */
+
+#ifndef INC_LAYOUTGENERATOR_H_
+#define INC_LAYOUTGENERATOR_H_
+
+#include <vector>
+
+#define AURORA_SIDE_LENGTH 150
+#define MAX_PANELS_PER_SHAPE 255
+#define LAYOUT_HEADER_LENGTH 2
+#define LAYOUT_INTS_PER_PANEL 4
+
+struct LayoutStream_t {
+	int nPanels;
+	std::vector<int> stream;
+};
+
+/**
+ * @description: generate a wall of triangles tiled edge to edge, roughly as wide as it is tall
+ * @params nPanels: number of panels, at most MAX_PANELS_PER_SHAPE
+ * @return: 0 on success, -1 if nPanels is out of range
+ */
+int generateTriangleLayout(LayoutStream_t* layout, int nPanels, int globalOrientation);
+
+/**
+ * @description: generate a grid of squares, roughly as wide as it is tall
+ * @params nPanels: number of panels, at most MAX_PANELS_PER_SHAPE
+ * @return: 0 on success, -1 if nPanels is out of range
+ */
+int generateSquareLayout(LayoutStream_t* layout, int nPanels, int globalOrientation);
+
+/**
+ * @description: load a layout stream from a text file
+ * @return: 0 on success, -1 on failure
+ */
+int loadLayout(const char* path, LayoutStream_t* layout);
+
+/**
+ * @description: build a palette stream (3 ints per colour) with nColors entries from a fixed set of hues
+ */
+void generatePalette(std::vector<int>* palette, int nColors);
+
+#endif /* INC_LAYOUTGENERATOR_H_ */
@@ -0,0 +1,106 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PanelStream.h
+ *
+ *  Streams the frames of a plugin over UDP to panel controllers, or to the PanelStandIn receiver in
+ *  their place. Every device gets one packet per call: a 20 byte header followed by the frames as
+ *  PackedFrame_t entries, little endian:
+ *
+ *  	offset  0  uint16 magic, uint8 version, uint8 reserved
+ *  	offset  4  uint16 device, uint16 number of frames
+ *  	offset  8  uint32 sequence, counting calls from 0 and wrapping, per device
+ *  	offset 12  uint64 send time, CLOCK_MONOTONIC ns of the sender
+ *  	offset 20  the frames, 8 bytes each
+ *
+ *  The packets of all devices are queued with sendmmsg, up to batchSize per system call. Every header
+ *  is allocated once and the frames are not copied: each packet is two iovecs, its own header and the
+ *  frame buffer that all devices share.
+ */
+
+#ifndef INC_PANELSTREAM_H_
+#define INC_PANELSTREAM_H_
+
+#include "PackedFrame.h"
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define PANEL_STREAM_PORT 27190
+#define PANEL_STREAM_MAGIC 0x5350			/*"PS"*/
+#define PANEL_STREAM_VERSION 1
+#define PANEL_STREAM_HEADER_BYTES 20
+#define PANEL_STREAM_MAX_FRAMES 1024		/*frames beyond this are not sent*/
+#define PANEL_STREAM_MAX_BYTES (PANEL_STREAM_HEADER_BYTES + PANEL_STREAM_MAX_FRAMES * sizeof(PackedFrame_t))
+#define PANEL_STREAM_MAX_DEVICES 4096
+#define PANEL_STREAM_MAX_BATCH 1024			/*UIO_MAXIOV, the most messages sendmmsg takes at once*/
+
+#define PANEL_STREAM_OK 0
+#define PANEL_STREAM_TRUNCATED -1
+#define PANEL_STREAM_NOT_OURS -2
+#define PANEL_STREAM_BAD_VERSION -3
+
+struct PanelHeader_t {
+	uint16_t device;
+	uint16_t nFrames;
+	uint32_t sequence;
+	uint64_t sendNs;
+};
+
+struct PanelStreamer_t {
+	int sock;
+	int nDevices;
+	int batchSize;					/*packets per sendmmsg*/
+	struct sockaddr_in remote;
+	uint8_t* headers;				/*PANEL_STREAM_HEADER_BYTES per device*/
+	struct iovec* iov;				/*header and frames of every device*/
+	struct mmsghdr* messages;
+	uint32_t sequence;
+	uint64_t nPackets;
+	uint64_t nBytes;
+	uint64_t nSyscalls;
+	uint64_t nDropped;				/*not sent because the socket buffer was full*/
+};
+
+/**
+ * @description: allocate the headers and messages of every device and open a socket to port on 127.0.0.1
+ * @params batchSize: packets per system call, 1 to PANEL_STREAM_MAX_BATCH
+ * @return: 0 on success, -1 on failure
+ */
+int openPanelStreamer(PanelStreamer_t* streamer, int nDevices, int batchSize, int port);
+
+/**
+ * @description: send the same frames to every device. Never blocks, packets that do not fit in the
+ * socket buffer are dropped and counted
+ * @return: the number of packets sent, or -1 on a socket error
+ */
+int streamPanelFrames(PanelStreamer_t* streamer, const PackedFrame_t* frames, int nFrames);
+
+/**
+ * @description: clear the packet, byte, syscall and drop counts
+ */
+void resetPanelStreamCounts(PanelStreamer_t* streamer);
+
+void closePanelStreamer(PanelStreamer_t* streamer);
+
+/**
+ * @description: read the header of a received packet, the frames follow at PANEL_STREAM_HEADER_BYTES
+ * @return: PANEL_STREAM_OK or one of the errors
+ */
+int decodePanelHeader(const uint8_t* buffer, int length, PanelHeader_t* header);
+
+#endif /* INC_PANELSTREAM_H_ */
@@ -0,0 +1,113 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PluginHost.h
+ *
+ *  Headless host that loads a libAuroraPlugin.so and drives it the same way the
+ *  SoundModuleSimulator does, without any of the networking or the Aurora.
+ */
+
+#ifndef INC_PLUGINHOST_H_
+#define INC_PLUGINHOST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "AuroraPlugin.h"
+#include "PackedFrame.h"
+
+/**
+ * Mirror of the structure returned by getEnabledFeatures() in libPluginUtilities.
+ * Must be kept in sync with the library, the host only ever reads it.
+ */
+struct EnabledFeatures_t {
+	bool energy;
+	bool fft;
+	uint16_t nFftBins;
+	bool distance;
+	bool speed;
+	bool beat;
+	uint16_t nFftBands;
+	int fftBandScale;
+	bool bandOnsets;
+};
+
+/**
+ * Mirror of the structure that is passed into updateRhythmFeatures() in libPluginUtilities.
+ * The library copies out of this structure, so the host keeps ownership of fftBins.
+ */
+struct RhythmFeatures_t {
+	uint16_t energy;
+	uint8_t* fftBins;
+	uint16_t nFftBins;
+	uint8_t speed;
+	uint8_t distance;
+};
+
+/**
+ * Mirror of the structure that is passed into updateSpectrumFeatures() in libPluginUtilities.
+ * The library copies the bins, sampleRate is 0 when the host does not know it.
+ */
+struct SpectrumFeatures_t {
+	const float* fftBins;
+	uint16_t nFftBins;
+	float sampleRate;
+};
+
+/**
+ * Entry points of a loaded plugin. The plugin hooks are exported by the plugin itself,
+ * the rest are exported by libPluginUtilities which the plugin was linked against.
+ */
+struct PluginApi_t {
+	void* handle;
+
+	void (*initPlugin)(void);
+	void (*getPluginFrame)(Frame_t* frames, int* nFrames, int* sleepTime);
+	void (*pluginCleanup)(void);
+	void (*getPluginFramePacked)(PackedFrame_t* frames, int* nFrames, int* sleepTime);	/*optional, NULL if not exported*/
+
+	void (*passLayoutData)(int* layoutDataByteStream, int nPanels);
+	void (*passColorPalette)(int* colorByteStream, int nColors);
+	void (*dataManagerCleanup)(void);
+
+	EnabledFeatures_t* (*getEnabledFeatures)(void);
+	void (*initRhythmFeatures)(void);
+	void (*updateRhythmFeatures)(RhythmFeatures_t* rhythmFeatures);
+	void (*deinitRhythmFeatures)(void);
+	void (*initBeatFeatures)(void);
+	void (*updateBeatFeatures)(void);
+	void (*deinitBeatFeatures)(void);
+	void (*updateSpectrumFeatures)(SpectrumFeatures_t* spectrumFeatures);	/*optional, older libraries lack it*/
+
+	void (*resetProfile)(void);				/*optional, from Profiler.h*/
+	void (*dumpProfile)(FILE* fp);			/*optional, from Profiler.h*/
+	void (*flushLog)(void);					/*optional, from Logger.h*/
+};
+
+/**
+ * @description: dlopen a plugin and resolve all of the entry points the host needs
+ * @params path: path to the libAuroraPlugin.so to load
+ * @params api: filled in with the resolved entry points
+ * @return: 0 on success, -1 if the library could not be loaded or a symbol is missing
+ */
+int loadPlugin(const char* path, PluginApi_t* api);
+
+/**
+ * @description: dlclose a plugin loaded by loadPlugin
+ */
+void unloadPlugin(PluginApi_t* api);
+
+#endif /* INC_PLUGINHOST_H_ */
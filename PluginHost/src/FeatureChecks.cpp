@@ -0,0 +1,386 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureChecks.cpp
+ *
+ *  The ring check uses a ring of its own, named after the pid, so it can run next to a live
+ *  FeatureExtractor. The processes share their counts through an anonymous shared mapping. The
+ *  protocol check needs no socket, it works on the encoded bytes.
+ */
+
+#include "FeatureChecks.h"
+#include "FeatureRing.h"
+#include "FeatureProtocol.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define NS_PER_SEC 1000000000ULL
+#define RING_CHECK_START_TIMEOUT_MS 2000	/*how long a reader waits for the first frame*/
+#define PROTOCOL_CHECK_EXTRA_HEADER 8		/*header bytes a newer producer might add*/
+#define PROTOCOL_CHECK_EXTRA_PAYLOAD 600	/*payload bytes of a field unknown to this version, past FEATURE_PROTOCOL_MAX_BYTES*/
+#define PROTOCOL_CHECK_UNKNOWN_MASK 0x100
+
+struct RingCheckCounts_t {
+	uint64_t nPublished;		/*producer only*/
+	uint64_t nReads;			/*frames copied out whole*/
+	uint64_t nTorn;				/*copied frames whose checksum did not match*/
+	uint64_t nBackwards;		/*newest frames older than the newest one read before*/
+	uint64_t nOverwritten;		/*frames the reader asked for after they were overwritten*/
+	uint64_t nBusy;				/*reads that gave up while the producer kept the slot busy*/
+};
+
+static uint64_t nowNs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * @description: FNV-1a over the fields of the frame, except captureNs which carries the checksum
+ */
+static uint64_t frameChecksum(const FeatureRingFrame_t* frame) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	uint8_t fields[offsetof(FeatureRingFrame_t, fftBins)];
+	memcpy(fields, frame, sizeof(fields));
+	memset(fields + offsetof(FeatureRingFrame_t, captureNs), 0, sizeof(frame->captureNs));
+	for (size_t i = 0; i < sizeof(fields); i++) {
+		hash = (hash ^ fields[i]) * 0x100000001b3ULL;
+	}
+	int nBins = frame->nFftBins < FEATURE_RING_MAX_BINS ? frame->nFftBins : FEATURE_RING_MAX_BINS;
+	for (int i = 0; i < nBins; i++) {
+		hash = (hash ^ frame->fftBins[i]) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/**
+ * @description: fill the frame with contents that change with every sequence number, down to the
+ * number of bins, so two frames mixed by a torn copy do not add up to a valid one
+ */
+static void makeCheckFrame(FeatureRingFrame_t* frame, uint64_t sequence) {
+	memset(frame, 0, sizeof(*frame));
+	frame->sequence = sequence;
+	frame->energy = (uint16_t)(sequence * 2654435761ULL >> 16);
+	frame->nFftBins = sequence % (FEATURE_RING_MAX_BINS + 1);
+	frame->beat = sequence & 1;
+	frame->onset = sequence & 2;
+	frame->tempo = (float)(sequence % 1000);
+	frame->beatPhase = (sequence % 97) / 97.0f;
+	frame->beatConfidence = (sequence % 13) / 13.0f;
+	for (int i = 0; i < frame->nFftBins; i++) {
+		frame->fftBins[i] = (uint8_t)(sequence * 31 + i);
+	}
+	frame->captureNs = frameChecksum(frame);
+}
+
+static int runRingProducer(const char* name, uint64_t deadline, RingCheckCounts_t* counts) {
+	FeatureRing_t ring;
+	if (createFeatureRing(&ring, name) < 0) {
+		return 1;
+	}
+	FeatureRingFrame_t frame;
+	while (nowNs() < deadline) {
+		// the ring numbers the frames itself, the next number is known before publishing
+		makeCheckFrame(&frame, ring.nPublished);
+		publishFeatureFrame(&ring, &frame);
+	}
+	counts->nPublished = ring.nPublished;
+	closeFeatureRing(&ring);
+	return 0;
+}
+
+/**
+ * @description: the first reader follows every frame in order like a reader that wants them all,
+ * the others take the newest frame like the host does
+ */
+static int runRingReader(const char* name, bool everyFrame, uint64_t deadline, RingCheckCounts_t* counts) {
+	FeatureRing_t ring;
+	if (openFeatureRing(&ring, name) < 0) {
+		return 1;
+	}
+	uint64_t startDeadline = nowNs() + RING_CHECK_START_TIMEOUT_MS * (NS_PER_SEC / 1000);
+	while (getFeatureRingCount(&ring) == 0) {
+		if (nowNs() > startDeadline) {
+			closeFeatureRing(&ring);
+			return 1;
+		}
+		usleep(1000);
+	}
+	FeatureRingFrame_t frame;
+	uint64_t next = 0;
+	while (nowNs() < deadline) {
+		int err = everyFrame ? readFeatureFrame(&ring, next, &frame) : readLatestFeatureFrame(&ring, &frame);
+		if (err == FEATURE_RING_OVERWRITTEN) {
+			counts->nOverwritten++;
+			next = getFeatureRingCount(&ring) - 1;
+			continue;
+		}
+		if (err == FEATURE_RING_BUSY) {
+			counts->nBusy++;
+			continue;
+		}
+		if (err != FEATURE_RING_OK) {
+			continue;
+		}
+		counts->nReads++;
+		if (frameChecksum(&frame) != frame.captureNs) {
+			counts->nTorn++;
+		}
+		if (frame.sequence + 1 < next) {
+			counts->nBackwards++;
+		}
+		next = frame.sequence + 1;
+	}
+	closeFeatureRing(&ring);
+	return 0;
+}
+
+int checkFeatureRing(double seconds) {
+	char name[64];
+	snprintf(name, sizeof(name), "%s-check-%d", FEATURE_RING_DEFAULT_NAME, (int)getpid());
+	int nProcesses = 1 + FEATURE_CHECK_RING_READERS;
+	RingCheckCounts_t* counts = (RingCheckCounts_t*)mmap(NULL, nProcesses * sizeof(RingCheckCounts_t),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counts == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+	memset(counts, 0, nProcesses * sizeof(RingCheckCounts_t));
+
+	// make the ring before forking so the readers can attach at once, the producer takes it over
+	FeatureRing_t ring;
+	if (createFeatureRing(&ring, name) < 0) {
+		munmap(counts, nProcesses * sizeof(RingCheckCounts_t));
+		return -1;
+	}
+	closeFeatureRing(&ring);
+
+	uint64_t deadline = nowNs() + (uint64_t)(seconds * NS_PER_SEC);
+	fflush(stdout);
+	int failures = 0;
+	for (int i = 0; i < nProcesses; i++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			failures++;
+			break;
+		}
+		if (pid == 0) {
+			_exit(i == 0 ? runRingProducer(name, deadline, &counts[0]) :
+					runRingReader(name, i == 1, deadline, &counts[i]));
+		}
+	}
+	int status;
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			failures++;
+		}
+	}
+	shm_unlink(name);
+
+	RingCheckCounts_t total;
+	memset(&total, 0, sizeof(total));
+	for (int i = 1; i < nProcesses; i++) {
+		total.nReads += counts[i].nReads;
+		total.nTorn += counts[i].nTorn;
+		total.nBackwards += counts[i].nBackwards;
+		total.nOverwritten += counts[i].nOverwritten;
+		total.nBusy += counts[i].nBusy;
+	}
+	bool ok = failures == 0 && total.nReads > 0 && total.nTorn == 0 && total.nBackwards == 0;
+	printf("feature ring: %llu frames published, %llu read by %d readers, %llu torn, %llu out of order, "
+			"%llu overwritten, %llu busy: %s\n",
+			(unsigned long long)counts[0].nPublished, (unsigned long long)total.nReads, FEATURE_CHECK_RING_READERS,
+			(unsigned long long)total.nTorn, (unsigned long long)total.nBackwards,
+			(unsigned long long)total.nOverwritten, (unsigned long long)total.nBusy, ok ? "ok" : "FAILED");
+	munmap(counts, nProcesses * sizeof(RingCheckCounts_t));
+	return ok ? 0 : -1;
+}
+
+/**
+ * @description: fill a packet with the fields of the mask, the others are left cleared as a decoder leaves them
+ */
+static void makeCheckPacket(FeaturePacket_t* packet, uint32_t mask, int nBins, uint8_t* bins) {
+	memset(packet, 0, sizeof(*packet));
+	packet->sequence = 0xfedcba98 + mask;
+	packet->featureMask = mask;
+	packet->captureNs = 0x0123456789abcdefULL;
+	for (int i = 0; i < nBins; i++) {
+		bins[i] = (uint8_t)(i * 7 + mask);
+	}
+	if (mask & FEATURE_MASK_ENERGY) {
+		packet->energy = 0xbeef;
+	}
+	if (mask & FEATURE_MASK_FFT) {
+		packet->nFftBins = nBins;
+		packet->fftBins = bins;
+	}
+	if (mask & FEATURE_MASK_BEAT) {
+		packet->beat = true;
+		packet->onset = mask & FEATURE_MASK_ENERGY;
+		packet->tempo = 123.5f;
+		packet->beatPhase = 0.25f;
+		packet->beatConfidence = 0.875f;
+	}
+}
+
+static bool samePacket(const FeaturePacket_t* a, const FeaturePacket_t* b) {
+	return a->sequence == b->sequence && a->featureMask == b->featureMask && a->captureNs == b->captureNs &&
+			a->energy == b->energy && a->nFftBins == b->nFftBins && a->beat == b->beat && a->onset == b->onset &&
+			a->tempo == b->tempo && a->beatPhase == b->beatPhase && a->beatConfidence == b->beatConfidence &&
+			(a->nFftBins == 0 || memcmp(a->fftBins, b->fftBins, a->nFftBins) == 0);
+}
+
+/**
+ * @description: the sequence tracker from a given state, fed a list of numbers
+ * @return: true if the returns and the counts are the expected ones
+ */
+static bool checkSequence(const uint32_t* numbers, const bool* newer, int n, uint64_t nLost, uint64_t nLate,
+		uint64_t nDuplicate) {
+	FeatureSequence_t sequence;
+	resetFeatureSequence(&sequence);
+	bool ok = true;
+	for (int i = 0; i < n; i++) {
+		ok &= trackFeatureSequence(&sequence, numbers[i]) == newer[i];
+	}
+	return ok && sequence.nReceived == (uint64_t)n && sequence.nLost == nLost && sequence.nLate == nLate &&
+			sequence.nDuplicate == nDuplicate;
+}
+
+int checkFeatureProtocol() {
+	static uint8_t buffer[FEATURE_PROTOCOL_MAX_DATAGRAM];
+	static uint8_t longer[FEATURE_PROTOCOL_MAX_DATAGRAM];
+	uint8_t bins[FEATURE_PROTOCOL_MAX_BINS];
+	int nChecks = 0;
+	int nFailed = 0;
+	FeaturePacket_t packet;
+	FeaturePacket_t decoded;
+
+	// every combination of the known bits, with no bins, one and the most, and a bit this version does not know
+	const int binCounts[] = {0, 1, FEATURE_PROTOCOL_MAX_BINS};
+	for (uint32_t mask = 0; mask <= FEATURE_MASK_KNOWN; mask++) {
+		for (int b = 0; b < (int)(sizeof(binCounts) / sizeof(binCounts[0])); b++) {
+			makeCheckPacket(&packet, mask, binCounts[b], bins);
+			packet.featureMask |= PROTOCOL_CHECK_UNKNOWN_MASK;
+			int length = encodeFeaturePacket(&packet, buffer, sizeof(buffer));
+			packet.featureMask = mask;
+			nChecks++;
+			if (length < FEATURE_FRAME_HEADER_BYTES || length > FEATURE_PROTOCOL_MAX_BYTES ||
+					decodeFeaturePacket(buffer, length, &decoded) != FEATURE_PROTOCOL_OK || !samePacket(&packet, &decoded)) {
+				fprintf(stderr, "round trip of mask 0x%x with %d bins failed\n", mask, binCounts[b]);
+				nFailed++;
+				continue;
+			}
+			// every shorter cut of the message is missing part of it
+			for (int cut = 0; cut < length; cut++) {
+				nChecks++;
+				if (decodeFeaturePacket(buffer, cut, &decoded) != FEATURE_PROTOCOL_TRUNCATED) {
+					fprintf(stderr, "mask 0x%x with %d bins cut to %d bytes was not truncated\n", mask, binCounts[b], cut);
+					nFailed++;
+				}
+			}
+		}
+	}
+
+	makeCheckPacket(&packet, FEATURE_MASK_KNOWN, FEATURE_PROTOCOL_MAX_BINS, bins);
+	int length = encodeFeaturePacket(&packet, buffer, sizeof(buffer));
+	buffer[0] ^= 0xff;
+	nChecks++;
+	if (decodeFeaturePacket(buffer, length, &decoded) != FEATURE_PROTOCOL_NOT_OURS) {
+		fprintf(stderr, "wrong magic was accepted\n");
+		nFailed++;
+	}
+	buffer[0] ^= 0xff;
+	buffer[2] = FEATURE_PROTOCOL_VERSION + 1;
+	nChecks++;
+	if (decodeFeaturePacket(buffer, length, &decoded) != FEATURE_PROTOCOL_BAD_VERSION) {
+		fprintf(stderr, "wrong version was accepted\n");
+		nFailed++;
+	}
+	buffer[2] = FEATURE_PROTOCOL_VERSION;
+	const char* text = "1 32 1";
+	nChecks++;
+	if (decodeFeaturePacket((const uint8_t*)text, strlen(text), &decoded) != FEATURE_PROTOCOL_NOT_OURS) {
+		fprintf(stderr, "a text request was taken for a frame\n");
+		nFailed++;
+	}
+
+	// a newer producer: header bytes after the 28 known ones, and a field after the known ones in the payload
+	int payloadBytes = length - FEATURE_FRAME_HEADER_BYTES;
+	int headerBytes = FEATURE_FRAME_HEADER_BYTES + PROTOCOL_CHECK_EXTRA_HEADER;
+	memcpy(longer, buffer, FEATURE_FRAME_HEADER_BYTES);
+	memset(longer + FEATURE_FRAME_HEADER_BYTES, 0xaa, PROTOCOL_CHECK_EXTRA_HEADER);
+	memcpy(longer + headerBytes, buffer + FEATURE_FRAME_HEADER_BYTES, payloadBytes);
+	memset(longer + headerBytes + payloadBytes, 0x55, PROTOCOL_CHECK_EXTRA_PAYLOAD);
+	longer[4] = headerBytes & 0xff;
+	longer[5] = headerBytes >> 8;
+	longer[6] = (payloadBytes + PROTOCOL_CHECK_EXTRA_PAYLOAD) & 0xff;
+	longer[7] = (payloadBytes + PROTOCOL_CHECK_EXTRA_PAYLOAD) >> 8;
+	longer[12 + 1] |= PROTOCOL_CHECK_UNKNOWN_MASK >> 8;
+	int longerBytes = headerBytes + payloadBytes + PROTOCOL_CHECK_EXTRA_PAYLOAD;
+	nChecks++;
+	if (longerBytes <= FEATURE_PROTOCOL_MAX_BYTES || decodeFeaturePacket(longer, longerBytes, &decoded) != FEATURE_PROTOCOL_OK ||
+			!samePacket(&packet, &decoded)) {
+		fprintf(stderr, "a longer header and payload were not skipped\n");
+		nFailed++;
+	}
+	nChecks++;
+	if (decodeFeaturePacket(longer, longerBytes - 1, &decoded) != FEATURE_PROTOCOL_TRUNCATED) {
+		fprintf(stderr, "a longer message cut short was not truncated\n");
+		nFailed++;
+	}
+
+	FeatureCapabilities_t wanted = {FEATURE_MASK_KNOWN, 64, 50};
+	FeatureCapabilities_t granted;
+	int type;
+	length = encodeFeatureCapabilities(FEATURE_MESSAGE_REQUEST, &wanted, buffer, sizeof(buffer));
+	nChecks++;
+	if (decodeFeatureCapabilities(buffer, length, &type, &granted) != FEATURE_PROTOCOL_OK || type != FEATURE_MESSAGE_REQUEST ||
+			granted.featureMask != wanted.featureMask || granted.nFftBins != wanted.nFftBins ||
+			granted.intervalMs != wanted.intervalMs) {
+		fprintf(stderr, "round trip of a request failed\n");
+		nFailed++;
+	}
+	nChecks++;
+	if (decodeFeaturePacket(buffer, length, &decoded) != FEATURE_PROTOCOL_BAD_TYPE) {
+		fprintf(stderr, "a request was taken for a frame\n");
+		nFailed++;
+	}
+
+	// through the wrap, then one lost that turns up late, the newest twice, and a loss across the wrap
+	const uint32_t wrapping[] = {0xfffffffe, 0xffffffff, 0, 1, 3, 2, 3, 3};
+	const bool wrappingNewer[] = {true, true, true, true, true, false, false, false};
+	nChecks++;
+	if (!checkSequence(wrapping, wrappingNewer, 8, 0, 1, 2)) {
+		fprintf(stderr, "sequence numbers through the wrap were miscounted\n");
+		nFailed++;
+	}
+	const uint32_t lossy[] = {0xfffffffd, 0xffffffff, 2, 0xffffffff};
+	const bool lossyNewer[] = {true, true, true, false};
+	nChecks++;
+	if (!checkSequence(lossy, lossyNewer, 4, 2, 1, 0)) {
+		fprintf(stderr, "losses across the wrap were miscounted\n");
+		nFailed++;
+	}
+
+	printf("feature protocol: %d checks, %d failed: %s\n", nChecks, nFailed, nFailed == 0 ? "ok" : "FAILED");
+	return nFailed == 0 ? 0 : -1;
+}
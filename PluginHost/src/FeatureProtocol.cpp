@@ -0,0 +1,252 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureProtocol.cpp
+ */
+
+#include "FeatureProtocol.h"
+#include <string.h>
+
+static void put16(uint8_t* p, uint16_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static void put64(uint8_t* p, uint64_t v) {
+	put32(p, v);
+	put32(p + 4, v >> 32);
+}
+
+static void putFloat(uint8_t* p, float v) {
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	put32(p, bits);
+}
+
+static uint16_t get16(const uint8_t* p) {
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static uint64_t get64(const uint8_t* p) {
+	return get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+static float getFloat(const uint8_t* p) {
+	uint32_t bits = get32(p);
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+static void putPrefix(uint8_t* p, int type, int headerBytes, int payloadBytes) {
+	put16(p, FEATURE_PROTOCOL_MAGIC);
+	p[2] = FEATURE_PROTOCOL_VERSION;
+	p[3] = type;
+	put16(p + 4, headerBytes);
+	put16(p + 6, payloadBytes);
+}
+
+/**
+ * @description: check the common prefix of a message
+ * @params minHeaderBytes: the header this decoder needs, a longer one is skipped
+ * @params payload: receives the start of the payload
+ * @params payloadBytes: receives the length of the payload
+ * @return: FEATURE_PROTOCOL_OK or one of the errors
+ */
+static int checkPrefix(const uint8_t* buffer, int length, int minHeaderBytes, int* type, const uint8_t** payload,
+		int* payloadBytes) {
+	if (length < FEATURE_PROTOCOL_PREFIX_BYTES) {
+		return length >= 2 && get16(buffer) != FEATURE_PROTOCOL_MAGIC ? FEATURE_PROTOCOL_NOT_OURS : FEATURE_PROTOCOL_TRUNCATED;
+	}
+	if (get16(buffer) != FEATURE_PROTOCOL_MAGIC) {
+		return FEATURE_PROTOCOL_NOT_OURS;
+	}
+	if (buffer[2] != FEATURE_PROTOCOL_VERSION) {
+		return FEATURE_PROTOCOL_BAD_VERSION;
+	}
+	*type = buffer[3];
+	int headerBytes = get16(buffer + 4);
+	*payloadBytes = get16(buffer + 6);
+	if (headerBytes < minHeaderBytes) {
+		return FEATURE_PROTOCOL_TRUNCATED;
+	}
+	if (headerBytes + *payloadBytes > length) {
+		return FEATURE_PROTOCOL_TRUNCATED;
+	}
+	*payload = buffer + headerBytes;
+	return FEATURE_PROTOCOL_OK;
+}
+
+int encodeFeatureCapabilities(int type, const FeatureCapabilities_t* capabilities, uint8_t* buffer, int size) {
+	int length = FEATURE_PROTOCOL_PREFIX_BYTES + FEATURE_CAPABILITIES_BYTES;
+	if (size < length) {
+		return FEATURE_PROTOCOL_TOO_LARGE;
+	}
+	putPrefix(buffer, type, FEATURE_PROTOCOL_PREFIX_BYTES, FEATURE_CAPABILITIES_BYTES);
+	uint8_t* p = buffer + FEATURE_PROTOCOL_PREFIX_BYTES;
+	put32(p, capabilities->featureMask);
+	put16(p + 4, capabilities->nFftBins);
+	put16(p + 6, capabilities->intervalMs);
+	return length;
+}
+
+int decodeFeatureCapabilities(const uint8_t* buffer, int length, int* type, FeatureCapabilities_t* capabilities) {
+	const uint8_t* p;
+	int payloadBytes;
+	int err = checkPrefix(buffer, length, FEATURE_PROTOCOL_PREFIX_BYTES, type, &p, &payloadBytes);
+	if (err != FEATURE_PROTOCOL_OK) {
+		return err;
+	}
+	if (*type != FEATURE_MESSAGE_REQUEST && *type != FEATURE_MESSAGE_ACCEPT) {
+		return FEATURE_PROTOCOL_BAD_TYPE;
+	}
+	if (payloadBytes < FEATURE_CAPABILITIES_BYTES) {
+		return FEATURE_PROTOCOL_TRUNCATED;
+	}
+	capabilities->featureMask = get32(p);
+	capabilities->nFftBins = get16(p + 4);
+	capabilities->intervalMs = get16(p + 6);
+	return FEATURE_PROTOCOL_OK;
+}
+
+int encodeFeaturePacket(const FeaturePacket_t* packet, uint8_t* buffer, int size) {
+	uint32_t mask = packet->featureMask & FEATURE_MASK_KNOWN;
+	int nBins = mask & FEATURE_MASK_FFT ? packet->nFftBins : 0;
+	if (nBins > FEATURE_PROTOCOL_MAX_BINS) {
+		return FEATURE_PROTOCOL_TOO_LARGE;
+	}
+	int payloadBytes = (mask & FEATURE_MASK_ENERGY ? 2 : 0) + nBins + (mask & FEATURE_MASK_BEAT ? 12 : 0);
+	int length = FEATURE_FRAME_HEADER_BYTES + payloadBytes;
+	if (size < length) {
+		return FEATURE_PROTOCOL_TOO_LARGE;
+	}
+
+	putPrefix(buffer, FEATURE_MESSAGE_FRAME, FEATURE_FRAME_HEADER_BYTES, payloadBytes);
+	put32(buffer + 8, packet->sequence);
+	put32(buffer + 12, mask);
+	put64(buffer + 16, packet->captureNs);
+	put16(buffer + 24, nBins);
+	buffer[26] = mask & FEATURE_MASK_BEAT ? (packet->beat ? FEATURE_FLAG_BEAT : 0) | (packet->onset ? FEATURE_FLAG_ONSET : 0) : 0;
+	buffer[27] = 0;
+
+	uint8_t* p = buffer + FEATURE_FRAME_HEADER_BYTES;
+	if (mask & FEATURE_MASK_ENERGY) {
+		put16(p, packet->energy);
+		p += 2;
+	}
+	if (mask & FEATURE_MASK_FFT) {
+		memcpy(p, packet->fftBins, nBins);
+		p += nBins;
+	}
+	if (mask & FEATURE_MASK_BEAT) {
+		putFloat(p, packet->tempo);
+		putFloat(p + 4, packet->beatPhase);
+		putFloat(p + 8, packet->beatConfidence);
+	}
+	return length;
+}
+
+int decodeFeaturePacket(const uint8_t* buffer, int length, FeaturePacket_t* packet) {
+	const uint8_t* p;
+	int payloadBytes;
+	int type;
+	// the type first, an accept has a shorter header than a frame and is not a truncated one
+	int err = checkPrefix(buffer, length, FEATURE_PROTOCOL_PREFIX_BYTES, &type, &p, &payloadBytes);
+	if (err != FEATURE_PROTOCOL_OK) {
+		return err;
+	}
+	if (type != FEATURE_MESSAGE_FRAME) {
+		return FEATURE_PROTOCOL_BAD_TYPE;
+	}
+	if (p - buffer < FEATURE_FRAME_HEADER_BYTES) {
+		return FEATURE_PROTOCOL_TRUNCATED;
+	}
+
+	memset(packet, 0, sizeof(*packet));
+	packet->sequence = get32(buffer + 8);
+	uint32_t mask = get32(buffer + 12);
+	packet->captureNs = get64(buffer + 16);
+	int nBins = get16(buffer + 24);
+	uint8_t flags = buffer[26];
+	if (nBins > FEATURE_PROTOCOL_MAX_BINS) {
+		return FEATURE_PROTOCOL_TOO_LARGE;
+	}
+
+	// the fields of the known bits come first, anything after them is from a newer producer
+	const uint8_t* end = p + payloadBytes;
+	int needed = (mask & FEATURE_MASK_ENERGY ? 2 : 0) + (mask & FEATURE_MASK_FFT ? nBins : 0) +
+			(mask & FEATURE_MASK_BEAT ? 12 : 0);
+	if (p + needed > end) {
+		return FEATURE_PROTOCOL_TRUNCATED;
+	}
+	packet->featureMask = mask & FEATURE_MASK_KNOWN;
+	if (mask & FEATURE_MASK_ENERGY) {
+		packet->energy = get16(p);
+		p += 2;
+	}
+	if (mask & FEATURE_MASK_FFT) {
+		packet->nFftBins = nBins;
+		packet->fftBins = p;
+		p += nBins;
+	}
+	if (mask & FEATURE_MASK_BEAT) {
+		packet->beat = (flags & FEATURE_FLAG_BEAT) != 0;
+		packet->onset = (flags & FEATURE_FLAG_ONSET) != 0;
+		packet->tempo = getFloat(p);
+		packet->beatPhase = getFloat(p + 4);
+		packet->beatConfidence = getFloat(p + 8);
+	}
+	return FEATURE_PROTOCOL_OK;
+}
+
+void resetFeatureSequence(FeatureSequence_t* sequence) {
+	memset(sequence, 0, sizeof(*sequence));
+}
+
+bool trackFeatureSequence(FeatureSequence_t* sequence, uint32_t number) {
+	sequence->nReceived++;
+	if (!sequence->started) {
+		sequence->started = true;
+		sequence->next = number + 1;
+		return true;
+	}
+	int32_t ahead = (int32_t)(number - sequence->next);
+	if (ahead >= 0) {
+		sequence->nLost += ahead;
+		sequence->next = number + 1;
+		return true;
+	}
+	// a duplicate of the newest frame was never counted as lost
+	if (number == sequence->next - 1) {
+		sequence->nDuplicate++;
+		return false;
+	}
+	sequence->nLate++;
+	if (sequence->nLost > 0) {
+		sequence->nLost--;
+	}
+	return false;
+}
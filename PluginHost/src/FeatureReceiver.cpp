@@ -0,0 +1,173 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureReceiver.cpp
+ */
+
+#include "FeatureReceiver.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define REQUEST_RETRY_MS 500
+
+static uint64_t monotonicNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @description: wait until the socket is readable
+ * @return: 1 if it is, 0 on timeout, -1 on error
+ */
+static int waitReadable(int sock, int timeoutMs) {
+	struct pollfd pfd;
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+	int n = poll(&pfd, 1, timeoutMs);
+	if (n < 0 && errno != EINTR) {
+		perror("poll");
+		return -1;
+	}
+	return n > 0 ? 1 : 0;
+}
+
+int openFeatureReceiver(FeatureReceiver_t* receiver, int maxAgeMs) {
+	memset(receiver, 0, sizeof(*receiver));
+	receiver->maxAgeNs = (uint64_t)maxAgeMs * 1000000ull;
+	resetFeatureSequence(&receiver->sequence);
+	receiver->sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (receiver->sock < 0) {
+		perror("socket");
+		return -1;
+	}
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	local.sin_port = 0;
+	if (bind(receiver->sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+		perror("bind");
+		close(receiver->sock);
+		receiver->sock = -1;
+		return -1;
+	}
+	receiver->producer.sin_family = AF_INET;
+	receiver->producer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	receiver->producer.sin_port = htons(FEATURE_PROTOCOL_REQUEST_PORT);
+	return 0;
+}
+
+int requestFeatures(FeatureReceiver_t* receiver, const FeatureCapabilities_t* wanted, int timeoutMs) {
+	uint8_t request[FEATURE_PROTOCOL_PREFIX_BYTES + FEATURE_CAPABILITIES_BYTES];
+	int requestBytes = encodeFeatureCapabilities(FEATURE_MESSAGE_REQUEST, wanted, request, sizeof(request));
+	uint64_t deadline = monotonicNs() + (uint64_t)timeoutMs * 1000000ull;
+	while (monotonicNs() < deadline) {
+		if (sendto(receiver->sock, request, requestBytes, 0, (struct sockaddr*)&receiver->producer,
+				sizeof(receiver->producer)) < 0) {
+			perror("sendto");
+			return -1;
+		}
+		uint64_t retry = monotonicNs() + REQUEST_RETRY_MS * 1000000ull;
+		while (monotonicNs() < retry) {
+			int ready = waitReadable(receiver->sock, REQUEST_RETRY_MS);
+			if (ready < 0) {
+				return -1;
+			}
+			if (ready == 0) {
+				break;
+			}
+			int length = recv(receiver->sock, receiver->buffer, sizeof(receiver->buffer), MSG_DONTWAIT);
+			int type;
+			FeatureCapabilities_t granted;
+			/*frames of an earlier stream can still be queued, skip everything but the answer*/
+			if (length > 0 && decodeFeatureCapabilities(receiver->buffer, length, &type, &granted) == FEATURE_PROTOCOL_OK
+					&& type == FEATURE_MESSAGE_ACCEPT) {
+				receiver->granted = granted;
+				resetFeatureSequence(&receiver->sequence);
+				receiver->nStale = 0;
+				receiver->nMalformed = 0;
+				receiver->hasFrame = false;
+				return 0;
+			}
+		}
+	}
+	fprintf(stderr, "no feature producer answered on port %d\n", FEATURE_PROTOCOL_REQUEST_PORT);
+	return -1;
+}
+
+int receiveFeatures(FeatureReceiver_t* receiver, int timeoutMs) {
+	bool received = false;
+	while (true) {
+		int length = recv(receiver->sock, receiver->buffer, sizeof(receiver->buffer), MSG_DONTWAIT);
+		if (length < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				perror("recv");
+				return -1;
+			}
+			if (received || timeoutMs <= 0) {
+				break;
+			}
+			int ready = waitReadable(receiver->sock, timeoutMs);
+			if (ready <= 0) {
+				return ready;
+			}
+			continue;
+		}
+		FeaturePacket_t packet;
+		int err = decodeFeaturePacket(receiver->buffer, length, &packet);
+		if (err != FEATURE_PROTOCOL_OK) {
+			/*an accept of a retried request is expected, anything else is not*/
+			if (err != FEATURE_PROTOCOL_BAD_TYPE) {
+				receiver->nMalformed++;
+			}
+			continue;
+		}
+		if (!trackFeatureSequence(&receiver->sequence, packet.sequence)) {
+			continue;
+		}
+		if (monotonicNs() - packet.captureNs > receiver->maxAgeNs) {
+			receiver->nStale++;
+			continue;
+		}
+		/*the buffer is reused by the next recv, keep the bins of the newest frame*/
+		if (packet.nFftBins > 0) {
+			memcpy(receiver->bins, packet.fftBins, packet.nFftBins);
+		}
+		packet.fftBins = receiver->bins;
+		receiver->latest = packet;
+		receiver->hasFrame = true;
+		received = true;
+	}
+	return received ? 1 : 0;
+}
+
+void closeFeatureReceiver(FeatureReceiver_t* receiver) {
+	if (receiver->sock >= 0) {
+		close(receiver->sock);
+		receiver->sock = -1;
+	}
+}
@@ -0,0 +1,203 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureRing.cpp
+ *
+ *  The seqlock follows the usual pattern: the producer stores the odd count, fences, writes the frame
+ *  and stores the even count with release. A reader loads the count with acquire, copies the frame,
+ *  fences with acquire and loads the count again. The copy itself races with the producer by design,
+ *  it is only used when both counts agree.
+ */
+
+#include "FeatureRing.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "readers map the ring read only, which needs lock free 64 bit atomics"
+#endif
+
+#define FEATURE_RING_MAX_RETRIES 1024
+#define CACHE_LINE_BYTES 64
+
+struct alignas(CACHE_LINE_BYTES) FeatureRingSlot_t {
+	std::atomic<uint64_t> count;		/*2 * sequence + 1 while the frame is written, 2 * sequence + 2 after*/
+	FeatureRingFrame_t frame;
+};
+
+struct FeatureRingShared_t {
+	uint32_t magic;						/*written last, a reader ignores a ring without it*/
+	uint32_t version;
+	uint32_t nSlots;
+	uint32_t slotSize;					/*catches producers and readers built with different layouts*/
+	int32_t producerPid;				/*0 when no producer is attached*/
+	alignas(CACHE_LINE_BYTES) std::atomic<uint64_t> nPublished;
+	FeatureRingSlot_t slots[FEATURE_RING_SLOTS];
+};
+
+/**
+ * @description: map the object, size it first if the caller is the producer
+ * @return: 0 on success, -1 on failure
+ */
+static int mapFeatureRing(FeatureRing_t* ring, const char* name, bool producer) {
+	ring->shared = NULL;
+	ring->size = sizeof(FeatureRingShared_t);
+	ring->producer = producer;
+	ring->nPublished = 0;
+	int fd = producer ? shm_open(name, O_CREAT | O_RDWR, 0644) : shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		perror(name);
+		return -1;
+	}
+	if (producer && ftruncate(fd, ring->size) < 0) {
+		perror("ftruncate");
+		close(fd);
+		return -1;
+	}
+	struct stat st;
+	if (!producer && (fstat(fd, &st) < 0 || (size_t)st.st_size < ring->size)) {
+		fprintf(stderr, "%s is not a feature ring\n", name);
+		close(fd);
+		return -1;
+	}
+	void* p = mmap(NULL, ring->size, producer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+	ring->shared = (FeatureRingShared_t*)p;
+	return 0;
+}
+
+int createFeatureRing(FeatureRing_t* ring, const char* name) {
+	if (mapFeatureRing(ring, name, true) < 0) {
+		return -1;
+	}
+	FeatureRingShared_t* s = ring->shared;
+	// one producer at a time, a ring left by one that died can be taken over
+	pid_t owner = s->magic == FEATURE_RING_MAGIC ? s->producerPid : 0;
+	if (owner > 0 && owner != getpid() && (kill(owner, 0) == 0 || errno == EPERM)) {
+		fprintf(stderr, "%s is in use by producer %d\n", name, (int)owner);
+		closeFeatureRing(ring);
+		return -1;
+	}
+	s->producerPid = getpid();
+	// readers still attached from an earlier producer see every slot change under them and start over
+	s->nPublished.store(0, std::memory_order_relaxed);
+	for (int i = 0; i < FEATURE_RING_SLOTS; i++) {
+		s->slots[i].count.store(0, std::memory_order_relaxed);
+	}
+	s->version = FEATURE_RING_VERSION;
+	s->nSlots = FEATURE_RING_SLOTS;
+	s->slotSize = sizeof(FeatureRingSlot_t);
+	std::atomic_thread_fence(std::memory_order_release);
+	s->magic = FEATURE_RING_MAGIC;
+	return 0;
+}
+
+int openFeatureRing(FeatureRing_t* ring, const char* name) {
+	if (mapFeatureRing(ring, name, false) < 0) {
+		return -1;
+	}
+	const FeatureRingShared_t* s = ring->shared;
+	if (s->magic != FEATURE_RING_MAGIC || s->version != FEATURE_RING_VERSION || s->nSlots != FEATURE_RING_SLOTS ||
+			s->slotSize != sizeof(FeatureRingSlot_t)) {
+		fprintf(stderr, "%s was made by an incompatible producer\n", name);
+		closeFeatureRing(ring);
+		return -1;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return 0;
+}
+
+void closeFeatureRing(FeatureRing_t* ring) {
+	if (ring->shared) {
+		if (ring->producer) {
+			ring->shared->producerPid = 0;
+		}
+		munmap(ring->shared, ring->size);
+		ring->shared = NULL;
+	}
+}
+
+uint64_t publishFeatureFrame(FeatureRing_t* ring, const FeatureRingFrame_t* frame) {
+	uint64_t sequence = ring->nPublished;
+	FeatureRingSlot_t* slot = &ring->shared->slots[sequence % FEATURE_RING_SLOTS];
+	int nBins = frame->nFftBins < FEATURE_RING_MAX_BINS ? frame->nFftBins : FEATURE_RING_MAX_BINS;
+
+	slot->count.store(2 * sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&slot->frame, frame, offsetof(FeatureRingFrame_t, fftBins) + nBins);
+	slot->frame.sequence = sequence;
+	slot->frame.nFftBins = nBins;
+	slot->count.store(2 * sequence + 2, std::memory_order_release);
+
+	ring->nPublished = sequence + 1;
+	ring->shared->nPublished.store(ring->nPublished, std::memory_order_release);
+	return sequence;
+}
+
+uint64_t getFeatureRingCount(const FeatureRing_t* ring) {
+	return ring->shared->nPublished.load(std::memory_order_acquire);
+}
+
+int readFeatureFrame(const FeatureRing_t* ring, uint64_t sequence, FeatureRingFrame_t* frame) {
+	const FeatureRingSlot_t* slot = &ring->shared->slots[sequence % FEATURE_RING_SLOTS];
+	uint64_t done = 2 * sequence + 2;
+	for (int retry = 0; retry < FEATURE_RING_MAX_RETRIES; retry++) {
+		uint64_t before = slot->count.load(std::memory_order_acquire);
+		if (before > done) {
+			return FEATURE_RING_OVERWRITTEN;
+		}
+		if (before < done - 1) {
+			return FEATURE_RING_EMPTY;
+		}
+		if (before == done) {
+			// copy the bins the frame has, nFftBins may be torn so it is clamped and checked with the count
+			memcpy(frame, &slot->frame, offsetof(FeatureRingFrame_t, fftBins));
+			int nBins = frame->nFftBins < FEATURE_RING_MAX_BINS ? frame->nFftBins : FEATURE_RING_MAX_BINS;
+			memcpy(frame->fftBins, slot->frame.fftBins, nBins);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot->count.load(std::memory_order_relaxed) == before) {
+				return FEATURE_RING_OK;
+			}
+		}
+	}
+	return FEATURE_RING_BUSY;
+}
+
+int readLatestFeatureFrame(const FeatureRing_t* ring, FeatureRingFrame_t* frame) {
+	for (int retry = 0; retry < FEATURE_RING_MAX_RETRIES; retry++) {
+		uint64_t n = getFeatureRingCount(ring);
+		if (n == 0) {
+			return FEATURE_RING_EMPTY;
+		}
+		// a newer frame or a restart of the producer got in the way, look again
+		if (readFeatureFrame(ring, n - 1, frame) == FEATURE_RING_OK) {
+			return FEATURE_RING_OK;
+		}
+	}
+	return FEATURE_RING_BUSY;
+}
@@ -0,0 +1,246 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FeatureTrace.cpp
+ *
+ *  Loading, saving, generating and recording of sound feature traces
+ */
+
+#include "FeatureTrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define SOUND_FEATURE_HOST "127.0.0.1"
+#define SOUND_FEATURE_DATA_PORT 27182		/*music_processor.py sends features to this port*/
+#define SOUND_FEATURE_REQUEST_PORT 27184	/*music_processor.py waits for the "b i b" request on this port*/
+#define MAX_LINE_LENGTH 4096
+
+int loadFeatureTrace(const char* path, FeatureTrace_t* trace) {
+	FILE* fp = fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "could not open trace %s\n", path);
+		return -1;
+	}
+
+	trace->nFrames = 0;
+	trace->nFftBins = -1;
+	trace->energy.clear();
+	trace->fftBins.clear();
+
+	char line[MAX_LINE_LENGTH];
+	int lineNumber = 0;
+	while (fgets(line, sizeof(line), fp)) {
+		lineNumber++;
+		char* p = line;
+		while (*p == ' ' || *p == '\t') {
+			p++;
+		}
+		if (*p == '#' || *p == '\n' || *p == '\0') {
+			continue;
+		}
+
+		char* end;
+		long energy = strtol(p, &end, 10);
+		if (end == p) {
+			fprintf(stderr, "%s:%d: expected energy\n", path, lineNumber);
+			fclose(fp);
+			return -1;
+		}
+		p = end;
+
+		int nBins = 0;
+		while (1) {
+			long bin = strtol(p, &end, 10);
+			if (end == p) {
+				break;
+			}
+			trace->fftBins.push_back(bin < 0 ? 0 : (bin > 255 ? 255 : bin));
+			nBins++;
+			p = end;
+		}
+
+		if (trace->nFftBins < 0) {
+			trace->nFftBins = nBins;
+		}
+		else if (trace->nFftBins != nBins) {
+			fprintf(stderr, "%s:%d: expected %d bins, found %d\n", path, lineNumber, trace->nFftBins, nBins);
+			fclose(fp);
+			return -1;
+		}
+		trace->energy.push_back(energy < 0 ? 0 : (energy > 65535 ? 65535 : energy));
+		trace->nFrames++;
+	}
+	fclose(fp);
+
+	if (trace->nFrames == 0) {
+		fprintf(stderr, "trace %s has no frames\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+int saveFeatureTrace(const char* path, const FeatureTrace_t* trace) {
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "could not open %s for writing\n", path);
+		return -1;
+	}
+	fprintf(fp, "# energy followed by %d fft bins per frame\n", trace->nFftBins);
+	for (int i = 0; i < trace->nFrames; i++) {
+		fprintf(fp, "%d", trace->energy[i]);
+		const uint8_t* bins = &trace->fftBins[i * trace->nFftBins];
+		for (int j = 0; j < trace->nFftBins; j++) {
+			fprintf(fp, " %d", bins[j]);
+		}
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+	return 0;
+}
+
+void generateFeatureTrace(FeatureTrace_t* trace, int nFrames, int nFftBins, float bpm, int frameIntervalMs, unsigned int seed) {
+	trace->nFrames = nFrames;
+	trace->nFftBins = nFftBins;
+	trace->energy.resize(nFrames);
+	trace->fftBins.resize(nFrames * nFftBins);
+
+	float beatPeriodMs = 60000.0 / bpm;
+	for (int i = 0; i < nFrames; i++) {
+		float t = (float)i * frameIntervalMs;
+		float phase = fmodf(t, beatPeriodMs) / beatPeriodMs;
+		float kick = expf(-phase * 8.0);								// sharp attack on the beat, decays before the next
+		float hat = expf(-fabsf(phase - 0.5) * 24.0);					// a shorter hit on the off beat
+
+		float energy = 400.0 + 3000.0 * kick + 800.0 * hat + (rand_r(&seed) % 200);
+		trace->energy[i] = energy > 65535 ? 65535 : (uint16_t)energy;
+
+		uint8_t* bins = &trace->fftBins[i * nFftBins];
+		for (int j = 0; j < nFftBins; j++) {
+			float position = (float)j / nFftBins;
+			float v = 40.0 * (1.0 - position);							// spectral tilt, more energy at low frequencies
+			if (position < 0.25) {
+				v += 200.0 * kick;
+			}
+			else if (position > 0.6) {
+				v += 120.0 * hat;
+			}
+			else {
+				v += 60.0 * kick * (1.0 - position);
+			}
+			v += rand_r(&seed) % 20;
+			bins[j] = v > 255 ? 255 : (uint8_t)v;
+		}
+	}
+}
+
+int recordFeatureTrace(FeatureTrace_t* trace, int nFrames, int nFftBins) {
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(SOUND_FEATURE_DATA_PORT);
+	inet_pton(AF_INET, SOUND_FEATURE_HOST, &local.sin_addr);
+	if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+		perror("bind");
+		close(sock);
+		return -1;
+	}
+
+	// same request the simulator sends: fft enabled, number of bins, energy enabled
+	char request[32];
+	int requestLength = snprintf(request, sizeof(request), "1 %d 1", nFftBins);
+	struct sockaddr_in remote = local;
+	remote.sin_port = htons(SOUND_FEATURE_REQUEST_PORT);
+	if (sendto(sock, request, requestLength, 0, (struct sockaddr*)&remote, sizeof(remote)) < 0) {
+		perror("sendto");
+		close(sock);
+		return -1;
+	}
+
+	trace->nFrames = 0;
+	trace->nFftBins = nFftBins;
+	trace->energy.clear();
+	trace->fftBins.clear();
+
+	// each packet is nFftBins uint8 bins followed by one little endian uint16 energy
+	std::vector<uint8_t> packet(nFftBins + sizeof(uint16_t));
+	while (trace->nFrames < nFrames) {
+		ssize_t n = recv(sock, &packet[0], packet.size(), 0);
+		if (n < 0) {
+			perror("recv");
+			close(sock);
+			return -1;
+		}
+		if (n != (ssize_t)packet.size()) {
+			fprintf(stderr, "dropping packet of %zd bytes, expected %zu\n", n, packet.size());
+			continue;
+		}
+		trace->fftBins.insert(trace->fftBins.end(), packet.begin(), packet.begin() + nFftBins);
+		trace->energy.push_back(packet[nFftBins] | (packet[nFftBins + 1] << 8));
+		trace->nFrames++;
+	}
+
+	close(sock);
+	return 0;
+}
+
+void resampleFftBins(const uint8_t* in, int nIn, uint8_t* out, int nOut) {
+	if (nIn == nOut) {
+		memcpy(out, in, nOut);
+		return;
+	}
+	for (int i = 0; i < nOut; i++) {
+		int start = (i * nIn) / nOut;
+		int end = ((i + 1) * nIn) / nOut;
+		if (end <= start) {
+			out[i] = in[start];
+			continue;
+		}
+		int acc = 0;
+		for (int j = start; j < end; j++) {
+			acc += in[j];
+		}
+		out[i] = acc / (end - start);
+	}
+}
+
+void resampleFftBinsFloat(const uint8_t* in, int nIn, float* out, int nOut) {
+	for (int i = 0; i < nOut; i++) {
+		int start = (i * nIn) / nOut;
+		int end = ((i + 1) * nIn) / nOut;
+		if (end <= start) {
+			out[i] = in[start];
+			continue;
+		}
+		int acc = 0;
+		for (int j = start; j < end; j++) {
+			acc += in[j];
+		}
+		out[i] = (float)acc / (end - start);
+	}
+}
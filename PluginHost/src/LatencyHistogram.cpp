@@ -0,0 +1,104 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LatencyHistogram.cpp
+ */
+
+#include "LatencyHistogram.h"
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+void LatencyHistogram::reset() {
+	memset(buckets, 0, sizeof(buckets));
+	count = 0;
+	sum = 0;
+	min = UINT64_MAX;
+	max = 0;
+}
+
+/**
+ * values below 2*LATENCY_SUB_BUCKETS get a bucket each, above that every power of two
+ * is split into LATENCY_SUB_BUCKETS buckets
+ */
+int LatencyHistogram::bucketIndex(uint64_t value) {
+	if (value < 2 * LATENCY_SUB_BUCKETS) {
+		return value;
+	}
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - LATENCY_SUB_BUCKET_BITS;
+	int mantissa = value >> shift;
+	return 2 * LATENCY_SUB_BUCKETS + (shift - 1) * LATENCY_SUB_BUCKETS + (mantissa - LATENCY_SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+	if (index < 2 * LATENCY_SUB_BUCKETS) {
+		return index;
+	}
+	int shift = (index - 2 * LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS + 1;
+	uint64_t mantissa = (index - 2 * LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS;
+	return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+	buckets[bucketIndex(ns)]++;
+	count++;
+	sum += ns;
+	if (ns < min) {
+		min = ns;
+	}
+	if (ns > max) {
+		max = ns;
+	}
+}
+
+uint64_t LatencyHistogram::getPercentile(double quantile) const {
+	if (count == 0) {
+		return 0;
+	}
+	uint64_t target = (uint64_t)(quantile * count + 0.5);
+	if (target < 1) {
+		target = 1;
+	}
+	uint64_t seen = 0;
+	for (int i = 0; i < LATENCY_N_BUCKETS; i++) {
+		seen += buckets[i];
+		if (seen >= target) {
+			uint64_t bound = bucketUpperBound(i);
+			return bound > max ? max : bound;
+		}
+	}
+	return max;
+}
+
+uint64_t LatencyHistogram::getCount() const {
+	return count;
+}
+
+uint64_t LatencyHistogram::getMin() const {
+	return count ? min : 0;
+}
+
+uint64_t LatencyHistogram::getMax() const {
+	return max;
+}
+
+double LatencyHistogram::getMean() const {
+	return count ? (double)sum / count : 0.0;
+}
@@ -0,0 +1,122 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LayoutGenerator.cpp
+ */
+
+#include "LayoutGenerator.h"
+#include <stdio.h>
+#include <math.h>
+
+#define SHAPE_ID_TRIANGLE 0
+#define SHAPE_ID_SQUARE (2 * 256)
+
+static const int paletteHues[][3] = {
+		{255, 0, 0},
+		{255, 128, 0},
+		{255, 255, 0},
+		{0, 255, 0},
+		{0, 255, 255},
+		{0, 0, 255},
+		{255, 0, 255},
+};
+
+static void addPanel(LayoutStream_t* layout, int panelId, int x, int y, int orientation) {
+	layout->stream.push_back(panelId);
+	layout->stream.push_back(x);
+	layout->stream.push_back(y);
+	layout->stream.push_back(orientation);
+	layout->nPanels++;
+}
+
+int generateTriangleLayout(LayoutStream_t* layout, int nPanels, int globalOrientation) {
+	if (nPanels < 1 || nPanels > MAX_PANELS_PER_SHAPE) {
+		fprintf(stderr, "a triangle layout must have between 1 and %d panels\n", MAX_PANELS_PER_SHAPE);
+		return -1;
+	}
+	layout->nPanels = 0;
+	layout->stream.clear();
+	layout->stream.push_back(globalOrientation);
+	layout->stream.push_back(AURORA_SIDE_LENGTH);
+
+	// adjacent triangles in a row alternate between pointing up and down, half a side apart
+	double columnStep = AURORA_SIDE_LENGTH / 2.0;
+	double rowHeight = AURORA_SIDE_LENGTH * sqrt(3.0) / 2.0;
+	int nColumns = (int)ceil(sqrt(nPanels * rowHeight / columnStep));
+
+	for (int i = 0; i < nPanels; i++) {
+		int row = i / nColumns;
+		int column = i % nColumns;
+		bool pointsUp = ((row + column) % 2) == 0;
+		double x = column * columnStep;
+		double y = row * rowHeight + (pointsUp ? rowHeight / 3.0 : 2.0 * rowHeight / 3.0);
+		addPanel(layout, SHAPE_ID_TRIANGLE + i + 1, (int)lround(x), (int)lround(y), pointsUp ? 0 : 60);
+	}
+	return 0;
+}
+
+int generateSquareLayout(LayoutStream_t* layout, int nPanels, int globalOrientation) {
+	if (nPanels < 1 || nPanels > MAX_PANELS_PER_SHAPE) {
+		fprintf(stderr, "a square layout must have between 1 and %d panels\n", MAX_PANELS_PER_SHAPE);
+		return -1;
+	}
+	layout->nPanels = 0;
+	layout->stream.clear();
+	layout->stream.push_back(globalOrientation);
+	layout->stream.push_back(AURORA_SIDE_LENGTH);
+
+	int nColumns = (int)ceil(sqrt((double)nPanels));
+	for (int i = 0; i < nPanels; i++) {
+		int x = (i % nColumns) * AURORA_SIDE_LENGTH + AURORA_SIDE_LENGTH / 2;
+		int y = (i / nColumns) * AURORA_SIDE_LENGTH + AURORA_SIDE_LENGTH / 2;
+		addPanel(layout, SHAPE_ID_SQUARE + i + 1, x, y, 0);
+	}
+	return 0;
+}
+
+int loadLayout(const char* path, LayoutStream_t* layout) {
+	FILE* fp = fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "could not open layout %s\n", path);
+		return -1;
+	}
+	layout->stream.clear();
+	int value;
+	while (fscanf(fp, "%d", &value) == 1) {
+		layout->stream.push_back(value);
+	}
+	fclose(fp);
+
+	int n = layout->stream.size() - LAYOUT_HEADER_LENGTH;
+	if (n < LAYOUT_INTS_PER_PANEL || (n % LAYOUT_INTS_PER_PANEL) != 0) {
+		fprintf(stderr, "layout %s must have %d header ints and %d ints per panel\n", path,
+				LAYOUT_HEADER_LENGTH, LAYOUT_INTS_PER_PANEL);
+		return -1;
+	}
+	layout->nPanels = n / LAYOUT_INTS_PER_PANEL;
+	return 0;
+}
+
+void generatePalette(std::vector<int>* palette, int nColors) {
+	int nHues = sizeof(paletteHues) / sizeof(paletteHues[0]);
+	palette->clear();
+	for (int i = 0; i < nColors; i++) {
+		palette->push_back(paletteHues[i % nHues][0]);
+		palette->push_back(paletteHues[i % nHues][1]);
+		palette->push_back(paletteHues[i % nHues][2]);
+	}
+}
@@ -0,0 +1,192 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PanelStream.cpp
+ */
+
+#include "PanelStream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the frames are sent as they are in memory, which must be little endian"
+#endif
+
+static void put16(uint8_t* p, uint16_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static void put64(uint8_t* p, uint64_t v) {
+	put32(p, v);
+	put32(p + 4, v >> 32);
+}
+
+static uint16_t get16(const uint8_t* p) {
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static uint64_t get64(const uint8_t* p) {
+	return get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+int openPanelStreamer(PanelStreamer_t* streamer, int nDevices, int batchSize, int port) {
+	memset(streamer, 0, sizeof(*streamer));
+	streamer->sock = -1;
+	if (nDevices < 1 || nDevices > PANEL_STREAM_MAX_DEVICES || batchSize < 1 || batchSize > PANEL_STREAM_MAX_BATCH) {
+		fprintf(stderr, "streaming needs 1 to %d devices and 1 to %d packets per batch\n", PANEL_STREAM_MAX_DEVICES,
+				PANEL_STREAM_MAX_BATCH);
+		return -1;
+	}
+	streamer->nDevices = nDevices;
+	streamer->batchSize = batchSize;
+	streamer->headers = (uint8_t*)calloc(nDevices, PANEL_STREAM_HEADER_BYTES);
+	streamer->iov = (struct iovec*)calloc(2 * nDevices, sizeof(struct iovec));
+	streamer->messages = (struct mmsghdr*)calloc(nDevices, sizeof(struct mmsghdr));
+	if (streamer->headers == NULL || streamer->iov == NULL || streamer->messages == NULL) {
+		fprintf(stderr, "out of memory for %d devices\n", nDevices);
+		closePanelStreamer(streamer);
+		return -1;
+	}
+	streamer->sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (streamer->sock < 0) {
+		perror("socket");
+		closePanelStreamer(streamer);
+		return -1;
+	}
+	streamer->remote.sin_family = AF_INET;
+	streamer->remote.sin_port = htons(port);
+	streamer->remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	// everything but the frame pointer, the lengths and the changing header fields is set once
+	for (int d = 0; d < nDevices; d++) {
+		uint8_t* header = streamer->headers + d * PANEL_STREAM_HEADER_BYTES;
+		put16(header, PANEL_STREAM_MAGIC);
+		header[2] = PANEL_STREAM_VERSION;
+		header[3] = 0;
+		put16(header + 4, d);
+		struct iovec* iov = streamer->iov + 2 * d;
+		iov[0].iov_base = header;
+		iov[0].iov_len = PANEL_STREAM_HEADER_BYTES;
+		struct msghdr* message = &streamer->messages[d].msg_hdr;
+		message->msg_name = &streamer->remote;
+		message->msg_namelen = sizeof(streamer->remote);
+		message->msg_iov = iov;
+		message->msg_iovlen = 2;
+	}
+	return 0;
+}
+
+int streamPanelFrames(PanelStreamer_t* streamer, const PackedFrame_t* frames, int nFrames) {
+	if (nFrames > PANEL_STREAM_MAX_FRAMES) {
+		nFrames = PANEL_STREAM_MAX_FRAMES;
+	}
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	uint64_t sendNs = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	size_t frameBytes = nFrames * sizeof(PackedFrame_t);
+	for (int d = 0; d < streamer->nDevices; d++) {
+		uint8_t* header = streamer->headers + d * PANEL_STREAM_HEADER_BYTES;
+		put16(header + 6, nFrames);
+		put32(header + 8, streamer->sequence);
+		put64(header + 12, sendNs);
+		struct iovec* iov = streamer->iov + 2 * d;
+		iov[1].iov_base = (void*)frames;
+		iov[1].iov_len = frameBytes;
+	}
+	streamer->sequence++;
+
+	int nSent = 0;
+	while (nSent < streamer->nDevices) {
+		int n = streamer->nDevices - nSent;
+		if (n > streamer->batchSize) {
+			n = streamer->batchSize;
+		}
+		int sent = sendmmsg(streamer->sock, streamer->messages + nSent, n, MSG_DONTWAIT);
+		streamer->nSyscalls++;
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+				// a full buffer stays full for the rest of the call, drop what is left
+				streamer->nDropped += streamer->nDevices - nSent;
+				break;
+			}
+			perror("sendmmsg");
+			return -1;
+		}
+		nSent += sent;
+	}
+	streamer->nPackets += nSent;
+	streamer->nBytes += (uint64_t)nSent * (PANEL_STREAM_HEADER_BYTES + frameBytes);
+	return nSent;
+}
+
+void resetPanelStreamCounts(PanelStreamer_t* streamer) {
+	streamer->nPackets = 0;
+	streamer->nBytes = 0;
+	streamer->nSyscalls = 0;
+	streamer->nDropped = 0;
+}
+
+void closePanelStreamer(PanelStreamer_t* streamer) {
+	if (streamer->sock >= 0) {
+		close(streamer->sock);
+		streamer->sock = -1;
+	}
+	free(streamer->headers);
+	free(streamer->iov);
+	free(streamer->messages);
+	streamer->headers = NULL;
+	streamer->iov = NULL;
+	streamer->messages = NULL;
+}
+
+int decodePanelHeader(const uint8_t* buffer, int length, PanelHeader_t* header) {
+	if (length < 2 || get16(buffer) != PANEL_STREAM_MAGIC) {
+		return PANEL_STREAM_NOT_OURS;
+	}
+	if (length < PANEL_STREAM_HEADER_BYTES) {
+		return PANEL_STREAM_TRUNCATED;
+	}
+	if (buffer[2] != PANEL_STREAM_VERSION) {
+		return PANEL_STREAM_BAD_VERSION;
+	}
+	header->device = get16(buffer + 4);
+	header->nFrames = get16(buffer + 6);
+	header->sequence = get32(buffer + 8);
+	header->sendNs = get64(buffer + 12);
+	if (PANEL_STREAM_HEADER_BYTES + header->nFrames * sizeof(PackedFrame_t) > (size_t)length) {
+		return PANEL_STREAM_TRUNCATED;
+	}
+	return PANEL_STREAM_OK;
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PluginHost.cpp
+ *
+ *  Loading and symbol resolution for libAuroraPlugin.so
+ */
+
+#include "PluginHost.h"
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @description: resolve one symbol out of the plugin or any library it depends on
+ * @return: 0 if found, -1 otherwise
+ */
+template <typename T>
+static int resolve(void* handle, const char* name, T* fn) {
+	dlerror();
+	void* sym = dlsym(handle, name);
+	const char* err = dlerror();
+	if (err != NULL || sym == NULL) {
+		fprintf(stderr, "could not resolve %s: %s\n", name, err ? err : "null symbol");
+		return -1;
+	}
+	*fn = reinterpret_cast<T>(sym);
+	return 0;
+}
+
+int loadPlugin(const char* path, PluginApi_t* api) {
+	memset(api, 0, sizeof(PluginApi_t));
+
+	api->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (api->handle == NULL) {
+		fprintf(stderr, "could not load %s: %s\n", path, dlerror());
+		return -1;
+	}
+
+	int err = 0;
+	err |= resolve(api->handle, "initPlugin", &api->initPlugin);
+	err |= resolve(api->handle, "getPluginFrame", &api->getPluginFrame);
+	err |= resolve(api->handle, "pluginCleanup", &api->pluginCleanup);
+	err |= resolve(api->handle, "passLayoutData", &api->passLayoutData);
+	err |= resolve(api->handle, "passColorPalette", &api->passColorPalette);
+	err |= resolve(api->handle, "dataManagerCleanup", &api->dataManagerCleanup);
+	err |= resolve(api->handle, "getEnabledFeatures", &api->getEnabledFeatures);
+	err |= resolve(api->handle, "initRhythmFeatures", &api->initRhythmFeatures);
+	err |= resolve(api->handle, "updateRhythmFeatures", &api->updateRhythmFeatures);
+	err |= resolve(api->handle, "deinitRhythmFeatures", &api->deinitRhythmFeatures);
+	err |= resolve(api->handle, "initBeatFeatures", &api->initBeatFeatures);
+	err |= resolve(api->handle, "updateBeatFeatures", &api->updateBeatFeatures);
+	err |= resolve(api->handle, "deinitBeatFeatures", &api->deinitBeatFeatures);
+
+	if (err) {
+		unloadPlugin(api);
+		return -1;
+	}
+
+	// optional entry points, looked up without complaining when they are missing
+	api->getPluginFramePacked = reinterpret_cast<void (*)(PackedFrame_t*, int*, int*)>(
+			dlsym(api->handle, "getPluginFramePacked"));
+	api->resetProfile = reinterpret_cast<void (*)(void)>(dlsym(api->handle, "resetProfile"));
+	api->dumpProfile = reinterpret_cast<void (*)(FILE*)>(dlsym(api->handle, "dumpProfile"));
+	api->flushLog = reinterpret_cast<void (*)(void)>(dlsym(api->handle, "flushLog"));
+	api->updateSpectrumFeatures = reinterpret_cast<void (*)(SpectrumFeatures_t*)>(
+			dlsym(api->handle, "updateSpectrumFeatures"));
+	return 0;
+}
+
+void unloadPlugin(PluginApi_t* api) {
+	if (api->handle) {
+		dlclose(api->handle);
+	}
+	memset(api, 0, sizeof(PluginApi_t));
+}
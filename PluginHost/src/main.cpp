@@ -0,0 +1,674 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * main.cpp
+ *
+ *  Headless plugin host. Loads one or more plugins, feeds them a layout, a palette and a sound
+ *  feature trace or the live features of a shared memory ring or of the binary UDP protocol, calls
+ *  getPluginFrame at a fixed rate or as fast as possible, and reports the latency and throughput of
+ *  every plugin.
+ */
+
+#include "PluginHost.h"
+#include "FeatureTrace.h"
+#include "FeatureRing.h"
+#include "FeatureReceiver.h"
+#include "FeatureChecks.h"
+#include "LayoutGenerator.h"
+#include "LatencyHistogram.h"
+#include "FrameDiffer.h"
+#include "PackedFrame.h"
+#include "PanelStream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DEFAULT_N_PANELS 30
+#define DEFAULT_N_COLORS 5
+#define DEFAULT_N_FRAMES 2000
+#define DEFAULT_N_WARMUP_FRAMES 20
+#define DEFAULT_N_FFT_BINS 32
+#define DEFAULT_BPM 120.0
+#define SOUND_FRAME_INTERVAL_MS 50		/*the sound module delivers a feature frame every 50ms*/
+#define NS_PER_SEC 1000000000ULL
+#define RING_POLL_NS 200000ULL			/*how often to look for a new frame in the ring while waiting*/
+#define RING_TIMEOUT_MS 2000			/*give up when the producer sends nothing for this long*/
+#define UDP_TIMEOUT_MS 2000				/*the same for the binary protocol*/
+#define UDP_REQUEST_TIMEOUT_MS 10000	/*how long to keep asking a producer that does not answer*/
+#define DEFAULT_MAX_AGE_MS 100			/*frames older than this are stale, about two frame intervals*/
+#define DEFAULT_STREAM_BATCH 64			/*packets per sendmmsg*/
+
+struct HostConfig_t {
+	const char* layoutPath;
+	const char* tracePath;
+	const char* recordPath;
+	double checkSeconds;	/*run the self checks of the feature protocol and ring instead, the ring for this long*/
+	const char* ringName;	/*NULL to replay the trace instead of reading the ring*/
+	bool udp;				/*request features over the binary protocol instead*/
+	int maxAgeMs;			/*drop protocol frames older than this*/
+	int nPanels;
+	bool squares;
+	int globalOrientation;
+	int nColors;
+	int nFrames;
+	int nWarmupFrames;
+	int nFftBins;
+	float bpm;
+	double rateHz;			/*0 to call getPluginFrame as fast as possible*/
+	bool quiet;
+	int diffThreshold;		/*-1 to keep the plugin's frames as they are*/
+	bool packed;			/*hand the frames on as PackedFrame_t*/
+	bool profile;			/*print the Profiler.h timers and counters of the plugin*/
+	int nDevices;			/*devices to stream the frames to, 0 for none*/
+	int streamBatch;
+};
+
+struct FrameStats_t {
+	LatencyHistogram frameLatency;		/*getPluginFrame only*/
+	LatencyHistogram featureLatency;	/*updateRhythmFeatures + updateBeatFeatures*/
+	LatencyHistogram diffLatency;		/*diffFrames*/
+	LatencyHistogram packLatency;		/*packFrames, when the plugin does not pack its own frames*/
+	LatencyHistogram featureAge;		/*capture of a ring frame to its update of the features*/
+	LatencyHistogram lightLatency;		/*capture of a protocol frame to the plugin frame made from it*/
+	LatencyHistogram streamLatency;		/*packing if needed and streamPanelFrames for every device*/
+	bool nativePacked;					/*the plugin exports getPluginFramePacked*/
+	uint64_t initNs;
+	uint64_t cleanupNs;
+	uint64_t wallNs;
+	int nCalls;
+	int minFrames;
+	int maxFrames;
+	uint64_t totalFrames;
+	uint64_t nEmitted;					/*frames left by diffFrames*/
+	uint64_t nSuppressed;				/*frames removed by diffFrames*/
+	uint64_t nRingFrames;				/*new frames read from the ring*/
+	uint64_t nRingRepeated;				/*calls that found no new frame and reused the last one*/
+	uint64_t nRingSkipped;				/*frames published while the host was busy and never read*/
+	uint64_t nUdpFrames;				/*new frames received over the protocol*/
+	uint64_t nUdpRepeated;				/*calls that received no new frame and reused the last one*/
+	uint64_t nUdpLost;					/*sequence numbers that never arrived*/
+	uint64_t nUdpLate;					/*arrived after a newer frame and dropped*/
+	uint64_t nUdpDuplicate;				/*the newest frame again and dropped*/
+	uint64_t nUdpStale;					/*older than maxAgeMs when they arrived and dropped*/
+	uint64_t nStreamPackets;
+	uint64_t nStreamBytes;
+	uint64_t nStreamSyscalls;
+	uint64_t nStreamDropped;
+};
+
+static FILE* report = stdout;
+
+static uint64_t nowNs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void sleepUntilNs(uint64_t deadline) {
+	struct timespec ts;
+	ts.tv_sec = deadline / NS_PER_SEC;
+	ts.tv_nsec = deadline % NS_PER_SEC;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+	}
+}
+
+static void usage(const char* name) {
+	fprintf(stderr,
+			"usage: %s [options] libAuroraPlugin.so [libAuroraPlugin.so ...]\n"
+			"       %s -R trace.txt [-f frames] [-k bins]\n"
+			"       %s -X seconds\n"
+			"  -l file   layout stream to use (globalOrientation sideLength {id x y orientation}...)\n"
+			"  -n N      generate a layout of N panels (default %d, at most %d)\n"
+			"  -s        generate squares instead of triangles\n"
+			"  -o deg    global orientation of the generated layout (default 0)\n"
+			"  -c N      number of palette colours (default %d)\n"
+			"  -t file   replay a recorded feature trace (default: synthetic)\n"
+			"  -S name   read live features from the shared memory ring of FeatureExtractor -m, - for %s\n"
+			"  -U        request live features from FeatureExtractor -u -w over the binary protocol\n"
+			"  -A ms     with -U, drop frames captured longer ago than this (default %d)\n"
+			"  -b bpm    tempo of the synthetic trace (default %.0f)\n"
+			"  -k N      fft bins of the synthetic or recorded trace (default %d)\n"
+			"  -f N      number of measured frames (default %d)\n"
+			"  -w N      number of warmup frames not measured (default %d)\n"
+			"  -r hz     call rate, 0 for as fast as possible (default 0)\n"
+			"  -q        discard the plugins' stdout\n"
+			"  -d N      only keep frames whose colour moved by more than N or whose transTime changed\n"
+			"  -p        use packed frames, from getPluginFramePacked if the plugin exports it\n"
+			"  -P        print the PROFILE_SCOPE timers and PROFILE_COUNT counters of the plugin\n"
+			"  -D N      stream every frame to N devices over UDP, e.g. to PanelStandIn on port %d\n"
+			"  -B N      with -D, packets per sendmmsg call, 1 to %d (default %d)\n"
+			"  -R file   record a trace from music_processor.py and exit\n"
+			"  -X s      check the feature protocol, and the feature ring with a producer running flat out and %d readers\n"
+			"            for s seconds, and exit\n",
+			name, name, name, DEFAULT_N_PANELS, MAX_PANELS_PER_SHAPE, DEFAULT_N_COLORS, FEATURE_RING_DEFAULT_NAME,
+			DEFAULT_MAX_AGE_MS, DEFAULT_BPM,
+			DEFAULT_N_FFT_BINS, DEFAULT_N_FRAMES, DEFAULT_N_WARMUP_FRAMES, PANEL_STREAM_PORT, PANEL_STREAM_MAX_BATCH,
+			DEFAULT_STREAM_BATCH, FEATURE_CHECK_RING_READERS);
+}
+
+/**
+ * @description: get the newest frame of the ring. With wait set and no frame since the last one, poll the count
+ * every RING_POLL_NS until one arrives. Polling is a single load, a frame is only copied when it is new
+ * @params nSeen: count of the ring when the last frame was taken, updated
+ * @return: 1 for a new frame, 0 if frame still holds the newest one, -1 if none arrived for RING_TIMEOUT_MS
+ */
+static int nextRingFrame(const FeatureRing_t* ring, FeatureRingFrame_t* frame, uint64_t* nSeen, bool wait) {
+	uint64_t waitStart = nowNs();
+	while (true) {
+		// a count below nSeen means the producer restarted, which is new as well
+		if (getFeatureRingCount(ring) != *nSeen) {
+			FeatureRingFrame_t latest;
+			if (readLatestFeatureFrame(ring, &latest) == FEATURE_RING_OK) {
+				memcpy(frame, &latest, sizeof(latest));
+				*nSeen = latest.sequence + 1;
+				return 1;
+			}
+		}
+		if (!wait && *nSeen > 0) {
+			return 0;
+		}
+		if (nowNs() - waitStart > RING_TIMEOUT_MS * (NS_PER_SEC / 1000)) {
+			return -1;
+		}
+		sleepUntilNs(nowNs() + RING_POLL_NS);
+	}
+}
+
+/**
+ * @description: load, run and unload one plugin
+ * @return: 0 on success, -1 if the plugin could not be loaded
+ */
+static int runPlugin(const char* path, const HostConfig_t* config, LayoutStream_t* layout,
+		std::vector<int>* palette, const FeatureTrace_t* trace, const FeatureRing_t* ring, FeatureReceiver_t* receiver,
+		PanelStreamer_t* streamer, FrameStats_t* stats) {
+	PluginApi_t api;
+	if (loadPlugin(path, &api) < 0) {
+		return -1;
+	}
+
+	api.passLayoutData(&layout->stream[0], layout->nPanels);
+	api.passColorPalette(&(*palette)[0], config->nColors);
+
+	uint64_t start = nowNs();
+	api.initPlugin();
+	stats->initNs = nowNs() - start;
+
+	EnabledFeatures_t* enabled = api.getEnabledFeatures();
+	api.initRhythmFeatures();
+	if (enabled->beat) {
+		api.initBeatFeatures();
+	}
+
+	int nBins = enabled->nFftBins;
+	std::vector<uint8_t> bins(nBins > 0 ? nBins : 1);
+	RhythmFeatures_t features;
+	memset(&features, 0, sizeof(features));
+	features.fftBins = &bins[0];
+	features.nFftBins = nBins;
+
+	// the trace only has 8 bit bins, but averaging them down to the plugin's bins keeps fractions
+	bool pushSpectrum = api.updateSpectrumFeatures != NULL && nBins > 0;
+	std::vector<float> binsFloat(pushSpectrum ? nBins : 1);
+	SpectrumFeatures_t spectrum = {&binsFloat[0], (uint16_t)(pushSpectrum ? nBins : 0), 0};
+
+	// the plugin may write one frame per panel
+	std::vector<Frame_t> frames(layout->nPanels);
+	std::vector<PackedFrame_t> packed(config->packed || streamer ? layout->nPanels : 0);
+	bool nativePacked = config->packed && api.getPluginFramePacked != NULL;
+	FrameDiffer_t differ;
+	initFrameDiffer(&differ, config->diffThreshold);
+	stats->frameLatency.reset();
+	stats->featureLatency.reset();
+	stats->diffLatency.reset();
+	stats->packLatency.reset();
+	stats->featureAge.reset();
+	stats->nRingFrames = 0;
+	stats->nRingRepeated = 0;
+	stats->nRingSkipped = 0;
+	stats->lightLatency.reset();
+	stats->nUdpFrames = 0;
+	stats->nUdpRepeated = 0;
+	stats->nUdpLost = 0;
+	stats->nUdpLate = 0;
+	stats->nUdpDuplicate = 0;
+	stats->nUdpStale = 0;
+	stats->streamLatency.reset();
+	stats->nativePacked = nativePacked;
+	stats->nCalls = 0;
+	stats->minFrames = layout->nPanels;
+	stats->maxFrames = 0;
+	stats->totalFrames = 0;
+
+	uint64_t period = config->rateHz > 0 ? (uint64_t)(NS_PER_SEC / config->rateHz) : 0;
+	int total = config->nWarmupFrames + config->nFrames;
+	uint64_t deadline = nowNs();
+	uint64_t wallStart = 0;
+	FeatureRingFrame_t ringFrame;
+	uint64_t nRingSeen = 0;
+	FeatureSequence_t udpBase;		/*counts of the receiver when measuring started*/
+	resetFeatureSequence(&udpBase);
+	uint64_t nUdpStaleBase = 0;
+
+	if (receiver) {
+		// the host resamples any bins, asking for the plugin's own saves it the work
+		FeatureCapabilities_t wanted;
+		wanted.featureMask = FEATURE_MASK_ENERGY | FEATURE_MASK_FFT;
+		wanted.nFftBins = nBins > 0 ? nBins : config->nFftBins;
+		wanted.intervalMs = SOUND_FRAME_INTERVAL_MS;
+		if (requestFeatures(receiver, &wanted, UDP_REQUEST_TIMEOUT_MS) < 0) {
+			total = 0;
+		}
+		udpBase = receiver->sequence;
+	}
+
+	for (int i = 0; i < total; i++) {
+		bool measured = i >= config->nWarmupFrames;
+		if (i == config->nWarmupFrames) {
+			wallStart = nowNs();
+			if (receiver) {
+				udpBase = receiver->sequence;
+				nUdpStaleBase = receiver->nStale;
+			}
+			if (streamer) {
+				resetPanelStreamCounts(streamer);
+			}
+			if (config->profile && api.resetProfile) {
+				api.resetProfile();
+			}
+		}
+		if (period) {
+			deadline += period;
+			sleepUntilNs(deadline);
+		}
+
+		const uint8_t* frameBins;
+		int nFrameBins;
+		int udpFresh = 0;
+		if (ring) {
+			uint64_t previous = nRingSeen;
+			int fresh = nextRingFrame(ring, &ringFrame, &nRingSeen, period == 0);
+			if (fresh < 0) {
+				fprintf(stderr, "%s: no features in the ring for %d ms, stopping\n", path, RING_TIMEOUT_MS);
+				break;
+			}
+			if (measured) {
+				stats->nRingFrames += fresh;
+				stats->nRingRepeated += !fresh;
+				stats->nRingSkipped += fresh && previous > 0 && nRingSeen > previous + 1 ? nRingSeen - previous - 1 : 0;
+			}
+			features.energy = ringFrame.energy;
+			frameBins = ringFrame.fftBins;
+			nFrameBins = ringFrame.nFftBins;
+		}
+		else if (receiver) {
+			// without pacing every call waits for a new frame, paced calls reuse the last one
+			bool wait = period == 0 || !receiver->hasFrame;
+			udpFresh = receiveFeatures(receiver, wait ? UDP_TIMEOUT_MS : 0);
+			if (udpFresh < 0 || (wait && udpFresh == 0)) {
+				fprintf(stderr, "%s: no features from the producer for %d ms, stopping\n", path, UDP_TIMEOUT_MS);
+				break;
+			}
+			if (measured) {
+				stats->nUdpFrames += udpFresh;
+				stats->nUdpRepeated += !udpFresh;
+			}
+			features.energy = receiver->latest.energy;
+			frameBins = receiver->latest.fftBins;
+			nFrameBins = receiver->latest.nFftBins;
+		}
+		else {
+			int t = i % trace->nFrames;
+			features.energy = trace->energy[t];
+			frameBins = &trace->fftBins[t * trace->nFftBins];
+			nFrameBins = trace->nFftBins;
+		}
+		if (nBins > 0 && nFrameBins > 0) {
+			resampleFftBins(frameBins, nFrameBins, &bins[0], nBins);
+		}
+		if (pushSpectrum && nFrameBins > 0) {
+			resampleFftBinsFloat(frameBins, nFrameBins, &binsFloat[0], nBins);
+		}
+
+		start = nowNs();
+		api.updateRhythmFeatures(&features);
+		if (pushSpectrum) {
+			api.updateSpectrumFeatures(&spectrum);
+		}
+		if (enabled->beat) {
+			api.updateBeatFeatures();
+		}
+		uint64_t featuresDone = nowNs();
+
+		int nFrames = 0;
+		int sleepTime = 0;
+		if (nativePacked) {
+			api.getPluginFramePacked(&packed[0], &nFrames, &sleepTime);
+		}
+		else {
+			api.getPluginFrame(&frames[0], &nFrames, &sleepTime);
+		}
+		uint64_t end = nowNs();
+
+		if (config->packed && !nativePacked) {
+			nFrames = packFrames(&frames[0], nFrames, &packed[0]);
+			if (measured) {
+				stats->packLatency.record(nowNs() - end);
+			}
+		}
+
+		if (config->diffThreshold >= 0) {
+			if (i == config->nWarmupFrames) {
+				differ.nEmitted = 0;
+				differ.nSuppressed = 0;
+			}
+			uint64_t diffStart = nowNs();
+			if (config->packed) {
+				nFrames = diffPackedFrames(&differ, &packed[0], nFrames);
+			}
+			else {
+				nFrames = diffFrames(&differ, &frames[0], nFrames);
+			}
+			if (measured) {
+				stats->diffLatency.record(nowNs() - diffStart);
+			}
+		}
+
+		if (streamer) {
+			uint64_t streamStart = nowNs();
+			if (!config->packed) {
+				nFrames = packFrames(&frames[0], nFrames, &packed[0]);
+			}
+			if (streamPanelFrames(streamer, &packed[0], nFrames) < 0) {
+				break;
+			}
+			if (measured) {
+				stats->streamLatency.record(nowNs() - streamStart);
+			}
+		}
+
+		if (measured) {
+			if (ring) {
+				stats->featureAge.record(start - ringFrame.captureNs);
+			}
+			if (udpFresh) {
+				stats->lightLatency.record(end - receiver->latest.captureNs);
+			}
+			stats->featureLatency.record(featuresDone - start);
+			stats->frameLatency.record(end - featuresDone);
+			stats->nCalls++;
+			stats->totalFrames += nFrames;
+			if (nFrames < stats->minFrames) {
+				stats->minFrames = nFrames;
+			}
+			if (nFrames > stats->maxFrames) {
+				stats->maxFrames = nFrames;
+			}
+		}
+	}
+	stats->wallNs = nowNs() - wallStart;
+	stats->nEmitted = differ.nEmitted;
+	stats->nSuppressed = differ.nSuppressed;
+	if (receiver) {
+		stats->nUdpLost = receiver->sequence.nLost - udpBase.nLost;
+		stats->nUdpLate = receiver->sequence.nLate - udpBase.nLate;
+		stats->nUdpDuplicate = receiver->sequence.nDuplicate - udpBase.nDuplicate;
+		stats->nUdpStale = receiver->nStale - nUdpStaleBase;
+	}
+	if (streamer) {
+		stats->nStreamPackets = streamer->nPackets;
+		stats->nStreamBytes = streamer->nBytes;
+		stats->nStreamSyscalls = streamer->nSyscalls;
+		stats->nStreamDropped = streamer->nDropped;
+	}
+	if (config->profile) {
+		// printed before the stats of the plugin, as the library goes away with it
+		fprintf(report, "%s profile\n", path);
+		if (api.dumpProfile) {
+			api.dumpProfile(report);
+		}
+		else {
+			fprintf(report, "  the utilities library of this plugin has no profiler\n");
+		}
+	}
+
+	start = nowNs();
+	api.pluginCleanup();
+	stats->cleanupNs = nowNs() - start;
+	// the plugin logs through a background thread, let it finish before the report is printed
+	if (api.flushLog) {
+		api.flushLog();
+	}
+
+	if (enabled->beat) {
+		api.deinitBeatFeatures();
+	}
+	api.deinitRhythmFeatures();
+	api.dataManagerCleanup();
+	unloadPlugin(&api);
+	return 0;
+}
+
+static void printStats(const char* path, const HostConfig_t* config, const LayoutStream_t* layout,
+		const FrameStats_t* stats) {
+	const LatencyHistogram& h = stats->frameLatency;
+	const LatencyHistogram& f = stats->featureLatency;
+	double seconds = (double)stats->wallNs / NS_PER_SEC;
+
+	fprintf(report, "%s\n", path);
+	fprintf(report, "  panels %d, calls %d, initPlugin %.1f us, pluginCleanup %.1f us\n",
+			layout->nPanels, stats->nCalls, stats->initNs / 1e3, stats->cleanupNs / 1e3);
+	fprintf(report, "  getPluginFrame us: min %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f mean %.2f\n",
+			h.getMin() / 1e3, h.getPercentile(0.50) / 1e3, h.getPercentile(0.90) / 1e3,
+			h.getPercentile(0.99) / 1e3, h.getMax() / 1e3, h.getMean() / 1e3);
+	fprintf(report, "  feature update us: p50 %.2f p99 %.2f max %.2f\n",
+			f.getPercentile(0.50) / 1e3, f.getPercentile(0.99) / 1e3, f.getMax() / 1e3);
+	fprintf(report, "  nFrames per call: min %d mean %.1f max %d\n",
+			stats->nCalls ? stats->minFrames : 0,
+			stats->nCalls ? (double)stats->totalFrames / stats->nCalls : 0.0, stats->maxFrames);
+	fprintf(report, "  throughput: %.1f calls/s, %.0f panel frames/s\n",
+			seconds > 0 ? stats->nCalls / seconds : 0.0, seconds > 0 ? stats->totalFrames / seconds : 0.0);
+	if (config->diffThreshold >= 0) {
+		const LatencyHistogram& d = stats->diffLatency;
+		uint64_t total = stats->nEmitted + stats->nSuppressed;
+		fprintf(report, "  delta frames (threshold %d): emitted %llu suppressed %llu (%.1f%% suppressed), "
+				"diffFrames us p50 %.2f p99 %.2f\n", config->diffThreshold,
+				(unsigned long long)stats->nEmitted, (unsigned long long)stats->nSuppressed,
+				total ? 100.0 * stats->nSuppressed / total : 0.0,
+				d.getPercentile(0.50) / 1e3, d.getPercentile(0.99) / 1e3);
+	}
+	if (config->ringName) {
+		const LatencyHistogram& a = stats->featureAge;
+		fprintf(report, "  ring %s: %llu new frames, %llu calls reused a frame, %llu frames skipped, "
+				"age ms p50 %.2f p99 %.2f max %.2f\n", config->ringName, (unsigned long long)stats->nRingFrames,
+				(unsigned long long)stats->nRingRepeated, (unsigned long long)stats->nRingSkipped,
+				a.getPercentile(0.50) / 1e6, a.getPercentile(0.99) / 1e6, a.getMax() / 1e6);
+	}
+	if (config->udp) {
+		const LatencyHistogram& l = stats->lightLatency;
+		fprintf(report, "  udp: %llu new frames, %llu calls reused a frame, %llu lost, %llu late, %llu duplicate, %llu stale (over %d ms)\n",
+				(unsigned long long)stats->nUdpFrames, (unsigned long long)stats->nUdpRepeated,
+				(unsigned long long)stats->nUdpLost, (unsigned long long)stats->nUdpLate, (unsigned long long)stats->nUdpDuplicate,
+				(unsigned long long)stats->nUdpStale, config->maxAgeMs);
+		fprintf(report, "  audio to light ms: p50 %.2f p90 %.2f p99 %.2f max %.2f\n", l.getPercentile(0.50) / 1e6,
+				l.getPercentile(0.90) / 1e6, l.getPercentile(0.99) / 1e6, l.getMax() / 1e6);
+	}
+	if (config->nDevices > 0) {
+		const LatencyHistogram& t = stats->streamLatency;
+		fprintf(report, "  stream to %d devices: %.0f packets/s, %.2f MB/s, %.1f packets per sendmmsg, %llu dropped, "
+				"us per call p50 %.2f p99 %.2f max %.2f\n", config->nDevices,
+				seconds > 0 ? stats->nStreamPackets / seconds : 0.0, seconds > 0 ? stats->nStreamBytes / seconds / 1e6 : 0.0,
+				stats->nStreamSyscalls ? (double)stats->nStreamPackets / stats->nStreamSyscalls : 0.0,
+				(unsigned long long)stats->nStreamDropped, t.getPercentile(0.50) / 1e3, t.getPercentile(0.99) / 1e3,
+				t.getMax() / 1e3);
+	}
+	if (config->packed) {
+		double perCall = stats->nCalls ? (double)stats->totalFrames / stats->nCalls : 0.0;
+		fprintf(report, "  packed frames: %.0f bytes per call instead of %.0f", perCall * sizeof(PackedFrame_t),
+				perCall * sizeof(Frame_t));
+		if (stats->nativePacked) {
+			fprintf(report, ", packed by the plugin\n");
+		}
+		else {
+			const LatencyHistogram& p = stats->packLatency;
+			fprintf(report, ", packFrames us p50 %.2f p99 %.2f\n", p.getPercentile(0.50) / 1e3, p.getPercentile(0.99) / 1e3);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	HostConfig_t config;
+	memset(&config, 0, sizeof(config));
+	config.nPanels = DEFAULT_N_PANELS;
+	config.nColors = DEFAULT_N_COLORS;
+	config.nFrames = DEFAULT_N_FRAMES;
+	config.nWarmupFrames = DEFAULT_N_WARMUP_FRAMES;
+	config.nFftBins = DEFAULT_N_FFT_BINS;
+	config.bpm = DEFAULT_BPM;
+	config.diffThreshold = -1;
+	config.maxAgeMs = DEFAULT_MAX_AGE_MS;
+	config.streamBatch = DEFAULT_STREAM_BATCH;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:n:so:c:t:S:UA:b:k:f:w:r:qd:pPD:B:R:X:h")) != -1) {
+		switch (opt) {
+		case 'l': config.layoutPath = optarg; break;
+		case 'n': config.nPanels = atoi(optarg); break;
+		case 's': config.squares = true; break;
+		case 'o': config.globalOrientation = atoi(optarg); break;
+		case 'c': config.nColors = atoi(optarg); break;
+		case 't': config.tracePath = optarg; break;
+		case 'S': config.ringName = strcmp(optarg, "-") ? optarg : FEATURE_RING_DEFAULT_NAME; break;
+		case 'U': config.udp = true; break;
+		case 'A': config.maxAgeMs = atoi(optarg); break;
+		case 'b': config.bpm = atof(optarg); break;
+		case 'k': config.nFftBins = atoi(optarg); break;
+		case 'f': config.nFrames = atoi(optarg); break;
+		case 'w': config.nWarmupFrames = atoi(optarg); break;
+		case 'r': config.rateHz = atof(optarg); break;
+		case 'q': config.quiet = true; break;
+		case 'd': config.diffThreshold = atoi(optarg); break;
+		case 'p': config.packed = true; break;
+		case 'P': config.profile = true; break;
+		case 'D': config.nDevices = atoi(optarg); break;
+		case 'B': config.streamBatch = atoi(optarg); break;
+		case 'R': config.recordPath = optarg; break;
+		case 'X': config.checkSeconds = atof(optarg); break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (config.checkSeconds > 0) {
+		int failed = checkFeatureProtocol() < 0;
+		failed += checkFeatureRing(config.checkSeconds) < 0;
+		return failed ? 1 : 0;
+	}
+
+	FeatureTrace_t trace;
+	if (config.recordPath) {
+		fprintf(stderr, "waiting for music_processor.py, recording %d frames of %d bins\n", config.nFrames, config.nFftBins);
+		if (recordFeatureTrace(&trace, config.nFrames, config.nFftBins) < 0) {
+			return 1;
+		}
+		return saveFeatureTrace(config.recordPath, &trace) < 0 ? 1 : 0;
+	}
+
+	if (optind >= argc || config.nFrames < 1 || config.nColors < 1 || config.nFftBins < 1 || config.bpm <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	LayoutStream_t layout;
+	int err;
+	if (config.layoutPath) {
+		err = loadLayout(config.layoutPath, &layout);
+	}
+	else if (config.squares) {
+		err = generateSquareLayout(&layout, config.nPanels, config.globalOrientation);
+	}
+	else {
+		err = generateTriangleLayout(&layout, config.nPanels, config.globalOrientation);
+	}
+	if (err < 0) {
+		return 1;
+	}
+
+	std::vector<int> palette;
+	generatePalette(&palette, config.nColors);
+
+	FeatureRing_t ring;
+	ring.shared = NULL;
+	FeatureReceiver_t receiver;
+	receiver.sock = -1;
+	if (config.ringName) {
+		if (openFeatureRing(&ring, config.ringName) < 0) {
+			return 1;
+		}
+	}
+	else if (config.udp) {
+		if (openFeatureReceiver(&receiver, config.maxAgeMs) < 0) {
+			return 1;
+		}
+	}
+	else if (config.tracePath) {
+		if (loadFeatureTrace(config.tracePath, &trace) < 0) {
+			return 1;
+		}
+	}
+	else {
+		generateFeatureTrace(&trace, config.nFrames + config.nWarmupFrames, config.nFftBins, config.bpm,
+				SOUND_FRAME_INTERVAL_MS, 1);
+	}
+
+	PanelStreamer_t streamer;
+	streamer.sock = -1;
+	if (config.nDevices > 0 && openPanelStreamer(&streamer, config.nDevices, config.streamBatch, PANEL_STREAM_PORT) < 0) {
+		return 1;
+	}
+
+	// plugins print from getPluginFrame, keep the report on the real stdout and drop theirs
+	if (config.quiet) {
+		fflush(stdout);
+		report = fdopen(dup(STDOUT_FILENO), "w");
+		int devNull = open("/dev/null", O_WRONLY);
+		dup2(devNull, STDOUT_FILENO);
+		close(devNull);
+	}
+
+	int failures = 0;
+	for (int i = optind; i < argc; i++) {
+		FrameStats_t stats;
+		if (runPlugin(argv[i], &config, &layout, &palette, &trace, ring.shared ? &ring : NULL,
+				receiver.sock >= 0 ? &receiver : NULL, streamer.sock >= 0 ? &streamer : NULL, &stats) < 0) {
+			failures++;
+			continue;
+		}
+		fflush(stdout);
+		printStats(argv[i], &config, &layout, &stats);
+		fflush(report);
+	}
+	closeFeatureRing(&ring);
+	closeFeatureReceiver(&receiver);
+	if (streamer.sock >= 0) {
+		closePanelStreamer(&streamer);
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/BandOnsetDetector.cpp \
+../src/BeatEngine.cpp \
+../src/BeatTracker.cpp \
+../src/BeatUtilities.cpp \
+../src/ColorUtils.cpp \
+../src/DataManager.cpp \
+../src/DiffusionEngine.cpp \
+../src/FrameDiffer.cpp \
+../src/LayoutProcessingUtils.cpp \
+../src/LightRenderer.cpp \
+../src/Logger.cpp \
+../src/OnsetDetector.cpp \
+../src/PackedFrame.cpp \
+../src/ParticleEngine.cpp \
+../src/PluginFeatures.cpp \
+../src/Point.cpp \
+../src/Profiler.cpp \
+../src/RhythmShape.cpp \
+../src/Shape.cpp \
+../src/SoundUtils.cpp \
+../src/Square.cpp \
+../src/Triangle.cpp 
+
+OBJS += \
+./src/BandOnsetDetector.o \
+./src/BeatEngine.o \
+./src/BeatTracker.o \
+./src/BeatUtilities.o \
+./src/ColorUtils.o \
+./src/DataManager.o \
+./src/DiffusionEngine.o \
+./src/FrameDiffer.o \
+./src/LayoutProcessingUtils.o \
+./src/LightRenderer.o \
+./src/Logger.o \
+./src/OnsetDetector.o \
+./src/PackedFrame.o \
+./src/ParticleEngine.o \
+./src/PluginFeatures.o \
+./src/Point.o \
+./src/Profiler.o \
+./src/RhythmShape.o \
+./src/Shape.o \
+./src/SoundUtils.o \
+./src/Square.o \
+./src/Triangle.o 
+
+CPP_DEPS += \
+./src/BandOnsetDetector.d \
+./src/BeatEngine.d \
+./src/BeatTracker.d \
+./src/BeatUtilities.d \
+./src/ColorUtils.d \
+./src/DataManager.d \
+./src/DiffusionEngine.d \
+./src/FrameDiffer.d \
+./src/LayoutProcessingUtils.d \
+./src/LightRenderer.d \
+./src/Logger.d \
+./src/OnsetDetector.d \
+./src/PackedFrame.d \
+./src/ParticleEngine.d \
+./src/PluginFeatures.d \
+./src/Point.d \
+./src/Profiler.d \
+./src/RhythmShape.d \
+./src/Shape.d \
+./src/SoundUtils.d \
+./src/Square.d \
+./src/Triangle.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/%.o: ../src/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	g++ -I../inc -O3 -g -Wall -c -fmessage-length=0 -std=c++11 -fPIC -flto -ffat-lto-objects -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
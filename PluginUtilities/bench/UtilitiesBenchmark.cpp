@@ -0,0 +1,2430 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * UtilitiesBenchmark.cpp
+ *
+ *  Microbenchmarks for the functions of libPluginUtilities. Each benchmark runs its
+ *  function in a tight loop and reports the mean time per call.
+ *
+ *  Before the benchmarks it checks that every implementation of renderLightSources stays within
+ *  LIGHT_RENDER_TOLERANCE of the per panel blend of the examples, computed in double precision,
+ *  that the panel grid finds the same panels as the linear search, that the streaming filters
+ *  match a brute force pass over their window, that the integer colour conversions stay within 1
+ *  of the floating point ones for every colour, and that every rotation of a frame slice set holds the
+ *  same slices as rotating the layout and calling getFrameSlicesFromLayoutForTriangle, that the
+ *  profiler does not lose samples recorded from several threads, that both diffusion steps match a
+ *  step over the adjacency graph and keep the total colour, that the adjacency graph matches
+ *  comparing the edges of every pair of panels, that getEntryPanels finds the same panels as a
+ *  search along the line through every panel, that the spectrum getters match computing them
+ *  from the bins, for log and mel bands, that the band onsets match a scalar reference and find
+ *  the hits in every band, and that the beat tracker finds the tempo and the beats of a set of
+ *  synthetic test tracks. It exits with 1 if a check fails.
+ *
+ *  usage: UtilitiesBenchmark [filter]
+ *  only the benchmarks whose name contains filter are run
+ */
+
+#include "AuroraPlugin.h"
+#include "BandOnsetDetector.h"
+#include "BeatEngine.h"
+#include "BeatTracker.h"
+#include "ColorUtils.h"
+#include "DataManager.h"
+#include "DiffusionEngine.h"
+#include "FrameDiffer.h"
+#include "LayoutProcessingUtils.h"
+#include "LightRenderer.h"
+#include "Logger.h"
+#include "PackedFrame.h"
+#include "ParticleEngine.h"
+#include "PluginFeatures.h"
+#include "PluginFeaturesInternal.h"
+#include "Point.h"
+#define PROFILING_ENABLED
+#include "Profiler.h"
+#include "Shape.h"
+#include "SourcePool.h"
+#include "StreamingFilters.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_SIDE_LENGTH 150
+#define BENCH_N_PANELS 30
+#define BENCH_N_COLORS 7
+#define BENCH_N_FFT_BINS 32
+#define BENCH_N_FFT_BANDS 12
+#define BENCH_MIN_TIME_NS 200000000LL		/*run each benchmark for at least 200ms*/
+#define BENCH_LARGE_N_PANELS 2048
+#define BENCH_N_LIGHT_SOURCES 32
+#define CHECK_N_SCENES 500
+#define CHECK_MAX_PANELS 300
+#define BENCH_MAX_TRIANGLES 255
+#define BENCH_N_POINTS 1024
+#define CHECK_DIFF_THRESHOLD 4
+#define CHECK_DIFF_N_CALLS 5
+#define CHECK_DIFF_MAX_ENTRIES 3
+#define BENCH_FILTER_LENGTH 16
+#define CHECK_N_FILTER_SAMPLES 2000
+#define BENCH_N_COLORS_BATCH 1024
+#define CHECK_N_PROFILE_THREADS 4
+#define CHECK_N_PROFILE_SAMPLES 100000
+#define CHECK_LOG_BURST 3
+#define CHECK_N_LOG_CALLS 10
+#define CHECK_POOL_CAPACITY 16
+#define CHECK_N_POOL_OPERATIONS 100000
+#define BENCH_POOL_CAPACITY 10
+#define CHECK_N_PARTICLE_FRAMES 2000
+#define BENCH_N_PARTICLES 32
+#define CHECK_N_POINTS 20000
+#define CHECK_N_DIFFUSION_STEPS 200
+#define CHECK_N_SPECTRUM_ROWS 1000
+#define CHECK_N_ONSET_TICKS 2000
+#define CHECK_ONSET_PERIOD 7			/*ticks between the hits of band 0, band k hits every period + k ticks*/
+#define TRACK_TICK_MS 50
+#define TRACK_LENGTH_MS 60000
+#define TRACK_WARMUP_MS 10000			/*tempo and beats are scored after the tracker had this long to lock*/
+#define TRACK_TEMPO_TOLERANCE 0.04f		/*a tempo within 4% of the true one is correct*/
+#define TRACK_BEAT_TOLERANCE 1			/*a beat within one tick of a true beat is correct*/
+#define CHECK_LANE_WIDTH 1.0f			/*layout units, centroids in a lane are this close across the direction*/
+
+extern "C" {
+	void passLayoutData(int* layoutDataByteStream, int nPanels);
+	void passColorPalette(int* colorByteStream, int nColors);
+	void dataManagerCleanup(void);
+}
+
+typedef long (*BenchFunction_t)(long nIterations);
+
+struct Benchmark_t {
+	const char* name;
+	BenchFunction_t function;
+};
+
+static volatile long sink;
+static std::vector<int> layoutStream;
+static std::vector<int> largeLayoutStream;
+static std::vector<int> paletteStream;
+static PanelCentroids_t largeWall;
+static LightSources_t lightSources;
+static std::vector<Frame_t> lightFrames(BENCH_LARGE_N_PANELS);
+
+/**
+ * @description: a wall of triangles tiled edge to edge, the same shape as the PluginHost default layout
+ */
+static void buildLayoutStream(std::vector<int>* stream, int nPanels) {
+	stream->clear();
+	stream->push_back(0);
+	stream->push_back(BENCH_SIDE_LENGTH);
+	double columnStep = BENCH_SIDE_LENGTH / 2.0;
+	double rowHeight = BENCH_SIDE_LENGTH * sqrt(3.0) / 2.0;
+	int nColumns = (int)ceil(sqrt(nPanels * rowHeight / columnStep));
+	for (int i = 0; i < nPanels; i++) {
+		int row = i / nColumns;
+		int column = i % nColumns;
+		bool pointsUp = ((row + column) % 2) == 0;
+		stream->push_back(i + 1);
+		stream->push_back((int)lround(column * columnStep));
+		stream->push_back((int)lround(row * rowHeight + (pointsUp ? rowHeight / 3.0 : 2.0 * rowHeight / 3.0)));
+		stream->push_back(pointsUp ? 0 : 60);
+	}
+}
+
+static void buildPaletteStream(int nColors) {
+	paletteStream.clear();
+	for (int i = 0; i < nColors; i++) {
+		paletteStream.push_back((i * 97) % 256);
+		paletteStream.push_back((i * 31) % 256);
+		paletteStream.push_back((i * 53) % 256);
+	}
+}
+
+/**
+ * @description: fill centroids with n panels on a square grid, one side length apart
+ */
+static void buildCentroids(PanelCentroids_t* centroids, int n) {
+	free(centroids->panelIds);
+	free(centroids->x);
+	free(centroids->y);
+	int nPadded = (n + PANEL_ARRAY_PADDING - 1) / PANEL_ARRAY_PADDING * PANEL_ARRAY_PADDING + PANEL_ARRAY_PADDING;
+	void* p;
+	posix_memalign(&p, PANEL_ARRAY_ALIGNMENT, nPadded * sizeof(int));
+	centroids->panelIds = (int*)p;
+	posix_memalign(&p, PANEL_ARRAY_ALIGNMENT, nPadded * sizeof(float));
+	centroids->x = (float*)p;
+	posix_memalign(&p, PANEL_ARRAY_ALIGNMENT, nPadded * sizeof(float));
+	centroids->y = (float*)p;
+	int nColumns = (int)ceil(sqrt((double)n));
+	for (int i = 0; i < nPadded; i++) {
+		centroids->panelIds[i] = i < n ? i + 1 : 0;
+		centroids->x[i] = i < n ? (i % nColumns) * BENCH_SIDE_LENGTH : 0;
+		centroids->y[i] = i < n ? (i / nColumns) * BENCH_SIDE_LENGTH : 0;
+	}
+	centroids->nPanels = n;
+	centroids->nPadded = nPadded;
+}
+
+static float randomFloat(unsigned int* seed, float min, float max) {
+	return min + (max - min) * (rand_r(seed) / (float)RAND_MAX);
+}
+
+/**
+ * @description: sources scattered over a wall of the given width, with random colours and parameters
+ */
+static void buildLightSources(LightSources_t* sources, int n, float width, bool randomParameters, unsigned int* seed) {
+	clearLightSources(sources);
+	for (int i = 0; i < n; i++) {
+		int idx = addLightSource(sources, randomFloat(seed, -0.2 * width, 1.2 * width),
+				randomFloat(seed, -0.2 * width, 1.2 * width), rand_r(seed) % 256, rand_r(seed) % 256, rand_r(seed) % 256);
+		if (randomParameters) {
+			sources->offset[idx] = randomFloat(seed, -1, 3);
+			sources->gain[idx] = randomFloat(seed, 0, 1);
+			sources->minFactor[idx] = rand_r(seed) % 2 ? 0 : randomFloat(seed, 0, 0.1);
+		}
+	}
+}
+
+/**
+ * @description: the blend of renderPanel in the examples, in double precision
+ */
+static void renderReference(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int* out) {
+	for (int p = 0; p < centroids->nPanels; p++) {
+		double c[3] = {(double)base.R, (double)base.G, (double)base.B};
+		for (int i = 0; i < sources->nSources; i++) {
+			double dx = centroids->x[p] - sources->x[i];
+			double dy = centroids->y[p] - sources->y[i];
+			double u = sqrt(dx * dx + dy * dy) * falloff->distanceScale - sources->offset[i];
+			double factor;
+			if (falloff->type == LIGHT_FALLOFF_INVERSE_LINEAR) {
+				factor = 1.0 / (falloff->k * (u > 0 ? u : 0) + 1.0);
+			}
+			else {
+				factor = 1.0 / (falloff->k * u * u + 1.0);
+			}
+			factor = (factor < 1.0 ? factor : 1.0) * sources->gain[i];
+			factor = factor > sources->minFactor[i] ? factor : sources->minFactor[i];
+			c[0] = c[0] * (1.0 - factor) + sources->R[i] * factor;
+			c[1] = c[1] * (1.0 - factor) + sources->G[i] * factor;
+			c[2] = c[2] * (1.0 - factor) + sources->B[i] * factor;
+		}
+		for (int j = 0; j < 3; j++) {
+			int v = (int)c[j];
+			out[p * 3 + j] = v > 255 ? 255 : (v < 0 ? 0 : v);
+		}
+	}
+}
+
+/**
+ * @description: compare every renderer the CPU supports with the double precision reference on random scenes
+ * @return: true if all of them are within LIGHT_RENDER_TOLERANCE
+ */
+static bool checkLightRenderers(void) {
+	static const char* names[] = {"scalar", "sse2", "avx2"};
+	unsigned int seed = 1;
+	PanelCentroids_t centroids;
+	static LightSources_t checkSources;
+	LightSources_t* sources = &checkSources;
+	std::vector<Frame_t> frames(CHECK_MAX_PANELS);
+	std::vector<int> reference(CHECK_MAX_PANELS * 3);
+	int maxError[LIGHT_RENDERER_AVX2 + 1] = {0, 0, 0};
+	int nPanelFrames = 0;
+
+	for (int scene = 0; scene < CHECK_N_SCENES; scene++) {
+		int nPanels = 1 + rand_r(&seed) % CHECK_MAX_PANELS;
+		buildCentroids(&centroids, nPanels);
+		float width = sqrt((double)nPanels) * BENCH_SIDE_LENGTH;
+		buildLightSources(sources, rand_r(&seed) % (MAX_LIGHT_SOURCES + 1), width, scene % 2, &seed);
+		LightFalloff_t falloff = {scene % 3 == 0 ? LIGHT_FALLOFF_INVERSE_LINEAR : LIGHT_FALLOFF_INVERSE_SQUARE,
+				randomFloat(&seed, 0.005, 0.02), randomFloat(&seed, 0.5, 3)};
+		RGB_t base = {rand_r(&seed) % 64, rand_r(&seed) % 64, rand_r(&seed) % 64};
+		renderReference(&centroids, sources, &falloff, base, reference.data());
+		nPanelFrames += nPanels;
+
+		for (int r = LIGHT_RENDERER_SCALAR; r <= LIGHT_RENDERER_AVX2; r++) {
+			if (selectLightRenderer(r) != r) {
+				continue;
+			}
+			renderLightSources(&centroids, sources, &falloff, base, 1, frames.data());
+			for (int p = 0; p < nPanels; p++) {
+				int error = abs(frames[p].r - reference[p * 3]);
+				error = std::max(error, abs(frames[p].g - reference[p * 3 + 1]));
+				error = std::max(error, abs(frames[p].b - reference[p * 3 + 2]));
+				if (frames[p].panelId != centroids.panelIds[p] || frames[p].transTime != 1) {
+					error = INT32_MAX;
+				}
+				maxError[r] = std::max(maxError[r], error);
+			}
+		}
+	}
+	bool ok = true;
+	for (int r = LIGHT_RENDERER_SCALAR; r <= LIGHT_RENDERER_AVX2; r++) {
+		if (selectLightRenderer(r) != r) {
+			printf("renderLightSources %-6s not supported by this CPU\n", names[r]);
+			continue;
+		}
+		bool pass = maxError[r] <= LIGHT_RENDER_TOLERANCE;
+		printf("renderLightSources %-6s max error %d over %d panel frames: %s\n", names[r], maxError[r], nPanelFrames,
+				pass ? "ok" : "FAILED");
+		ok = ok && pass;
+	}
+	selectLightRenderer(LIGHT_RENDERER_AVX2);
+	return ok;
+}
+
+/**
+ * @description: points spread over the layout and a margin around it
+ */
+static void buildRandomPoints(LayoutData* layoutData, std::vector<Point>* points, int n, unsigned int* seed) {
+	float minX = 1e9, minY = 1e9, maxX = -1e9, maxY = -1e9;
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		minX = std::min(minX, layoutData->centroids.x[i]);
+		minY = std::min(minY, layoutData->centroids.y[i]);
+		maxX = std::max(maxX, layoutData->centroids.x[i]);
+		maxY = std::max(maxY, layoutData->centroids.y[i]);
+	}
+	points->resize(n);
+	for (int i = 0; i < n; i++) {
+		(*points)[i] = Point(randomFloat(seed, minX - BENCH_SIDE_LENGTH, maxX + BENCH_SIDE_LENGTH),
+				randomFloat(seed, minY - BENCH_SIDE_LENGTH, maxY + BENCH_SIDE_LENGTH));
+	}
+}
+
+/**
+ * @description: compare the grid with the linear search on random points, for small and large layouts at every rotation
+ * @return: true if they always find the same panel
+ */
+static bool checkPanelGrid(void) {
+	unsigned int seed = 1;
+	std::vector<Point> points;
+	std::vector<int> gridIds(CHECK_N_POINTS);
+	int nMismatches = 0;
+	int nHits = 0;
+	int nLookups = 0;
+	std::vector<int>* streams[] = {&layoutStream, &largeLayoutStream};
+	int nPanels[] = {BENCH_N_PANELS, BENCH_MAX_TRIANGLES};
+
+	for (int l = 0; l < 2; l++) {
+		for (int rotation = 0; rotation < 360; rotation += 30) {
+			LayoutData* ld = NULL;
+			parseLayoutData(streams[l]->data(), nPanels[l], &ld);
+			buildPanelGrid(ld);
+			int angle = rotation;
+			rotateAuroraPanels(ld, &angle);
+			buildRandomPoints(ld, &points, CHECK_N_POINTS, &seed);
+			pointsInsideWhichPanels(ld, points.data(), CHECK_N_POINTS, gridIds.data());
+			PanelGrid_t* grid = ld->panelGrid;
+			ld->panelGrid = NULL;
+			for (int i = 0; i < CHECK_N_POINTS; i++) {
+				int linearId = pointInsideWhichPanel(ld, points[i]);
+				nMismatches += linearId != gridIds[i];
+				nHits += linearId != -1;
+			}
+			ld->panelGrid = grid;
+			nLookups += CHECK_N_POINTS;
+			freeLayoutData(ld);
+		}
+	}
+	printf("pointsInsideWhichPanels grid %d mismatches over %d points (%d inside a panel): %s\n", nMismatches, nLookups,
+			nHits, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+struct CheckDiffEntry_t {
+	int panelId;
+	int r, g, b;
+	int transTime;
+};
+
+/**
+ * The calls of the frame differ check, with the panels each call should keep in order, -1 terminated.
+ * Panel 5 drifts by 2 per call after its first commit at 100, so only the comparison with the
+ * committed colour, not with the last one seen, makes it emit again in call 4. The differ is reset
+ * before call 5
+ */
+static const CheckDiffEntry_t checkDiffCalls[CHECK_DIFF_N_CALLS][CHECK_DIFF_MAX_ENTRIES] = {
+	{{5, 100, 100, 100, 1}, {2, 100, 100, 100, 1}, {9, 100, 100, 100, 1}},
+	{{5, 104, 100, 100, 1}, {2, 100, 105, 100, 1}, {9, 100, 100, 100, 2}},	/*at the threshold, above it, transTime only*/
+	{{5, 102, 100, 100, 1}, {2, 100, 105, 100, 1}, {9, 100, 100, 96, 2}},
+	{{9, 100, 100, 95, 2}, {5, 106, 100, 100, 1}, {2, 100, 105, 100, 1}},
+	{{2, 100, 105, 100, 1}, {5, 106, 100, 100, 1}, {9, 100, 100, 95, 2}},
+};
+static const int checkDiffKept[CHECK_DIFF_N_CALLS][CHECK_DIFF_MAX_ENTRIES + 1] = {
+	{5, 2, 9, -1},
+	{2, 9, -1},
+	{-1},
+	{9, 5, -1},
+	{2, 5, 9, -1},
+};
+
+/**
+ * @description: run the scripted calls through diffFrames or diffPackedFrames
+ * @return: the number of calls that kept other entries than expected, or kept them with other colours
+ */
+template <typename Frame>
+static int runDiffScript(int (*diffCall)(FrameDiffer_t*, Frame*, int), FrameDiffer_t* differ) {
+	int nMismatches = 0;
+	initFrameDiffer(differ, CHECK_DIFF_THRESHOLD);
+	for (int c = 0; c < CHECK_DIFF_N_CALLS; c++) {
+		if (c == CHECK_DIFF_N_CALLS - 1) {
+			resetFrameDiffer(differ);
+		}
+		Frame frames[CHECK_DIFF_MAX_ENTRIES];
+		for (int i = 0; i < CHECK_DIFF_MAX_ENTRIES; i++) {
+			const CheckDiffEntry_t* e = &checkDiffCalls[c][i];
+			frames[i].panelId = e->panelId;
+			frames[i].r = e->r;
+			frames[i].g = e->g;
+			frames[i].b = e->b;
+			frames[i].transTime = e->transTime;
+		}
+		int nKept = diffCall(differ, frames, CHECK_DIFF_MAX_ENTRIES);
+		int nExpected = 0;
+		while (checkDiffKept[c][nExpected] >= 0) {
+			nExpected++;
+		}
+		bool same = nKept == nExpected;
+		for (int i = 0; same && i < nKept; i++) {
+			same = frames[i].panelId == checkDiffKept[c][i];
+			// the kept entry must be the one of this call, not a stale copy
+			for (int j = 0; same && j < CHECK_DIFF_MAX_ENTRIES; j++) {
+				const CheckDiffEntry_t* e = &checkDiffCalls[c][j];
+				if (e->panelId == frames[i].panelId) {
+					same = frames[i].r == e->r && frames[i].g == e->g && frames[i].b == e->b &&
+							frames[i].transTime == e->transTime;
+				}
+			}
+		}
+		nMismatches += !same;
+	}
+	return nMismatches;
+}
+
+/**
+ * @description: run scripted calls through both differs and compare the kept entries, their order and the
+ * counters with the expected ones
+ * @return: true if they all match
+ */
+static bool checkFrameDiffer(void) {
+	FrameDiffer_t differ;
+	int nMismatches = runDiffScript<Frame_t>(diffFrames, &differ);
+	// 3 + 2 + 0 + 2 + 3 kept and 0 + 1 + 3 + 1 + 0 dropped, the reset before the last call keeps the counters
+	nMismatches += differ.nEmitted != 10 || differ.nSuppressed != 5;
+	nMismatches += runDiffScript<PackedFrame_t>(diffPackedFrames, &differ);
+	nMismatches += differ.nEmitted != 10 || differ.nSuppressed != 5;
+	printf("frame differ %d mismatches over %d calls of each differ: %s\n", nMismatches, CHECK_DIFF_N_CALLS,
+			nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+// packed frames are handed on as they are in memory, so their layout is part of the format
+static_assert(sizeof(PackedFrame_t) == 8, "PackedFrame_t must stay 8 bytes");
+static_assert(offsetof(PackedFrame_t, panelId) == 0 && offsetof(PackedFrame_t, r) == 2 && offsetof(PackedFrame_t, g) == 3 &&
+		offsetof(PackedFrame_t, b) == 4 && offsetof(PackedFrame_t, flags) == 5 && offsetof(PackedFrame_t, transTime) == 6,
+		"PackedFrame_t fields moved");
+
+/**
+ * @description: round trip every 16 bit panel id through packFrames and unpackFrames, and pack out of range
+ * colours, transTimes and panel ids
+ * @return: true if the round trip is exact, out of range values are clamped and out of range ids are left out
+ */
+static bool checkPackedFrames(void) {
+	int nFrames = PACKED_FRAME_MAX_PANEL_ID + 1;
+	std::vector<Frame_t> frames(nFrames);
+	std::vector<PackedFrame_t> packed(nFrames);
+	std::vector<Frame_t> unpacked(nFrames);
+	for (int i = 0; i < nFrames; i++) {
+		frames[i].panelId = i;
+		frames[i].r = i & 0xFF;
+		frames[i].g = (i >> 8) & 0xFF;
+		frames[i].b = 255 - (i & 0xFF);
+		frames[i].transTime = (i * 7) & PACKED_FRAME_MAX_TRANS_TIME;
+	}
+	int nMismatches = packFrames(&frames[0], nFrames, &packed[0]) != nFrames;
+	unpackFrames(&packed[0], nFrames, &unpacked[0]);
+	for (int i = 0; i < nFrames; i++) {
+		const Frame_t& f = frames[i];
+		const Frame_t& u = unpacked[i];
+		nMismatches += f.panelId != u.panelId || f.r != u.r || f.g != u.g || f.b != u.b || f.transTime != u.transTime ||
+				packed[i].flags != 0;
+	}
+
+	// panel ids -1 and 0x10000 do not fit and are left out, the rest keep their order
+	const Frame_t outOfRange[] = {
+		{7, -5, 300, 256, -1},
+		{-1, 1, 2, 3, 4},
+		{8, 0, 255, 128, PACKED_FRAME_MAX_TRANS_TIME + 1},
+		{PACKED_FRAME_MAX_PANEL_ID + 1, 1, 2, 3, 4},
+		{PACKED_FRAME_MAX_PANEL_ID, -1000, 1000, 0, 70000},
+	};
+	const Frame_t clamped[] = {
+		{7, 0, 255, 255, 0},
+		{8, 0, 255, 128, PACKED_FRAME_MAX_TRANS_TIME},
+		{PACKED_FRAME_MAX_PANEL_ID, 0, 255, 0, PACKED_FRAME_MAX_TRANS_TIME},
+	};
+	int nIn = sizeof(outOfRange) / sizeof(outOfRange[0]);
+	int nOut = sizeof(clamped) / sizeof(clamped[0]);
+	int nPacked = packFrames(outOfRange, nIn, &packed[0]);
+	nMismatches += nPacked != nOut;
+	unpackFrames(&packed[0], nOut, &unpacked[0]);
+	for (int i = 0; i < nOut; i++) {
+		const Frame_t& c = clamped[i];
+		const Frame_t& u = unpacked[i];
+		nMismatches += c.panelId != u.panelId || c.r != u.r || c.g != u.g || c.b != u.b || c.transTime != u.transTime;
+	}
+	printf("packed frames %d mismatches over %d round trips and %d out of range entries: %s\n", nMismatches, nFrames,
+			nIn, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * @description: check the spectrum getters on one row of bins against computing them from the row
+ * @return: the number of getters that disagree
+ */
+static int checkSpectrumRow(const float* row, int nBins, int nBands) {
+	const float* bins = getFftBinsFloat();
+	const uint16_t* bins16 = getFftBins16();
+	const float* bands = getFftBands();
+	int nMismatches = 0;
+	int peak = 0;
+	double sum = 0;
+	double weightedSum = 0;
+	for (int j = 0; j < nBins; j++) {
+		float b16 = std::min(std::max(row[j] * FFT_BIN16_SCALE, 0.0f), 65535.0f);
+		nMismatches += bins[j] != row[j] || bins16[j] != (uint16_t)b16;
+		peak = row[j] > row[peak] ? j : peak;
+		sum += row[j];
+		weightedSum += row[j] * j;
+	}
+	double centroid = sum > 0 ? weightedSum / sum : 0;
+	nMismatches += getPeakFftBin() != peak || fabs(getSpectralCentroid() - centroid) > 1e-3;
+
+	// every band lies between the smallest and the largest bin, the band holding the peak is the strongest
+	float lowest = *std::min_element(row, row + nBins);
+	float highest = *std::max_element(row, row + nBins);
+	for (int k = 0; k < nBands; k++) {
+		nMismatches += bands[k] < lowest - 1e-3f || bands[k] > highest + 1e-3f;
+	}
+	return nMismatches;
+}
+
+/**
+ * @description: feed random rows of 8 bit bins and of float bins through the sound module side of the features,
+ * for log and mel bands, and compare the spectrum getters with computing them from the rows. A flat spectrum must
+ * give flat bands
+ * @return: true if they all match
+ */
+static bool checkSpectrumFeatures(void) {
+	int scales[] = {FFT_BANDS_LOG, FFT_BANDS_MEL};
+	uint8_t row8[BENCH_N_FFT_BINS];
+	float row[BENCH_N_FFT_BINS];
+	RhythmFeatures_t rf = {0, row8, BENCH_N_FFT_BINS, 0, 0};
+	SpectrumFeatures_t sf = {row, BENCH_N_FFT_BINS, 48000.0f};
+	unsigned int seed = 1;
+	int nMismatches = 0;
+
+	for (int s = 0; s < 2; s++) {
+		enableFftBands(BENCH_N_FFT_BANDS, scales[s]);
+		initRhythmFeatures();
+		for (int fromSoundModule = 0; fromSoundModule < 2; fromSoundModule++) {
+			for (int i = 0; i < CHECK_N_SPECTRUM_ROWS; i++) {
+				for (int j = 0; j < BENCH_N_FFT_BINS; j++) {
+					row8[j] = rand_r(&seed) % 256;
+					row[j] = fromSoundModule ? randomFloat(&seed, 0, 400) : row8[j];
+				}
+				updateRhythmFeatures(&rf);
+				if (fromSoundModule) {
+					updateSpectrumFeatures(&sf);
+				}
+				nMismatches += checkSpectrumRow(row, BENCH_N_FFT_BINS, BENCH_N_FFT_BANDS);
+			}
+			std::fill(row, row + BENCH_N_FFT_BINS, 100.0f);
+			updateSpectrumFeatures(&sf);
+			for (int k = 0; k < BENCH_N_FFT_BANDS; k++) {
+				nMismatches += fabsf(getFftBands()[k] - 100.0f) > 1e-3f;
+			}
+		}
+		// leave the getters as the plugins see them, fed from 8 bit bins
+		deinitRhythmFeatures();
+		initRhythmFeatures();
+	}
+	printf("spectrum features %d mismatches over %d rows: %s\n", nMismatches, 4 * CHECK_N_SPECTRUM_ROWS,
+			nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * @description: the band onset detector one band at a time, in double precision
+ */
+struct BandOnsetReference_t {
+	double previous;
+	double mean;
+	double deviation;
+	int hold;
+	bool primed;
+};
+
+/**
+ * @description: feed hits at a different period into every band over a noise floor and compare the band onsets
+ * with a scalar reference and with the hits, then compare the getters of PluginFeatures with a detector fed from
+ * getFftBands
+ * @return: true if the onsets match the reference, find the hits without false onsets, and the getters match
+ */
+static bool checkBandOnsets(void) {
+	const int nBands = BENCH_N_FFT_BANDS;
+	const double rate = 1.0 - exp(-TRACK_TICK_MS / 1000.0);
+	const int holdTicks = 2;			/*100ms*/
+	BandOnsetDetector detector;
+	detector.bandOnsetDetectorInit(nBands, TRACK_TICK_MS);
+	std::vector<BandOnsetReference_t> reference(nBands);
+	memset(reference.data(), 0, nBands * sizeof(BandOnsetReference_t));
+	unsigned int seed = 1;
+	int nMismatches = 0;
+	int nHits = 0;
+	int nFound = 0;
+	int nFalse = 0;
+	float bands[BENCH_N_FFT_BANDS];
+	for (int i = 0; i < CHECK_N_ONSET_TICKS; i++) {
+		for (int k = 0; k < nBands; k++) {
+			int phase = i % (CHECK_ONSET_PERIOD + k);
+			bands[k] = 20 + 5 * randomFloat(&seed, 0, 1) + (phase == 0 ? 100 : (phase == 1 ? 40 : 0));
+		}
+		detector.bandOnsetDetectorTick(bands);
+		for (int k = 0; k < nBands; k++) {
+			BandOnsetReference_t* r = &reference[k];
+			bool onset = false;
+			double strength = 0;
+			if (r->primed) {
+				double flux = std::max(bands[k] - r->previous, 0.0);
+				double threshold = r->mean + 2 * r->deviation + 2;
+				strength = flux / threshold;
+				onset = strength > 1 && r->hold <= 0;
+				r->hold = onset ? holdTicks : r->hold - 1;
+				double d = flux - r->mean;
+				r->mean += rate * d;
+				r->deviation += rate * (fabs(d) - r->deviation);
+			}
+			r->previous = bands[k];
+			r->primed = true;
+			bool nearThreshold = fabs(strength - 1) < 1e-3;
+			nMismatches += !nearThreshold && (detector.getOnsets()[k] != onset ||
+					fabs(detector.getStrengths()[k] - strength) > 1e-3 * (1 + strength));
+
+			if (i >= 1000 / TRACK_TICK_MS) {
+				bool hit = i % (CHECK_ONSET_PERIOD + k) == 0;
+				nHits += hit;
+				nFound += hit && detector.getOnsets()[k];
+				nFalse += !hit && detector.getOnsets()[k];
+			}
+		}
+	}
+	bool detectorOk = nMismatches == 0 && nFound == nHits && nFalse <= nHits / 100;
+	printf("band onsets %d mismatches with the reference, %d of %d hits found, %d false onsets: %s\n", nMismatches,
+			nFound, nHits, nFalse, detectorOk ? "ok" : "FAILED");
+
+	// the getters run the same detector over getFftBands on every update
+	uint8_t row8[BENCH_N_FFT_BINS];
+	RhythmFeatures_t rf = {0, row8, BENCH_N_FFT_BINS, 0, 0};
+	BandOnsetDetector shadow;
+	shadow.bandOnsetDetectorInit(nBands, SOUND_TICK_MS);
+	int nGetterMismatches = 0;
+	deinitRhythmFeatures();
+	initRhythmFeatures();
+	for (int i = 0; i < CHECK_N_SPECTRUM_ROWS; i++) {
+		for (int j = 0; j < BENCH_N_FFT_BINS; j++) {
+			row8[j] = i % (CHECK_ONSET_PERIOD + j) == 0 ? 200 : rand_r(&seed) % 40;
+		}
+		updateRhythmFeatures(&rf);
+		shadow.bandOnsetDetectorTick(getFftBands());
+		nGetterMismatches += getBandOnsets() == NULL || getBandOnsetStrengths() == NULL ||
+				memcmp(getBandOnsets(), shadow.getOnsets(), nBands) != 0 ||
+				memcmp(getBandOnsetStrengths(), shadow.getStrengths(), nBands * sizeof(float)) != 0;
+	}
+	printf("band onset getters %d mismatches over %d updates: %s\n", nGetterMismatches, CHECK_N_SPECTRUM_ROWS,
+			nGetterMismatches == 0 ? "ok" : "FAILED");
+	return detectorOk && nGetterMismatches == 0;
+}
+
+/**
+ * A synthetic track for the tempo and beat tracker: a kick on every beat, optionally some hits
+ * between the beats, with kicks left out and moved in time
+ */
+struct TestTrack_t {
+	const char* name;
+	float bpm;
+	float offBeat;			/*level of a hit half way between the beats*/
+	float syncopation;		/*level of a hit three quarters into the beat*/
+	float dropout;			/*probability that a kick is left out*/
+	float jitterMs;			/*kicks move by up to this much*/
+	float noise;			/*level of the broadband noise*/
+};
+
+static const TestTrack_t testTracks[] = {
+	{"four on the floor 120", 120, 0.3f, 0, 0, 0, 0.05f},
+	{"house 128", 128, 0.5f, 0, 0, 0, 0.05f},
+	{"ballad 72", 72, 0.2f, 0, 0, 5, 0.05f},
+	{"hip hop 90, dropouts", 90, 0.4f, 0.3f, 0.2f, 10, 0.1f},
+	{"rock 110, jitter", 110, 0.5f, 0, 0.05f, 15, 0.1f},
+	{"techno 140", 140, 0.3f, 0, 0, 0, 0.2f},
+	{"syncopated 100", 100, 0.3f, 0.6f, 0.1f, 5, 0.1f},
+	{"drum and bass 174", 174, 0.3f, 0.4f, 0.1f, 5, 0.1f},
+};
+
+/**
+ * @description: render a test track into features, one tick every TRACK_TICK_MS, the same way as the
+ * synthetic trace of PluginHost. beatTicks gets the tick at or after every kick
+ */
+static void buildTestTrack(const TestTrack_t* track, unsigned int seed, std::vector<uint16_t>* energy,
+		std::vector<uint8_t>* bins, std::vector<int>* beatTicks) {
+	int nTicks = TRACK_LENGTH_MS / TRACK_TICK_MS;
+	float beatMs = 60000.0f / track->bpm;
+	energy->assign(nTicks, 0);
+	bins->assign(nTicks * BENCH_N_FFT_BINS, 0);
+	beatTicks->clear();
+
+	std::vector<float> kick(nTicks, 0);
+	std::vector<float> hat(nTicks, 0);
+	for (int beat = 0; beat * beatMs < TRACK_LENGTH_MS; beat++) {
+		float t = beat * beatMs;
+		if (randomFloat(&seed, 0, 1) >= track->dropout) {
+			float kickMs = t + randomFloat(&seed, -track->jitterMs, track->jitterMs);
+			int tick = (int)ceilf(std::max(kickMs, 0.0f) / TRACK_TICK_MS);
+			for (int i = tick; i < nTicks; i++) {
+				kick[i] += expf(-(i * TRACK_TICK_MS - kickMs) / 80.0f);
+			}
+			beatTicks->push_back(tick);
+		}
+		float hits[] = {t + beatMs * 0.5f, t + beatMs * 0.75f};
+		float levels[] = {track->offBeat, track->syncopation};
+		for (int h = 0; h < 2; h++) {
+			int tick = (int)ceilf(hits[h] / TRACK_TICK_MS);
+			if (tick < nTicks) {
+				hat[tick] += levels[h];
+			}
+		}
+	}
+
+	for (int i = 0; i < nTicks; i++) {
+		float e = 400 + 3000 * kick[i] + 800 * hat[i] + 2000 * track->noise * randomFloat(&seed, 0, 1);
+		(*energy)[i] = std::min(e, 65535.0f);
+		for (int j = 0; j < BENCH_N_FFT_BINS; j++) {
+			float position = (float)j / BENCH_N_FFT_BINS;
+			float v = 40 * (1 - position) + 200 * track->noise * randomFloat(&seed, 0, 1);
+			v += position < 0.25f ? 200 * kick[i] : (position > 0.6f ? 120 * hat[i] : 60 * kick[i] * (1 - position));
+			(*bins)[i * BENCH_N_FFT_BINS + j] = std::min(v, 255.0f);
+		}
+	}
+}
+
+/**
+ * @description: run the beat engine over every test track and score the tempo and the beats after the
+ * warmup: the share of ticks with the tempo within TRACK_TEMPO_TOLERANCE, and the F-measure of the beats
+ * against the kicks within TRACK_BEAT_TOLERANCE ticks
+ * @return: true if every track reaches 90% correct tempo and an F-measure of 0.8, and onsets at random
+ * times stay below the confidence at which beats follow the tracker
+ */
+static bool checkBeatTracker(void) {
+	bool ok = true;
+	int warmupTicks = TRACK_WARMUP_MS / TRACK_TICK_MS;
+	int nTracks = sizeof(testTracks) / sizeof(testTracks[0]);
+	for (int t = 0; t < nTracks; t++) {
+		std::vector<uint16_t> energy;
+		std::vector<uint8_t> bins;
+		std::vector<int> beatTicks;
+		buildTestTrack(&testTracks[t], t + 1, &energy, &bins, &beatTicks);
+
+		BeatEngine engine;
+		engine.beatEngineInit(BENCH_N_FFT_BINS, TRACK_TICK_MS);
+		std::vector<bool> trueBeat(energy.size(), false);
+		for (size_t b = 0; b < beatTicks.size(); b++) {
+			if (beatTicks[b] < (int)energy.size()) {
+				trueBeat[beatTicks[b]] = true;
+			}
+		}
+		int nTempoCorrect = 0;
+		int nScored = 0;
+		int nBeats = 0;
+		int nHits = 0;
+		int nTrue = 0;
+		for (int i = 0; i < (int)energy.size(); i++) {
+			engine.beatEngineTick(energy[i], &bins[i * BENCH_N_FFT_BINS]);
+			if (i < warmupTicks) {
+				continue;
+			}
+			nScored++;
+			nTempoCorrect += fabsf(engine.getTempo() - testTracks[t].bpm) <= TRACK_TEMPO_TOLERANCE * testTracks[t].bpm;
+			nTrue += trueBeat[i];
+			if (engine.isBeat()) {
+				nBeats++;
+				bool hit = false;
+				for (int d = -TRACK_BEAT_TOLERANCE; d <= TRACK_BEAT_TOLERANCE; d++) {
+					hit = hit || (i + d >= 0 && i + d < (int)energy.size() && trueBeat[i + d]);
+				}
+				nHits += hit;
+			}
+		}
+		float tempoScore = (float)nTempoCorrect / nScored;
+		float precision = nBeats ? (float)nHits / nBeats : 0;
+		float recall = nTrue ? (float)std::min(nHits, nTrue) / nTrue : 0;
+		float f = precision + recall > 0 ? 2 * precision * recall / (precision + recall) : 0;
+		bool trackOk = tempoScore >= 0.9f && f >= 0.8f;
+		printf("beat tracker %-24s tempo %5.1f of %5.1f correct %3.0f%%, confidence %.2f, beat F %.2f: %s\n",
+				testTracks[t].name, engine.getTempo(), testTracks[t].bpm, 100 * tempoScore, engine.getBeatConfidence(), f,
+				trackOk ? "ok" : "FAILED");
+		ok = ok && trackOk;
+	}
+
+	// onsets at random times must not look periodic
+	BeatTracker tracker;
+	unsigned int seed = 1;
+	float sumConfidence = 0;
+	int nTicks = TRACK_LENGTH_MS / TRACK_TICK_MS;
+	for (int i = 0; i < nTicks; i++) {
+		bool onset = rand_r(&seed) % 6 == 0;
+		tracker.beatTrackerTick(onset ? randomFloat(&seed, 20, 60) : randomFloat(&seed, 0, 3), onset);
+		sumConfidence += i >= warmupTicks ? tracker.getConfidence() : 0;
+	}
+	float meanConfidence = sumConfidence / (nTicks - warmupTicks);
+	bool randomOk = meanConfidence < MIN_TRACKER_CONFIDENCE;
+	printf("beat tracker random onsets, mean confidence %.2f: %s\n", meanConfidence, randomOk ? "ok" : "FAILED");
+	return ok && randomOk;
+}
+
+/**
+ * @description: one diffusion step straight from the CSR adjacency graph, summing the neighbours in the same order
+ */
+static void stepDiffusionReference(const LayoutData* ld, const DiffusionField_t* field, std::vector<float>* planes) {
+	const PanelAdjacency_t* a = &ld->adjacency;
+	std::vector<float> next(planes->size());
+	float base[3] = {(float)field->base.R, (float)field->base.G, (float)field->base.B};
+	for (int c = 0; c < 3; c++) {
+		const float* in = planes->data() + c * ld->nPanels;
+		for (int i = 0; i < ld->nPanels; i++) {
+			float laplacian = 0.0f;
+			for (int j = a->offsets[i]; j < a->offsets[i + 1]; j++) {
+				laplacian = laplacian + (in[a->neighbors[j]] - in[i]);
+			}
+			float v = in[i] + field->rate * laplacian;
+			next[c * ld->nPanels + i] = base[c] + (v - base[c]) * field->decay;
+		}
+	}
+	planes->swap(next);
+}
+
+/**
+ * @description: inject colour at random panels of the large layout and step the field with both implementations
+ * and the reference, then let it spread without decay and check that no colour was lost
+ * @return: true if all three always hold the same colours and the total is kept
+ */
+static bool checkDiffusionEngine(void) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	DiffusionField_t fields[2];
+	int implementations[2] = {DIFFUSION_STEP_SCALAR, DIFFUSION_STEP_AVX2};
+	std::vector<float> reference(3 * ld->nPanels, 0.0f);
+	unsigned int seed = 1;
+	int nMismatches = 0;
+
+	for (int f = 0; f < 2; f++) {
+		initDiffusionField(&fields[f], ld);
+		fields[f].rate = 0.2f;
+		fields[f].decay = 0.97f;
+		fields[f].base.B = 10;
+		clearDiffusionField(&fields[f]);
+	}
+	std::fill(reference.begin() + 2 * ld->nPanels, reference.end(), 10.0f);
+	for (int step = 0; step < CHECK_N_DIFFUSION_STEPS; step++) {
+		if (step == CHECK_N_DIFFUSION_STEPS / 2) {
+			fields[0].decay = fields[1].decay = 1.0f;
+		}
+		int panel = rand_r(&seed) % ld->nPanels;
+		float amount = randomFloat(&seed, 0, 1);
+		int R = rand_r(&seed) % 256;
+		int G = rand_r(&seed) % 256;
+		for (int f = 0; f < 2; f++) {
+			injectDiffusion(&fields[f], panel, R, G, 0, amount);
+		}
+		reference[panel] = reference[panel] * (1.0f - amount) + R * amount;
+		reference[ld->nPanels + panel] = reference[ld->nPanels + panel] * (1.0f - amount) + G * amount;
+		reference[2 * ld->nPanels + panel] = reference[2 * ld->nPanels + panel] * (1.0f - amount) + 0 * amount;
+		for (int f = 0; f < 2; f++) {
+			selectDiffusionStep(implementations[f]);
+			stepDiffusion(&fields[f]);
+		}
+		stepDiffusionReference(ld, &fields[0], &reference);
+		for (int f = 0; f < 2; f++) {
+			const DiffusionField_t* field = &fields[f];
+			const float* planes[3] = {field->R[field->current], field->G[field->current], field->B[field->current]};
+			for (int c = 0; c < 3; c++) {
+				nMismatches += !std::equal(planes[c], planes[c] + ld->nPanels, reference.begin() + c * ld->nPanels);
+			}
+		}
+	}
+
+	// without decay the colour only moves between panels
+	double before = 0;
+	double after = 0;
+	for (int i = 0; i < ld->nPanels; i++) {
+		before += fields[0].R[fields[0].current][i];
+	}
+	for (int step = 0; step < CHECK_N_DIFFUSION_STEPS; step++) {
+		stepDiffusion(&fields[0]);
+	}
+	for (int i = 0; i < ld->nPanels; i++) {
+		after += fields[0].R[fields[0].current][i];
+	}
+	bool kept = fabs(after - before) < before * 1e-4;
+	selectDiffusionStep(DIFFUSION_STEP_AVX2);
+	freeLayoutData(ld);
+	printf("diffusion engine %d mismatches over %d steps, total %.1f kept as %.1f: %s\n", nMismatches,
+			CHECK_N_DIFFUSION_STEPS, before, after, nMismatches == 0 && kept ? "ok" : "FAILED");
+	return nMismatches == 0 && kept;
+}
+
+/**
+ * @description: a grid of squares with a Rhythm module in the middle of it
+ */
+static void buildSquareLayoutStream(std::vector<int>* stream, int nPanels) {
+	stream->clear();
+	stream->push_back(0);
+	stream->push_back(BENCH_SIDE_LENGTH);
+	int nColumns = (int)ceil(sqrt((double)nPanels));
+	for (int i = 0; i < nPanels; i++) {
+		bool rhythm = i == nPanels / 2;
+		stream->push_back((rhythm ? SHAPE_RHYTHM : SHAPE_SQUARE) * 256 + i + 1);
+		stream->push_back((i % nColumns) * BENCH_SIDE_LENGTH + BENCH_SIDE_LENGTH / 2);
+		stream->push_back((i / nColumns) * BENCH_SIDE_LENGTH + BENCH_SIDE_LENGTH / 2);
+		stream->push_back(0);
+	}
+}
+
+/**
+ * @description: compare the adjacency graph of triangle and square layouts with testing every pair of edges of every
+ * pair of panels
+ * @return: true if they find the same neighbours
+ */
+static bool checkPanelAdjacency(void) {
+	std::vector<int> squareStream;
+	buildSquareLayoutStream(&squareStream, BENCH_N_PANELS);
+	std::vector<int>* streams[] = {&layoutStream, &largeLayoutStream, &squareStream};
+	int nPanels[] = {BENCH_N_PANELS, BENCH_MAX_TRIANGLES, BENCH_N_PANELS};
+	double tolerance = BENCH_SIDE_LENGTH * 0.2;
+	int nMismatches = 0;
+	int nEdges = 0;
+
+	for (int l = 0; l < 3; l++) {
+		LayoutData* ld = NULL;
+		parseLayoutData(streams[l]->data(), nPanels[l], &ld);
+		for (int i = 0; i < ld->nPanels; i++) {
+			std::vector<int> reference;
+			Shape* s1 = ld->panels[i].shape;
+			for (int j = 0; s1 && j < ld->nPanels; j++) {
+				Shape* s2 = ld->panels[j].shape;
+				bool shared = false;
+				for (int v = 0; s2 && i != j && v < s1->nVertices; v++) {
+					Point m1 = s1->vertices[v] + s1->vertices[(v + 1) % s1->nVertices];
+					for (int w = 0; w < s2->nVertices; w++) {
+						Point m2 = s2->vertices[w] + s2->vertices[(w + 1) % s2->nVertices];
+						shared = shared || (fabs(m1.x - m2.x) < 2 * tolerance && fabs(m1.y - m2.y) < 2 * tolerance);
+					}
+				}
+				if (shared) {
+					reference.push_back(j);
+				}
+			}
+			const PanelAdjacency_t* a = &ld->adjacency;
+			nMismatches += !std::equal(reference.begin(), reference.end(), a->neighbors.begin() + a->offsets[i]) ||
+					(int)reference.size() != a->offsets[i + 1] - a->offsets[i];
+			nEdges += reference.size();
+		}
+		printf("adjacency of %d panels: %d edges, adjacent distance %.2f\n", ld->nPanels,
+				(int)ld->adjacency.neighbors.size() / 2, ld->adjacency.adjacentDistance);
+		freeLayoutData(ld);
+	}
+	printf("panel adjacency %d mismatches over %d neighbours: %s\n", nMismatches, nEdges, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * @description: the entry panels found the way Soda used to find its start points: for every panel the line through it
+ * in the direction, the panel near that line furthest back along it, without repeats and in the order first found
+ */
+static void entryPanelsReference(LayoutData* ld, double directionDegrees, float laneWidth, std::vector<int>* panels) {
+	double theta = degs2rads(directionDegrees);
+	double dx = cos(theta);
+	double dy = sin(theta);
+	const PanelCentroids_t* c = &ld->centroids;
+	panels->clear();
+	for (int n1 = 0; n1 < ld->nPanels; n1++) {
+		double across = c->x[n1] * dy - c->y[n1] * dx;
+		int entry = -1;
+		double entryAlong = 0;
+		for (int i = 0; i < ld->nPanels; i++) {
+			double along = c->x[i] * dx + c->y[i] * dy;
+			if (fabs(c->x[i] * dy - c->y[i] * dx - across) < laneWidth && (entry < 0 || along < entryAlong)) {
+				entry = i;
+				entryAlong = along;
+			}
+		}
+		if (std::find(panels->begin(), panels->end(), entry) == panels->end()) {
+			panels->push_back(entry);
+		}
+	}
+}
+
+/**
+ * @description: compare getEntryPanels with the reference for small and large layouts, several directions, and again
+ * after rotating the layout, which recomputes the cached results
+ * @return: true if they find the same panels in the same order and a repeated call returns the cached result
+ */
+static bool checkEntryPanels(void) {
+	const double directions[] = {0, 45, 90, 135, 180, 270};
+	const int nDirections = sizeof(directions) / sizeof(directions[0]);
+	std::vector<int>* streams[] = {&layoutStream, &largeLayoutStream};
+	int nPanels[] = {BENCH_N_PANELS, BENCH_MAX_TRIANGLES};
+	std::vector<int> reference;
+	int nMismatches = 0;
+	int nChecks = 0;
+
+	for (int l = 0; l < 2; l++) {
+		LayoutData* ld = NULL;
+		parseLayoutData(streams[l]->data(), nPanels[l], &ld);
+		for (int rotation = 0; rotation <= 60; rotation += 60) {
+			int angle = rotation;
+			rotateAuroraPanels(ld, &angle);
+			for (int d = 0; d < nDirections; d++) {
+				const EntryPanels_t* entry = getEntryPanels(ld, directions[d], CHECK_LANE_WIDTH);
+				entryPanelsReference(ld, directions[d], CHECK_LANE_WIDTH, &reference);
+				nMismatches += entry->panels != reference;
+				nMismatches += getEntryPanels(ld, directions[d], CHECK_LANE_WIDTH) != entry;
+				nChecks++;
+			}
+		}
+		freeLayoutData(ld);
+	}
+	printf("entry panels %d mismatches over %d directions: %s\n", nMismatches, nChecks, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * @description: feed random fft rows to the scalar filters and the filter banks, and compare every output
+ * with the mean, min, max and median of the window computed from scratch
+ * @return: true if they all match
+ */
+static bool checkStreamingFilters(void) {
+	unsigned int seed = 1;
+	int nChannels = BENCH_N_FFT_BINS;
+	int length = BENCH_FILTER_LENGTH;
+	std::vector<float> history;
+	std::vector<float> row(nChannels);
+	std::vector<float> window;
+	RunningMean<float> mean(length);
+	RunningMin<float, BENCH_FILTER_LENGTH> minimum;
+	RunningMax<float> maximum(length);
+	RunningMedian<float, BENCH_FILTER_LENGTH> median;
+	RunningMeanBank<float> meanBank(nChannels, length);
+	RunningMinBank<float> minBank(nChannels, length);
+	RunningMaxBank<float, BENCH_FILTER_LENGTH> maxBank(nChannels);
+	RunningMedianBank<float> medianBank(nChannels, length);
+	int nMismatches = 0;
+	int nChecks = 0;
+
+	for (int t = 0; t < CHECK_N_FILTER_SAMPLES; t++) {
+		for (int c = 0; c < nChannels; c++) {
+			// few distinct values so the windows hold plenty of duplicates
+			row[c] = (float)(rand_r(&seed) % 64);
+			history.push_back(row[c]);
+		}
+		mean.feedFilter(row[0]);
+		minimum.feedFilter(row[0]);
+		maximum.feedFilter(row[0]);
+		median.feedFilter(row[0]);
+		meanBank.feedFilter(row.data());
+		minBank.feedFilter(row.data());
+		maxBank.feedFilter(row.data());
+		medianBank.feedFilter(row.data());
+
+		int first = std::max(0, t - length + 1);
+		for (int c = 0; c < nChannels; c++) {
+			window.clear();
+			for (int i = first; i <= t; i++) {
+				window.push_back(history[i * nChannels + c]);
+			}
+			std::sort(window.begin(), window.end());
+			double sum = 0;
+			for (size_t i = 0; i < window.size(); i++) {
+				sum += window[i];
+			}
+			double expectedMean = sum / window.size();
+			float expectedMedian = window[window.size() / 2];
+			nMismatches += fabs(meanBank.getMeans()[c] - expectedMean) > 1e-3;
+			nMismatches += minBank.getValues()[c] != window.front();
+			nMismatches += maxBank.getValues()[c] != window.back();
+			nMismatches += medianBank.getValues()[c] != expectedMedian;
+			if (c == 0) {
+				nMismatches += fabs(mean.getMean() - expectedMean) > 1e-9;
+				nMismatches += minimum.getValue() != window.front();
+				nMismatches += maximum.getValue() != window.back();
+				nMismatches += median.getValue() != expectedMedian;
+				nChecks += 4;
+			}
+			nChecks += 4;
+		}
+	}
+	printf("streaming filters %d mismatches over %d outputs: %s\n", nMismatches, nChecks, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * @description: run HSVtoRGBFast and RGBtoHSVFast on every colour and compare them with HSVtoRGB and RGBtoHSV
+ * @return: true if no channel is more than 1 apart (hues compared around the circle)
+ */
+static bool checkColorConversions(void) {
+	int maxError = 0;
+	long nDiffering = 0;
+	long nColors = 0;
+	for (int h = 0; h <= 360; h++) {
+		for (int s = 0; s <= 100; s++) {
+			for (int v = 0; v <= 100; v++) {
+				HSV_t hsv = {h, s, v};
+				RGB_t a, b;
+				HSVtoRGB(hsv, &a);
+				HSVtoRGBFast(hsv, &b);
+				int e = std::max(std::max(abs(a.R - b.R), abs(a.G - b.G)), abs(a.B - b.B));
+				maxError = std::max(maxError, e);
+				nDiffering += e != 0;
+				nColors++;
+			}
+		}
+	}
+	for (int r = 0; r < 256; r++) {
+		for (int g = 0; g < 256; g++) {
+			for (int b = 0; b < 256; b++) {
+				RGB_t rgb = {r, g, b};
+				HSV_t x, y;
+				RGBtoHSV(rgb, &x);
+				RGBtoHSVFast(rgb, &y);
+				int dh = abs(x.H - y.H);
+				int e = std::max(std::max(std::min(dh, 360 - dh), abs(x.S - y.S)), abs(x.V - y.V));
+				maxError = std::max(maxError, e);
+				nDiffering += e != 0;
+				nColors++;
+			}
+		}
+	}
+	printf("HSVtoRGBFast/RGBtoHSVFast max error %d, %ld of %ld colours rounded differently: %s\n", maxError, nDiffering,
+			nColors, maxError <= 1 ? "ok" : "FAILED");
+	return maxError <= 1;
+}
+
+/**
+ * @description: for small and large layouts, base rotations of 0 and 30 degrees and every snapped turn, compare the
+ * view of a frame slice set with the slices of the rotated layout
+ * @return: true if they hold the same panels in the same order
+ */
+static bool checkFrameSliceSet(void) {
+	std::vector<int>* streams[] = {&layoutStream, &largeLayoutStream};
+	int nPanels[] = {BENCH_N_PANELS, BENCH_MAX_TRIANGLES};
+	int nMismatches = 0;
+	int nViews = 0;
+
+	for (int l = 0; l < 2; l++) {
+		for (int base = 0; base <= 30; base += 30) {
+			LayoutData* ld = NULL;
+			parseLayoutData(streams[l]->data(), nPanels[l], &ld);
+			int angle = base;
+			rotateAuroraPanels(ld, &angle);
+			FrameSliceSet_t sliceSet;
+			buildFrameSliceSet(ld, base, &sliceSet);
+			for (int turn = 0; turn < 360; turn += 30) {
+				LayoutData* rotated = NULL;
+				parseLayoutData(streams[l]->data(), nPanels[l], &rotated);
+				angle = base;
+				rotateAuroraPanels(rotated, &angle);
+				angle = turn;
+				rotateAuroraPanels(rotated, &angle);
+				FrameSlice_t* slices = NULL;
+				int nSlices = 0;
+				getFrameSlicesFromLayoutForTriangle(rotated, &slices, &nSlices, base + turn);
+
+				FrameSliceView_t view = getFrameSliceView(&sliceSet, turn);
+				bool same = view.nSlices == nSlices && view.rotation == (base + turn) % 360;
+				for (int s = 0; same && s < nSlices; s++) {
+					int first = view.sliceOffsets[s];
+					same = view.sliceOffsets[s + 1] - first == (int)slices[s].panelIds.size() &&
+							std::equal(slices[s].panelIds.begin(), slices[s].panelIds.end(), view.panelIds + first);
+				}
+				nMismatches += !same;
+				nViews++;
+				freeFrameSlices(slices);
+				freeLayoutData(rotated);
+			}
+			freeLayoutData(ld);
+		}
+	}
+	printf("frame slice set %d mismatches over %d rotations: %s\n", nMismatches, nViews, nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+static ProfileSite_t checkTimerSite("check timer", PROFILE_SITE_TIMER);
+static ProfileSite_t checkCounterSite("check counter", PROFILE_SITE_COUNTER);
+
+static void recordProfileSamples(void) {
+	for (int i = 0; i < CHECK_N_PROFILE_SAMPLES; i++) {
+		ProfileScope scope(checkTimerSite);
+		addProfileCount(checkCounterSite.id, 2);
+	}
+}
+
+/**
+ * @description: record timers and counters from several threads at once and compare the totals with the number of calls
+ * @return: true if no sample was lost
+ */
+static bool checkProfiler(void) {
+	resetProfile();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < CHECK_N_PROFILE_THREADS; t++) {
+		threads.push_back(std::thread(recordProfileSamples));
+	}
+	for (size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+	uint64_t nTimed, ticks, nCounted, total;
+	getProfileTotals(checkTimerSite.id, &nTimed, &ticks);
+	getProfileTotals(checkCounterSite.id, &nCounted, &total);
+	uint64_t expected = (uint64_t)CHECK_N_PROFILE_THREADS * CHECK_N_PROFILE_SAMPLES;
+	bool ok = nTimed == expected && nCounted == expected && total == 2 * expected;
+	printf("profiler %llu timer samples, %llu counts totalling %llu from %d threads: %s\n", (unsigned long long)nTimed,
+			(unsigned long long)nCounted, (unsigned long long)total, CHECK_N_PROFILE_THREADS, ok ? "ok" : "FAILED");
+	resetProfile();
+	return ok;
+}
+
+/**
+ * @description: exhaust the token bucket of a call site, then queue one record through the drainer
+ * @return: true if the bucket allowed exactly the burst and nothing was dropped
+ */
+static bool checkLogger(void) {
+	LogSite_t site(0, CHECK_LOG_BURST);
+	int nAllowed = 0;
+	for (int i = 0; i < CHECK_N_LOG_CALLS; i++) {
+		nAllowed += allowLog(&site);
+	}
+	bool ok = nAllowed == CHECK_LOG_BURST && site.nSuppressed == CHECK_N_LOG_CALLS - CHECK_LOG_BURST;
+
+	// the drainer prints to stdout, point it at a temporary file while the records below are drained
+	std::string longA(40, 'a');
+	std::string longB(40, 'b');
+	flushLog();
+	fflush(stdout);
+	FILE* capture = tmpfile();
+	int savedStdout = dup(STDOUT_FILENO);
+	dup2(fileno(capture), STDOUT_FILENO);
+	LOG_INFO("ints %d|%5d|%-4d|%03u|%x|%%\n", -42, 7, 3, 9u, 255);
+	LOG_INFO("lengths %ld %lld %hd %lu\n", 1234567890123L, -5LL, (short)7, 4000000000UL);
+	LOG_INFO("floats %5.2f|%.3e|%g|%c\n", M_PI, 12345.678, 0.5, 'x');
+	LOG_INFO("strings %s|%-6s|%.2s|\n", "abc", "de", "xyz");
+	// 40 + 1 bytes for the first, the second gets the 22 left before the terminator, the third none
+	LOG_INFO("packed %s|%s|%s|\n", longA.c_str(), longB.c_str(), "c");
+	LOG_INFO("missing %d and %s end\n", 5);
+	LOG_INFO("%d%d%d%d%d%d%d%d%d\n", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+	LOG_DEBUG("below LOG_MIN_LEVEL\n");
+	LOG_WARN("level %d\n", LOG_LEVEL_WARN);
+	flushLog();
+	dup2(savedStdout, STDOUT_FILENO);
+	close(savedStdout);
+	char text[1024];
+	rewind(capture);
+	size_t length = fread(text, 1, sizeof(text) - 1, capture);
+	text[length] = 0;
+	fclose(capture);
+
+	std::string expected = "ints -42|    7|3   |009|ff|%\n"
+			"lengths 1234567890123 -5 7 4000000000\n"
+			"floats  3.14|1.235e+04|0.5|x\n"
+			"strings abc|de    |xy|\n"
+			"packed " + longA + "|" + std::string(22, 'b') + "||\n"
+			"missing 5 and  end\n"
+			"12345678\n"
+			"warning: level 2\n";
+	bool formatOk = expected == text;
+	if (!formatOk) {
+		printf("logger printed:\n%s", text);
+	}
+	ok = ok && formatOk && getLogDropCount() == 0;
+	printf("logger %d of %d calls allowed with a burst of %d, records formatted %s, %llu dropped: %s\n", nAllowed,
+			CHECK_N_LOG_CALLS, CHECK_LOG_BURST, formatOk ? "as expected" : "wrongly",
+			(unsigned long long)getLogDropCount(), ok ? "ok" : "FAILED");
+	return ok;
+}
+
+struct CheckSource_t {
+	int key;
+	int id;
+};
+
+/**
+ * @description: apply random sorted inserts and removals to a pool and to a vector, and compare the order,
+ * the handles and the unordered contents after every operation
+ * @return: true if the pool always matched the vector
+ */
+static bool checkSourcePool(void) {
+	SourcePool<CheckSource_t, CHECK_POOL_CAPACITY, true> ordered;
+	SourcePool<int, CHECK_POOL_CAPACITY> unordered;
+	std::vector<CheckSource_t> reference;
+	std::vector<SourceHandle_t> handles;
+	std::vector<SourceHandle_t> staleHandles;
+	unsigned int seed = 11;
+	int nMismatches = 0;
+	for (int op = 0; op < CHECK_N_POOL_OPERATIONS; op++) {
+		int choice = rand_r(&seed) % 3;
+		if (choice == 0 && !ordered.isFull()) {
+			// insert after every source with a key that is not larger, like RhythmicNorthernLights
+			CheckSource_t source = {rand_r(&seed) % 8, op};
+			int before = SOURCE_POOL_NONE;
+			for (int i = ordered.last(); i != SOURCE_POOL_NONE && source.key < ordered[i].key; i = ordered.prev(i)) {
+				before = i;
+			}
+			handles.push_back(ordered.getHandle(ordered.insertBefore(before, source)));
+			size_t position = 0;
+			while (position < reference.size() && reference[position].key <= source.key) {
+				position++;
+			}
+			reference.insert(reference.begin() + position, source);
+			unordered.add(source.id);
+		}
+		else if (choice == 1 && !ordered.isEmpty()) {
+			// erase one source while walking, like the expiry loops of the plugins
+			int victim = reference[rand_r(&seed) % reference.size()].id;
+			int i = ordered.first();
+			while (i != SOURCE_POOL_NONE) {
+				if (ordered[i].id == victim) {
+					staleHandles.push_back(ordered.getHandle(i));
+					i = ordered.erase(i);
+				}
+				else {
+					i = ordered.next(i);
+				}
+			}
+			for (size_t k = 0; k < reference.size(); k++) {
+				if (reference[k].id == victim) {
+					reference.erase(reference.begin() + k);
+					break;
+				}
+			}
+			for (int k = 0; k < unordered.size(); k++) {
+				if (unordered[k] == victim) {
+					unordered.remove(k);
+					break;
+				}
+			}
+		}
+		else if (choice == 2 && !handles.empty()) {
+			// remove through a handle, which may already be stale
+			size_t k = rand_r(&seed) % handles.size();
+			CheckSource_t* source = ordered.get(handles[k]);
+			if (source) {
+				int id = source->id;
+				ordered.remove(handles[k]);
+				for (size_t j = 0; j < reference.size(); j++) {
+					if (reference[j].id == id) {
+						reference.erase(reference.begin() + j);
+						break;
+					}
+				}
+				for (int j = 0; j < unordered.size(); j++) {
+					if (unordered[j] == id) {
+						unordered.remove(j);
+						break;
+					}
+				}
+			}
+			staleHandles.push_back(handles[k]);
+			handles.erase(handles.begin() + k);
+		}
+
+		size_t k = 0;
+		for (int i = ordered.first(); i != SOURCE_POOL_NONE; i = ordered.next(i), k++) {
+			if (k >= reference.size() || ordered[i].id != reference[k].id) {
+				nMismatches++;
+				break;
+			}
+		}
+		std::vector<int> ids;
+		for (int i = 0; i < unordered.size(); i++) {
+			ids.push_back(unordered[i]);
+		}
+		std::vector<int> referenceIds;
+		for (size_t j = 0; j < reference.size(); j++) {
+			referenceIds.push_back(reference[j].id);
+		}
+		std::sort(ids.begin(), ids.end());
+		std::sort(referenceIds.begin(), referenceIds.end());
+		if (k != reference.size() || (int)reference.size() != ordered.size() || ids != referenceIds) {
+			nMismatches++;
+		}
+		if (!staleHandles.empty() && ordered.isValid(staleHandles.back())) {
+			nMismatches++;
+		}
+		if (handles.size() > 4 * CHECK_POOL_CAPACITY) {
+			handles.erase(handles.begin());
+		}
+		if (staleHandles.size() > 4 * CHECK_POOL_CAPACITY) {
+			staleHandles.erase(staleHandles.begin());
+		}
+	}
+	printf("source pool %d mismatches over %d operations: %s\n", nMismatches, CHECK_N_POOL_OPERATIONS,
+			nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+/**
+ * A light source as the examples kept it, in a list that is shifted on every insert and removal
+ */
+struct ReferenceParticle_t {
+	float x, y, vx, vy, radius, age, ageRate, intensity;
+	int R, G, B;
+};
+
+/**
+ * @description: run the particle engine and the list based source handling of the examples side by side, with random
+ * spawns, for each kernel and order, and compare the frames
+ * @return: true if every frame matched exactly
+ */
+static bool checkParticleEngine(void) {
+	PanelCentroids_t centroids;
+	buildCentroids(&centroids, BENCH_N_PANELS);
+	std::vector<Frame_t> frames(BENCH_N_PANELS);
+	std::vector<Frame_t> referenceFrames(BENCH_N_PANELS);
+	static ParticleSystem_t particles;
+	static LightSources_t lights;
+	RGB_t base = {10, 20, 30};
+	int kernels[] = {PARTICLE_KERNEL_INVERSE_SQUARE, PARTICLE_KERNEL_BUBBLE, PARTICLE_KERNEL_DIFFUSION};
+	int nMismatches = 0;
+	unsigned int seed = 5;
+	for (int k = 0; k < 3; k++) {
+		bool diffusion = kernels[k] == PARTICLE_KERNEL_DIFFUSION;
+		initParticleSystem(&particles, 10);
+		particles.config.kernel = kernels[k];
+		particles.config.distanceScale = diffusion ? 0.015 : 1.0 / BENCH_SIDE_LENGTH;
+		particles.config.k = diffusion ? 2.0 : 1.5;
+		if (diffusion) {
+			particles.config.order = PARTICLE_ORDER_INTENSITY;
+			particles.config.diffusionRate = 0.2;
+			particles.config.minFactor = 0.05;
+			particles.config.motion = PARTICLE_MOTION_STATIC;
+			particles.config.expiry = PARTICLE_EXPIRE_AGE;
+			particles.config.maxAge = 40.0;
+			particles.config.minParticles = 2;
+		}
+		else {
+			particles.config.expiry = PARTICLE_EXPIRE_DISTANCE;
+			particles.config.maxDistance = 20.0 * BENCH_SIDE_LENGTH;
+		}
+		std::vector<ReferenceParticle_t> reference;
+		for (int frame = 0; frame < CHECK_N_PARTICLE_FRAMES; frame++) {
+			if (rand_r(&seed) % 3 == 0) {
+				ReferenceParticle_t p;
+				p.x = randomFloat(&seed, 0, 6 * BENCH_SIDE_LENGTH);
+				p.y = randomFloat(&seed, 0, 6 * BENCH_SIDE_LENGTH);
+				p.vx = diffusion ? 0 : randomFloat(&seed, -50, 50);
+				p.vy = diffusion ? 0 : randomFloat(&seed, -50, 50);
+				p.radius = kernels[k] == PARTICLE_KERNEL_BUBBLE ? 0.2 : 0;
+				p.age = 0;
+				p.ageRate = diffusion ? randomFloat(&seed, 0.5, 1.5) : 1;
+				p.intensity = (rand_r(&seed) % 4 + 1) * 0.25f;
+				p.R = rand_r(&seed) % 256;
+				p.G = rand_r(&seed) % 256;
+				p.B = rand_r(&seed) % 256;
+
+				int i = spawnParticle(&particles, p.x, p.y, p.R, p.G, p.B, p.intensity);
+				particles.vx[i] = p.vx;
+				particles.vy[i] = p.vy;
+				particles.radius[i] = p.radius;
+				particles.ageRate[i] = p.ageRate;
+
+				if ((int)reference.size() >= 10) {
+					reference.erase(reference.begin());
+				}
+				size_t position = reference.size();
+				while (diffusion && position > 0 && p.intensity < reference[position - 1].intensity) {
+					position--;
+				}
+				reference.insert(reference.begin() + position, p);
+			}
+
+			renderParticles(&particles, &centroids, base, 1, frames.data());
+			LightFalloff_t falloff = {diffusion ? LIGHT_FALLOFF_INVERSE_LINEAR : LIGHT_FALLOFF_INVERSE_SQUARE,
+					particles.config.distanceScale, particles.config.k};
+			clearLightSources(&lights);
+			for (size_t j = 0; j < reference.size(); j++) {
+				const ReferenceParticle_t& p = reference[j];
+				int idx = addLightSource(&lights, p.x, p.y, p.R, p.G, p.B);
+				lights.offset[idx] = diffusion ? p.age * 0.2 : p.radius;
+				if (diffusion) {
+					lights.gain[idx] = p.age >= 40.0 ? 0.0 : 1.0 - p.age / 40.0;
+					lights.minFactor[idx] = 0.05;
+				}
+			}
+			renderLightSources(&centroids, &lights, &falloff, base, 1, referenceFrames.data());
+			if (memcmp(frames.data(), referenceFrames.data(), BENCH_N_PANELS * sizeof(Frame_t)) != 0
+					|| particles.nParticles != (int)reference.size()) {
+				nMismatches++;
+			}
+
+			updateParticles(&particles);
+			bool expireOld = (int)reference.size() > 2;
+			for (size_t j = 0; j < reference.size(); j++) {
+				ReferenceParticle_t& p = reference[j];
+				p.x += p.vx;
+				p.y += p.vy;
+				p.age += p.ageRate;
+				float d = sqrt(p.x * p.x + p.y * p.y);
+				if ((!diffusion && d > 20.0 * BENCH_SIDE_LENGTH) || (diffusion && expireOld && p.age > 40.0)) {
+					reference.erase(reference.begin() + j);
+					j--;
+				}
+			}
+		}
+	}
+	printf("particle engine %d mismatches over %d frames of 3 kernels: %s\n", nMismatches, 3 * CHECK_N_PARTICLE_FRAMES,
+			nMismatches == 0 ? "ok" : "FAILED");
+	return nMismatches == 0;
+}
+
+static long benchProfileScope(long n) {
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		PROFILE_SCOPE("bench scope");
+		s += i;
+	}
+	return s;
+}
+
+static long benchProfileCount(long n) {
+	for (long i = 0; i < n; i++) {
+		PROFILE_COUNT("bench count", i & 7);
+	}
+	return n;
+}
+
+static long benchLogRateLimited(long n) {
+	LogSite_t site(0, 0);
+	for (long i = 0; i < n; i++) {
+		logAt(&site, LOG_LEVEL_INFO, "bench %ld\n", i);
+	}
+	return site.nSuppressed;
+}
+
+/**
+ * one new source per call, the oldest one evicted when the pool is full and every fourth one expired by a walk
+ */
+static long benchSourcePool(long n) {
+	static SourcePool<CheckSource_t, BENCH_POOL_CAPACITY, true> pool;
+	long s = 0;
+	for (long k = 0; k < n; k++) {
+		if (pool.isFull()) {
+			pool.remove(pool.first());
+		}
+		CheckSource_t source = {(int)(k & 7), (int)k};
+		pool.add(source);
+		int i = pool.first();
+		while (i != SOURCE_POOL_NONE) {
+			if ((pool[i].id & 3) == 3) {
+				i = pool.erase(i);
+			}
+			else {
+				s += pool[i].key;
+				i = pool.next(i);
+			}
+		}
+	}
+	return s;
+}
+
+static long benchPointRotate(long n) {
+	Point p(100, 50);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		Point r = p.rotate(i % 360);
+		s += (long)r.x;
+	}
+	return s;
+}
+
+static long benchPointDistance(long n) {
+	Point a(0, 0);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		Point b(i % 300, 40);
+		s += (long)Point::distance(a, b);
+	}
+	return s;
+}
+
+static long benchPointArithmetic(long n) {
+	Point a(1, 2);
+	Point acc;
+	for (long i = 0; i < n; i++) {
+		acc = acc + a;
+		acc = acc - Point(0.5, 1);
+	}
+	int x, y;
+	acc.ToInt(&x, &y);
+	return x + y;
+}
+
+static long benchHSVtoRGB(long n) {
+	RGB_t rgb;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		HSV_t hsv = {(int)(i % 360), 100, 100};
+		HSVtoRGB(hsv, &rgb);
+		s += rgb.R;
+	}
+	return s;
+}
+
+static long benchRGBtoHSV(long n) {
+	HSV_t hsv;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		RGB_t rgb = {(int)(i & 255), (int)((i >> 3) & 255), 40};
+		RGBtoHSV(rgb, &hsv);
+		s += hsv.H;
+	}
+	return s;
+}
+
+static long benchHSVtoRGBFast(long n) {
+	RGB_t rgb;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		HSV_t hsv = {(int)(i % 360), 100, 100};
+		HSVtoRGBFast(hsv, &rgb);
+		s += rgb.R;
+	}
+	return s;
+}
+
+static long benchRGBtoHSVFast(long n) {
+	HSV_t hsv;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		RGB_t rgb = {(int)(i & 255), (int)((i >> 3) & 255), 40};
+		RGBtoHSVFast(rgb, &hsv);
+		s += hsv.H;
+	}
+	return s;
+}
+
+static long benchHSVtoRGBBatch(long n) {
+	static HSV_t hsv[BENCH_N_COLORS_BATCH];
+	static RGB_t rgb[BENCH_N_COLORS_BATCH];
+	for (int i = 0; i < BENCH_N_COLORS_BATCH; i++) {
+		HSV_t c = {i % 360, 100 - i % 50, 100 - i % 30};
+		hsv[i] = c;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		hsv[i % BENCH_N_COLORS_BATCH].H = (int)(i % 360);
+		HSVtoRGB(hsv, rgb, BENCH_N_COLORS_BATCH);
+		s += rgb[i % BENCH_N_COLORS_BATCH].G;
+	}
+	return s;
+}
+
+static long benchHSVtoRGBLoop(long n) {
+	static HSV_t hsv[BENCH_N_COLORS_BATCH];
+	static RGB_t rgb[BENCH_N_COLORS_BATCH];
+	for (int i = 0; i < BENCH_N_COLORS_BATCH; i++) {
+		HSV_t c = {i % 360, 100 - i % 50, 100 - i % 30};
+		hsv[i] = c;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		hsv[i % BENCH_N_COLORS_BATCH].H = (int)(i % 360);
+		for (int k = 0; k < BENCH_N_COLORS_BATCH; k++) {
+			HSVtoRGB(hsv[k], &rgb[k]);
+		}
+		s += rgb[i % BENCH_N_COLORS_BATCH].G;
+	}
+	return s;
+}
+
+static long benchRGBtoHSVBatch(long n) {
+	static RGB_t rgb[BENCH_N_COLORS_BATCH];
+	static HSV_t hsv[BENCH_N_COLORS_BATCH];
+	for (int i = 0; i < BENCH_N_COLORS_BATCH; i++) {
+		RGB_t c = {i & 255, (i * 7) & 255, (i * 13) & 255};
+		rgb[i] = c;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		rgb[i % BENCH_N_COLORS_BATCH].R = (int)(i & 255);
+		RGBtoHSV(rgb, hsv, BENCH_N_COLORS_BATCH);
+		s += hsv[i % BENCH_N_COLORS_BATCH].H;
+	}
+	return s;
+}
+
+static long benchRGBtoHSVLoop(long n) {
+	static RGB_t rgb[BENCH_N_COLORS_BATCH];
+	static HSV_t hsv[BENCH_N_COLORS_BATCH];
+	for (int i = 0; i < BENCH_N_COLORS_BATCH; i++) {
+		RGB_t c = {i & 255, (i * 7) & 255, (i * 13) & 255};
+		rgb[i] = c;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		rgb[i % BENCH_N_COLORS_BATCH].R = (int)(i & 255);
+		for (int k = 0; k < BENCH_N_COLORS_BATCH; k++) {
+			RGBtoHSV(rgb[k], &hsv[k]);
+		}
+		s += hsv[i % BENCH_N_COLORS_BATCH].H;
+	}
+	return s;
+}
+
+static long benchRGBOperators(long n) {
+	RGB_t a = {200, 100, 50};
+	RGB_t b = {10, 20, 30};
+	RGB_t acc = {0, 0, 0};
+	for (long i = 0; i < n; i++) {
+		acc = (acc * 3 + a - b) / 4.0f;
+	}
+	return acc.R + acc.G + acc.B;
+}
+
+static long benchLimitRGB(long n) {
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		RGB_t c = {(int)(i % 400) - 50, 300, -3};
+		s += limitRGB(c, 255, 0).R;
+	}
+	return s;
+}
+
+static long benchParseColor(long n) {
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		RGB_t* rgb = NULL;
+		parseColor(paletteStream.data(), BENCH_N_COLORS, &rgb);
+		s += rgb[0].R;
+		freeColor(rgb);
+	}
+	return s;
+}
+
+static long benchPassLayoutData(long n) {
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		passLayoutData(layoutStream.data(), BENCH_N_PANELS);
+		s += getLayoutData()->nPanels;
+	}
+	return s;
+}
+
+static long benchParseLayoutData(long n) {
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		LayoutData* ld = NULL;
+		parseLayoutData(layoutStream.data(), BENCH_N_PANELS, &ld);
+		s += ld->nPanels;
+		freeLayoutData(ld);
+	}
+	return s;
+}
+
+static long benchRotateAuroraPanels(long n) {
+	LayoutData* ld = NULL;
+	parseLayoutData(layoutStream.data(), BENCH_N_PANELS, &ld);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		int angle = 30;
+		s += rotateAuroraPanels(ld, &angle);
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchGetFrameSlices(long n) {
+	LayoutData* ld = getLayoutData();
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		FrameSlice_t* slices = NULL;
+		int nSlices = 0;
+		getFrameSlicesFromLayoutForTriangle(ld, &slices, &nSlices, (i % 12) * 30);
+		s += nSlices;
+		freeFrameSlices(slices);
+	}
+	return s;
+}
+
+static long benchRotateAndSlice(long n) {
+	// what a rotating effect has to do on every turn without a frame slice set
+	LayoutData* ld = NULL;
+	parseLayoutData(layoutStream.data(), BENCH_N_PANELS, &ld);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		int angle = 30;
+		rotateAuroraPanels(ld, &angle);
+		FrameSlice_t* slices = NULL;
+		int nSlices = 0;
+		getFrameSlicesFromLayoutForTriangle(ld, &slices, &nSlices, (int)((i + 1) % 12) * 30);
+		s += nSlices;
+		freeFrameSlices(slices);
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchBuildFrameSliceSet(long n) {
+	LayoutData* ld = getLayoutData();
+	FrameSliceSet_t sliceSet;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFrameSliceSet(ld, 0, &sliceSet);
+		s += sliceSet.panelIds.size();
+	}
+	return s;
+}
+
+static long benchGetFrameSliceView(long n) {
+	LayoutData* ld = getLayoutData();
+	FrameSliceSet_t sliceSet;
+	buildFrameSliceSet(ld, 0, &sliceSet);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		FrameSliceView_t view = getFrameSliceView(&sliceSet, (int)(i % 12) * 30);
+		s += view.nSlices + view.panelIds[view.sliceOffsets[0]];
+	}
+	return s;
+}
+
+static long benchIsPointInsidePanel(long n) {
+	LayoutData* ld = getLayoutData();
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		Panel* panel = &ld->panels[i % ld->nPanels];
+		s += isPointInsidePanel(panel, panel->shape->getCentroid());
+	}
+	return s;
+}
+
+static long benchPointInsideWhichPanel(long n) {
+	LayoutData* ld = getLayoutData();
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		Point p = ld->panels[i % ld->nPanels].shape->getCentroid();
+		s += pointInsideWhichPanel(ld, p);
+	}
+	return s;
+}
+
+static long benchPointInsideWhichPanelLarge(long n, bool useGrid) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	if (useGrid) {
+		buildPanelGrid(ld);
+	}
+	unsigned int seed = 1;
+	std::vector<Point> points;
+	buildRandomPoints(ld, &points, BENCH_N_POINTS, &seed);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		s += pointInsideWhichPanel(ld, points[i % BENCH_N_POINTS]);
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchPointInsideWhichPanelLinear(long n) {
+	return benchPointInsideWhichPanelLarge(n, false);
+}
+
+static long benchPointInsideWhichPanelGrid(long n) {
+	return benchPointInsideWhichPanelLarge(n, true);
+}
+
+static long benchPointsInsideWhichPanels(long n) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	buildPanelGrid(ld);
+	unsigned int seed = 1;
+	std::vector<Point> points;
+	std::vector<int> panelIds(BENCH_N_POINTS);
+	buildRandomPoints(ld, &points, BENCH_N_POINTS, &seed);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		pointsInsideWhichPanels(ld, points.data(), BENCH_N_POINTS, panelIds.data());
+		s += panelIds[i % BENCH_N_POINTS];
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchBuildPanelGrid(long n) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		buildPanelGrid(ld);
+		s += ld->panelGrid->nColumns;
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchBuildPanelAdjacency(long n) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		buildPanelAdjacency(ld);
+		s += ld->adjacency.neighbors.size();
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchGetEntryPanels(long n, bool cached) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		if (!cached) {
+			delete ld->entryPanelCache;
+			ld->entryPanelCache = NULL;
+		}
+		s += getEntryPanels(ld, 90, CHECK_LANE_WIDTH)->panels.size();
+	}
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchGetEntryPanelsUncached(long n) {
+	return benchGetEntryPanels(n, false);
+}
+
+static long benchGetEntryPanelsCached(long n) {
+	return benchGetEntryPanels(n, true);
+}
+
+static long benchUpdateRhythmFeatures(long n) {
+	uint8_t bins[BENCH_N_FFT_BINS];
+	memset(bins, 0, sizeof(bins));
+	RhythmFeatures_t rf = {0, bins, BENCH_N_FFT_BINS, 0, 0};
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		rf.energy = (uint16_t)i;
+		bins[i % BENCH_N_FFT_BINS] = (uint8_t)i;
+		updateRhythmFeatures(&rf);
+		s += getEnergy();
+	}
+	return s;
+}
+
+static long benchUpdateSpectrumFeatures(long n) {
+	float bins[BENCH_N_FFT_BINS];
+	std::fill(bins, bins + BENCH_N_FFT_BINS, 0.0f);
+	SpectrumFeatures_t sf = {bins, BENCH_N_FFT_BINS, 0};
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		bins[i % BENCH_N_FFT_BINS] = (float)(i % 1000);
+		updateSpectrumFeatures(&sf);
+		s += getPeakFftBin();
+	}
+	return s;
+}
+
+static long benchUpdateBeatFeatures(long n) {
+	uint8_t bins[BENCH_N_FFT_BINS];
+	RhythmFeatures_t rf = {0, bins, BENCH_N_FFT_BINS, 0, 0};
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		bool kick = (i % 10) == 0;
+		rf.energy = kick ? 4000 : 200;
+		memset(bins, kick ? 200 : 20, sizeof(bins));
+		updateRhythmFeatures(&rf);
+		updateBeatFeatures();
+		s += getIsBeat();
+	}
+	return s + (long)getTempo();
+}
+
+static long benchBandOnsets(long n) {
+	static BandOnsetDetector detector;
+	static float bands[BENCH_N_FFT_BINS];
+	if (detector.getNBands() == 0) {
+		detector.bandOnsetDetectorInit(BENCH_N_FFT_BINS, SOUND_TICK_MS);
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		bands[i % BENCH_N_FFT_BINS] = (float)(i % 200);
+		detector.bandOnsetDetectorTick(bands);
+		s += detector.getOnsets()[i % BENCH_N_FFT_BINS];
+	}
+	return s;
+}
+
+static long benchBeatTracker(long n) {
+	static BeatTracker tracker;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		bool kick = (i % 10) == 0;
+		tracker.beatTrackerTick(kick ? 50 : 1, kick);
+		s += tracker.isBeat();
+	}
+	return s;
+}
+
+static long benchBeatEngineTestTrack(long n) {
+	static std::vector<uint16_t> energy;
+	static std::vector<uint8_t> bins;
+	static BeatEngine engine;
+	if (energy.empty()) {
+		std::vector<int> beatTicks;
+		buildTestTrack(&testTracks[3], 1, &energy, &bins, &beatTicks);
+		engine.beatEngineInit(BENCH_N_FFT_BINS, TRACK_TICK_MS);
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		int t = i % energy.size();
+		engine.beatEngineTick(energy[t], &bins[t * BENCH_N_FFT_BINS]);
+		s += engine.isBeat();
+	}
+	return s;
+}
+
+static long benchRenderLightSources(long n, int renderer, int nPanels) {
+	static const LightFalloff_t falloff = {LIGHT_FALLOFF_INVERSE_SQUARE, 1.0f / BENCH_SIDE_LENGTH, 1.5f};
+	RGB_t base = {0, 0, 0};
+	selectLightRenderer(renderer);
+	largeWall.nPanels = nPanels;
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		renderLightSources(&largeWall, &lightSources, &falloff, base, 1, lightFrames.data());
+		s += lightFrames[i % nPanels].r;
+	}
+	largeWall.nPanels = BENCH_LARGE_N_PANELS;
+	selectLightRenderer(LIGHT_RENDERER_AVX2);
+	return s;
+}
+
+/**
+ * one spawn, one render and one update per call, diffusing particles on the large wall
+ */
+static long benchParticles(long n) {
+	static ParticleSystem_t particles;
+	initParticleSystem(&particles, BENCH_N_PARTICLES);
+	particles.config.order = PARTICLE_ORDER_INTENSITY;
+	particles.config.kernel = PARTICLE_KERNEL_DIFFUSION;
+	particles.config.distanceScale = 0.015;
+	particles.config.k = 2.0;
+	particles.config.diffusionRate = 0.2;
+	particles.config.minFactor = 0.05;
+	particles.config.expiry = PARTICLE_EXPIRE_AGE;
+	particles.config.maxAge = 40.0;
+	RGB_t base = {0, 0, 0};
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		spawnParticle(&particles, lightSources.x[i % BENCH_N_LIGHT_SOURCES], lightSources.y[i % BENCH_N_LIGHT_SOURCES],
+				255, 128, 0, (i % 4) * 0.25f);
+		renderParticles(&particles, &largeWall, base, 1, lightFrames.data());
+		updateParticles(&particles);
+		s += lightFrames[i % BENCH_LARGE_N_PANELS].r;
+	}
+	return s;
+}
+
+/**
+ * one injection, one render and one step per call on the largest triangle layout
+ */
+static long benchDiffusion(long n, int implementation) {
+	LayoutData* ld = NULL;
+	parseLayoutData(largeLayoutStream.data(), BENCH_MAX_TRIANGLES, &ld);
+	DiffusionField_t field;
+	initDiffusionField(&field, ld);
+	field.rate = 0.2f;
+	field.decay = 0.97f;
+	selectDiffusionStep(implementation);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		injectDiffusion(&field, (i * 7) % ld->nPanels, 255, 128, 0, 1.0f);
+		renderDiffusion(&field, 1, lightFrames.data());
+		stepDiffusion(&field);
+		s += lightFrames[i % ld->nPanels].r;
+	}
+	selectDiffusionStep(DIFFUSION_STEP_AVX2);
+	freeLayoutData(ld);
+	return s;
+}
+
+static long benchDiffusionScalar(long n) {
+	return benchDiffusion(n, DIFFUSION_STEP_SCALAR);
+}
+
+static long benchDiffusionAvx2(long n) {
+	return benchDiffusion(n, DIFFUSION_STEP_AVX2);
+}
+
+static long benchRenderScalarSmall(long n) {
+	return benchRenderLightSources(n, LIGHT_RENDERER_SCALAR, BENCH_N_PANELS);
+}
+
+static long benchRenderBestSmall(long n) {
+	return benchRenderLightSources(n, LIGHT_RENDERER_AVX2, BENCH_N_PANELS);
+}
+
+static long benchRenderScalarLarge(long n) {
+	return benchRenderLightSources(n, LIGHT_RENDERER_SCALAR, BENCH_LARGE_N_PANELS);
+}
+
+static long benchRenderSse2Large(long n) {
+	return benchRenderLightSources(n, LIGHT_RENDERER_SSE2, BENCH_LARGE_N_PANELS);
+}
+
+static long benchRenderAvx2Large(long n) {
+	return benchRenderLightSources(n, LIGHT_RENDERER_AVX2, BENCH_LARGE_N_PANELS);
+}
+
+/**
+ * @description: diff a wall where one panel in eight changes colour on every frame
+ */
+static long benchDiffFrames(long n) {
+	FrameDiffer_t differ;
+	initFrameDiffer(&differ, FRAME_DIFF_DEFAULT_THRESHOLD);
+	std::vector<Frame_t> frames(BENCH_LARGE_N_PANELS);
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		for (int p = 0; p < BENCH_LARGE_N_PANELS; p++) {
+			int c = (p % 8 == 0) ? (int)(i & 255) : 100;
+			Frame_t f = {p + 1, c, c, c, 1};
+			frames[p] = f;
+		}
+		s += diffFrames(&differ, frames.data(), BENCH_LARGE_N_PANELS);
+	}
+	return s;
+}
+
+/**
+ * @description: fill a row of fake fft bins for sample i
+ */
+static void buildFilterRow(float* row, long i) {
+	for (int c = 0; c < BENCH_N_FFT_BINS; c++) {
+		row[c] = (float)((i * 7 + c * 13) & 63);
+	}
+}
+
+static long benchAveragingFilterShift(long n) {
+	// the SoundBar AveragingFilter this family replaced: shift the window, then re-add it
+	uint16_t buffer[BENCH_FILTER_LENGTH] = {0};
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		for (int k = 0; k < BENCH_FILTER_LENGTH - 1; k++) {
+			buffer[k] = buffer[k + 1];
+		}
+		buffer[BENCH_FILTER_LENGTH - 1] = (uint16_t)(i & 1023);
+		uint32_t sum = 0;
+		for (int k = 0; k < BENCH_FILTER_LENGTH; k++) {
+			sum += buffer[k];
+		}
+		s += sum;
+	}
+	return s;
+}
+
+static long benchRunningMean(long n) {
+	RunningMean<uint16_t, BENCH_FILTER_LENGTH> filter;
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		filter.feedFilter((uint16_t)(i & 1023));
+		s += filter.getMean();
+	}
+	return (long)s;
+}
+
+static long benchRunningMax(long n) {
+	RunningMax<float, BENCH_FILTER_LENGTH> filter;
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		filter.feedFilter((float)((i * 7) & 63));
+		s += filter.getValue();
+	}
+	return (long)s;
+}
+
+static long benchRunningMedian(long n) {
+	RunningMedian<float, BENCH_FILTER_LENGTH> filter;
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		filter.feedFilter((float)((i * 7) & 63));
+		s += filter.getValue();
+	}
+	return (long)s;
+}
+
+static long benchMeanBank(long n) {
+	RunningMeanBank<float, BENCH_FILTER_LENGTH> bank(BENCH_N_FFT_BINS);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		bank.feedFilter(row);
+		s += bank.getMeans()[i % BENCH_N_FFT_BINS];
+	}
+	return (long)s;
+}
+
+static long benchEmaBank(long n) {
+	EmaBank<float> bank(BENCH_N_FFT_BINS, 0.2f);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		bank.feedFilter(row);
+		s += bank.getValues()[i % BENCH_N_FFT_BINS];
+	}
+	return (long)s;
+}
+
+static long benchMaxBank(long n) {
+	RunningMaxBank<float, BENCH_FILTER_LENGTH> bank(BENCH_N_FFT_BINS);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		bank.feedFilter(row);
+		s += bank.getValues()[i % BENCH_N_FFT_BINS];
+	}
+	return (long)s;
+}
+
+static long benchMaxDeques(long n) {
+	std::vector<RunningMax<float, BENCH_FILTER_LENGTH> > filters(BENCH_N_FFT_BINS);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		for (int c = 0; c < BENCH_N_FFT_BINS; c++) {
+			filters[c].feedFilter(row[c]);
+		}
+		s += filters[i % BENCH_N_FFT_BINS].getValue();
+	}
+	return (long)s;
+}
+
+static long benchMedianBank(long n) {
+	RunningMedianBank<float, BENCH_FILTER_LENGTH> bank(BENCH_N_FFT_BINS);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		bank.feedFilter(row);
+		s += bank.getValues()[i % BENCH_N_FFT_BINS];
+	}
+	return (long)s;
+}
+
+static long benchMedianTrees(long n) {
+	std::vector<RunningMedian<float, BENCH_FILTER_LENGTH> > filters(BENCH_N_FFT_BINS);
+	float row[BENCH_N_FFT_BINS];
+	double s = 0;
+	for (long i = 0; i < n; i++) {
+		buildFilterRow(row, i);
+		for (int c = 0; c < BENCH_N_FFT_BINS; c++) {
+			filters[c].feedFilter(row[c]);
+		}
+		s += filters[i % BENCH_N_FFT_BINS].getValue();
+	}
+	return (long)s;
+}
+
+static long benchPackFrames(long n) {
+	std::vector<Frame_t> frames(BENCH_LARGE_N_PANELS);
+	std::vector<PackedFrame_t> packed(BENCH_LARGE_N_PANELS);
+	for (int p = 0; p < BENCH_LARGE_N_PANELS; p++) {
+		Frame_t f = {p + 1, p & 255, (p * 3) & 255, (p * 7) & 255, 1};
+		frames[p] = f;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		frames[i % BENCH_LARGE_N_PANELS].r = (int)(i & 255);
+		s += packFrames(frames.data(), BENCH_LARGE_N_PANELS, packed.data());
+		s += packed[i % BENCH_LARGE_N_PANELS].r;
+	}
+	return s;
+}
+
+static long benchUnpackFrames(long n) {
+	std::vector<Frame_t> frames(BENCH_LARGE_N_PANELS);
+	std::vector<PackedFrame_t> packed(BENCH_LARGE_N_PANELS);
+	for (int p = 0; p < BENCH_LARGE_N_PANELS; p++) {
+		PackedFrame_t f = {(uint16_t)(p + 1), (uint8_t)p, (uint8_t)(p * 3), (uint8_t)(p * 7), 0, 1};
+		packed[p] = f;
+	}
+	long s = 0;
+	for (long i = 0; i < n; i++) {
+		packed[i % BENCH_LARGE_N_PANELS].r = (uint8_t)i;
+		unpackFrames(packed.data(), BENCH_LARGE_N_PANELS, frames.data());
+		s += frames[i % BENCH_LARGE_N_PANELS].r;
+	}
+	return s;
+}
+
+static const Benchmark_t benchmarks[] = {
+		{"PROFILE_SCOPE", benchProfileScope},
+		{"PROFILE_COUNT", benchProfileCount},
+		{"log call, rate limited", benchLogRateLimited},
+		{"SourcePool add, evict and walk 10", benchSourcePool},
+		{"Point::rotate", benchPointRotate},
+		{"Point::distance", benchPointDistance},
+		{"Point::operator+-", benchPointArithmetic},
+		{"HSVtoRGB", benchHSVtoRGB},
+		{"RGBtoHSV", benchRGBtoHSV},
+		{"HSVtoRGBFast", benchHSVtoRGBFast},
+		{"RGBtoHSVFast", benchRGBtoHSVFast},
+		{"HSVtoRGB loop x1024", benchHSVtoRGBLoop},
+		{"HSVtoRGB batch x1024", benchHSVtoRGBBatch},
+		{"RGBtoHSV loop x1024", benchRGBtoHSVLoop},
+		{"RGBtoHSV batch x1024", benchRGBtoHSVBatch},
+		{"RGB_t operators", benchRGBOperators},
+		{"limitRGB", benchLimitRGB},
+		{"parseColor+freeColor", benchParseColor},
+		{"passLayoutData", benchPassLayoutData},
+		{"parseLayoutData+freeLayoutData", benchParseLayoutData},
+		{"rotateAuroraPanels", benchRotateAuroraPanels},
+		{"getFrameSlicesFromLayoutForTriangle", benchGetFrameSlices},
+		{"rotateAuroraPanels+getFrameSlices", benchRotateAndSlice},
+		{"buildFrameSliceSet", benchBuildFrameSliceSet},
+		{"getFrameSliceView", benchGetFrameSliceView},
+		{"isPointInsidePanel", benchIsPointInsidePanel},
+		{"pointInsideWhichPanel", benchPointInsideWhichPanel},
+		{"pointInsideWhichPanel 255 linear", benchPointInsideWhichPanelLinear},
+		{"pointInsideWhichPanel 255 grid", benchPointInsideWhichPanelGrid},
+		{"pointsInsideWhichPanels 255 grid x1024", benchPointsInsideWhichPanels},
+		{"buildPanelGrid 255", benchBuildPanelGrid},
+		{"buildPanelAdjacency 255", benchBuildPanelAdjacency},
+		{"getEntryPanels 255 uncached", benchGetEntryPanelsUncached},
+		{"getEntryPanels 255 cached", benchGetEntryPanelsCached},
+		{"updateRhythmFeatures", benchUpdateRhythmFeatures},
+		{"updateSpectrumFeatures", benchUpdateSpectrumFeatures},
+		{"updateBeatFeatures", benchUpdateBeatFeatures},
+		{"BandOnsetDetector tick 32", benchBandOnsets},
+		{"BeatTracker tick", benchBeatTracker},
+		{"BeatEngine tick, hip hop test track", benchBeatEngineTestTrack},
+		{"diffFrames 2048", benchDiffFrames},
+		{"packFrames 2048", benchPackFrames},
+		{"unpackFrames 2048", benchUnpackFrames},
+		{"AveragingFilter shift 16", benchAveragingFilterShift},
+		{"RunningMean 16", benchRunningMean},
+		{"RunningMax 16", benchRunningMax},
+		{"RunningMedian 16", benchRunningMedian},
+		{"RunningMeanBank 16x32", benchMeanBank},
+		{"EmaBank 32", benchEmaBank},
+		{"RunningMaxBank 16x32", benchMaxBank},
+		{"RunningMax 16 x32 filters", benchMaxDeques},
+		{"RunningMedianBank 16x32", benchMedianBank},
+		{"RunningMedian 16 x32 filters", benchMedianTrees},
+		{"renderLightSources scalar 30x32", benchRenderScalarSmall},
+		{"renderLightSources best 30x32", benchRenderBestSmall},
+		{"renderLightSources scalar 2048x32", benchRenderScalarLarge},
+		{"renderLightSources sse2 2048x32", benchRenderSse2Large},
+		{"renderLightSources avx2 2048x32", benchRenderAvx2Large},
+		{"particles spawn, render, update 2048x32", benchParticles},
+		{"diffusion inject, render, step 255 scalar", benchDiffusionScalar},
+		{"diffusion inject, render, step 255 avx2", benchDiffusionAvx2},
+};
+
+/**
+ * @description: double the iteration count until the benchmark runs for BENCH_MIN_TIME_NS
+ * @return: mean time per call in ns
+ */
+static double runBenchmark(const Benchmark_t* benchmark) {
+	long n = 1;
+	while (true) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		sink = benchmark->function(n);
+		long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= BENCH_MIN_TIME_NS) {
+			return (double)elapsed / n;
+		}
+		n *= 2;
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* filter = argc > 1 ? argv[1] : NULL;
+
+	buildLayoutStream(&layoutStream, BENCH_N_PANELS);
+	buildLayoutStream(&largeLayoutStream, BENCH_MAX_TRIANGLES);
+	buildPaletteStream(BENCH_N_COLORS);
+	passLayoutData(layoutStream.data(), BENCH_N_PANELS);
+	passColorPalette(paletteStream.data(), BENCH_N_COLORS);
+	enableBeatFeatures();
+	enableFftBands(BENCH_N_FFT_BANDS, FFT_BANDS_MEL);
+	enableBandOnsets();
+	initRhythmFeatures();
+	initBeatFeatures();
+
+	unsigned int seed = 1;
+	buildCentroids(&largeWall, BENCH_LARGE_N_PANELS);
+	buildLightSources(&lightSources, BENCH_N_LIGHT_SOURCES, sqrt((double)BENCH_LARGE_N_PANELS) * BENCH_SIDE_LENGTH, false,
+			&seed);
+	bool ok = checkLightRenderers();
+	ok = checkPanelGrid() && ok;
+	ok = checkFrameDiffer() && ok;
+	ok = checkStreamingFilters() && ok;
+	ok = checkPackedFrames() && ok;
+	ok = checkColorConversions() && ok;
+	ok = checkFrameSliceSet() && ok;
+	ok = checkProfiler() && ok;
+	ok = checkLogger() && ok;
+	ok = checkSourcePool() && ok;
+	ok = checkParticleEngine() && ok;
+	ok = checkDiffusionEngine() && ok;
+	ok = checkSpectrumFeatures() && ok;
+	ok = checkBandOnsets() && ok;
+	ok = checkBeatTracker() && ok;
+	ok = checkPanelAdjacency() && ok;
+	ok = checkEntryPanels() && ok;
+	printf("\n");
+
+	printf("%-40s %12s\n", "benchmark", "ns/call");
+	int nBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	for (int i = 0; i < nBenchmarks; i++) {
+		if (filter && strstr(benchmarks[i].name, filter) == NULL) {
+			continue;
+		}
+		printf("%-40s %12.1f\n", benchmarks[i].name, runBenchmark(&benchmarks[i]));
+	}
+
+	deinitBeatFeatures();
+	deinitRhythmFeatures();
+	dataManagerCleanup();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BandOnsetDetector.h
+ *
+ *  Onsets in every band of the spectrum. The novelty of a band is its spectral flux, the half wave
+ *  rectified rise of the band since the previous tick. An onset is reported when the flux exceeds an
+ *  adaptive threshold: the running mean of the flux plus a multiple of its running mean deviation,
+ *  plus a floor that keeps silence and noise quiet. A band that fired holds off for a few ticks.
+ *
+ *  The state is kept as one array per quantity, so a tick is a single branch free pass over the
+ *  bands that the compiler vectorizes. The strength of a band is its flux over its threshold, so it
+ *  is above 1 on an onset and tells how far above the recent flux of that band it is.
+ */
+
+#ifndef INC_BANDONSETDETECTOR_H_
+#define INC_BANDONSETDETECTOR_H_
+
+#include <stdint.h>
+#include <vector>
+
+class BandOnsetDetector {
+	int nBands;
+	bool primed;					/*the first tick only sets the previous spectrum*/
+	float meanRate;					/*of the running mean and deviation, per tick*/
+	float holdTicks;				/*ticks a band is held off after an onset*/
+	std::vector<float> previous;	/*band values of the previous tick*/
+	std::vector<float> mean;		/*running mean of the flux*/
+	std::vector<float> deviation;	/*running mean absolute deviation of the flux*/
+	std::vector<float> hold;		/*ticks left before the band may fire again*/
+	std::vector<float> strengths;
+	std::vector<uint8_t> onsets;
+public:
+	BandOnsetDetector();
+	virtual ~BandOnsetDetector();
+	void bandOnsetDetectorInit(int nBands, float tickMs);
+	void bandOnsetDetectorTick(const float* bands);
+	int getNBands();
+	const uint8_t* getOnsets();
+	const float* getStrengths();
+};
+
+#endif /* INC_BANDONSETDETECTOR_H_ */
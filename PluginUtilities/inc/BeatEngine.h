@@ -0,0 +1,48 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatEngine.h
+ *
+ *  Onset, beat and tempo detection behind the beat features of PluginFeatures.h
+ */
+
+#ifndef INC_BEATENGINE_H_
+#define INC_BEATENGINE_H_
+
+#include <stdint.h>
+#include "OnsetDetector.h"
+#include "BeatTracker.h"
+
+class BeatEngine {
+	OnsetDetector* od;
+	BeatTracker* bt;
+public:
+	BeatEngine();
+	virtual ~BeatEngine();
+	void beatEngineInit(int nFftBins, float tickMs);
+	void beatEngineTick(uint16_t energy, uint8_t* fftBins);
+	bool isBeat();
+	float getTempo();
+	float getBeatPhase();
+	float getBeatConfidence();
+	bool isOnset();
+	float getOnsetNovelty();
+	float getNovelty();
+	float getLowFrequencyNovelty();
+};
+
+#endif /* INC_BEATENGINE_H_ */
@@ -0,0 +1,78 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatTracker.h
+ *
+ *  Streaming tempo and beat tracker. The onset strength of every tick drives a bank of resonators,
+ *  one for every candidate tempo from MIN_TRACKER_BPM to MAX_TRACKER_BPM. A resonator is a leaky
+ *  complex sum of the onset strength turned at its own tempo: its magnitude tells how strongly the
+ *  onsets repeat at that tempo and its angle tells where in the beat they fall. A tick costs one
+ *  complex multiply-add per resonator, however long the history is.
+ *
+ *  The tempo is the resonator with the highest salience, interpolated between its neighbours. The
+ *  beat phase is the angle of that resonator, 0 on the beat, and a beat is reported when it wraps.
+ *  The confidence compares the magnitude of the resonator with that of a perfectly periodic input.
+ *  While it is below MIN_TRACKER_CONFIDENCE, onsets are reported as beats instead.
+ */
+
+#ifndef INC_BEATTRACKER_H_
+#define INC_BEATTRACKER_H_
+
+#define MIN_TRACKER_BPM 60
+#define MAX_TRACKER_BPM 200
+#define N_TRACKER_TEMPOS (MAX_TRACKER_BPM - MIN_TRACKER_BPM + 1)	/*one resonator per bpm*/
+#define MIN_TRACKER_CONFIDENCE 0.5f
+
+class BeatTracker {
+	float re[N_TRACKER_TEMPOS];			/*resonators*/
+	float im[N_TRACKER_TEMPOS];
+	float phasorRe[N_TRACKER_TEMPOS];	/*e^(-i w t) of every resonator*/
+	float phasorIm[N_TRACKER_TEMPOS];
+	float rotationRe[N_TRACKER_TEMPOS];	/*e^(-i w), the turn of one tick*/
+	float rotationIm[N_TRACKER_TEMPOS];
+	float magnitude[N_TRACKER_TEMPOS];
+	float salience[N_TRACKER_TEMPOS];
+	float prior[N_TRACKER_TEMPOS];		/*weak preference for tempos around 120 bpm*/
+	float tickMs;
+	float decay;						/*of the resonators, per tick*/
+	float meanRate;						/*of the running mean of the onset strength, per tick*/
+	float onsetMean;					/*running mean of the onset strength, subtracted from it*/
+	float mass;							/*leaky sum of the onset envelope*/
+	float tempo;
+	int tempoIndex;						/*resonator of the tempo*/
+	float phase;
+	float confidence;
+	bool beat;
+	int ticksSinceBeat;
+	int ticksSinceOnset;
+	int nTicks;
+
+	void updateResonators(float envelope);
+	void updateTempo();
+	void updateBeat(bool onset);
+public:
+	BeatTracker();
+	virtual ~BeatTracker();
+	void beatTrackerInit(float tickMs);
+	void beatTrackerTick(float onsetStrength, bool onset);
+	bool isBeat();
+	float getTempo();
+	float getPhase();
+	float getConfidence();
+};
+
+#endif /* INC_BEATTRACKER_H_ */
@@ -0,0 +1,153 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatUtilities.h
+ *
+ *  Small containers used by the beat engine
+ */
+
+#ifndef INC_BEATUTILITIES_H_
+#define INC_BEATUTILITIES_H_
+
+#include <stddef.h>
+
+/**
+ * Fixed length circular buffer. Pushing into a full Fifo overwrites the oldest element.
+ */
+template <typename T>
+class Fifo {
+	T* buffer;
+	int head;		/*index of the newest element*/
+	int tail;		/*index of the oldest element*/
+	int length;
+	int count;
+public:
+	Fifo(int length) {
+		this->length = length;
+		buffer = new T[length]();
+		head = 0;
+		tail = 0;
+		count = 0;
+	}
+
+	~Fifo() {
+		if (buffer) {
+			delete [] buffer;
+			buffer = NULL;
+		}
+		length = 0;
+		head = 0;
+	}
+
+	void push(T element) {
+		if (length == 0 || buffer == NULL) {
+			return;
+		}
+		head++;
+		if (head == length) {
+			head -= length;
+		}
+		buffer[head] = element;
+		count++;
+		if (head == tail) {
+			tail++;
+			if (tail == length) {
+				tail -= length;
+			}
+		}
+	}
+
+	T pop() {
+		if (count == 0) {
+			return T();
+		}
+		T element = buffer[tail];
+		tail++;
+		if (tail == length) {
+			tail -= length;
+		}
+		count--;
+		return element;
+	}
+
+	bool isMember(T element) {
+		for (int i = 0; i < length; i++) {
+			if (buffer[i] == element) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool isEmpty() {
+		return count <= 0;
+	}
+
+	T getElementAtIndex(int index) {
+		if (length == 0 || buffer == NULL || index < 0 || index >= length) {
+			return -1;
+		}
+		return buffer[index];
+	}
+
+	/**
+	 * @description: average over the whole buffer, including slots that have not been written yet
+	 */
+	float getAverage() {
+		if (length == 0 || buffer == NULL) {
+			return 0;
+		}
+		float sum = 0;
+		for (int i = 0; i < length; i++) {
+			sum += buffer[i];
+		}
+		return sum / length;
+	}
+
+	int getHead() {
+		return head;
+	}
+
+	int getLength() {
+		return length;
+	}
+};
+
+/**
+ * Histogram of integer values with a limited memory. Bins that have not been hit recently
+ * decay over time so the histogram follows changes in the music.
+ */
+class Histogram {
+	int* bins;
+	int length;
+	int total;
+	int degradeCounter;
+	int popCounter;
+	Fifo<int>* recentBins;		/*bins that were incremented recently and must not decay*/
+public:
+	Histogram();
+	Histogram(int length);
+	virtual ~Histogram();
+	void incrementHistogramBin(int bin);
+	void degradeHistogram();
+	float getProbabilityOfBins(int* bins, int nBins);
+	int getHistogramBin(int bin);
+	void displayHistogram(int scale);
+	int getLength();
+};
+
+#endif /* INC_BEATUTILITIES_H_ */
@@ -0,0 +1,143 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+
+/*
+ * DiffusionEngine.h
+ *
+ *  Colour that spreads over the panels along their shared edges, for effects like the
+ *  northern lights where a beat lights up a panel and the colour bleeds into its surroundings.
+ *
+ *      static DiffusionField_t field;
+ *
+ *      initPlugin:
+ *          initDiffusionField(&field, layoutData);
+ *          field.rate = 0.15;
+ *          field.decay = 0.97;
+ *      getPluginFrame:
+ *          injectDiffusion(&field, panel, R, G, B, 1.0);
+ *          renderDiffusion(&field, TRANSITION_TIME, frames);
+ *          stepDiffusion(&field);
+ *      pluginCleanup:
+ *          freeDiffusionField(&field);
+ *
+ *  Every panel holds a colour. A step moves every channel towards the channel of the neighbours
+ *  by a discrete Laplacian over the adjacency graph of the layout, then fades what is above the
+ *  base colour:
+ *      c' = c + rate * sum over neighbours n of (n - c)
+ *      c' = base + (c' - base) * decay
+ *  Injecting colour only touches one panel and a step costs O(edges) however much colour was
+ *  injected. The colours are kept in two sets of float planes, the step reads one and writes the
+ *  other. The neighbours are stored as nSlots arrays of one neighbour per panel, so the step runs
+ *  over 8 panels at a time with AVX2 gathers when the CPU supports it. Both implementations sum
+ *  the neighbours in the same order and give the same results.
+ *
+ *  With d neighbours a channel keeps 1 - rate * d of itself, keep rate * nSlots below 1 or the
+ *  colours start to oscillate.
+ */
+
+#ifndef INC_DIFFUSIONENGINE_H_
+#define INC_DIFFUSIONENGINE_H_
+
+#include "AuroraPlugin.h"
+#include "ColorUtils.h"
+#include "LayoutProcessingUtils.h"
+#include <stdlib.h>
+
+#define DIFFUSION_STEP_SCALAR 0
+#define DIFFUSION_STEP_AVX2 1
+
+struct DiffusionField_t {
+	int nPanels;
+	int nPadded;				/*entries of every array, a multiple of PANEL_ARRAY_PADDING*/
+	int nSlots;					/*the most neighbours of any panel*/
+	const int* panelIds;		/*the ids of the panels, from the layout*/
+	int* neighbors;				/*slot s of panel i at s * nPadded + i, i itself where the panel has fewer neighbours*/
+	float* R[2];				/*colour planes, [current] is the colour now*/
+	float* G[2];
+	float* B[2];
+	int current;
+	float rate;					/*share of the difference to every neighbour that flows over in a step*/
+	float decay;				/*share of the colour above base kept in a step*/
+	RGB_t base;					/*colour of a panel without any injected colour*/
+	DiffusionField_t(const DiffusionField_t&) = delete;
+	DiffusionField_t(){
+		nPanels = 0;
+		nPadded = 0;
+		nSlots = 0;
+		panelIds = NULL;
+		neighbors = NULL;
+		R[0] = R[1] = G[0] = G[1] = B[0] = B[1] = NULL;
+		current = 0;
+		rate = 0;
+		decay = 1;
+		base.R = base.G = base.B = 0;
+	}
+	~DiffusionField_t(){
+		free(neighbors);
+		for (int i = 0; i < 2; i++) {
+			free(R[i]);
+			free(G[i]);
+			free(B[i]);
+		}
+	}
+};
+
+/**
+ * @description: set up a field for the panels of a layout from its adjacency graph, with every panel at the base
+ * colour black, a rate of 0 and a decay of 1. The field keeps the panel ids of the layout, so call it again if
+ * the layout is freed
+ * @params layoutData: the layout, usually getLayoutData()
+ */
+void initDiffusionField(DiffusionField_t* field, const LayoutData* layoutData);
+
+/**
+ * @description: free the arrays of a field, it can be initialised again afterwards
+ */
+void freeDiffusionField(DiffusionField_t* field);
+
+/**
+ * @description: set every panel to the base colour
+ */
+void clearDiffusionField(DiffusionField_t* field);
+
+/**
+ * @description: mix a colour into one panel: c = c * (1 - amount) + colour * amount
+ * @params panel: index of the panel in the layout
+ * @params amount: 0 leaves the panel as it is, 1 sets it to the colour
+ */
+void injectDiffusion(DiffusionField_t* field, int panel, int R, int G, int B, float amount);
+
+/**
+ * @description: spread and fade the colours by one step
+ */
+void stepDiffusion(DiffusionField_t* field);
+
+/**
+ * @description: write the current colour of every panel into frames, truncated to integers and limited to 0..255
+ * @params frames: filled with field->nPanels frames
+ */
+void renderDiffusion(const DiffusionField_t* field, int transTime, Frame_t* frames);
+
+/**
+ * @description: choose the implementation used by stepDiffusion. By default the fastest one the CPU supports is used
+ * @params implementation: one of the DIFFUSION_STEP_* defines
+ * @return: the implementation that is now in use, which is lower than requested if the CPU does not support it
+ */
+int selectDiffusionStep(int implementation);
+
+#endif /* INC_DIFFUSIONENGINE_H_ */
@@ -0,0 +1,78 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FrameDiffer.h
+ *
+ *  Turns the full frames of getPluginFrame into delta frames: only the panels whose colour moved
+ *  by more than a threshold since it was last sent, or whose transTime changed, are kept.
+ *  A plugin can call it at the end of getPluginFrame,
+ *      *nFrames = diffFrames(&frameDiffer, frames, *nFrames);
+ *  and a host can apply it to the frames of any plugin before sending them on.
+ */
+
+#ifndef INC_FRAMEDIFFER_H_
+#define INC_FRAMEDIFFER_H_
+
+#include "AuroraPlugin.h"
+#include "PackedFrame.h"
+#include <stdint.h>
+#include <vector>
+
+#define FRAME_DIFF_DEFAULT_THRESHOLD 0		/*send every change*/
+
+/**
+ * The colour and transTime last sent to one panel
+ */
+struct CommittedFrame_t {
+	int r, g, b;
+	int transTime;
+	bool valid;		/*false until the panel has been sent once*/
+};
+
+struct FrameDiffer_t {
+	int threshold;							/*a panel is sent again when a channel moved by more than this*/
+	std::vector<CommittedFrame_t> committed;	/*indexed by panelId*/
+	uint64_t nEmitted;						/*entries kept by diffFrames since the last reset*/
+	uint64_t nSuppressed;					/*entries dropped by diffFrames since the last reset*/
+};
+
+/**
+ * @description: set the threshold and forget all committed colours
+ */
+void initFrameDiffer(FrameDiffer_t* differ, int threshold);
+
+/**
+ * @description: forget the committed colours, so the next frames are sent in full, e.g. after the Aurora was cleared.
+ * The counters are kept
+ */
+void resetFrameDiffer(FrameDiffer_t* differ);
+
+/**
+ * @description: remove the entries of frames that would not visibly change their panel, compacting the rest to the
+ * front of frames in their original order, and commit the colours of the entries that are kept
+ * @params frames: the frames of one call of getPluginFrame, modified in place
+ * @params nFrames: number of entries in frames
+ * @return: the number of entries kept
+ */
+int diffFrames(FrameDiffer_t* differ, Frame_t* frames, int nFrames);
+
+/**
+ * @description: diffFrames for packed frames
+ */
+int diffPackedFrames(FrameDiffer_t* differ, PackedFrame_t* frames, int nFrames);
+
+#endif /* INC_FRAMEDIFFER_H_ */
@@ -0,0 +1,313 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LayoutProcessingUtilities.h
+ *
+ *  Created on: Feb 13, 2017
+ *      Author: eski
+ */
+
+#ifndef UTILITIES_LAYOUTPROCESSINGUTILITIES_H_
+#define UTILITIES_LAYOUTPROCESSINGUTILITIES_H_
+
+#include "Point.h"
+#include <vector>
+#include <stdlib.h>
+#include "Shape.h"
+
+#define PANEL_ARRAY_ALIGNMENT 64		/*bytes, one cache line*/
+#define PANEL_ARRAY_PADDING 16			/*entries, one cache line of floats*/
+#define SNAPPED_ROTATION_STEP 30		/*degrees, rotateAuroraPanels snaps to multiples of this*/
+#define N_SNAPPED_ROTATIONS 12
+
+
+/**
+ * An Element of the layout Data Array
+ */
+
+struct Panel{
+	int panelId;	 	/*the panelId of the panel*/
+	Shape* shape;
+	Panel (const Panel&) = delete;
+	Panel(){
+		panelId = -1;
+		shape = NULL;
+	}
+	~Panel(){
+		if (shape){
+			delete shape;
+		}
+	}
+};
+
+/**
+ * A structure of arrays copy of the panel ids and centroids, for loops that visit every panel on every frame.
+ * Entry i describes panels[i] of the LayoutData it belongs to; panels without a shape have their id and a
+ * centroid of (0, 0). The arrays are PANEL_ARRAY_ALIGNMENT aligned and padded with zeros up to nPadded entries,
+ * a multiple of PANEL_ARRAY_PADDING, so they can be processed in whole vectors.
+ * The layout utilities rebuild it whenever the panels move, i.e. in getLayoutData() and rotateAuroraPanels()
+ */
+struct PanelCentroids_t{
+	int nPanels;
+	int nPadded;
+	int* panelIds;
+	float* x;
+	float* y;
+	PanelCentroids_t(const PanelCentroids_t&) = delete;
+	PanelCentroids_t(){
+		nPanels = 0;
+		nPadded = 0;
+		panelIds = NULL;
+		x = NULL;
+		y = NULL;
+	}
+	~PanelCentroids_t(){
+		free(panelIds);
+		free(x);
+		free(y);
+	}
+};
+
+/**
+ * A uniform grid over the bounding boxes of the panels, so that the panel under a point can be found by testing only
+ * the few panels around it. Cell (column, row) covers x from minX + column * cellSize and y from minY + row * cellSize.
+ * cellPanels[cellOffsets[c] .. cellOffsets[c + 1]) are the indexes of the panels whose bounding box overlaps cell
+ * c = row * nColumns + column, in layout order
+ */
+struct PanelGrid_t{
+	float minX;
+	float minY;
+	float cellSize;
+	int nColumns;
+	int nRows;
+	std::vector<int> cellOffsets;
+	std::vector<int> cellPanels;
+};
+
+/**
+ * Which panels touch which, as a compressed sparse row graph: the neighbours of panels[i] are the panel indexes
+ * neighbors[offsets[i] .. offsets[i + 1]), in increasing order. Two panels are neighbours when they share an edge,
+ * whatever their shapes; the Rhythm module and other panels without vertices have no neighbours.
+ * Every edge is listed from both of its panels
+ */
+struct PanelAdjacency_t{
+	std::vector<int> offsets;		/*nPanels + 1 entries*/
+	std::vector<int> neighbors;
+	float adjacentDistance;			/*mean distance between the centroids of neighbouring panels*/
+	PanelAdjacency_t(){
+		adjacentDistance = 0;
+	}
+};
+
+/**
+ * The entry panels of a layout for one direction of travel: the panels a source moving in that direction across the
+ * layout would enter it at. The panels are split into lanes parallel to the direction, panels whose centroids are less
+ * than laneWidth apart across the direction share a lane, and the entry panel of a lane is its panel furthest against
+ * the direction. panels holds one index into LayoutData::panels per lane, the lanes ordered by their lowest panel index
+ */
+struct EntryPanels_t{
+	double directionDegrees;		/*direction of travel, counterclockwise from the x axis*/
+	float laneWidth;
+	std::vector<int> panels;
+};
+
+/**
+ * The entry panels computed so far for a layout, one entry per direction and lane width. The entries are allocated one
+ * by one so that they do not move when another direction is added
+ */
+struct EntryPanelCache_t{
+	std::vector<EntryPanels_t*> entries;
+	EntryPanelCache_t(){}
+	EntryPanelCache_t(const EntryPanelCache_t&) = delete;
+	~EntryPanelCache_t(){
+		for (size_t i = 0; i < entries.size(); i++) {
+			delete entries[i];
+		}
+	}
+};
+
+struct LayoutData{
+	int nPanels; 					/*number of panels in the layout*/
+	Panel* panels; 					/*statically allocated buffer containing the layoutData of the panels*/
+	int globalOrientation; 			/*orientation as set by the user*/
+	Point layoutGeometricCenter;
+	PanelCentroids_t centroids;		/*the panel ids and centroids of panels, as arrays*/
+	PanelAdjacency_t adjacency;		/*the panels sharing an edge with each panel*/
+	PanelGrid_t* panelGrid;			/*spatial index for pointInsideWhichPanel, NULL unless buildPanelGrid() was called*/
+	EntryPanelCache_t* entryPanelCache;	/*results of getEntryPanels, NULL until it is first called*/
+	LayoutData(const LayoutData&) = delete;
+	LayoutData(){
+		nPanels = 0;
+		panels = NULL;
+		globalOrientation = 0;
+		panelGrid = NULL;
+		entryPanelCache = NULL;
+	}
+	~LayoutData(){
+		if (panels){
+			delete [] panels;
+			panels = NULL;
+		}
+		if (panelGrid){
+			delete panelGrid;
+			panelGrid = NULL;
+		}
+		if (entryPanelCache){
+			delete entryPanelCache;
+			entryPanelCache = NULL;
+		}
+	}
+};
+
+struct FrameSlice_t {
+	std::vector<int> panelIds;
+};
+
+/**
+ * The frame slices of a layout for all N_SNAPPED_ROTATIONS rotations, in flat arrays. Rotation r is the layout turned
+ * through r * SNAPPED_ROTATION_STEP degrees with rotateAuroraPanels; its slices are
+ * sliceOffsets[rotationOffsets[r] .. rotationOffsets[r + 1]), and slice s holds panelIds[sliceOffsets[s] .. sliceOffsets[s + 1]).
+ * Build it once with buildFrameSliceSet and read it through getFrameSliceView
+ */
+struct FrameSliceSet_t {
+	int baseRotation;									/*totalAuroraRotation of the layout it was built from*/
+	int rotationOffsets[N_SNAPPED_ROTATIONS + 1];
+	std::vector<int> sliceOffsets;
+	std::vector<int> panelIds;
+};
+
+/**
+ * The slices of one rotation of a FrameSliceSet_t: slice s holds panelIds[sliceOffsets[s] .. sliceOffsets[s + 1]).
+ * Points into the set, valid as long as the set is not rebuilt
+ */
+struct FrameSliceView_t {
+	int rotation;				/*totalAuroraRotation of this view*/
+	int nSlices;
+	const int* sliceOffsets;
+	const int* panelIds;
+};
+
+/**
+ * Helper function
+ */
+void parseLayoutData(int* layoutDataByteStream, int nPanels, LayoutData** layoutData);
+
+/*
+ * @description: Utility function to geometrically rotate the layout through a specified angle. the angle is snapped to the
+ * closest multiple of 30 degrees
+ * @params layoutData : the layout to rotate
+ * @params angle_degrees: the angle to rotate through
+ */
+int rotateAuroraPanels(LayoutData* layoutData, int *angle_degrees);
+
+/**
+ * @description: rebuild layoutData->centroids from the shapes of the panels. Called internally whenever the panels move,
+ * a plugin only needs to call it after moving shapes itself through Shape::updateShape
+ * @params layoutData: the layout to update
+ */
+void updatePanelCentroids(LayoutData* layoutData);
+
+/**
+ * @description: Utility function that helps breakdown the layout into frame slices, which aligns the layout into a grid. This helps in creating effects
+ * @params LayoutData: the layoutData to process
+ * @params frameSlices: A buffer that is dynamically allocated internally and 'splits' the layout into 'FrameSlices' that is aligns the layout into a grid
+ * The grid spacing is 0.5*sideLength if orientations are multiples of 60 degrees and 0.288*sideLength if its not a multiple of 60 degrees
+ */
+void getFrameSlicesFromLayoutForTriangle(LayoutData* layoutData, FrameSlice_t** frameSlices, int* nFrameSlicesint, int totalAuroraRotation);
+
+/**
+ * @description: compute the frame slices of the layout for every rotation in steps of SNAPPED_ROTATION_STEP at once, so
+ * that an effect can turn without rotating the layout or recomputing the slices. The layout itself is not modified.
+ * Rotation 0 gives the same slices as getFrameSlicesFromLayoutForTriangle
+ * @params layoutData: the layoutData to process
+ * @params totalAuroraRotation: the rotation of the layout as passed to getFrameSlicesFromLayoutForTriangle
+ * @params sliceSet: filled with the slices, can be reused to rebuild after the layout changed
+ */
+void buildFrameSliceSet(LayoutData* layoutData, int totalAuroraRotation, FrameSliceSet_t* sliceSet);
+
+/**
+ * @description: the slices for the layout turned through angle_degrees since the set was built. Does not allocate
+ * @params angle_degrees: snapped to the closest multiple of SNAPPED_ROTATION_STEP, any multiple of 360 is the same rotation
+ */
+FrameSliceView_t getFrameSliceView(const FrameSliceSet_t* sliceSet, int angle_degrees);
+
+/**
+ * @description: test whether point p is inside Panel given by panel.
+ * @params layoutDataElement: the centroid of the shape that the point is inside
+ * @params p : the point to be tested
+ * @return : true if inside, else false
+ */
+bool isPointInsidePanel(Panel* panel, Point p);
+
+/**
+ * @description: returns the panelId of the panel the point p is inside.
+ * If not inside any panel, the value returned is -1
+ * the function loops over all the panels unless buildPanelGrid() has been called on the layout, so without the grid
+ * excessive usage of this API might hit efficiency
+ * @params layoutData : a pointer to the LayoutData object
+ * @params p : the point to test and check if within any panel
+ * @return : the panelId of the panel that the point is within, -1 if not inside any panel
+ */
+int pointInsideWhichPanel(LayoutData* layoutData, Point p);
+
+/**
+ * @description: batched pointInsideWhichPanel, for sampling many points (particles, pixels of an image) onto the panels
+ * @params points: the points to look up
+ * @params nPoints: number of points
+ * @params panelIds: filled with the panelId under each point, -1 where there is none
+ */
+void pointsInsideWhichPanels(LayoutData* layoutData, const Point* points, int nPoints, int* panelIds);
+
+/**
+ * @description: build a uniform grid over the panels that makes pointInsideWhichPanel and pointsInsideWhichPanels
+ * roughly O(1) per point. The grid is kept up to date by rotateAuroraPanels and freed with the layout.
+ * Call it once after getLayoutData(), or after moving shapes through Shape::updateShape
+ * @params layoutData: the layout to index
+ */
+void buildPanelGrid(LayoutData* layoutData);
+
+/**
+ * @description: rebuild layoutData->adjacency from the vertices of the shapes. Panels are matched through a hash of
+ * their edge midpoints, which takes O(n). parseLayoutData builds it, and rotating the layout does not change it,
+ * so a plugin only needs to call it after moving shapes itself through Shape::updateShape
+ * @params layoutData: the layout to update
+ */
+void buildPanelAdjacency(LayoutData* layoutData);
+
+/**
+ * @description: the panels a source travelling across the layout in a direction enters it at, e.g. the bottom panel of
+ * every column for sources rising at 90 degrees. The panels are sorted by their position across the direction, which
+ * makes the first call for a direction O(n log n); the result is cached with the layout, so later calls for the same
+ * direction and lane width only search the cache. Cached results are recomputed in place whenever the panels move
+ * @params layoutData: the layout to analyse
+ * @params directionDegrees: the direction of travel, counterclockwise from the x axis
+ * @params laneWidth: panels closer than this across the direction are in the same lane, in layout units
+ * @return: the entry panels, owned by the layout and valid until it is freed
+ */
+const EntryPanels_t* getEntryPanels(LayoutData* layoutData, double directionDegrees, float laneWidth);
+
+/**
+ * Internal Helper function
+ */
+void freeLayoutData(LayoutData* layoutData);
+
+/**
+ * @description: De-allocate frameslices allocated by getFramesFrom Layout
+ */
+void freeFrameSlices(FrameSlice_t* frameSlices);
+
+#endif /* UTILITIES_LAYOUTPROCESSINGUTILITIES_H_ */
@@ -0,0 +1,105 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LightRenderer.h
+ *
+ *  Renders every panel of a layout for a list of point light sources in one pass.
+ *
+ *  Each panel starts at a base colour and mixes in every source in order, oldest first:
+ *      R = R * (1 - f) + source.R * f
+ *  where f falls off with the distance d between the panel centroid and the source:
+ *      u = d * falloff.distanceScale - source.offset
+ *      f = 1 / (falloff.k * u * u + 1)            LIGHT_FALLOFF_INVERSE_SQUARE
+ *      f = 1 / (falloff.k * max(u, 0) + 1)       LIGHT_FALLOFF_INVERSE_LINEAR
+ *      f = max(min(f, 1) * source.gain, source.minFactor)
+ *
+ *  The panels are processed 8 (AVX2) or 4 (SSE2) at a time when the CPU supports it, the
+ *  sources are still mixed in one after the other so the result matches the scalar blend.
+ */
+
+#ifndef INC_LIGHTRENDERER_H_
+#define INC_LIGHTRENDERER_H_
+
+#include "AuroraPlugin.h"
+#include "ColorUtils.h"
+#include "LayoutProcessingUtils.h"
+
+#define MAX_LIGHT_SOURCES 64
+#define LIGHT_RENDER_TOLERANCE 1		/*max difference of a channel from the same blend in double precision*/
+
+#define LIGHT_FALLOFF_INVERSE_SQUARE 0
+#define LIGHT_FALLOFF_INVERSE_LINEAR 1
+
+#define LIGHT_RENDERER_SCALAR 0
+#define LIGHT_RENDERER_SSE2 1
+#define LIGHT_RENDERER_AVX2 2
+
+struct LightFalloff_t {
+	int type;					/*one of the LIGHT_FALLOFF_* defines*/
+	float distanceScale;		/*converts distances in layout units to the units of the falloff*/
+	float k;					/*steepness of the falloff*/
+};
+
+/**
+ * The sources of one frame, as arrays. Sources are mixed in the order they were added.
+ */
+struct alignas(64) LightSources_t {
+	int nSources;
+	float x[MAX_LIGHT_SOURCES];
+	float y[MAX_LIGHT_SOURCES];
+	float R[MAX_LIGHT_SOURCES];
+	float G[MAX_LIGHT_SOURCES];
+	float B[MAX_LIGHT_SOURCES];
+	float offset[MAX_LIGHT_SOURCES];		/*subtracted from the scaled distance, e.g. the radius of the source*/
+	float gain[MAX_LIGHT_SOURCES];			/*f is multiplied by this, 1 by default*/
+	float minFactor[MAX_LIGHT_SOURCES];		/*f never drops below this, 0 by default*/
+};
+
+/**
+ * @description: remove all sources
+ */
+void clearLightSources(LightSources_t* sources);
+
+/**
+ * @description: append a source with offset 0, gain 1 and minFactor 0
+ * @return: index of the new source, to change its other parameters, or -1 if there are already MAX_LIGHT_SOURCES
+ */
+int addLightSource(LightSources_t* sources, float x, float y, int R, int G, int B);
+
+/**
+ * @description: render all panels of the layout for all sources, straight into frames.
+ * Channels are truncated to integers and limited to 0..255 like the per panel renderers of the examples
+ * @params centroids: the panel ids and centroids, usually &getLayoutData()->centroids
+ * @params base: the colour of a panel before any source is mixed in
+ * @params frames: filled with centroids->nPanels frames
+ */
+void renderLightSources(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int transTime, Frame_t* frames);
+
+/**
+ * @description: choose the implementation used by renderLightSources. By default the fastest one the CPU supports is used
+ * @params renderer: one of the LIGHT_RENDERER_* defines
+ * @return: the implementation that is now in use, which is lower than requested if the CPU does not support it
+ */
+int selectLightRenderer(int renderer);
+
+/**
+ * @description: the implementation used by renderLightSources, one of the LIGHT_RENDERER_* defines
+ */
+int getLightRenderer(void);
+
+#endif /* INC_LIGHTRENDERER_H_ */
@@ -0,0 +1,195 @@
+/*
+ * logger.h
+ *
+ *  Created on: May 10, 2017
+ *      Author: leizhang
+ *
+ *  Asynchronous logging for plugins.
+ *
+ *      LOG_INFO("found %d panels, rotation %f\n", nPanels, rotation);
+ *      LOG_DEBUG("%d %1.1f %d\n", getIsBeat(), getTempo(), getIsOnset());
+ *
+ *  A log call does not format anything. It copies the format pointer and its arguments into a
+ *  fixed size record in a lock-free ring buffer and returns. A background thread, started by the
+ *  first record, drains the ring, formats the records and writes them to stdout. When the ring is
+ *  full the record is dropped and counted, so a slow stdout can never stall getPluginFrame.
+ *
+ *  The format must be a string literal, or at least outlive the logger. String arguments are
+ *  copied, up to LOG_STRING_BYTES per record in total. At most LOG_MAX_ARGS arguments are kept.
+ *
+ *  Levels below LOG_MIN_LEVEL compile to nothing. It defaults to LOG_LEVEL_INFO and can be set
+ *  with -DLOG_MIN_LEVEL=... or a #define before this header; LOG_LEVEL_NONE disables logging.
+ *
+ *  Every call site is rate limited on its own: it may burst LOG_RATE_BURST records and then
+ *  LOG_RATE_PER_SEC records per second. Suppressed records are counted and reported with the
+ *  next record that gets through. PRINTLOG is LOG_INFO, for plugins written against the old
+ *  printf logger.
+ */
+
+#ifndef INC_LOGGER_H_
+#define INC_LOGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+#ifndef LOG_RATE_PER_SEC
+#define LOG_RATE_PER_SEC 20
+#endif
+#ifndef LOG_RATE_BURST
+#define LOG_RATE_BURST 100
+#endif
+
+#define LOG_MAX_ARGS 8
+#define LOG_STRING_BYTES 64
+#define LOG_RING_SIZE 256			/*records, must be a power of two*/
+
+#define LOG_ARG_INT 0
+#define LOG_ARG_UINT 1
+#define LOG_ARG_DOUBLE 2
+#define LOG_ARG_POINTER 3
+#define LOG_ARG_STRING 4
+
+/**
+ * One argument of a log call, as captured on the calling thread
+ */
+struct LogArg_t {
+	int type;
+	union {
+		long long i;
+		unsigned long long u;
+		double d;
+		const void* p;
+		const char* s;
+	};
+};
+
+/**
+ * A call site of a log macro, with its token bucket
+ */
+struct LogSite_t {
+	int ratePerSec;
+	int burst;
+	int tokens;
+	uint32_t nSuppressed;
+	uint64_t lastRefillMs;
+	LogSite_t(int _ratePerSec, int _burst) {
+		ratePerSec = _ratePerSec;
+		burst = _burst;
+		tokens = _burst;
+		nSuppressed = 0;
+		lastRefillMs = 0;
+	}
+};
+
+/**
+ * @description: take a token from the bucket of a call site, refilling it first
+ * @return: true if the record may be logged, false if it is suppressed
+ */
+bool allowLog(LogSite_t* site);
+
+/**
+ * @description: copy a record into the ring and start the drainer if it is not running. Never blocks
+ * @params nSuppressed: records of the same call site that were suppressed before this one
+ * @return: true if the record was queued, false if the ring was full and it was dropped
+ */
+bool writeLogRecord(int level, uint32_t nSuppressed, const char* format, const LogArg_t* args, int nArgs);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @description: wait until the drainer has written every record queued so far
+ */
+void flushLog(void);
+
+/**
+ * @description: number of records dropped because the ring was full, since the library was loaded
+ */
+uint64_t getLogDropCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline LogArg_t makeLogArg(long long v) { LogArg_t a; a.type = LOG_ARG_INT; a.i = v; return a; }
+static inline LogArg_t makeLogArg(unsigned long long v) { LogArg_t a; a.type = LOG_ARG_UINT; a.u = v; return a; }
+static inline LogArg_t makeLogArg(double v) { LogArg_t a; a.type = LOG_ARG_DOUBLE; a.d = v; return a; }
+static inline LogArg_t makeLogArg(const char* v) { LogArg_t a; a.type = LOG_ARG_STRING; a.s = v; return a; }
+static inline LogArg_t makeLogArg(const void* v) { LogArg_t a; a.type = LOG_ARG_POINTER; a.p = v; return a; }
+static inline LogArg_t makeLogArg(char* v) { return makeLogArg((const char*)v); }
+static inline LogArg_t makeLogArg(bool v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(char v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(signed char v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(short v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(int v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(long v) { return makeLogArg((long long)v); }
+static inline LogArg_t makeLogArg(unsigned char v) { return makeLogArg((unsigned long long)v); }
+static inline LogArg_t makeLogArg(unsigned short v) { return makeLogArg((unsigned long long)v); }
+static inline LogArg_t makeLogArg(unsigned int v) { return makeLogArg((unsigned long long)v); }
+static inline LogArg_t makeLogArg(unsigned long v) { return makeLogArg((unsigned long long)v); }
+static inline LogArg_t makeLogArg(float v) { return makeLogArg((double)v); }
+template <typename T>
+static inline LogArg_t makeLogArg(T* v) { return makeLogArg((const void*)v); }
+
+/**
+ * @description: rate limit, capture the arguments and queue a record. Used by the macros
+ */
+static inline void logAt(LogSite_t* site, int level, const char* format) {
+	if (allowLog(site)) {
+		writeLogRecord(level, site->nSuppressed, format, NULL, 0);
+		site->nSuppressed = 0;
+	}
+}
+
+template <typename... Args>
+static inline void logAt(LogSite_t* site, int level, const char* format, Args... args) {
+	if (allowLog(site)) {
+		const LogArg_t packed[] = {makeLogArg(args)...};
+		int n = sizeof...(Args) < LOG_MAX_ARGS ? sizeof...(Args) : LOG_MAX_ARGS;
+		writeLogRecord(level, site->nSuppressed, format, packed, n);
+		site->nSuppressed = 0;
+	}
+}
+
+#define LOG_AT(level, format, ...) do { \
+	static LogSite_t logSite(LOG_RATE_PER_SEC, LOG_RATE_BURST); \
+	logAt(&logSite, level, format, ##__VA_ARGS__); \
+} while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) LOG_AT(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) do {} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) LOG_AT(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) do {} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) do {} while (0)
+#endif
+
+#define PRINTLOG(format, ...) LOG_INFO(format, ##__VA_ARGS__)
+
+#endif /* INC_LOGGER_H_ */
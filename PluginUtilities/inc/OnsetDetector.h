@@ -0,0 +1,50 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * OnsetDetector.h
+ *
+ *  Detects onsets as peaks of a novelty function built from the rise in energy and
+ *  the rise in the lowest fft bins
+ */
+
+#ifndef INC_ONSETDETECTOR_H_
+#define INC_ONSETDETECTOR_H_
+
+#include <stdint.h>
+#include "BeatUtilities.h"
+
+class OnsetDetector {
+	bool onset;
+	float onsetNovelty;		/*novelty at the last onset*/
+	float novelty;			/*novelty of the current tick*/
+	Fifo<float>* noveltyHistory;
+
+	void updateNovelty(uint16_t energy, uint8_t* fftBins);
+	void onsetDetect();
+public:
+	OnsetDetector();
+	virtual ~OnsetDetector();
+	void onsetDetectorInit(int nFftBins);
+	void onsetDetectorTick(uint16_t energy, uint8_t* fftBins);
+	void onsetDetectorPrint(int level);
+	bool isOnset();
+	float getOnsetNovelty();
+	float getNovelty();
+	float getLowFrequencyNovelty();
+};
+
+#endif /* INC_ONSETDETECTOR_H_ */
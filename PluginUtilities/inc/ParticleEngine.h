@@ -0,0 +1,150 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+/*
+ * ParticleEngine.h
+ *
+ *  The light sources of the source based examples, kept in one place: spawning, motion, ageing,
+ *  expiry and rendering.
+ *
+ *      static ParticleSystem_t particles;
+ *
+ *      initPlugin:
+ *          initParticleSystem(&particles, MAX_SOURCES);
+ *          particles.config.kernel = PARTICLE_KERNEL_BUBBLE;
+ *          particles.config.expiry = PARTICLE_EXPIRE_DISTANCE;
+ *          ...
+ *      getPluginFrame:
+ *          int i = spawnParticle(&particles, x, y, R, G, B);
+ *          particles.vx[i] = ...;
+ *          renderParticles(&particles, &layoutData->centroids, baseColour, TRANSITION_TIME, frames);
+ *          updateParticles(&particles);
+ *
+ *  The particles are stored as arrays, one per attribute, so motion and ageing are straight loops
+ *  over all particles. Rendering maps every particle to a light source according to the falloff
+ *  kernel and renders all panels in one pass of renderLightSources, vectorised over the panels.
+ *
+ *  The order of the particles only matters for rendering and eviction: sources are blended in
+ *  order, and a spawn into a full system evicts the first particle in order. The order is kept by
+ *  an ordered SourcePool whose items are the intensities, at the same indices as the attribute
+ *  arrays: a removal moves the last particle into the gap in both, a spawn links the particle into
+ *  its place in the order once, and eviction and rendering just walk the links.
+ */
+
+#ifndef INC_PARTICLEENGINE_H_
+#define INC_PARTICLEENGINE_H_
+
+#include <stdint.h>
+#include "AuroraPlugin.h"
+#include "ColorUtils.h"
+#include "LayoutProcessingUtils.h"
+#include "LightRenderer.h"
+#include "SourcePool.h"
+
+#define MAX_PARTICLES MAX_LIGHT_SOURCES
+
+/*
+ * falloff kernels, d is the distance to the panel times distanceScale
+ */
+#define PARTICLE_KERNEL_INVERSE_SQUARE 0	/*1 / (k * d * d + 1)*/
+#define PARTICLE_KERNEL_BUBBLE 1			/*1 / (k * u * u + 1), u = d - radius*/
+#define PARTICLE_KERNEL_DIFFUSION 2			/*1 / (k * max(u, 0) + 1), u = d - age * diffusionRate,
+											  faded out linearly until maxAge and never below minFactor*/
+
+#define PARTICLE_MOTION_STATIC 0			/*particles stay where they are spawned*/
+#define PARTICLE_MOTION_LINEAR 1			/*position += velocity on every update*/
+#define PARTICLE_MOTION_DAMPED 2			/*as linear, then velocity *= drag*/
+
+#define PARTICLE_EXPIRE_DISTANCE 1			/*bit: expires further than maxDistance from the origin*/
+#define PARTICLE_EXPIRE_AGE 2				/*bit: expires older than maxAge, while there are more than minParticles*/
+
+#define PARTICLE_ORDER_SPAWN 0				/*oldest first*/
+#define PARTICLE_ORDER_INTENSITY 1			/*lowest intensity at spawn first, oldest first among equal ones*/
+
+struct ParticleConfig_t {
+	int capacity;				/*at most MAX_PARTICLES*/
+	int order;					/*one of the PARTICLE_ORDER_* defines*/
+	int kernel;					/*one of the PARTICLE_KERNEL_* defines*/
+	float distanceScale;		/*converts distances in layout units to the units of the kernel*/
+	float k;					/*steepness of the kernel*/
+	double diffusionRate;		/*PARTICLE_KERNEL_DIFFUSION: growth of the radius per unit of age*/
+	float minFactor;			/*PARTICLE_KERNEL_DIFFUSION: share of its colour a particle always keeps*/
+	int motion;					/*one of the PARTICLE_MOTION_* defines*/
+	float drag;					/*PARTICLE_MOTION_DAMPED: velocity kept per update*/
+	int expiry;					/*PARTICLE_EXPIRE_* bits*/
+	double maxDistance;
+	double maxAge;
+	int minParticles;
+};
+
+struct alignas(64) ParticleSystem_t {
+	ParticleConfig_t config;
+	int nParticles;
+	float x[MAX_PARTICLES];
+	float y[MAX_PARTICLES];
+	float vx[MAX_PARTICLES];			/*layout units per update*/
+	float vy[MAX_PARTICLES];
+	float R[MAX_PARTICLES];
+	float G[MAX_PARTICLES];
+	float B[MAX_PARTICLES];
+	float radius[MAX_PARTICLES];		/*PARTICLE_KERNEL_BUBBLE, in units of the kernel*/
+	float age[MAX_PARTICLES];
+	float ageRate[MAX_PARTICLES];		/*added to the age on every update, 1 by default*/
+	SourcePool<float, MAX_PARTICLES, true> order;	/*the intensity of every particle, linked in render order*/
+	LightSources_t lights;				/*the light sources of the last render*/
+};
+
+/**
+ * @description: empty a particle system and reset its configuration: oldest first, inverse square kernel with
+ * scale and steepness 1, linear motion, no expiry
+ * @params capacity: number of particles before the oldest, or weakest, is evicted. Limited to MAX_PARTICLES
+ */
+void initParticleSystem(ParticleSystem_t* particles, int capacity);
+
+/**
+ * @description: add a particle, evicting the first one in order if the system is full. Its velocity, radius
+ * and age are 0 and its ageRate 1; change them through the returned index
+ * @params intensity: where the particle goes in PARTICLE_ORDER_INTENSITY, fixed for its life
+ * @return: index of the new particle, valid until the next update or spawn
+ */
+int spawnParticle(ParticleSystem_t* particles, float x, float y, int R, int G, int B, float intensity = 1.0f);
+
+/**
+ * @description: remove a particle, the last particle takes its index
+ */
+void removeParticle(ParticleSystem_t* particles, int index);
+
+/**
+ * @description: index of the first particle in order, SOURCE_POOL_NONE (-1) if there are none
+ */
+int getFirstParticle(const ParticleSystem_t* particles);
+
+/**
+ * @description: move and age all particles, then remove the ones that expired
+ */
+void updateParticles(ParticleSystem_t* particles);
+
+/**
+ * @description: render all panels for all particles, blended in order, straight into frames
+ * @params centroids: the panel ids and centroids, usually &getLayoutData()->centroids
+ * @params base: the colour of a panel before any particle is mixed in
+ * @params frames: filled with centroids->nPanels frames
+ */
+void renderParticles(ParticleSystem_t* particles, const PanelCentroids_t* centroids, RGB_t base, int transTime,
+		Frame_t* frames);
+
+#endif /* INC_PARTICLEENGINE_H_ */
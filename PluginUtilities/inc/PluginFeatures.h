@@ -0,0 +1,70 @@
+/*
+ * AdvancedFeatures.h
+ *
+ *  Created on: Jul 5, 2017
+ *      Author: leizhang
+ */
+
+#ifndef INC_PLUGINFEATURES_H_
+#define INC_PLUGINFEATURES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ----------------------------------
+ * RHYTHM FEATURE FUNCTIONS
+ * ----------------------------------
+ */
+void enableEnergy(void);
+void enableFft(uint16_t nFftBins);
+void enableDistance(void);
+void enableSpeed(void);			// get motion speed in m/s
+uint16_t getEnergy(void);
+uint8_t *getFftBins(void);
+uint8_t getDistance(void);
+uint8_t getSpeed(void);
+
+/* ----------------------------------
+ * BEAT FEATURE FUNCTIONS
+ * ----------------------------------
+ */
+void enableBeatFeatures(void);	// enable beat features
+bool getIsBeat(void);			// get beat flag
+bool getIsOnset(void);			// get onset flag
+float getTempo(void);			// get tempo in beats-per-minute (bpm)
+float getBeatPhase(void);		// get position in the current beat, 0 on the beat rising to 1 just before the next
+float getBeatConfidence(void);	// get how periodic the recent onsets are, 0 to 1. Below 0.5 beats follow the onsets
+
+/* ----------------------------------
+ * SPECTRUM FEATURE FUNCTIONS
+ * computed once per update of the sound features, the pointers stay valid until the plugin is unloaded
+ * ----------------------------------
+ */
+#define FFT_BANDS_LOG 0				// bands of equal width in log frequency, from FFT_BANDS_MIN_HZ
+#define FFT_BANDS_MEL 1				// bands of equal width on the mel scale, from 0 Hz
+#define FFT_BANDS_MIN_HZ 40.0f		// lowest frequency of the log bands
+#define FFT_BIN16_SCALE 256			// getFftBins16 is the bin times this, saturated at 65535
+
+void enableFftBands(uint16_t nBands, int scale);	// aggregate the fft bins into nBands bands, scale is FFT_BANDS_LOG or FFT_BANDS_MEL
+const float *getFftBinsFloat(void);		// the fft bins on the scale of getFftBins, not rounded or saturated if the sound module can provide that
+const uint16_t *getFftBins16(void);		// the fft bins in 1/FFT_BIN16_SCALE steps
+const float *getFftBands(void);			// mean magnitude of the bins in every band, lowest band first
+float getSpectralCentroid(void);		// magnitude weighted mean bin index, 0 in silence
+uint16_t getPeakFftBin(void);			// index of the strongest bin, the lowest one on a tie
+
+/* ----------------------------------
+ * BAND ONSET FEATURE FUNCTIONS
+ * one entry per band of getFftBands, or per fft bin if no bands are enabled. An onset is a rise of the band
+ * well above its recent rises, a band that fired holds off for 100ms
+ * ----------------------------------
+ */
+void enableBandOnsets(void);				// detect onsets in every band, on every update of the sound features
+const uint8_t *getBandOnsets(void);			// 1 for the bands that had an onset in this update, else 0
+const float *getBandOnsetStrengths(void);	// rise of every band over its onset threshold, above 1 on an onset
+
+/* -----------------------------------
+ * MORE ADVANCED FEATURES ...
+ * -----------------------------------
+ */
+
+#endif /* INC_PLUGINFEATURES_H_ */
@@ -0,0 +1,98 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PluginFeaturesInternal.h
+ *
+ *  The side of PluginFeatures.h that faces the sound module. The sound module reads
+ *  the enabled features after initPlugin(), then pushes a RhythmFeatures_t into the
+ *  library every time it has new data and before it calls getPluginFrame().
+ */
+
+#ifndef INC_PLUGINFEATURESINTERNAL_H_
+#define INC_PLUGINFEATURESINTERNAL_H_
+
+#include <stdint.h>
+
+#define DEFAULT_N_FFT_BINS 32
+#define SOUND_TICK_MS 50.0f				/*the sound module updates the features every 50ms*/
+#define DEFAULT_SAMPLE_RATE 44100.0f	/*Hz, assumed for the mel bands until the sound module passes its own*/
+
+struct EnabledFeatures_t {
+	bool energy;
+	bool fft;
+	uint16_t nFftBins;
+	bool distance;
+	bool speed;
+	bool beat;
+	uint16_t nFftBands;
+	int fftBandScale;
+	bool bandOnsets;
+};
+
+struct RhythmFeatures_t {
+	uint16_t energy;
+	uint8_t* fftBins;
+	uint16_t nFftBins;
+	uint8_t speed;
+	uint8_t distance;
+};
+
+/**
+ * The fft bins at full resolution, for sound modules that have more than 8 bits. The bins span 0 Hz to half the
+ * sample rate in equal steps, on the same scale as RhythmFeatures_t::fftBins
+ */
+struct SpectrumFeatures_t {
+	const float* fftBins;
+	uint16_t nFftBins;
+	float sampleRate;			/*Hz, 0 if unknown*/
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+EnabledFeatures_t* getEnabledFeatures(void);
+
+/**
+ * @description: allocate the feature storage for the fft size that the plugin enabled
+ */
+void initRhythmFeatures(void);
+
+/**
+ * @description: copy the latest features from the sound module, the caller keeps ownership of fftBins
+ */
+void updateRhythmFeatures(RhythmFeatures_t* rhythmFeatures);
+
+/**
+ * @description: optional, call after updateRhythmFeatures to replace the 8 bit bins by bins at full resolution.
+ * Once it has been called the spectrum features are only computed from these bins
+ */
+void updateSpectrumFeatures(SpectrumFeatures_t* spectrumFeatures);
+void deinitRhythmFeatures(void);
+void initBeatFeatures(void);
+
+/**
+ * @description: run one tick of the beat engine on the features of the last updateRhythmFeatures()
+ */
+void updateBeatFeatures(void);
+void deinitBeatFeatures(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_PLUGINFEATURESINTERNAL_H_ */
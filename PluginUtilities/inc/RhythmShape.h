@@ -0,0 +1,37 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * RhythmShape.h
+ */
+
+#ifndef INC_RHYTHMSHAPE_H_
+#define INC_RHYTHMSHAPE_H_
+
+#include "Shape.h"
+
+/**
+ * The Rhythm module. It has no light and no area, so no point is ever inside it
+ */
+class RhythmShape : public Shape {
+public:
+	RhythmShape(Point centroid, int sideLength, int orientation);
+	virtual ~RhythmShape();
+	virtual bool isPointInsideShape(Point p);
+	virtual void updateShape(Point* centroid, int* orientation);
+};
+
+#endif /* INC_RHYTHMSHAPE_H_ */
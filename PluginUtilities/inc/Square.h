@@ -0,0 +1,40 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Square.h
+ */
+
+#ifndef INC_SQUARE_H_
+#define INC_SQUARE_H_
+
+#include "Shape.h"
+
+class Square : public Shape {
+public:
+	/**
+	 * @description: an axis aligned square
+	 * @params centroid: the centroid of the square
+	 * @params sideLength: length of a side
+	 * @params orientation: orientation in degrees, kept but not used for the vertices
+	 */
+	Square(Point centroid, int sideLength, int orientation);
+	virtual ~Square();
+	virtual bool isPointInsideShape(Point p);
+	virtual void updateShape(Point* centroid, int* orientation);
+};
+
+#endif /* INC_SQUARE_H_ */
@@ -0,0 +1,41 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Triangle.h
+ */
+
+#ifndef INC_TRIANGLE_H_
+#define INC_TRIANGLE_H_
+
+#include "Shape.h"
+
+class Triangle : public Shape {
+public:
+	/**
+	 * @description: an equilateral triangle, pointing up if orientation is a multiple of 120 degrees,
+	 * pointing down otherwise
+	 * @params centroid: the centroid of the triangle
+	 * @params sideLength: length of a side
+	 * @params orientation: orientation in degrees
+	 */
+	Triangle(Point centroid, int sideLength, int orientation);
+	virtual ~Triangle();
+	virtual bool isPointInsideShape(Point p);
+	virtual void updateShape(Point* centroid, int* orientation);
+};
+
+#endif /* INC_TRIANGLE_H_ */
@@ -0,0 +1,105 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BandOnsetDetector.cpp
+ */
+
+#include "BandOnsetDetector.h"
+#include <math.h>
+
+#define DEFAULT_TICK_MS 50.0f			/*the sound module delivers features every 50ms*/
+#define FLUX_TIME_CONSTANT_MS 1000.0f	/*how long the threshold remembers the flux of a band*/
+#define THRESHOLD_DEVIATIONS 2.0f		/*the flux must exceed its running mean by this many mean deviations*/
+#define THRESHOLD_FLOOR 2.0f			/*and by this much, on the scale of the fft bins*/
+#define HOLD_MS 100.0f					/*a band does not fire again for this long after an onset*/
+
+BandOnsetDetector::BandOnsetDetector() {
+	bandOnsetDetectorInit(0, DEFAULT_TICK_MS);
+}
+
+BandOnsetDetector::~BandOnsetDetector() {
+}
+
+void BandOnsetDetector::bandOnsetDetectorInit(int _nBands, float tickMs) {
+	nBands = _nBands > 0 ? _nBands : 0;
+	primed = false;
+	meanRate = 1.0f - expf(-tickMs / FLUX_TIME_CONSTANT_MS);
+	holdTicks = roundf(HOLD_MS / tickMs);
+	previous.assign(nBands, 0.0f);
+	mean.assign(nBands, 0.0f);
+	deviation.assign(nBands, 0.0f);
+	hold.assign(nBands, 0.0f);
+	strengths.assign(nBands, 0.0f);
+	onsets.assign(nBands, 0);
+}
+
+/**
+ * @description: one pass over the bands. The arrays are passed as restricted parameters so that the loop
+ * vectorizes without run time alias checks, and the hold is updated arithmetically because a select
+ * would stay a branch under trapping math
+ */
+static void fluxOnsetPass(const float* __restrict bands, float* __restrict prev, float* __restrict mean,
+		float* __restrict deviation, float* __restrict hold, float* __restrict strength, uint8_t* __restrict onset,
+		int nBands, float meanRate, float holdTicks) {
+	for (int b = 0; b < nBands; b++) {
+		float x = bands[b];
+		float rise = x - prev[b];
+		float flux = rise > 0 ? rise : 0;
+		prev[b] = x;
+
+		// the threshold is taken before the flux of this tick is folded into it
+		float threshold = mean[b] + THRESHOLD_DEVIATIONS * deviation[b] + THRESHOLD_FLOOR;
+		float s = flux / threshold;
+		float h = hold[b];
+		bool fired = (s > 1.0f) & (h <= 0);
+		strength[b] = s;
+		onset[b] = fired;
+		hold[b] = h - 1.0f + fired * (holdTicks - h + 1.0f);
+
+		float d = flux - mean[b];
+		mean[b] += meanRate * d;
+		deviation[b] += meanRate * (fabsf(d) - deviation[b]);
+	}
+}
+
+/**
+ * @description: compare every band with the previous tick and flag the onsets
+ * @params bands: nBands values, on the scale of the fft bins
+ */
+void BandOnsetDetector::bandOnsetDetectorTick(const float* bands) {
+	if (!primed) {
+		for (int b = 0; b < nBands; b++) {
+			previous[b] = bands[b];
+		}
+		primed = true;
+		return;
+	}
+	fluxOnsetPass(bands, previous.data(), mean.data(), deviation.data(), hold.data(), strengths.data(), onsets.data(),
+			nBands, meanRate, holdTicks);
+}
+
+int BandOnsetDetector::getNBands() {
+	return nBands;
+}
+
+const uint8_t* BandOnsetDetector::getOnsets() {
+	return onsets.data();
+}
+
+const float* BandOnsetDetector::getStrengths() {
+	return strengths.data();
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatEngine.cpp
+ */
+
+#include "BeatEngine.h"
+
+BeatEngine::BeatEngine() {
+	od = new OnsetDetector;
+	bt = new BeatTracker;
+}
+
+BeatEngine::~BeatEngine() {
+	delete od;
+	delete bt;
+}
+
+void BeatEngine::beatEngineInit(int nFftBins, float tickMs) {
+	od->onsetDetectorInit(nFftBins);
+	bt->beatTrackerInit(tickMs);
+}
+
+void BeatEngine::beatEngineTick(uint16_t energy, uint8_t* fftBins) {
+	od->onsetDetectorTick(energy, fftBins);
+	od->onsetDetectorPrint(0);
+	bt->beatTrackerTick(od->getNovelty(), od->isOnset());
+}
+
+bool BeatEngine::isBeat() {
+	return bt->isBeat();
+}
+
+float BeatEngine::getTempo() {
+	return bt->getTempo();
+}
+
+float BeatEngine::getBeatPhase() {
+	return bt->getPhase();
+}
+
+float BeatEngine::getBeatConfidence() {
+	return bt->getConfidence();
+}
+
+bool BeatEngine::isOnset() {
+	return od->isOnset();
+}
+
+float BeatEngine::getOnsetNovelty() {
+	return od->getOnsetNovelty();
+}
+
+float BeatEngine::getNovelty() {
+	return od->getNovelty();
+}
+
+float BeatEngine::getLowFrequencyNovelty() {
+	return od->getLowFrequencyNovelty();
+}
@@ -0,0 +1,195 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatTracker.cpp
+ */
+
+#include "BeatTracker.h"
+#include <math.h>
+#include <string.h>
+
+#define DEFAULT_TICK_MS 50.0f				/*the sound module delivers features every 50ms*/
+#define RESONATOR_TIME_CONSTANT_MS 6000.0f	/*how long the resonators remember the onsets*/
+#define ONSET_MEAN_TIME_CONSTANT_MS 2000.0f
+#define HARMONIC_WEIGHT 0.5f				/*a tempo also gets this share of the salience of twice the tempo*/
+#define PRIOR_CENTRE_BPM 120.0f
+#define PRIOR_WIDTH_OCTAVES 1.0f
+#define MIN_MASS 1e-3f						/*below this the input is taken as silence*/
+#define MIN_BEAT_PERIOD_FRACTION 0.6f		/*beats closer than this share of the beat period are dropped*/
+#define MIN_ONSET_INTERVAL 3				/*without a confident tempo, onsets closer than this many ticks are not beats*/
+#define RENORMALIZE_TICKS 256				/*the phasors are pulled back onto the unit circle this often*/
+#define N_HARMONIC_TEMPOS ((MAX_TRACKER_BPM / 2) - MIN_TRACKER_BPM + 1)	/*tempos whose double is in range*/
+
+BeatTracker::BeatTracker() {
+	beatTrackerInit(DEFAULT_TICK_MS);
+}
+
+BeatTracker::~BeatTracker() {
+}
+
+void BeatTracker::beatTrackerInit(float _tickMs) {
+	tickMs = _tickMs;
+	decay = expf(-tickMs / RESONATOR_TIME_CONSTANT_MS);
+	meanRate = 1.0f - expf(-tickMs / ONSET_MEAN_TIME_CONSTANT_MS);
+	for (int k = 0; k < N_TRACKER_TEMPOS; k++) {
+		float bpm = MIN_TRACKER_BPM + k;
+		double w = 2 * M_PI * bpm / 60.0 * tickMs / 1000.0;
+		rotationRe[k] = cos(w);
+		rotationIm[k] = -sin(w);
+		phasorRe[k] = 1;
+		phasorIm[k] = 0;
+		re[k] = 0;
+		im[k] = 0;
+		magnitude[k] = 0;
+		salience[k] = 0;
+		float octaves = log2f(bpm / PRIOR_CENTRE_BPM) / PRIOR_WIDTH_OCTAVES;
+		prior[k] = expf(-0.5f * octaves * octaves);
+	}
+	onsetMean = 0;
+	mass = 0;
+	tempo = 0;
+	tempoIndex = 0;
+	phase = 0;
+	confidence = 0;
+	beat = false;
+	ticksSinceBeat = 0;
+	ticksSinceOnset = 0;
+	nTicks = 0;
+}
+
+/**
+ * @description: turn every phasor by one tick and add the onset envelope to the resonators along it.
+ * The square roots are taken in a loop of their own so that the update vectorizes
+ */
+void BeatTracker::updateResonators(float envelope) {
+	mass = mass * decay + envelope;
+	for (int k = 0; k < N_TRACKER_TEMPOS; k++) {
+		float pr = phasorRe[k] * rotationRe[k] - phasorIm[k] * rotationIm[k];
+		float pi = phasorRe[k] * rotationIm[k] + phasorIm[k] * rotationRe[k];
+		phasorRe[k] = pr;
+		phasorIm[k] = pi;
+		re[k] = re[k] * decay + envelope * pr;
+		im[k] = im[k] * decay + envelope * pi;
+		magnitude[k] = re[k] * re[k] + im[k] * im[k];
+	}
+	for (int k = 0; k < N_TRACKER_TEMPOS; k++) {
+		magnitude[k] = sqrtf(magnitude[k]);
+	}
+	nTicks++;
+	if (nTicks % RENORMALIZE_TICKS == 0) {
+		for (int k = 0; k < N_TRACKER_TEMPOS; k++) {
+			float scale = 1.0f / sqrtf(phasorRe[k] * phasorRe[k] + phasorIm[k] * phasorIm[k]);
+			phasorRe[k] *= scale;
+			phasorIm[k] *= scale;
+		}
+	}
+}
+
+/**
+ * @description: pick the most salient resonator, counting the salience of twice its tempo so that a
+ * beat with hits in between is not mistaken for twice the tempo, and interpolate the tempo between its
+ * neighbours. The tempo is kept while the confidence is too low
+ */
+void BeatTracker::updateTempo() {
+	for (int k = 0; k < N_HARMONIC_TEMPOS; k++) {
+		salience[k] = (magnitude[k] + HARMONIC_WEIGHT * magnitude[2 * k + MIN_TRACKER_BPM]) * prior[k];
+	}
+	for (int k = N_HARMONIC_TEMPOS; k < N_TRACKER_TEMPOS; k++) {
+		salience[k] = magnitude[k] * prior[k];
+	}
+	int best = 0;
+	float bestSalience = salience[0];
+	for (int k = 1; k < N_TRACKER_TEMPOS; k++) {
+		if (salience[k] > bestSalience) {
+			bestSalience = salience[k];
+			best = k;
+		}
+	}
+	confidence = mass > MIN_MASS ? magnitude[best] / mass : 0;
+	if (confidence > 1) {
+		confidence = 1;
+	}
+	if (confidence < MIN_TRACKER_CONFIDENCE) {
+		return;
+	}
+	float offset = 0;
+	if (best > 0 && best < N_TRACKER_TEMPOS - 1) {
+		float below = salience[best - 1];
+		float above = salience[best + 1];
+		float curvature = below - 2 * bestSalience + above;
+		if (curvature < 0) {
+			offset = 0.5f * (below - above) / curvature;
+			offset = offset < -0.5f ? -0.5f : (offset > 0.5f ? 0.5f : offset);
+		}
+	}
+	tempoIndex = best;
+	tempo = MIN_TRACKER_BPM + best + offset;
+}
+
+/**
+ * @description: the phase is where the current tick falls in the beat of the tempo resonator, half
+ * a tick ahead so that a beat is reported on the tick closest to it
+ */
+void BeatTracker::updateBeat(bool onset) {
+	int k = tempoIndex;
+	float cr = re[k] * phasorRe[k] + im[k] * phasorIm[k];
+	float ci = im[k] * phasorRe[k] - re[k] * phasorIm[k];
+	float previousPhase = phase;
+	float halfTick = 0.5f * (MIN_TRACKER_BPM + k) / 60.0f * tickMs / 1000.0f;
+	phase = atan2f(ci, cr) / (2 * M_PI) + halfTick;
+	phase -= floorf(phase);
+
+	ticksSinceBeat++;
+	ticksSinceOnset++;
+	if (confidence >= MIN_TRACKER_CONFIDENCE) {
+		float periodTicks = 60000.0f / (tempo * tickMs);
+		beat = phase < previousPhase - 0.5f && ticksSinceBeat >= MIN_BEAT_PERIOD_FRACTION * periodTicks;
+	}
+	else {
+		beat = onset && ticksSinceOnset >= MIN_ONSET_INTERVAL;
+	}
+	if (beat) {
+		ticksSinceBeat = 0;
+	}
+	if (onset) {
+		ticksSinceOnset = 0;
+	}
+}
+
+void BeatTracker::beatTrackerTick(float onsetStrength, bool onset) {
+	float envelope = onsetStrength - onsetMean;
+	onsetMean += (onsetStrength - onsetMean) * meanRate;
+	updateResonators(envelope > 0 ? envelope : 0);
+	updateTempo();
+	updateBeat(onset);
+}
+
+bool BeatTracker::isBeat() {
+	return beat;
+}
+
+float BeatTracker::getTempo() {
+	return tempo;
+}
+
+float BeatTracker::getPhase() {
+	return phase;
+}
+
+float BeatTracker::getConfidence() {
+	return confidence;
+}
@@ -0,0 +1,131 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * BeatUtilities.cpp
+ */
+
+#include "BeatUtilities.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DEFAULT_HISTOGRAM_LENGTH 32
+#define MAX_BIN_COUNT 64
+#define N_RECENT_BINS 9
+#define DEGRADE_INTERVAL 15		/*ticks between each decay of the bins*/
+#define POP_INTERVAL 10			/*ticks between each release of a recent bin*/
+
+Histogram::Histogram() {
+	length = DEFAULT_HISTOGRAM_LENGTH;
+	bins = new int[length];
+	memset(bins, 0, length * sizeof(int));
+	total = 0;
+	recentBins = new Fifo<int>(N_RECENT_BINS);
+	degradeCounter = 0;
+	popCounter = 0;
+}
+
+Histogram::Histogram(int length) {
+	this->length = length;
+	bins = new int[length];
+	memset(bins, 0, length * sizeof(int));
+	total = 0;
+	recentBins = new Fifo<int>(N_RECENT_BINS);
+	degradeCounter = 0;
+	popCounter = 0;
+}
+
+Histogram::~Histogram() {
+	if (bins) {
+		delete [] bins;
+		bins = NULL;
+	}
+	if (recentBins) {
+		delete recentBins;
+		recentBins = NULL;
+	}
+	length = 0;
+	total = 0;
+}
+
+void Histogram::incrementHistogramBin(int bin) {
+	if (bin < 0 || bin >= length) {
+		return;
+	}
+	if (bins[bin] < MAX_BIN_COUNT) {
+		bins[bin]++;
+		total++;
+	}
+	recentBins->push(bin);
+}
+
+void Histogram::degradeHistogram() {
+	if (degradeCounter == DEGRADE_INTERVAL) {
+		for (int i = 0; i < length; i++) {
+			if (!recentBins->isMember(i) && bins[i] > 0) {
+				bins[i]--;
+				total--;
+			}
+		}
+		degradeCounter = 0;
+	}
+	else {
+		degradeCounter++;
+	}
+
+	if (popCounter > POP_INTERVAL && !recentBins->isEmpty()) {
+		recentBins->pop();
+		popCounter = 0;
+	}
+	else {
+		popCounter++;
+	}
+}
+
+float Histogram::getProbabilityOfBins(int* bins, int nBins) {
+	if (total <= 0) {
+		return 0;
+	}
+	int sum = 0;
+	for (int i = 0; i < nBins; i++) {
+		sum += getHistogramBin(bins[i]);
+	}
+	return (float)sum / total;
+}
+
+int Histogram::getHistogramBin(int bin) {
+	if (bin < 0 || bin >= length) {
+		return 0;
+	}
+	return bins[bin];
+}
+
+void Histogram::displayHistogram(int scale) {
+	if (scale < 1) {
+		scale = 1;
+	}
+	for (int i = 0; i < length; i++) {
+		printf("%2d: ", i);
+		for (int j = 0; j < bins[i] / scale; j++) {
+			printf("#");
+		}
+		printf("\n");
+	}
+}
+
+int Histogram::getLength() {
+	return length;
+}
@@ -0,0 +1,298 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * ColorUtils.cpp
+ *
+ *  Created on: Feb 12, 2017
+ *      Author: eski
+ */
+
+#include "ColorUtils.h"
+#include <math.h>
+#include <algorithm>
+
+#define HUE_LUT_SIZE 360
+#define HUE_WEIGHT_MAX 60		/*hue weights are in 60ths of the chroma*/
+
+/**
+ * Share of the chroma that each channel gets at one hue, in 60ths. This is the C, X, 0
+ * assignment of HSVtoRGB: X / C = 1 - |(H / 60) mod 2 - 1|, which is a whole number of 60ths for whole degrees.
+ */
+struct HueWeights_t {
+	unsigned char r, g, b;
+};
+
+struct HueLut_t {
+	HueWeights_t weights[HUE_LUT_SIZE];
+};
+
+static constexpr unsigned char hueRamp(int hue) {
+	return (unsigned char)(hue % 120 < 60 ? hue % 120 : 120 - hue % 120);
+}
+
+static constexpr HueWeights_t hueWeights(int hue) {
+	return hue < 60 ? HueWeights_t{HUE_WEIGHT_MAX, hueRamp(hue), 0} :
+			hue < 120 ? HueWeights_t{hueRamp(hue), HUE_WEIGHT_MAX, 0} :
+			hue < 180 ? HueWeights_t{0, HUE_WEIGHT_MAX, hueRamp(hue)} :
+			hue < 240 ? HueWeights_t{0, hueRamp(hue), HUE_WEIGHT_MAX} :
+			hue < 300 ? HueWeights_t{hueRamp(hue), 0, HUE_WEIGHT_MAX} :
+			HueWeights_t{HUE_WEIGHT_MAX, 0, hueRamp(hue)};
+}
+
+template <int... I>
+struct HueIndices {
+};
+
+template <int N, int... I>
+struct MakeHueIndices : MakeHueIndices<N - 1, N - 1, I...> {
+};
+
+template <int... I>
+struct MakeHueIndices<0, I...> {
+	typedef HueIndices<I...> type;
+};
+
+template <int... I>
+static constexpr HueLut_t makeHueLut(HueIndices<I...>) {
+	return HueLut_t{{hueWeights(I)...}};
+}
+
+static constexpr HueLut_t hueLut = makeHueLut(MakeHueIndices<HUE_LUT_SIZE>::type());
+
+/**
+ * @description: n / d rounded half away from zero, for d > 0
+ */
+static inline int divRound(int n, int d) {
+	return n >= 0 ? (2 * n + d) / (2 * d) : -((-2 * n + d) / (2 * d));
+}
+
+void parseColor(int* colorByteStream, int nColors, RGB_t** rgb) {
+	RGB_t* colors = new RGB_t[nColors];
+	int idx = 0;
+	for (int i = 0; i < nColors; i++) {
+		colors[i].R = colorByteStream[idx++];
+		colors[i].G = colorByteStream[idx++];
+		colors[i].B = colorByteStream[idx++];
+	}
+	*rgb = colors;
+}
+
+void HSVtoRGB(HSV_t hsv, RGB_t* rgb) {
+	if (hsv.H >= 360) {
+		hsv.H = 360 - hsv.H;
+	}
+	double s = hsv.S / 100.0;
+	double v = hsv.V / 100.0;
+	double C = s * v;
+	double X = C * (1 - fabs(fmod(hsv.H / 60.0, 2) - 1));
+	double m = v - C;
+	double r = 0, g = 0, b = 0;
+
+	if (hsv.H >= 0 && hsv.H < 60) {
+		r = C, g = X, b = 0;
+	}
+	if (hsv.H >= 60 && hsv.H < 120) {
+		r = X, g = C, b = 0;
+	}
+	if (hsv.H >= 120 && hsv.H < 180) {
+		r = 0, g = C, b = X;
+	}
+	if (hsv.H >= 180 && hsv.H < 240) {
+		r = 0, g = X, b = C;
+	}
+	if (hsv.H >= 240 && hsv.H < 300) {
+		r = X, g = 0, b = C;
+	}
+	if (hsv.H >= 300 && hsv.H < 360) {
+		r = C, g = 0, b = X;
+	}
+	rgb->R = (int)round((r + m) * 255);
+	rgb->G = (int)round((g + m) * 255);
+	rgb->B = (int)round((b + m) * 255);
+}
+
+void HSVtoRGBFast(HSV_t hsv, RGB_t* rgb) {
+	if (hsv.S < 0 || hsv.S > 100 || hsv.V < 0 || hsv.V > 100) {
+		HSVtoRGB(hsv, rgb);
+		return;
+	}
+	// HSVtoRGB maps 360 to 0 and anything above it to a negative hue, which gets no chroma
+	static const HueWeights_t grey = {0, 0, 0};
+	int hue = hsv.H == HUE_LUT_SIZE ? 0 : hsv.H;
+	const HueWeights_t& w = (hue >= 0 && hue < HUE_LUT_SIZE) ? hueLut.weights[hue] : grey;
+	// channel = 255 * v * (1 - s * (1 - w / 60)), with s and v in percent
+	int scale = 255 * hsv.V;
+	int full = HUE_WEIGHT_MAX * 100;
+	int d = 100 * 100 * HUE_WEIGHT_MAX;
+	rgb->R = (scale * (full - hsv.S * (HUE_WEIGHT_MAX - w.r)) + d / 2) / d;
+	rgb->G = (scale * (full - hsv.S * (HUE_WEIGHT_MAX - w.g)) + d / 2) / d;
+	rgb->B = (scale * (full - hsv.S * (HUE_WEIGHT_MAX - w.b)) + d / 2) / d;
+}
+
+void HSVtoRGB(const HSV_t* hsv, RGB_t* rgb, int n) {
+	for (int i = 0; i < n; i++) {
+		HSVtoRGBFast(hsv[i], &rgb[i]);
+	}
+}
+
+void RGBtoHSV(RGB_t rgb, HSV_t* hsv) {
+	double r = rgb.R / 255.0;
+	double g = rgb.G / 255.0;
+	double b = rgb.B / 255.0;
+	double cmax = std::max(std::max(r, g), b);
+	double cmin = std::min(std::min(r, g), b);
+	double delta = cmax - cmin;
+	int H = 0, S = 0, V = 0;
+
+	if (delta == 0) {
+		H = 0;
+	}
+	else if (cmax == r) {
+		H = (int)round(60 * ((g - b) / delta));
+		if (H < 0) {
+			H += 360;
+		}
+	}
+	else if (cmax == g) {
+		H = (int)round(60 * ((b - r) / delta + 2));
+		if (H < 0) {
+			H += 360;
+		}
+	}
+	else if (cmax == b) {
+		H = (int)round(60 * ((r - g) / delta + 4));
+		if (H < 0) {
+			H += 360;
+		}
+	}
+
+	if (cmax == 0) {
+		S = 0;
+	}
+	else {
+		S = (int)round(delta / cmax * 100);
+	}
+	V = (int)round(cmax * 100);
+
+	hsv->H = H;
+	hsv->S = S;
+	hsv->V = V;
+}
+
+void RGBtoHSVFast(RGB_t rgb, HSV_t* hsv) {
+	if ((unsigned)rgb.R > 255 || (unsigned)rgb.G > 255 || (unsigned)rgb.B > 255) {
+		RGBtoHSV(rgb, hsv);
+		return;
+	}
+	int cmax = std::max(std::max(rgb.R, rgb.G), rgb.B);
+	int cmin = std::min(std::min(rgb.R, rgb.G), rgb.B);
+	int delta = cmax - cmin;
+	int H = 0;
+
+	// the channels are all over 255, so it cancels out of the hue and the saturation
+	if (delta == 0) {
+		H = 0;
+	}
+	else if (cmax == rgb.R) {
+		H = divRound(60 * (rgb.G - rgb.B), delta);
+		if (H < 0) {
+			H += 360;
+		}
+	}
+	else if (cmax == rgb.G) {
+		H = divRound(60 * (rgb.B - rgb.R) + 120 * delta, delta);
+	}
+	else {
+		H = divRound(60 * (rgb.R - rgb.G) + 240 * delta, delta);
+	}
+
+	hsv->H = H;
+	hsv->S = cmax == 0 ? 0 : divRound(100 * delta, cmax);
+	hsv->V = divRound(100 * cmax, 255);
+}
+
+void RGBtoHSV(const RGB_t* rgb, HSV_t* hsv, int n) {
+	for (int i = 0; i < n; i++) {
+		RGBtoHSVFast(rgb[i], &hsv[i]);
+	}
+}
+
+RGB_t getPaletteColour(const RGB_t* palette, int nColours, float position) {
+	RGB_t rgb;
+	if (nColours <= 0) {
+		rgb.R = 128;
+		rgb.G = 128;
+		rgb.B = 128;
+		return rgb;
+	}
+	int idx = (int)position;
+	if (nColours == 1 || position <= 0) {
+		return palette[0];
+	}
+	if (idx >= nColours - 1) {
+		return palette[nColours - 1];
+	}
+	float fraction = position - (float)idx;
+	float R = (1.0 - fraction) * palette[idx].R + fraction * palette[idx + 1].R;
+	float G = (1.0 - fraction) * palette[idx].G + fraction * palette[idx + 1].G;
+	float B = (1.0 - fraction) * palette[idx].B + fraction * palette[idx + 1].B;
+	rgb.R = (int)R;
+	rgb.G = (int)G;
+	rgb.B = (int)B;
+	return rgb;
+}
+
+void freeColor(RGB_t* rgb) {
+	if (rgb) {
+		delete [] rgb;
+	}
+}
+
+RGB_t operator+ (const RGB_t& l, const RGB_t& r) {
+	RGB_t c = {l.R + r.R, l.G + r.G, l.B + r.B};
+	return c;
+}
+
+RGB_t operator- (const RGB_t& l, const RGB_t& r) {
+	RGB_t c = {l.R - r.R, l.G - r.G, l.B - r.B};
+	return c;
+}
+
+RGB_t operator* (const RGB_t& l, int m) {
+	RGB_t c = {l.R * m, l.G * m, l.B * m};
+	return c;
+}
+
+RGB_t operator* (int m, const RGB_t& l) {
+	return l * m;
+}
+
+RGB_t operator/ (const RGB_t& l, float d) {
+	RGB_t c = {(int)round(l.R / d), (int)round(l.G / d), (int)round(l.B / d)};
+	return c;
+}
+
+RGB_t limitRGB(const RGB_t& c, int max, int min) {
+	RGB_t l;
+	l.R = c.R > max ? max : c.R;
+	l.G = c.G > max ? max : c.G;
+	l.B = c.B > max ? max : c.B;
+	l.R = l.R < min ? min : l.R;
+	l.G = l.G < min ? min : l.G;
+	l.B = l.B < min ? min : l.B;
+	return l;
+}
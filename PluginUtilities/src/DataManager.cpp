@@ -0,0 +1,91 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * DataManager.cpp
+ *
+ *  Created on: Feb 13, 2017
+ *      Author: eski
+ */
+
+#include "DataManager.h"
+#include "Version.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	const char* getPluginUtilitiesVersion();
+	void passLayoutData(int* layoutDataByteStream, int nPanels);
+	void passColorPalette(int* colorByteStream, int nColors);
+	void dataManagerCleanup();
+
+#ifdef __cplusplus
+}
+#endif
+
+static RGB_t* colorPalette = NULL;
+static LayoutData* layoutData = NULL;
+int nPaletteColors = 0;
+
+void getColorPalette(RGB_t** palette, int* nColors) {
+	*palette = colorPalette;
+	*nColors = nPaletteColors;
+}
+
+LayoutData* getLayoutData() {
+	return layoutData;
+}
+
+/**
+ * @description: version of the SDK this library implements
+ */
+const char* getPluginUtilitiesVersion() {
+	return SDK_VERSION;
+}
+
+/**
+ * @description: called by the host before initPlugin with the layout of the Aurora
+ */
+void passLayoutData(int* layoutDataByteStream, int nPanels) {
+	if (layoutData) {
+		freeLayoutData(layoutData);
+	}
+	parseLayoutData(layoutDataByteStream, nPanels, &layoutData);
+}
+
+/**
+ * @description: called by the host before initPlugin with the palette chosen by the user
+ */
+void passColorPalette(int* colorByteStream, int nColors) {
+	if (colorPalette) {
+		freeColor(colorPalette);
+	}
+	parseColor(colorByteStream, nColors, &colorPalette);
+	nPaletteColors = nColors;
+}
+
+/**
+ * @description: called by the host after pluginCleanup
+ */
+void dataManagerCleanup() {
+	freeColor(colorPalette);
+	colorPalette = NULL;
+	nPaletteColors = 0;
+	freeLayoutData(layoutData);
+	layoutData = NULL;
+}
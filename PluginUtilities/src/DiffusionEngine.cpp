@@ -0,0 +1,209 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+
+/*
+ * DiffusionEngine.cpp
+ *
+ *  Both implementations of the step evaluate the same float expressions in the same order and do
+ *  not contract them into fused multiply-adds, so they give the same results.
+ */
+
+#include "DiffusionEngine.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIFFUSION_STEP_X86
+#include <immintrin.h>
+#endif
+
+#define MAX_CHANNEL_VALUE 255.0f
+#define N_CHANNELS 3
+
+typedef void (*StepFunction_t)(DiffusionField_t* field);
+
+static StepFunction_t stepFunction = NULL;
+
+/**
+ * @description: allocate an aligned array of n elements of size bytes, zero filled
+ */
+static void* allocFieldArray(int n, size_t size) {
+	void* p = NULL;
+	if (posix_memalign(&p, PANEL_ARRAY_ALIGNMENT, n * size) != 0) {
+		return NULL;
+	}
+	memset(p, 0, n * size);
+	return p;
+}
+
+void initDiffusionField(DiffusionField_t* field, const LayoutData* layoutData) {
+	freeDiffusionField(field);
+	const PanelAdjacency_t* adjacency = &layoutData->adjacency;
+	field->nPanels = layoutData->nPanels;
+	field->nPadded = layoutData->centroids.nPadded;
+	field->panelIds = layoutData->centroids.panelIds;
+	field->nSlots = 0;
+	for (int i = 0; i < field->nPanels; i++) {
+		int degree = adjacency->offsets[i + 1] - adjacency->offsets[i];
+		field->nSlots = degree > field->nSlots ? degree : field->nSlots;
+	}
+
+	// a panel with fewer neighbours than slots is its own neighbour in the remaining slots, which adds nothing
+	field->neighbors = (int*)allocFieldArray(field->nSlots * field->nPadded + 1, sizeof(int));
+	for (int s = 0; s < field->nSlots; s++) {
+		for (int i = 0; i < field->nPadded; i++) {
+			int j = i < field->nPanels ? adjacency->offsets[i] + s : 0;
+			bool hasNeighbor = i < field->nPanels && j < adjacency->offsets[i + 1];
+			field->neighbors[s * field->nPadded + i] = hasNeighbor ? adjacency->neighbors[j] : i;
+		}
+	}
+	for (int i = 0; i < 2; i++) {
+		field->R[i] = (float*)allocFieldArray(field->nPadded, sizeof(float));
+		field->G[i] = (float*)allocFieldArray(field->nPadded, sizeof(float));
+		field->B[i] = (float*)allocFieldArray(field->nPadded, sizeof(float));
+	}
+	field->current = 0;
+	field->rate = 0;
+	field->decay = 1;
+	field->base.R = field->base.G = field->base.B = 0;
+}
+
+void freeDiffusionField(DiffusionField_t* field) {
+	free(field->neighbors);
+	field->neighbors = NULL;
+	for (int i = 0; i < 2; i++) {
+		free(field->R[i]);
+		free(field->G[i]);
+		free(field->B[i]);
+		field->R[i] = field->G[i] = field->B[i] = NULL;
+	}
+	field->nPanels = 0;
+	field->nPadded = 0;
+	field->nSlots = 0;
+	field->panelIds = NULL;
+}
+
+void clearDiffusionField(DiffusionField_t* field) {
+	float* planes[N_CHANNELS] = {field->R[field->current], field->G[field->current], field->B[field->current]};
+	float base[N_CHANNELS] = {(float)field->base.R, (float)field->base.G, (float)field->base.B};
+	for (int c = 0; c < N_CHANNELS; c++) {
+		for (int i = 0; i < field->nPanels; i++) {
+			planes[c][i] = base[c];
+		}
+	}
+}
+
+void injectDiffusion(DiffusionField_t* field, int panel, int R, int G, int B, float amount) {
+	if (panel < 0 || panel >= field->nPanels) {
+		return;
+	}
+	float keep = 1.0f - amount;
+	int c = field->current;
+	field->R[c][panel] = field->R[c][panel] * keep + R * amount;
+	field->G[c][panel] = field->G[c][panel] * keep + G * amount;
+	field->B[c][panel] = field->B[c][panel] * keep + B * amount;
+}
+
+static void stepScalar(DiffusionField_t* field) {
+	int current = field->current;
+	const float* in[N_CHANNELS] = {field->R[current], field->G[current], field->B[current]};
+	float* out[N_CHANNELS] = {field->R[current ^ 1], field->G[current ^ 1], field->B[current ^ 1]};
+	float base[N_CHANNELS] = {(float)field->base.R, (float)field->base.G, (float)field->base.B};
+
+	for (int c = 0; c < N_CHANNELS; c++) {
+		for (int i = 0; i < field->nPanels; i++) {
+			float v = in[c][i];
+			float laplacian = 0.0f;
+			for (int s = 0; s < field->nSlots; s++) {
+				laplacian = laplacian + (in[c][field->neighbors[s * field->nPadded + i]] - v);
+			}
+			float next = v + field->rate * laplacian;
+			out[c][i] = base[c] + (next - base[c]) * field->decay;
+		}
+	}
+}
+
+#ifdef DIFFUSION_STEP_X86
+
+__attribute__((target("avx2")))
+static void stepAvx2(DiffusionField_t* field) {
+	const int width = 8;
+	int current = field->current;
+	const float* in[N_CHANNELS] = {field->R[current], field->G[current], field->B[current]};
+	float* out[N_CHANNELS] = {field->R[current ^ 1], field->G[current ^ 1], field->B[current ^ 1]};
+	float base[N_CHANNELS] = {(float)field->base.R, (float)field->base.G, (float)field->base.B};
+	const __m256 rate = _mm256_set1_ps(field->rate);
+	const __m256 decay = _mm256_set1_ps(field->decay);
+
+	for (int c = 0; c < N_CHANNELS; c++) {
+		const __m256 b = _mm256_set1_ps(base[c]);
+		for (int i = 0; i < field->nPanels; i += width) {
+			__m256 v = _mm256_load_ps(&in[c][i]);
+			__m256 laplacian = _mm256_setzero_ps();
+			for (int s = 0; s < field->nSlots; s++) {
+				__m256i index = _mm256_load_si256((const __m256i*)&field->neighbors[s * field->nPadded + i]);
+				__m256 n = _mm256_i32gather_ps(in[c], index, sizeof(float));
+				laplacian = _mm256_add_ps(laplacian, _mm256_sub_ps(n, v));
+			}
+			__m256 next = _mm256_add_ps(v, _mm256_mul_ps(rate, laplacian));
+			_mm256_store_ps(&out[c][i], _mm256_add_ps(b, _mm256_mul_ps(_mm256_sub_ps(next, b), decay)));
+		}
+	}
+}
+
+#endif
+
+void stepDiffusion(DiffusionField_t* field) {
+	if (stepFunction == NULL) {
+		selectDiffusionStep(DIFFUSION_STEP_AVX2);
+	}
+	stepFunction(field);
+	field->current ^= 1;
+}
+
+static inline int channelToInt(float c) {
+	if (c > MAX_CHANNEL_VALUE) {
+		c = MAX_CHANNEL_VALUE;
+	}
+	if (c < 0) {
+		c = 0;
+	}
+	return (int)c;
+}
+
+void renderDiffusion(const DiffusionField_t* field, int transTime, Frame_t* frames) {
+	int c = field->current;
+	for (int i = 0; i < field->nPanels; i++) {
+		frames[i].panelId = field->panelIds[i];
+		frames[i].r = channelToInt(field->R[c][i]);
+		frames[i].g = channelToInt(field->G[c][i]);
+		frames[i].b = channelToInt(field->B[c][i]);
+		frames[i].transTime = transTime;
+	}
+}
+
+int selectDiffusionStep(int implementation) {
+#ifdef DIFFUSION_STEP_X86
+	__builtin_cpu_init();
+	if (implementation >= DIFFUSION_STEP_AVX2 && __builtin_cpu_supports("avx2")) {
+		stepFunction = stepAvx2;
+		return DIFFUSION_STEP_AVX2;
+	}
+#endif
+	stepFunction = stepScalar;
+	return DIFFUSION_STEP_SCALAR;
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * FrameDiffer.cpp
+ */
+
+#include "FrameDiffer.h"
+#include <stdlib.h>
+
+void initFrameDiffer(FrameDiffer_t* differ, int threshold) {
+	differ->threshold = threshold;
+	differ->committed.clear();
+	differ->nEmitted = 0;
+	differ->nSuppressed = 0;
+}
+
+void resetFrameDiffer(FrameDiffer_t* differ) {
+	for (size_t i = 0; i < differ->committed.size(); i++) {
+		differ->committed[i].valid = false;
+	}
+}
+
+/**
+ * @description: the frame layout independent part of diffFrames and diffPackedFrames
+ */
+template <typename Frame>
+static int diff(FrameDiffer_t* differ, Frame* frames, int nFrames) {
+	int nKept = 0;
+	for (int i = 0; i < nFrames; i++) {
+		int id = frames[i].panelId;
+		if (id < 0) {
+			// not a panel the differ can track, always send it
+			frames[nKept++] = frames[i];
+			continue;
+		}
+		if (id >= (int)differ->committed.size()) {
+			CommittedFrame_t empty = {0, 0, 0, 0, false};
+			differ->committed.resize(id + 1, empty);
+		}
+		CommittedFrame_t* c = &differ->committed[id];
+		const Frame* f = &frames[i];
+		int threshold = differ->threshold;
+		if (c->valid && c->transTime == f->transTime && abs(c->r - f->r) <= threshold &&
+				abs(c->g - f->g) <= threshold && abs(c->b - f->b) <= threshold) {
+			continue;
+		}
+		c->r = f->r;
+		c->g = f->g;
+		c->b = f->b;
+		c->transTime = f->transTime;
+		c->valid = true;
+		frames[nKept++] = frames[i];
+	}
+	differ->nEmitted += nKept;
+	differ->nSuppressed += nFrames - nKept;
+	return nKept;
+}
+
+int diffFrames(FrameDiffer_t* differ, Frame_t* frames, int nFrames) {
+	return diff(differ, frames, nFrames);
+}
+
+int diffPackedFrames(FrameDiffer_t* differ, PackedFrame_t* frames, int nFrames) {
+	return diff(differ, frames, nFrames);
+}
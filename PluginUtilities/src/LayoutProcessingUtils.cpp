@@ -0,0 +1,734 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LayoutProcessingUtils.cpp
+ *
+ *  Created on: Feb 13, 2017
+ *      Author: eski
+ */
+
+#include "LayoutProcessingUtils.h"
+#include "Triangle.h"
+#include "Square.h"
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <unordered_map>
+
+#define SHAPE_TYPE_DIVISOR 256			/*the shape of a panel is encoded in its panelId*/
+#define SLICE_TOLERANCE 3.0				/*max distance between a centroid and the slice it is put into*/
+#define SLICE_STEP_DIVISOR_ROTATED 3.4641016	/*2*sqrt(3), for layouts that are not at a multiple of 60 degrees*/
+#define SLICE_STEP_DIVISOR 2.0
+#define GRID_BOUNDS_MARGIN 0.02			/*fraction of the side length, covers the tolerance of Shape::isPointInsideShape*/
+#define EDGE_MATCH_TOLERANCE 0.2		/*fraction of the side length that the midpoints of a shared edge may differ by*/
+
+struct SpatialBounds {
+	int maxX;
+	int minX;
+	int maxY;
+	int minY;
+	int maxXIndex;
+	int minXIndex;
+	int maxYIndex;
+	int minYIndex;
+	int xExpanse;
+	int yExpanse;
+};
+
+/**
+ * @description: mean of the centroids of all the panels
+ */
+Point getLayoutGeometricCenter(LayoutData* layoutData) {
+	double sumx = 0;
+	double sumy = 0;
+	int n = 0;
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		if (layoutData->panels[i].shape) {
+			sumx += layoutData->panels[i].shape->getCentroid().x;
+			sumy += layoutData->panels[i].shape->getCentroid().y;
+			n++;
+		}
+	}
+	if (n == 0) {
+		return Point(0, 0);
+	}
+	return Point(sumx / n, sumy / n);
+}
+
+/**
+ * @description: extremes of the centroids of the panels, and which panels they belong to
+ */
+SpatialBounds getBoundsOfAuroraSystem(Panel* layoutDataArray, int nPanels) {
+	SpatialBounds bounds;
+	bounds.maxX = INT_MIN;
+	bounds.minX = INT_MAX;
+	bounds.maxY = INT_MIN;
+	bounds.minY = INT_MAX;
+	bounds.maxXIndex = -1;
+	bounds.minXIndex = -1;
+	bounds.maxYIndex = -1;
+	bounds.minYIndex = -1;
+
+	for (int i = 0; i < nPanels; i++) {
+		if (layoutDataArray[i].shape == NULL) {
+			continue;
+		}
+		const Point& c = layoutDataArray[i].shape->getCentroid();
+		if (c.x > bounds.maxX) {
+			bounds.maxX = c.x;
+			bounds.maxXIndex = i;
+		}
+		if (c.x < bounds.minX) {
+			bounds.minX = c.x;
+			bounds.minXIndex = i;
+		}
+		if (c.y > bounds.maxY) {
+			bounds.maxY = c.y;
+			bounds.maxYIndex = i;
+		}
+		if (c.y < bounds.minY) {
+			bounds.minY = c.y;
+			bounds.minYIndex = i;
+		}
+	}
+	bounds.xExpanse = bounds.maxX - bounds.minX;
+	bounds.yExpanse = bounds.maxY - bounds.minY;
+	return bounds;
+}
+
+/**
+ * @description: round angle to the closest multiple of num
+ */
+int snapToNum(degrees angle, double num) {
+	return (int)(round(angle / num) * num);
+}
+
+void parseLayoutData(int* layoutDataByteStream, int nPanels, LayoutData** layoutData) {
+	if (nPanels < 0) {
+		nPanels = 0;
+	}
+	LayoutData* ld = new LayoutData;
+	ld->panels = new Panel[nPanels];
+
+	int idx = 0;
+	ld->globalOrientation = layoutDataByteStream[idx++];
+	Shape::sideLength = layoutDataByteStream[idx++];
+
+	for (int i = 0; i < nPanels; i++) {
+		int panelId = layoutDataByteStream[idx++];
+		Point centroid;
+		centroid.x = layoutDataByteStream[idx++];
+		centroid.y = layoutDataByteStream[idx++];
+		int orientation = layoutDataByteStream[idx++];
+		int shapeType = panelId / SHAPE_TYPE_DIVISOR;
+
+		// the Rhythm module is not a light, it is left out of the layout
+		if (shapeType == SHAPE_RHYTHM) {
+			continue;
+		}
+		ld->panels[i].panelId = panelId;
+		if (shapeType == SHAPE_TRIANGLE) {
+			ld->panels[i].shape = new Triangle(centroid, Shape::sideLength, orientation);
+		}
+		else if (shapeType == SHAPE_SQUARE) {
+			ld->panels[i].shape = new Square(centroid, Shape::sideLength, orientation);
+		}
+	}
+	ld->nPanels = nPanels;
+	ld->layoutGeometricCenter = getLayoutGeometricCenter(ld);
+	updatePanelCentroids(ld);
+	buildPanelAdjacency(ld);
+	*layoutData = ld;
+}
+
+int rotateAuroraPanels(LayoutData* layoutData, int *angle_degrees) {
+	*angle_degrees = snapToNum(*angle_degrees, 30);
+	int angle = *angle_degrees;
+
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		Shape* shape = layoutData->panels[i].shape;
+		if (shape == NULL) {
+			continue;
+		}
+		Point centroid = shape->getCentroid();
+		centroid = centroid.rotate(-angle);
+		int orientation = shape->getOrientation() - angle;
+		shape->updateShape(&centroid, &orientation);
+	}
+	layoutData->layoutGeometricCenter = getLayoutGeometricCenter(layoutData);
+	updatePanelCentroids(layoutData);
+	if (layoutData->panelGrid) {
+		buildPanelGrid(layoutData);
+	}
+	return 0;
+}
+
+/**
+ * @description: allocate an aligned array of n elements of size bytes, zero filled
+ */
+static void* allocPanelArray(int n, size_t size) {
+	void* p = NULL;
+	if (posix_memalign(&p, PANEL_ARRAY_ALIGNMENT, n * size) != 0) {
+		return NULL;
+	}
+	memset(p, 0, n * size);
+	return p;
+}
+
+static void computeEntryPanels(LayoutData* layoutData, EntryPanels_t* entry);
+
+void updatePanelCentroids(LayoutData* layoutData) {
+	PanelCentroids_t* c = &layoutData->centroids;
+	int nPadded = (layoutData->nPanels + PANEL_ARRAY_PADDING - 1) / PANEL_ARRAY_PADDING * PANEL_ARRAY_PADDING;
+	if (nPadded == 0) {
+		nPadded = PANEL_ARRAY_PADDING;
+	}
+	if (c->nPadded != nPadded) {
+		free(c->panelIds);
+		free(c->x);
+		free(c->y);
+		c->panelIds = (int*)allocPanelArray(nPadded, sizeof(int));
+		c->x = (float*)allocPanelArray(nPadded, sizeof(float));
+		c->y = (float*)allocPanelArray(nPadded, sizeof(float));
+		c->nPadded = nPadded;
+	}
+	c->nPanels = layoutData->nPanels;
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		Panel* panel = &layoutData->panels[i];
+		c->panelIds[i] = panel->panelId;
+		if (panel->shape) {
+			c->x[i] = panel->shape->getCentroid().x;
+			c->y[i] = panel->shape->getCentroid().y;
+		}
+		else {
+			c->x[i] = 0;
+			c->y[i] = 0;
+		}
+	}
+	if (layoutData->entryPanelCache) {
+		std::vector<EntryPanels_t*>& entries = layoutData->entryPanelCache->entries;
+		for (size_t e = 0; e < entries.size(); e++) {
+			computeEntryPanels(layoutData, entries[e]);
+		}
+	}
+}
+
+/**
+ * @description: split the panels into vertical slices spaced by a fraction of the side length,
+ * every panel is put into the first slice whose x is within SLICE_TOLERANCE of its centroid
+ * @params x: x coordinate of the centroid of every panel
+ * @params hasShape: false for the panels that have no centroid
+ * @params sliceOfPanel: filled with the slice of every panel, -1 if it is in none
+ * @return: the number of slices
+ */
+static int assignSlices(const double* x, const unsigned char* hasShape, int nPanels, int rotation, int* sliceOfPanel) {
+	// the bounds are whole numbers, as in getBoundsOfAuroraSystem
+	int maxX = INT_MIN;
+	int minX = INT_MAX;
+	int minXIndex = -1;
+	for (int i = 0; i < nPanels; i++) {
+		sliceOfPanel[i] = -1;
+		if (!hasShape[i]) {
+			continue;
+		}
+		if (x[i] > maxX) {
+			maxX = x[i];
+		}
+		if (x[i] < minX) {
+			minX = x[i];
+			minXIndex = i;
+		}
+	}
+	if (minXIndex < 0) {
+		return 0;
+	}
+
+	double step;
+	int n;
+	if (rotation % 60 != 0) {
+		step = Shape::sideLength / SLICE_STEP_DIVISOR_ROTATED;
+		n = (int)((maxX - minX) / floor(step) + 1.0);
+	}
+	else {
+		step = Shape::sideLength / SLICE_STEP_DIVISOR;
+		n = (int)((maxX - minX) / floor(step) + 2.0);
+	}
+	if (n < 1) {
+		n = 1;
+	}
+
+	double startX = x[minXIndex];
+	for (int i = 0; i < nPanels; i++) {
+		if (!hasShape[i]) {
+			continue;
+		}
+		int first = 0;
+		int last = n - 1;
+		if (step > 2 * SLICE_TOLERANCE) {
+			// slices are further apart than twice the tolerance, only the nearest one can match
+			int j = (int)floor((x[i] - startX) / step + 0.5);
+			first = j - 1 < 0 ? 0 : j - 1;
+			last = j + 1 > n - 1 ? n - 1 : j + 1;
+		}
+		for (int j = first; j <= last; j++) {
+			if (fabs(startX + j * step - x[i]) <= SLICE_TOLERANCE) {
+				sliceOfPanel[i] = j;
+				break;
+			}
+		}
+	}
+	return n;
+}
+
+void getSimpleFramesFromLayout(LayoutData* layoutData, FrameSlice_t** frameSlices, int* nFrameSlices, int rotation) {
+	int nPanels = layoutData->nPanels;
+	std::vector<double> x(nPanels > 0 ? nPanels : 1);
+	std::vector<unsigned char> hasShape(nPanels > 0 ? nPanels : 1);
+	std::vector<int> sliceOfPanel(nPanels > 0 ? nPanels : 1);
+	for (int i = 0; i < nPanels; i++) {
+		Shape* shape = layoutData->panels[i].shape;
+		hasShape[i] = shape != NULL;
+		x[i] = shape ? shape->getCentroid().x : 0;
+	}
+	int n = assignSlices(x.data(), hasShape.data(), nPanels, rotation, sliceOfPanel.data());
+	if (n <= 0) {
+		*frameSlices = NULL;
+		*nFrameSlices = 0;
+		return;
+	}
+
+	FrameSlice_t* slices = new FrameSlice_t[n];
+	for (int i = 0; i < nPanels; i++) {
+		if (sliceOfPanel[i] >= 0) {
+			slices[sliceOfPanel[i]].panelIds.push_back(layoutData->panels[i].panelId);
+		}
+	}
+	*frameSlices = slices;
+	*nFrameSlices = n;
+}
+
+void getFrameSlicesFromLayoutForTriangle(LayoutData* layoutData, FrameSlice_t** frameSlices, int* nFrameSlices, int totalAuroraRotation) {
+	getSimpleFramesFromLayout(layoutData, frameSlices, nFrameSlices, totalAuroraRotation);
+}
+
+void buildFrameSliceSet(LayoutData* layoutData, int totalAuroraRotation, FrameSliceSet_t* sliceSet) {
+	int nPanels = layoutData->nPanels;
+	std::vector<double> x(nPanels > 0 ? nPanels : 1);
+	std::vector<unsigned char> hasShape(nPanels > 0 ? nPanels : 1);
+	std::vector<int> sliceOfPanel(nPanels > 0 ? nPanels : 1);
+	std::vector<int> counts;
+	for (int i = 0; i < nPanels; i++) {
+		hasShape[i] = layoutData->panels[i].shape != NULL;
+	}
+
+	sliceSet->baseRotation = totalAuroraRotation;
+	sliceSet->sliceOffsets.clear();
+	sliceSet->panelIds.clear();
+	for (int r = 0; r < N_SNAPPED_ROTATIONS; r++) {
+		int angle = r * SNAPPED_ROTATION_STEP;
+		// the centroids as rotateAuroraPanels would leave them after rotating through angle
+		for (int i = 0; i < nPanels; i++) {
+			Shape* shape = layoutData->panels[i].shape;
+			if (shape) {
+				Point c = shape->getCentroid();
+				x[i] = r == 0 ? c.x : c.rotate(-angle).x;
+			}
+		}
+		int n = assignSlices(x.data(), hasShape.data(), nPanels, totalAuroraRotation + angle,
+				sliceOfPanel.data());
+
+		// bucket the panels of this rotation by slice, keeping layout order inside a slice
+		int firstSlice = sliceSet->sliceOffsets.size();
+		int firstPanel = sliceSet->panelIds.size();
+		sliceSet->rotationOffsets[r] = firstSlice;
+		counts.assign(n + 1, 0);
+		for (int i = 0; i < nPanels; i++) {
+			if (sliceOfPanel[i] >= 0) {
+				counts[sliceOfPanel[i] + 1]++;
+			}
+		}
+		for (int s = 0; s < n; s++) {
+			counts[s + 1] += counts[s];
+		}
+		for (int s = 0; s < n; s++) {
+			sliceSet->sliceOffsets.push_back(firstPanel + counts[s]);
+		}
+		sliceSet->panelIds.resize(firstPanel + counts[n]);
+		for (int i = 0; i < nPanels; i++) {
+			if (sliceOfPanel[i] >= 0) {
+				sliceSet->panelIds[firstPanel + counts[sliceOfPanel[i]]++] = layoutData->panels[i].panelId;
+			}
+		}
+	}
+	sliceSet->rotationOffsets[N_SNAPPED_ROTATIONS] = sliceSet->sliceOffsets.size();
+	// closes the last slice of the last rotation
+	sliceSet->sliceOffsets.push_back(sliceSet->panelIds.size());
+}
+
+FrameSliceView_t getFrameSliceView(const FrameSliceSet_t* sliceSet, int angle_degrees) {
+	int r = snapToNum(angle_degrees, SNAPPED_ROTATION_STEP) / SNAPPED_ROTATION_STEP % N_SNAPPED_ROTATIONS;
+	if (r < 0) {
+		r += N_SNAPPED_ROTATIONS;
+	}
+	FrameSliceView_t view;
+	view.rotation = (sliceSet->baseRotation + r * SNAPPED_ROTATION_STEP) % 360;
+	view.nSlices = sliceSet->rotationOffsets[r + 1] - sliceSet->rotationOffsets[r];
+	view.sliceOffsets = sliceSet->sliceOffsets.data() + sliceSet->rotationOffsets[r];
+	view.panelIds = sliceSet->panelIds.data();
+	return view;
+}
+
+bool isPointInsidePanel(Panel* panel, Point p) {
+	if (panel->shape == NULL) {
+		return false;
+	}
+	return panel->shape->isPointInsideShape(p);
+}
+
+/**
+ * @description: bounding box of the vertices of a shape, grown by the margin
+ */
+static void getShapeBounds(Shape* shape, float margin, float* minX, float* minY, float* maxX, float* maxY) {
+	*minX = *maxX = shape->vertices[0].x;
+	*minY = *maxY = shape->vertices[0].y;
+	for (int v = 1; v < shape->nVertices; v++) {
+		*minX = fminf(*minX, shape->vertices[v].x);
+		*maxX = fmaxf(*maxX, shape->vertices[v].x);
+		*minY = fminf(*minY, shape->vertices[v].y);
+		*maxY = fmaxf(*maxY, shape->vertices[v].y);
+	}
+	*minX -= margin;
+	*minY -= margin;
+	*maxX += margin;
+	*maxY += margin;
+}
+
+static inline int getGridCell(const PanelGrid_t* grid, float v, float min, int n) {
+	int c = (int)floorf((v - min) / grid->cellSize);
+	return c < 0 ? 0 : (c >= n ? n - 1 : c);
+}
+
+void buildPanelGrid(LayoutData* layoutData) {
+	if (layoutData->panelGrid == NULL) {
+		layoutData->panelGrid = new PanelGrid_t;
+	}
+	PanelGrid_t* grid = layoutData->panelGrid;
+	float margin = Shape::sideLength * GRID_BOUNDS_MARGIN + 1.0f;
+	float minX = 0, minY = 0, maxX = 0, maxY = 0;
+	bool first = true;
+
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		Shape* shape = layoutData->panels[i].shape;
+		if (shape == NULL || shape->nVertices == 0) {
+			continue;
+		}
+		float x0, y0, x1, y1;
+		getShapeBounds(shape, margin, &x0, &y0, &x1, &y1);
+		if (first) {
+			minX = x0;
+			minY = y0;
+			maxX = x1;
+			maxY = y1;
+			first = false;
+		}
+		minX = fminf(minX, x0);
+		minY = fminf(minY, y0);
+		maxX = fmaxf(maxX, x1);
+		maxY = fmaxf(maxY, y1);
+	}
+
+	// one cell per side length keeps the number of panels overlapping a cell small and constant
+	grid->cellSize = Shape::sideLength > 0 ? Shape::sideLength : 1;
+	grid->minX = minX;
+	grid->minY = minY;
+	grid->nColumns = (int)((maxX - minX) / grid->cellSize) + 1;
+	grid->nRows = (int)((maxY - minY) / grid->cellSize) + 1;
+	int nCells = grid->nColumns * grid->nRows;
+
+	// count the panels of every cell, turn the counts into offsets, then fill in the panels in layout order
+	grid->cellOffsets.assign(nCells + 1, 0);
+	for (int pass = 0; pass < 2; pass++) {
+		std::vector<int> next;
+		if (pass == 1) {
+			for (int c = 0; c < nCells; c++) {
+				grid->cellOffsets[c + 1] += grid->cellOffsets[c];
+			}
+			grid->cellPanels.assign(grid->cellOffsets[nCells], 0);
+			next.assign(grid->cellOffsets.begin(), grid->cellOffsets.end() - 1);
+		}
+		for (int i = 0; i < layoutData->nPanels; i++) {
+			Shape* shape = layoutData->panels[i].shape;
+			if (shape == NULL || shape->nVertices == 0) {
+				continue;
+			}
+			float x0, y0, x1, y1;
+			getShapeBounds(shape, margin, &x0, &y0, &x1, &y1);
+			int c0 = getGridCell(grid, x0, grid->minX, grid->nColumns);
+			int c1 = getGridCell(grid, x1, grid->minX, grid->nColumns);
+			int r0 = getGridCell(grid, y0, grid->minY, grid->nRows);
+			int r1 = getGridCell(grid, y1, grid->minY, grid->nRows);
+			for (int r = r0; r <= r1; r++) {
+				for (int c = c0; c <= c1; c++) {
+					int cell = r * grid->nColumns + c;
+					if (pass == 0) {
+						grid->cellOffsets[cell + 1]++;
+					}
+					else {
+						grid->cellPanels[next[cell]++] = i;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @description: the panel under p using the grid, the first matching panel in layout order like the linear search
+ */
+static int pointInsideWhichPanelOfGrid(LayoutData* layoutData, const PanelGrid_t* grid, Point p) {
+	float column = (p.x - grid->minX) / grid->cellSize;
+	float row = (p.y - grid->minY) / grid->cellSize;
+	if (!(column >= 0 && row >= 0 && column < grid->nColumns && row < grid->nRows)) {
+		return -1;
+	}
+	int cell = (int)row * grid->nColumns + (int)column;
+	for (int j = grid->cellOffsets[cell]; j < grid->cellOffsets[cell + 1]; j++) {
+		Panel* panel = &layoutData->panels[grid->cellPanels[j]];
+		if (panel->shape->isPointInsideShape(p)) {
+			return panel->panelId;
+		}
+	}
+	return -1;
+}
+
+int pointInsideWhichPanel(LayoutData* layoutData, Point p) {
+	if (layoutData->panelGrid) {
+		return pointInsideWhichPanelOfGrid(layoutData, layoutData->panelGrid, p);
+	}
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		if (isPointInsidePanel(&layoutData->panels[i], p)) {
+			return layoutData->panels[i].panelId;
+		}
+	}
+	return -1;
+}
+
+void pointsInsideWhichPanels(LayoutData* layoutData, const Point* points, int nPoints, int* panelIds) {
+	const PanelGrid_t* grid = layoutData->panelGrid;
+	for (int i = 0; i < nPoints; i++) {
+		if (grid) {
+			panelIds[i] = pointInsideWhichPanelOfGrid(layoutData, grid, points[i]);
+		}
+		else {
+			panelIds[i] = pointInsideWhichPanel(layoutData, points[i]);
+		}
+	}
+}
+
+/**
+ * The midpoint of an edge of a panel, for matching it with the same edge of the neighbouring panel
+ */
+struct PanelEdge_t {
+	double x;
+	double y;
+	int panel;
+	int next;			/*next edge in the same hash cell, -1 at the end*/
+};
+
+static inline long long getEdgeCell(long long column, long long row) {
+	return (column << 32) ^ (row & 0xffffffffLL);
+}
+
+void buildPanelAdjacency(LayoutData* layoutData) {
+	PanelAdjacency_t* adjacency = &layoutData->adjacency;
+	int nPanels = layoutData->nPanels;
+	double tolerance = (Shape::sideLength > 0 ? Shape::sideLength : 1) * EDGE_MATCH_TOLERANCE;
+
+	// hash the midpoint of every edge into cells as large as the tolerance, a matching midpoint is in one of the 3x3
+	// cells around it. The midpoints of the edges of a panel are at least half a side apart, so a cell holds very few
+	std::vector<PanelEdge_t> edges;
+	std::unordered_map<long long, int> cells;
+	std::vector<std::pair<int, int> > pairs;
+	edges.reserve(nPanels * 4);
+	cells.reserve(nPanels * 4);
+	pairs.reserve(nPanels * 4);
+	for (int i = 0; i < nPanels; i++) {
+		Shape* shape = layoutData->panels[i].shape;
+		if (shape == NULL) {
+			continue;
+		}
+		for (int v = 0; v < shape->nVertices; v++) {
+			const Point& a = shape->vertices[v];
+			const Point& b = shape->vertices[(v + 1) % shape->nVertices];
+			PanelEdge_t edge;
+			edge.x = (a.x + b.x) / 2.0;
+			edge.y = (a.y + b.y) / 2.0;
+			edge.panel = i;
+			long long column = (long long)floor(edge.x / tolerance);
+			long long row = (long long)floor(edge.y / tolerance);
+			for (long long c = column - 1; c <= column + 1; c++) {
+				for (long long r = row - 1; r <= row + 1; r++) {
+					std::unordered_map<long long, int>::const_iterator cell = cells.find(getEdgeCell(c, r));
+					for (int e = cell == cells.end() ? -1 : cell->second; e >= 0; e = edges[e].next) {
+						if (edges[e].panel != i && fabs(edges[e].x - edge.x) < tolerance &&
+								fabs(edges[e].y - edge.y) < tolerance) {
+							pairs.push_back(std::make_pair(i, edges[e].panel));
+							pairs.push_back(std::make_pair(edges[e].panel, i));
+						}
+					}
+				}
+			}
+			std::pair<std::unordered_map<long long, int>::iterator, bool> inserted =
+					cells.insert(std::make_pair(getEdgeCell(column, row), (int)edges.size()));
+			edge.next = inserted.second ? -1 : inserted.first->second;
+			inserted.first->second = (int)edges.size();
+			edges.push_back(edge);
+		}
+	}
+
+	// count the neighbours of every panel, turn the counts into offsets, then fill them in
+	adjacency->offsets.assign(nPanels + 1, 0);
+	for (size_t p = 0; p < pairs.size(); p++) {
+		adjacency->offsets[pairs[p].first + 1]++;
+	}
+	for (int i = 0; i < nPanels; i++) {
+		adjacency->offsets[i + 1] += adjacency->offsets[i];
+	}
+	adjacency->neighbors.assign(pairs.size(), 0);
+	std::vector<int> next(adjacency->offsets.begin(), adjacency->offsets.end() - 1);
+	for (size_t p = 0; p < pairs.size(); p++) {
+		adjacency->neighbors[next[pairs[p].first]++] = pairs[p].second;
+	}
+	double sum = 0;
+	for (int i = 0; i < nPanels; i++) {
+		std::sort(adjacency->neighbors.begin() + adjacency->offsets[i], adjacency->neighbors.begin() + adjacency->offsets[i + 1]);
+		for (int j = adjacency->offsets[i]; j < adjacency->offsets[i + 1]; j++) {
+			const Point& p1 = layoutData->panels[i].shape->getCentroid();
+			const Point& p2 = layoutData->panels[adjacency->neighbors[j]].shape->getCentroid();
+			sum += Point::distance(p1, p2);
+		}
+	}
+
+	// without any neighbours, take the distance between the centroids of two regular panels of the first shape that
+	// would share an edge: twice the radius of its incircle
+	if (pairs.size() > 0) {
+		adjacency->adjacentDistance = sum / pairs.size();
+	}
+	else {
+		adjacency->adjacentDistance = Shape::sideLength;
+		for (int i = 0; i < nPanels; i++) {
+			Shape* shape = layoutData->panels[i].shape;
+			if (shape && shape->nVertices > 0) {
+				adjacency->adjacentDistance = 4.0 * shape->area / (shape->nVertices * Shape::sideLength);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * A panel projected onto the direction of travel (along) and onto the perpendicular to it (across)
+ */
+struct PanelProjection_t {
+	double across;
+	double along;
+	int panel;
+	bool operator<(const PanelProjection_t& p) const {
+		return across < p.across || (across == p.across && panel < p.panel);
+	}
+};
+
+/**
+ * @description: fill entry->panels for the current centroids of the layout. Sorting by the across coordinate puts the
+ * panels of a lane next to each other, a lane ends where the gap to the next panel is at least the lane width
+ */
+static void computeEntryPanels(LayoutData* layoutData, EntryPanels_t* entry) {
+	const PanelCentroids_t* c = &layoutData->centroids;
+	radians theta = degs2rads(entry->directionDegrees);
+	double dx = cos(theta);
+	double dy = sin(theta);
+
+	std::vector<PanelProjection_t> projections;
+	projections.reserve(layoutData->nPanels);
+	for (int i = 0; i < layoutData->nPanels; i++) {
+		if (layoutData->panels[i].shape == NULL) {
+			continue;
+		}
+		PanelProjection_t p;
+		p.across = c->x[i] * dy - c->y[i] * dx;
+		p.along = c->x[i] * dx + c->y[i] * dy;
+		p.panel = i;
+		projections.push_back(p);
+	}
+	std::sort(projections.begin(), projections.end());
+
+	// per lane, its lowest panel index and its entry panel, the furthest back along the direction
+	std::vector<std::pair<int, int> > lanes;
+	double entryAlong = 0;
+	for (size_t k = 0; k < projections.size(); k++) {
+		const PanelProjection_t& p = projections[k];
+		if (k == 0 || p.across - projections[k - 1].across >= entry->laneWidth) {
+			lanes.push_back(std::make_pair(p.panel, p.panel));
+			entryAlong = p.along;
+			continue;
+		}
+		std::pair<int, int>& lane = lanes.back();
+		lane.first = std::min(lane.first, p.panel);
+		if (p.along < entryAlong || (p.along == entryAlong && p.panel < lane.second)) {
+			lane.second = p.panel;
+			entryAlong = p.along;
+		}
+	}
+	std::sort(lanes.begin(), lanes.end());
+
+	entry->panels.resize(lanes.size());
+	for (size_t l = 0; l < lanes.size(); l++) {
+		entry->panels[l] = lanes[l].second;
+	}
+}
+
+const EntryPanels_t* getEntryPanels(LayoutData* layoutData, double directionDegrees, float laneWidth) {
+	if (layoutData->entryPanelCache == NULL) {
+		layoutData->entryPanelCache = new EntryPanelCache_t;
+	}
+	std::vector<EntryPanels_t*>& entries = layoutData->entryPanelCache->entries;
+	for (size_t e = 0; e < entries.size(); e++) {
+		if (entries[e]->directionDegrees == directionDegrees && entries[e]->laneWidth == laneWidth) {
+			return entries[e];
+		}
+	}
+	EntryPanels_t* entry = new EntryPanels_t;
+	entry->directionDegrees = directionDegrees;
+	entry->laneWidth = laneWidth;
+	computeEntryPanels(layoutData, entry);
+	entries.push_back(entry);
+	return entry;
+}
+
+void freeLayoutData(LayoutData* layoutData) {
+	if (layoutData) {
+		delete layoutData;
+	}
+}
+
+void freeFrameSlices(FrameSlice_t* frameSlices) {
+	if (frameSlices) {
+		delete [] frameSlices;
+	}
+}
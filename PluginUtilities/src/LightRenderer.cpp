@@ -0,0 +1,250 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * LightRenderer.cpp
+ *
+ *  All implementations evaluate the same float expressions in the same order and do not contract
+ *  them into fused multiply-adds, so they give the same results.
+ */
+
+#include "LightRenderer.h"
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIGHT_RENDERER_X86
+#include <immintrin.h>
+#endif
+
+#define MAX_CHANNEL_VALUE 255.0f
+#define N_CHANNELS 3
+
+typedef void (*RenderFunction_t)(const PanelCentroids_t* centroids, const LightSources_t* sources,
+		const LightFalloff_t* falloff, RGB_t base, int transTime, Frame_t* frames);
+
+static int activeRenderer = -1;
+static RenderFunction_t renderFunction = NULL;
+
+void clearLightSources(LightSources_t* sources) {
+	sources->nSources = 0;
+}
+
+int addLightSource(LightSources_t* sources, float x, float y, int R, int G, int B) {
+	if (sources->nSources >= MAX_LIGHT_SOURCES) {
+		return -1;
+	}
+	int i = sources->nSources++;
+	sources->x[i] = x;
+	sources->y[i] = y;
+	sources->R[i] = R;
+	sources->G[i] = G;
+	sources->B[i] = B;
+	sources->offset[i] = 0;
+	sources->gain[i] = 1;
+	sources->minFactor[i] = 0;
+	return i;
+}
+
+static inline int channelToInt(float c) {
+	if (c > MAX_CHANNEL_VALUE) {
+		c = MAX_CHANNEL_VALUE;
+	}
+	if (c < 0) {
+		c = 0;
+	}
+	return (int)c;
+}
+
+static void renderScalar(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int transTime, Frame_t* frames) {
+	bool linear = falloff->type == LIGHT_FALLOFF_INVERSE_LINEAR;
+	for (int p = 0; p < centroids->nPanels; p++) {
+		float R = base.R;
+		float G = base.G;
+		float B = base.B;
+		for (int i = 0; i < sources->nSources; i++) {
+			float dx = centroids->x[p] - sources->x[i];
+			float dy = centroids->y[p] - sources->y[i];
+			float u = sqrtf(dx * dx + dy * dy) * falloff->distanceScale - sources->offset[i];
+			float den;
+			if (linear) {
+				u = u > 0.0f ? u : 0.0f;
+				den = falloff->k * u + 1.0f;
+			}
+			else {
+				den = falloff->k * (u * u) + 1.0f;
+			}
+			float f = 1.0f / den;
+			f = f < 1.0f ? f : 1.0f;
+			f = f * sources->gain[i];
+			f = f > sources->minFactor[i] ? f : sources->minFactor[i];
+			float keep = 1.0f - f;
+			R = R * keep + sources->R[i] * f;
+			G = G * keep + sources->G[i] * f;
+			B = B * keep + sources->B[i] * f;
+		}
+		frames[p].panelId = centroids->panelIds[p];
+		frames[p].r = channelToInt(R);
+		frames[p].g = channelToInt(G);
+		frames[p].b = channelToInt(B);
+		frames[p].transTime = transTime;
+	}
+}
+
+#ifdef LIGHT_RENDERER_X86
+
+/**
+ * @description: copy a block of rendered channels into the frames, the last block of the layout may be partial
+ */
+static inline void storeFrames(const PanelCentroids_t* centroids, int p, int n, const int* r, const int* g, const int* b,
+		int transTime, Frame_t* frames) {
+	if (n > centroids->nPanels - p) {
+		n = centroids->nPanels - p;
+	}
+	for (int j = 0; j < n; j++) {
+		frames[p + j].panelId = centroids->panelIds[p + j];
+		frames[p + j].r = r[j];
+		frames[p + j].g = g[j];
+		frames[p + j].b = b[j];
+		frames[p + j].transTime = transTime;
+	}
+}
+
+__attribute__((target("sse2")))
+static void renderSse2(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int transTime, Frame_t* frames) {
+	const int width = 4;
+	bool linear = falloff->type == LIGHT_FALLOFF_INVERSE_LINEAR;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 maxChannel = _mm_set1_ps(MAX_CHANNEL_VALUE);
+	const __m128 scale = _mm_set1_ps(falloff->distanceScale);
+	const __m128 k = _mm_set1_ps(falloff->k);
+	alignas(16) int r[width], g[width], b[width];
+
+	for (int p = 0; p < centroids->nPanels; p += width) {
+		__m128 px = _mm_load_ps(&centroids->x[p]);
+		__m128 py = _mm_load_ps(&centroids->y[p]);
+		__m128 R = _mm_set1_ps(base.R);
+		__m128 G = _mm_set1_ps(base.G);
+		__m128 B = _mm_set1_ps(base.B);
+		for (int i = 0; i < sources->nSources; i++) {
+			__m128 dx = _mm_sub_ps(px, _mm_set1_ps(sources->x[i]));
+			__m128 dy = _mm_sub_ps(py, _mm_set1_ps(sources->y[i]));
+			__m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+			__m128 u = _mm_sub_ps(_mm_mul_ps(d, scale), _mm_set1_ps(sources->offset[i]));
+			__m128 den;
+			if (linear) {
+				u = _mm_max_ps(u, zero);
+				den = _mm_add_ps(_mm_mul_ps(k, u), one);
+			}
+			else {
+				den = _mm_add_ps(_mm_mul_ps(k, _mm_mul_ps(u, u)), one);
+			}
+			__m128 f = _mm_min_ps(_mm_div_ps(one, den), one);
+			f = _mm_max_ps(_mm_mul_ps(f, _mm_set1_ps(sources->gain[i])), _mm_set1_ps(sources->minFactor[i]));
+			__m128 keep = _mm_sub_ps(one, f);
+			R = _mm_add_ps(_mm_mul_ps(R, keep), _mm_mul_ps(_mm_set1_ps(sources->R[i]), f));
+			G = _mm_add_ps(_mm_mul_ps(G, keep), _mm_mul_ps(_mm_set1_ps(sources->G[i]), f));
+			B = _mm_add_ps(_mm_mul_ps(B, keep), _mm_mul_ps(_mm_set1_ps(sources->B[i]), f));
+		}
+		_mm_store_si128((__m128i*)r, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(R, maxChannel), zero)));
+		_mm_store_si128((__m128i*)g, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(G, maxChannel), zero)));
+		_mm_store_si128((__m128i*)b, _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(B, maxChannel), zero)));
+		storeFrames(centroids, p, width, r, g, b, transTime, frames);
+	}
+}
+
+__attribute__((target("avx2")))
+static void renderAvx2(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int transTime, Frame_t* frames) {
+	const int width = 8;
+	bool linear = falloff->type == LIGHT_FALLOFF_INVERSE_LINEAR;
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 maxChannel = _mm256_set1_ps(MAX_CHANNEL_VALUE);
+	const __m256 scale = _mm256_set1_ps(falloff->distanceScale);
+	const __m256 k = _mm256_set1_ps(falloff->k);
+	alignas(32) int r[width], g[width], b[width];
+
+	for (int p = 0; p < centroids->nPanels; p += width) {
+		__m256 px = _mm256_load_ps(&centroids->x[p]);
+		__m256 py = _mm256_load_ps(&centroids->y[p]);
+		__m256 R = _mm256_set1_ps(base.R);
+		__m256 G = _mm256_set1_ps(base.G);
+		__m256 B = _mm256_set1_ps(base.B);
+		for (int i = 0; i < sources->nSources; i++) {
+			__m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(sources->x[i]));
+			__m256 dy = _mm256_sub_ps(py, _mm256_set1_ps(sources->y[i]));
+			__m256 d = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+			__m256 u = _mm256_sub_ps(_mm256_mul_ps(d, scale), _mm256_set1_ps(sources->offset[i]));
+			__m256 den;
+			if (linear) {
+				u = _mm256_max_ps(u, zero);
+				den = _mm256_add_ps(_mm256_mul_ps(k, u), one);
+			}
+			else {
+				den = _mm256_add_ps(_mm256_mul_ps(k, _mm256_mul_ps(u, u)), one);
+			}
+			__m256 f = _mm256_min_ps(_mm256_div_ps(one, den), one);
+			f = _mm256_max_ps(_mm256_mul_ps(f, _mm256_set1_ps(sources->gain[i])), _mm256_set1_ps(sources->minFactor[i]));
+			__m256 keep = _mm256_sub_ps(one, f);
+			R = _mm256_add_ps(_mm256_mul_ps(R, keep), _mm256_mul_ps(_mm256_set1_ps(sources->R[i]), f));
+			G = _mm256_add_ps(_mm256_mul_ps(G, keep), _mm256_mul_ps(_mm256_set1_ps(sources->G[i]), f));
+			B = _mm256_add_ps(_mm256_mul_ps(B, keep), _mm256_mul_ps(_mm256_set1_ps(sources->B[i]), f));
+		}
+		_mm256_store_si256((__m256i*)r, _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(R, maxChannel), zero)));
+		_mm256_store_si256((__m256i*)g, _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(G, maxChannel), zero)));
+		_mm256_store_si256((__m256i*)b, _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(B, maxChannel), zero)));
+		storeFrames(centroids, p, width, r, g, b, transTime, frames);
+	}
+}
+
+#endif
+
+int selectLightRenderer(int renderer) {
+#ifdef LIGHT_RENDERER_X86
+	__builtin_cpu_init();
+	if (renderer >= LIGHT_RENDERER_AVX2 && __builtin_cpu_supports("avx2")) {
+		renderFunction = renderAvx2;
+		activeRenderer = LIGHT_RENDERER_AVX2;
+		return activeRenderer;
+	}
+	if (renderer >= LIGHT_RENDERER_SSE2 && __builtin_cpu_supports("sse2")) {
+		renderFunction = renderSse2;
+		activeRenderer = LIGHT_RENDERER_SSE2;
+		return activeRenderer;
+	}
+#endif
+	renderFunction = renderScalar;
+	activeRenderer = LIGHT_RENDERER_SCALAR;
+	return activeRenderer;
+}
+
+int getLightRenderer(void) {
+	if (renderFunction == NULL) {
+		selectLightRenderer(LIGHT_RENDERER_AVX2);
+	}
+	return activeRenderer;
+}
+
+void renderLightSources(const PanelCentroids_t* centroids, const LightSources_t* sources, const LightFalloff_t* falloff,
+		RGB_t base, int transTime, Frame_t* frames) {
+	if (renderFunction == NULL) {
+		selectLightRenderer(LIGHT_RENDERER_AVX2);
+	}
+	renderFunction(centroids, sources, falloff, base, transTime, frames);
+}
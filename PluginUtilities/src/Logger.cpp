@@ -0,0 +1,366 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+/*
+ * Logger.cpp
+ *
+ *  The ring is a bounded queue in the style of Vyukov: every slot carries a sequence number
+ *  that tells producers when it is free and the drainer when it is filled. Producers claim a slot
+ *  with one compare and swap on the enqueue position, so any thread may log. There is only one
+ *  consumer, the drainer thread, which is started by the first record and joined when the library
+ *  is unloaded.
+ */
+
+#include "Logger.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_LINE_LENGTH 512
+#define LOG_DRAIN_SLEEP_MS 1
+
+/**
+ * A queued log call. String arguments live in strings, their arg holds the offset
+ */
+struct LogRecord_t {
+	const char* format;
+	int level;
+	int nArgs;
+	uint32_t nSuppressed;
+	LogArg_t args[LOG_MAX_ARGS];
+	char strings[LOG_STRING_BYTES];
+};
+
+struct LogSlot_t {
+	std::atomic<uint64_t> sequence;
+	LogRecord_t record;
+};
+
+static LogSlot_t ring[LOG_RING_SIZE];
+static std::atomic<uint64_t> enqueuePos(0);
+static std::atomic<uint64_t> dequeuePos(0);
+static std::atomic<uint64_t> dropCount(0);
+static std::atomic<bool> drainerStarted(false);
+static std::once_flag drainerOnce;
+
+static uint64_t monotonicMs(void) {
+	struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool allowLog(LogSite_t* site) {
+	uint64_t now = monotonicMs();
+	if (site->tokens >= site->burst || site->lastRefillMs == 0) {
+		site->lastRefillMs = now;
+	}
+	else if (site->ratePerSec > 0) {
+		uint64_t refill = (now - site->lastRefillMs) * site->ratePerSec / 1000;
+		if (refill > 0) {
+			site->tokens = refill >= (uint64_t)(site->burst - site->tokens) ? site->burst : site->tokens + (int)refill;
+			site->lastRefillMs += refill * 1000 / site->ratePerSec;
+		}
+	}
+	if (site->tokens > 0) {
+		site->tokens--;
+		return true;
+	}
+	site->nSuppressed++;
+	return false;
+}
+
+static long long argAsInt(const LogArg_t& arg) {
+	switch (arg.type) {
+	case LOG_ARG_UINT:
+		return (long long)arg.u;
+	case LOG_ARG_DOUBLE:
+		return (long long)arg.d;
+	case LOG_ARG_POINTER:
+		return (long long)(intptr_t)arg.p;
+	case LOG_ARG_STRING:
+		return 0;
+	default:
+		return arg.i;
+	}
+}
+
+static double argAsDouble(const LogArg_t& arg) {
+	switch (arg.type) {
+	case LOG_ARG_INT:
+		return (double)arg.i;
+	case LOG_ARG_UINT:
+		return (double)arg.u;
+	case LOG_ARG_DOUBLE:
+		return arg.d;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @description: printf a record into a line, one conversion at a time with the type it was captured as
+ * @return: length of the line, truncated to size - 1
+ */
+static int formatRecord(const LogRecord_t* record, char* line, int size) {
+	const char* p = record->format;
+	int length = 0;
+	int argIndex = 0;
+	char spec[32];
+	while (*p && length < size - 1) {
+		if (*p != '%') {
+			line[length++] = *p++;
+			continue;
+		}
+		if (p[1] == '%') {
+			line[length++] = '%';
+			p += 2;
+			continue;
+		}
+		// keep flags, width and precision, drop * and length modifiers, they are replaced below
+		int specLength = 0;
+		spec[specLength++] = *p++;
+		while (*p && strchr("-+ #0123456789.*hlLqjzt", *p)) {
+			if (strchr("-+ #0123456789.", *p) && specLength < (int)sizeof(spec) - 4) {
+				spec[specLength++] = *p;
+			}
+			p++;
+		}
+		char conversion = *p;
+		if (conversion == 0) {
+			break;
+		}
+		p++;
+		if (argIndex >= record->nArgs) {
+			continue;
+		}
+		const LogArg_t& arg = record->args[argIndex++];
+		int n = 0;
+		switch (conversion) {
+		case 'd':
+		case 'i':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec, argAsInt(arg));
+			break;
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec, (unsigned long long)argAsInt(arg));
+			break;
+		case 'c':
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec, (int)argAsInt(arg));
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec, argAsDouble(arg));
+			break;
+		case 's':
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec,
+					arg.type == LOG_ARG_STRING ? record->strings + arg.u : "?");
+			break;
+		case 'p':
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			n = snprintf(line + length, size - length, spec, arg.type == LOG_ARG_POINTER ? arg.p : NULL);
+			break;
+		default:
+			break;
+		}
+		if (n > 0) {
+			length += n < size - 1 - length ? n : size - 1 - length;
+		}
+	}
+	line[length] = 0;
+	return length;
+}
+
+static void printRecord(const LogRecord_t* record, FILE* fp) {
+	char line[LOG_LINE_LENGTH];
+	if (record->nSuppressed > 0) {
+		fprintf(fp, "[%u similar log records suppressed]\n", record->nSuppressed);
+	}
+	if (record->level == LOG_LEVEL_WARN) {
+		fputs("warning: ", fp);
+	}
+	else if (record->level >= LOG_LEVEL_ERROR) {
+		fputs("error: ", fp);
+	}
+	int length = formatRecord(record, line, sizeof(line));
+	fwrite(line, 1, length, fp);
+}
+
+/**
+ * @description: print every filled slot, in order, and hand the slots back to the producers
+ * @return: the number of records printed
+ */
+static int drainRing(FILE* fp) {
+	static uint64_t reportedDrops = 0;
+	int n = 0;
+	uint64_t pos = dequeuePos.load(std::memory_order_relaxed);
+	for (;;) {
+		LogSlot_t* slot = &ring[pos & (LOG_RING_SIZE - 1)];
+		if (slot->sequence.load(std::memory_order_acquire) != pos + 1) {
+			break;
+		}
+		printRecord(&slot->record, fp);
+		slot->sequence.store(pos + LOG_RING_SIZE, std::memory_order_release);
+		pos++;
+		dequeuePos.store(pos, std::memory_order_release);
+		n++;
+	}
+	uint64_t drops = dropCount.load(std::memory_order_relaxed);
+	if (drops != reportedDrops) {
+		fprintf(fp, "[%llu log records dropped, the log ring was full]\n", (unsigned long long)(drops - reportedDrops));
+		reportedDrops = drops;
+		n++;
+	}
+	if (n > 0) {
+		fflush(fp);
+	}
+	return n;
+}
+
+/**
+ * Owns the drainer thread. The static instance stops it and prints what is left when the library
+ * is unloaded, before the code the thread runs goes away
+ */
+class LogDrainer {
+	std::thread thread;
+	std::atomic<bool> stop;
+
+	void run() {
+		while (!stop.load(std::memory_order_acquire)) {
+			if (drainRing(stdout) == 0) {
+				struct timespec ts = {0, LOG_DRAIN_SLEEP_MS * 1000000L};
+				nanosleep(&ts, NULL);
+			}
+		}
+		drainRing(stdout);
+	}
+
+public:
+	LogDrainer() : stop(false) {
+	}
+
+	void start() {
+		for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+			ring[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		thread = std::thread(&LogDrainer::run, this);
+		drainerStarted.store(true, std::memory_order_release);
+	}
+
+	~LogDrainer() {
+		if (thread.joinable()) {
+			stop.store(true, std::memory_order_release);
+			thread.join();
+		}
+	}
+};
+
+static LogDrainer drainer;
+
+static void startDrainer(void) {
+	drainer.start();
+}
+
+bool writeLogRecord(int level, uint32_t nSuppressed, const char* format, const LogArg_t* args, int nArgs) {
+	if (!drainerStarted.load(std::memory_order_acquire)) {
+		std::call_once(drainerOnce, startDrainer);
+	}
+
+	uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+	LogSlot_t* slot;
+	for (;;) {
+		slot = &ring[pos & (LOG_RING_SIZE - 1)];
+		int64_t diff = (int64_t)slot->sequence.load(std::memory_order_acquire) - (int64_t)pos;
+		if (diff == 0) {
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			dropCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else {
+			pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	LogRecord_t* record = &slot->record;
+	record->format = format;
+	record->level = level;
+	record->nSuppressed = nSuppressed;
+	record->nArgs = nArgs < LOG_MAX_ARGS ? nArgs : LOG_MAX_ARGS;
+	int stringLength = 0;
+	for (int i = 0; i < record->nArgs; i++) {
+		record->args[i] = args[i];
+		if (args[i].type == LOG_ARG_STRING) {
+			const char* s = args[i].s ? args[i].s : "(null)";
+			int n = strnlen(s, LOG_STRING_BYTES - 1 - stringLength);
+			memcpy(record->strings + stringLength, s, n);
+			record->strings[stringLength + n] = 0;
+			record->args[i].u = stringLength;
+			stringLength += n + (stringLength + n < LOG_STRING_BYTES - 1 ? 1 : 0);
+		}
+	}
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+void flushLog(void) {
+	if (!drainerStarted.load(std::memory_order_acquire)) {
+		return;
+	}
+	uint64_t target = enqueuePos.load(std::memory_order_acquire);
+	while (dequeuePos.load(std::memory_order_acquire) < target) {
+		struct timespec ts = {0, LOG_DRAIN_SLEEP_MS * 1000000L};
+		nanosleep(&ts, NULL);
+	}
+	fflush(stdout);
+}
+
+uint64_t getLogDropCount(void) {
+	return dropCount.load(std::memory_order_relaxed);
+}
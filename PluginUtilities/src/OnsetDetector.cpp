@@ -0,0 +1,149 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * OnsetDetector.cpp
+ */
+
+#include "OnsetDetector.h"
+#include <stdio.h>
+
+#define N_NOVELTY_HISTORY 9
+#define N_PEAK_NEIGHBOURS 3			/*the novelty must be the largest of this many ticks*/
+#define ONSET_THRESHOLD 12.0		/*the novelty must exceed its running average by this much*/
+#define ENERGY_SCALE 64.0f
+#define FFT_SCALE 8.0f
+#define ENERGY_NOVELTY_WEIGHT 1.0
+#define FREQ_NOVELTY_WEIGHT 10.0
+#define MAX_FFT_BINS 32
+
+static int freqLoBoundry = 1;
+static int freqMdBoundry = 8;
+static int freqHiBoundry = 32;
+static float prevEnergy = 0;
+static float energyNovelty = 0;
+static float prevFftBins[MAX_FFT_BINS];
+static float freqNoveltyLo = 0;
+
+/**
+ * @description: half wave rectified difference of the energy with the previous tick
+ */
+static void updateEnergyNovelty(uint16_t energy) {
+	float e = energy / ENERGY_SCALE;
+	float diff = e - prevEnergy;
+	energyNovelty = diff >= 0 ? diff : 0;
+	prevEnergy = e;
+}
+
+/**
+ * @description: sum of the half wave rectified differences of the bins start to end-1 with the previous tick
+ */
+static float accumulateFrequencyNovelty(uint8_t* fftBins, int start, int end) {
+	float sum = 0;
+	for (int i = start; i < end; i++) {
+		float bin = fftBins[i] / FFT_SCALE;
+		float diff = bin - prevFftBins[i];
+		sum += diff > 0 ? diff : 0;
+		prevFftBins[i] = bin;
+	}
+	return sum;
+}
+
+static void updateFreqNovelty(uint8_t* fftBins) {
+	freqNoveltyLo = accumulateFrequencyNovelty(fftBins, 0, freqLoBoundry);
+}
+
+OnsetDetector::OnsetDetector() {
+	onset = false;
+	onsetNovelty = 0;
+	novelty = 0;
+	noveltyHistory = NULL;
+}
+
+OnsetDetector::~OnsetDetector() {
+	if (noveltyHistory) {
+		delete noveltyHistory;
+		noveltyHistory = NULL;
+	}
+}
+
+void OnsetDetector::onsetDetectorInit(int nFftBins) {
+	if (nFftBins < freqLoBoundry) {
+		freqLoBoundry = nFftBins;
+	}
+	if (nFftBins < freqMdBoundry) {
+		freqMdBoundry = nFftBins;
+	}
+	if (nFftBins < freqHiBoundry) {
+		freqHiBoundry = nFftBins;
+	}
+	noveltyHistory = new Fifo<float>(N_NOVELTY_HISTORY);
+}
+
+void OnsetDetector::updateNovelty(uint16_t energy, uint8_t* fftBins) {
+	updateEnergyNovelty(energy);
+	updateFreqNovelty(fftBins);
+	novelty = energyNovelty * ENERGY_NOVELTY_WEIGHT + freqNoveltyLo * FREQ_NOVELTY_WEIGHT;
+	noveltyHistory->push(novelty);
+}
+
+void OnsetDetector::onsetDetect() {
+	int idx = noveltyHistory->getHead();
+	for (int i = 0; i < N_PEAK_NEIGHBOURS; i++) {
+		if (noveltyHistory->getElementAtIndex(idx) > novelty) {
+			onset = false;
+			return;
+		}
+		idx--;
+		if (idx < 0) {
+			idx = noveltyHistory->getLength() - 1;
+		}
+	}
+	if (novelty - noveltyHistory->getAverage() < ONSET_THRESHOLD) {
+		onset = false;
+		return;
+	}
+	onset = true;
+	onsetNovelty = novelty;
+}
+
+void OnsetDetector::onsetDetectorTick(uint16_t energy, uint8_t* fftBins) {
+	updateNovelty(energy, fftBins);
+	onsetDetect();
+}
+
+void OnsetDetector::onsetDetectorPrint(int level) {
+	if (level < 1) {
+		return;
+	}
+	printf("novelty %6.1f %s\n", novelty, onset ? "ONSET" : "");
+}
+
+bool OnsetDetector::isOnset() {
+	return onset;
+}
+
+float OnsetDetector::getOnsetNovelty() {
+	return onsetNovelty;
+}
+
+float OnsetDetector::getNovelty() {
+	return novelty;
+}
+
+float OnsetDetector::getLowFrequencyNovelty() {
+	return freqNoveltyLo;
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PackedFrame.cpp
+ */
+
+#include "PackedFrame.h"
+
+static inline uint8_t clampChannel(int value) {
+	return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+int packFrames(const Frame_t* frames, int nFrames, PackedFrame_t* packed) {
+	int nPacked = 0;
+	for (int i = 0; i < nFrames; i++) {
+		const Frame_t* f = &frames[i];
+		if (f->panelId < 0 || f->panelId > PACKED_FRAME_MAX_PANEL_ID) {
+			continue;
+		}
+		PackedFrame_t* p = &packed[nPacked++];
+		p->panelId = (uint16_t)f->panelId;
+		p->r = clampChannel(f->r);
+		p->g = clampChannel(f->g);
+		p->b = clampChannel(f->b);
+		p->flags = 0;
+		p->transTime = (uint16_t)(f->transTime < 0 ? 0 :
+				(f->transTime > PACKED_FRAME_MAX_TRANS_TIME ? PACKED_FRAME_MAX_TRANS_TIME : f->transTime));
+	}
+	return nPacked;
+}
+
+void unpackFrames(const PackedFrame_t* packed, int nPacked, Frame_t* frames) {
+	for (int i = 0; i < nPacked; i++) {
+		frames[i].panelId = packed[i].panelId;
+		frames[i].r = packed[i].r;
+		frames[i].g = packed[i].g;
+		frames[i].b = packed[i].b;
+		frames[i].transTime = packed[i].transTime;
+	}
+}
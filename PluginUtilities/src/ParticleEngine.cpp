@@ -0,0 +1,179 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+
+/*
+ * ParticleEngine.cpp
+ */
+
+#include "ParticleEngine.h"
+#include <math.h>
+
+void initParticleSystem(ParticleSystem_t* particles, int capacity) {
+	ParticleConfig_t* config = &particles->config;
+	config->capacity = capacity < 1 ? 1 : (capacity > MAX_PARTICLES ? MAX_PARTICLES : capacity);
+	config->order = PARTICLE_ORDER_SPAWN;
+	config->kernel = PARTICLE_KERNEL_INVERSE_SQUARE;
+	config->distanceScale = 1.0;
+	config->k = 1.0;
+	config->diffusionRate = 0.0;
+	config->minFactor = 0.0;
+	config->motion = PARTICLE_MOTION_LINEAR;
+	config->drag = 1.0;
+	config->expiry = 0;
+	config->maxDistance = 0.0;
+	config->maxAge = 0.0;
+	config->minParticles = 0;
+	particles->nParticles = 0;
+	particles->order.clear();
+	clearLightSources(&particles->lights);
+}
+
+int getFirstParticle(const ParticleSystem_t* particles) {
+	return particles->order.first();
+}
+
+void removeParticle(ParticleSystem_t* particles, int index) {
+	// the pool moves the last particle into index as well, so the arrays stay parallel to it
+	particles->order.remove(index);
+	int last = --particles->nParticles;
+	if (index == last) {
+		return;
+	}
+	particles->x[index] = particles->x[last];
+	particles->y[index] = particles->y[last];
+	particles->vx[index] = particles->vx[last];
+	particles->vy[index] = particles->vy[last];
+	particles->R[index] = particles->R[last];
+	particles->G[index] = particles->G[last];
+	particles->B[index] = particles->B[last];
+	particles->radius[index] = particles->radius[last];
+	particles->age[index] = particles->age[last];
+	particles->ageRate[index] = particles->ageRate[last];
+}
+
+int spawnParticle(ParticleSystem_t* particles, float x, float y, int R, int G, int B, float intensity) {
+	SourcePool<float, MAX_PARTICLES, true>* order = &particles->order;
+	if (particles->nParticles >= particles->config.capacity) {
+		removeParticle(particles, order->first());
+	}
+	// the newest particle goes last, or in front of the newer particles with a higher intensity
+	int before = SOURCE_POOL_NONE;
+	if (particles->config.order == PARTICLE_ORDER_INTENSITY) {
+		for (int j = order->last(); j != SOURCE_POOL_NONE && intensity < (*order)[j]; j = order->prev(j)) {
+			before = j;
+		}
+	}
+	int i = order->insertBefore(before, intensity);
+	particles->nParticles++;
+	particles->x[i] = x;
+	particles->y[i] = y;
+	particles->vx[i] = 0;
+	particles->vy[i] = 0;
+	particles->R[i] = R;
+	particles->G[i] = G;
+	particles->B[i] = B;
+	particles->radius[i] = 0;
+	particles->age[i] = 0;
+	particles->ageRate[i] = 1;
+	return i;
+}
+
+void updateParticles(ParticleSystem_t* particles) {
+	const ParticleConfig_t* config = &particles->config;
+	int n = particles->nParticles;
+	float* __restrict x = particles->x;
+	float* __restrict y = particles->y;
+	float* __restrict vx = particles->vx;
+	float* __restrict vy = particles->vy;
+	float* __restrict age = particles->age;
+	const float* __restrict ageRate = particles->ageRate;
+
+	// motion and ageing of every particle, straight loops over the arrays
+	if (config->motion != PARTICLE_MOTION_STATIC) {
+		for (int i = 0; i < n; i++) {
+			x[i] += vx[i];
+			y[i] += vy[i];
+		}
+		if (config->motion == PARTICLE_MOTION_DAMPED) {
+			for (int i = 0; i < n; i++) {
+				vx[i] *= config->drag;
+				vy[i] *= config->drag;
+			}
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		age[i] += ageRate[i];
+	}
+
+	// the age limit only applies while there are more than minParticles particles, checked once per update
+	bool expireByDistance = (config->expiry & PARTICLE_EXPIRE_DISTANCE) != 0;
+	bool expireByAge = (config->expiry & PARTICLE_EXPIRE_AGE) != 0 && n > config->minParticles;
+	if (!expireByDistance && !expireByAge) {
+		return;
+	}
+	int i = 0;
+	while (i < particles->nParticles) {
+		bool expired = false;
+		if (expireByDistance) {
+			float d = sqrtf(x[i] * x[i] + y[i] * y[i]);
+			expired = d > config->maxDistance;
+		}
+		if (expireByAge && age[i] > config->maxAge) {
+			expired = true;
+		}
+		if (expired) {
+			removeParticle(particles, i);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void renderParticles(ParticleSystem_t* particles, const PanelCentroids_t* centroids, RGB_t base, int transTime,
+		Frame_t* frames) {
+	const ParticleConfig_t* config = &particles->config;
+	const SourcePool<float, MAX_PARTICLES, true>* order = &particles->order;
+
+	LightSources_t* lights = &particles->lights;
+	LightFalloff_t falloff;
+	falloff.type = config->kernel == PARTICLE_KERNEL_DIFFUSION ? LIGHT_FALLOFF_INVERSE_LINEAR : LIGHT_FALLOFF_INVERSE_SQUARE;
+	falloff.distanceScale = config->distanceScale;
+	falloff.k = config->k;
+	lights->nSources = particles->nParticles;
+	int s = 0;
+	for (int i = order->first(); i != SOURCE_POOL_NONE; i = order->next(i), s++) {
+		lights->x[s] = particles->x[i];
+		lights->y[s] = particles->y[i];
+		lights->R[s] = particles->R[i];
+		lights->G[s] = particles->G[i];
+		lights->B[s] = particles->B[i];
+		lights->offset[s] = 0;
+		lights->gain[s] = 1;
+		lights->minFactor[s] = 0;
+		if (config->kernel == PARTICLE_KERNEL_BUBBLE) {
+			lights->offset[s] = particles->radius[i];
+		}
+		else if (config->kernel == PARTICLE_KERNEL_DIFFUSION) {
+			float age = particles->age[i];
+			lights->offset[s] = age * config->diffusionRate;
+			lights->gain[s] = age >= config->maxAge ? 0.0 : 1.0 - age / config->maxAge;
+			lights->minFactor[s] = config->minFactor;
+		}
+	}
+	renderLightSources(centroids, lights, &falloff, base, transTime, frames);
+}
@@ -0,0 +1,349 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * PluginFeatures.cpp
+ */
+
+#include "PluginFeatures.h"
+#include "PluginFeaturesInternal.h"
+#include "BeatEngine.h"
+#include "BandOnsetDetector.h"
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <vector>
+
+#define MAX_BIN16_VALUE 65535.0f
+
+/**
+ * The spectrum features derived from the fft bins on every update. A band holds the bins whose centre frequency is in
+ * it; a band too narrow to hold any takes the spectrum interpolated at its centre instead
+ */
+struct SpectrumState_t {
+	std::vector<float> fftBins;
+	std::vector<uint16_t> fftBins16;
+	std::vector<float> fftBands;
+	std::vector<int> bandStart;			/*first bin of every band*/
+	std::vector<int> bandEnd;			/*one past the last bin of every band*/
+	std::vector<float> bandCentre;		/*centre of every band, in bins*/
+	BandOnsetDetector bandOnsets;		/*over the bands, or over the bins without bands*/
+	float sampleRate;
+	float spectralCentroid;
+	uint16_t peakFftBin;
+	bool fromSoundModule;				/*updateSpectrumFeatures has been called*/
+	SpectrumState_t(){
+		sampleRate = DEFAULT_SAMPLE_RATE;
+		spectralCentroid = 0;
+		peakFftBin = 0;
+		fromSoundModule = false;
+	}
+};
+
+static EnabledFeatures_t enabledFeatures = {false, false, 0, false, false, false, 0, FFT_BANDS_LOG, false};
+static RhythmFeatures_t rhythmFeatures = {0, NULL, 0, 0, 0};
+static SpectrumState_t spectrum;
+static BeatEngine* beatEngine = NULL;
+
+static inline float hzToMel(float hz) {
+	return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static inline float melToHz(float mel) {
+	return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+/**
+ * @description: work out which bins go into which band, for the number of bins and the sample rate
+ */
+static void computeBandLayout(void) {
+	int nBins = spectrum.fftBins.size();
+	int nBands = enabledFeatures.nFftBands;
+	spectrum.fftBands.assign(nBins > 0 ? nBands : 0, 0.0f);
+	spectrum.bandStart.assign(spectrum.fftBands.size(), 0);
+	spectrum.bandEnd.assign(spectrum.fftBands.size(), 0);
+	spectrum.bandCentre.assign(spectrum.fftBands.size(), 0.0f);
+	if (spectrum.fftBands.empty()) {
+		return;
+	}
+
+	float nyquist = spectrum.sampleRate / 2.0f;
+	float binHz = nyquist / nBins;
+	bool mel = enabledFeatures.fftBandScale == FFT_BANDS_MEL;
+	float minHz = FFT_BANDS_MIN_HZ < nyquist ? FFT_BANDS_MIN_HZ : nyquist / 2.0f;
+	for (int k = 0; k < nBands; k++) {
+		float lo, hi;
+		if (mel) {
+			lo = melToHz(hzToMel(nyquist) * k / nBands);
+			hi = melToHz(hzToMel(nyquist) * (k + 1) / nBands);
+		}
+		else {
+			lo = minHz * powf(nyquist / minHz, (float)k / nBands);
+			hi = minHz * powf(nyquist / minHz, (float)(k + 1) / nBands);
+		}
+		// bin j is centred on (j + 0.5) * binHz
+		int start = (int)ceilf(lo / binHz - 0.5f);
+		int end = k == nBands - 1 ? nBins : (int)ceilf(hi / binHz - 0.5f);
+		spectrum.bandStart[k] = start < 0 ? 0 : (start > nBins ? nBins : start);
+		spectrum.bandEnd[k] = end < spectrum.bandStart[k] ? spectrum.bandStart[k] : (end > nBins ? nBins : end);
+		spectrum.bandCentre[k] = (lo + hi) / 2.0f / binHz - 0.5f;
+	}
+}
+
+/**
+ * @description: derive the 16 bit bins, the peak, the centroid and the bands from spectrum.fftBins
+ */
+static void computeSpectrumFeatures(void) {
+	int nBins = spectrum.fftBins.size();
+	const float* bins = spectrum.fftBins.data();
+	float peak = 0;
+	float sum = 0;
+	float weightedSum = 0;
+	spectrum.peakFftBin = 0;
+	for (int j = 0; j < nBins; j++) {
+		float b = bins[j];
+		float b16 = b * FFT_BIN16_SCALE;
+		spectrum.fftBins16[j] = b16 > MAX_BIN16_VALUE ? (uint16_t)MAX_BIN16_VALUE : (b16 > 0 ? (uint16_t)b16 : 0);
+		if (b > peak) {
+			peak = b;
+			spectrum.peakFftBin = j;
+		}
+		sum += b;
+		weightedSum += b * j;
+	}
+	spectrum.spectralCentroid = sum > 0 ? weightedSum / sum : 0;
+
+	for (size_t k = 0; k < spectrum.fftBands.size(); k++) {
+		int start = spectrum.bandStart[k];
+		int end = spectrum.bandEnd[k];
+		if (end > start) {
+			float acc = 0;
+			for (int j = start; j < end; j++) {
+				acc += bins[j];
+			}
+			spectrum.fftBands[k] = acc / (end - start);
+			continue;
+		}
+		float position = spectrum.bandCentre[k];
+		position = position < 0 ? 0 : (position > nBins - 1 ? nBins - 1 : position);
+		int j = (int)position;
+		float fraction = position - j;
+		spectrum.fftBands[k] = j + 1 < nBins ? bins[j] * (1.0f - fraction) + bins[j + 1] * fraction : bins[j];
+	}
+
+	if (spectrum.bandOnsets.getNBands() > 0) {
+		spectrum.bandOnsets.bandOnsetDetectorTick(spectrum.fftBands.empty() ? bins : spectrum.fftBands.data());
+	}
+}
+
+/**
+ * @description: size the band onset detector for the bands, or for the bins if there are no bands
+ */
+static void initBandOnsets(void) {
+	int n = 0;
+	if (enabledFeatures.bandOnsets) {
+		n = spectrum.fftBands.empty() ? spectrum.fftBins.size() : spectrum.fftBands.size();
+	}
+	spectrum.bandOnsets.bandOnsetDetectorInit(n, SOUND_TICK_MS);
+}
+
+extern "C" EnabledFeatures_t* getEnabledFeatures(void) {
+	return &enabledFeatures;
+}
+
+extern "C" void initRhythmFeatures(void) {
+	deinitRhythmFeatures();
+	if (enabledFeatures.nFftBins > 0) {
+		rhythmFeatures.fftBins = new uint8_t[enabledFeatures.nFftBins]();
+	}
+	rhythmFeatures.nFftBins = enabledFeatures.nFftBins;
+	spectrum.fftBins.assign(enabledFeatures.nFftBins, 0.0f);
+	spectrum.fftBins16.assign(enabledFeatures.nFftBins, 0);
+	spectrum.spectralCentroid = 0;
+	spectrum.peakFftBin = 0;
+	computeBandLayout();
+	initBandOnsets();
+}
+
+extern "C" void updateRhythmFeatures(RhythmFeatures_t* in) {
+	rhythmFeatures.energy = in->energy;
+	if (rhythmFeatures.fftBins && in->fftBins) {
+		int n = in->nFftBins < rhythmFeatures.nFftBins ? in->nFftBins : rhythmFeatures.nFftBins;
+		memcpy(rhythmFeatures.fftBins, in->fftBins, n);
+	}
+	rhythmFeatures.speed = in->speed;
+	rhythmFeatures.distance = in->distance;
+	if (!spectrum.fromSoundModule && rhythmFeatures.fftBins) {
+		for (int j = 0; j < rhythmFeatures.nFftBins; j++) {
+			spectrum.fftBins[j] = rhythmFeatures.fftBins[j];
+		}
+		computeSpectrumFeatures();
+	}
+}
+
+extern "C" void updateSpectrumFeatures(SpectrumFeatures_t* in) {
+	if (in->fftBins == NULL || spectrum.fftBins.empty()) {
+		return;
+	}
+	spectrum.fromSoundModule = true;
+	if (in->sampleRate > 0 && in->sampleRate != spectrum.sampleRate) {
+		spectrum.sampleRate = in->sampleRate;
+		computeBandLayout();
+	}
+	int n = in->nFftBins < (int)spectrum.fftBins.size() ? in->nFftBins : (int)spectrum.fftBins.size();
+	memcpy(spectrum.fftBins.data(), in->fftBins, n * sizeof(float));
+	computeSpectrumFeatures();
+}
+
+extern "C" void deinitRhythmFeatures(void) {
+	if (rhythmFeatures.fftBins) {
+		delete [] rhythmFeatures.fftBins;
+		rhythmFeatures.fftBins = NULL;
+	}
+	rhythmFeatures.nFftBins = 0;
+	spectrum.fftBins.clear();
+	spectrum.fftBins16.clear();
+	computeBandLayout();
+	initBandOnsets();
+	spectrum.fromSoundModule = false;
+}
+
+extern "C" void initBeatFeatures(void) {
+	deinitBeatFeatures();
+	beatEngine = new BeatEngine;
+	beatEngine->beatEngineInit(enabledFeatures.nFftBins, SOUND_TICK_MS);
+}
+
+extern "C" void updateBeatFeatures(void) {
+	if (beatEngine == NULL || rhythmFeatures.fftBins == NULL) {
+		return;
+	}
+	beatEngine->beatEngineTick(rhythmFeatures.energy, rhythmFeatures.fftBins);
+}
+
+extern "C" void deinitBeatFeatures(void) {
+	if (beatEngine) {
+		delete beatEngine;
+		beatEngine = NULL;
+	}
+}
+
+void enableEnergy(void) {
+	enabledFeatures.energy = true;
+}
+
+void enableFft(uint16_t nFftBins) {
+	enabledFeatures.fft = true;
+	enabledFeatures.nFftBins = nFftBins;
+}
+
+void enableFftBands(uint16_t nBands, int scale) {
+	enabledFeatures.fft = true;
+	enabledFeatures.nFftBands = nBands;
+	enabledFeatures.fftBandScale = scale;
+	if (enabledFeatures.nFftBins == 0) {
+		enabledFeatures.nFftBins = DEFAULT_N_FFT_BINS;
+	}
+}
+
+void enableBandOnsets(void) {
+	enabledFeatures.fft = true;
+	enabledFeatures.bandOnsets = true;
+	if (enabledFeatures.nFftBins == 0) {
+		enabledFeatures.nFftBins = DEFAULT_N_FFT_BINS;
+	}
+}
+
+void enableDistance(void) {
+	enabledFeatures.distance = true;
+}
+
+void enableSpeed(void) {
+	enabledFeatures.speed = true;
+}
+
+uint16_t getEnergy(void) {
+	return rhythmFeatures.energy;
+}
+
+uint8_t* getFftBins(void) {
+	return rhythmFeatures.fftBins;
+}
+
+const float* getFftBinsFloat(void) {
+	return spectrum.fftBins.empty() ? NULL : spectrum.fftBins.data();
+}
+
+const uint16_t* getFftBins16(void) {
+	return spectrum.fftBins16.empty() ? NULL : spectrum.fftBins16.data();
+}
+
+const float* getFftBands(void) {
+	return spectrum.fftBands.empty() ? NULL : spectrum.fftBands.data();
+}
+
+float getSpectralCentroid(void) {
+	return spectrum.spectralCentroid;
+}
+
+uint16_t getPeakFftBin(void) {
+	return spectrum.peakFftBin;
+}
+
+const uint8_t* getBandOnsets(void) {
+	return spectrum.bandOnsets.getNBands() > 0 ? spectrum.bandOnsets.getOnsets() : NULL;
+}
+
+const float* getBandOnsetStrengths(void) {
+	return spectrum.bandOnsets.getNBands() > 0 ? spectrum.bandOnsets.getStrengths() : NULL;
+}
+
+uint8_t getDistance(void) {
+	return rhythmFeatures.distance;
+}
+
+uint8_t getSpeed(void) {
+	return rhythmFeatures.speed;
+}
+
+void enableBeatFeatures(void) {
+	enabledFeatures.beat = true;
+	enabledFeatures.energy = true;
+	enabledFeatures.fft = true;
+	if (enabledFeatures.nFftBins == 0) {
+		enabledFeatures.nFftBins = DEFAULT_N_FFT_BINS;
+	}
+}
+
+bool getIsBeat(void) {
+	return beatEngine ? beatEngine->isBeat() : false;
+}
+
+bool getIsOnset(void) {
+	return beatEngine ? beatEngine->isOnset() : false;
+}
+
+float getTempo(void) {
+	return beatEngine ? beatEngine->getTempo() : 0;
+}
+
+float getBeatPhase(void) {
+	return beatEngine ? beatEngine->getBeatPhase() : 0;
+}
+
+float getBeatConfidence(void) {
+	return beatEngine ? beatEngine->getBeatConfidence() : 0;
+}
@@ -0,0 +1,265 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Profiler.cpp
+ *
+ *  Every thread owns one ProfileThread_t, linked into a global list the first time it records.
+ *  Only the owner writes to it, with relaxed atomic stores, so dumpProfile can read it from any
+ *  thread without locks. Thread blocks are never freed, a thread that exits keeps its samples.
+ */
+
+#include "Profiler.h"
+#include <atomic>
+#include <string.h>
+#include <chrono>
+
+/**
+ * The id of a site is taken before its name and kind are written. The name is stored last with
+ * release, so a dump that sees the name also sees the kind, and skips a site whose name is not there yet
+ */
+struct ProfileSiteInfo_t {
+	std::atomic<const char*> name;
+	int kind;
+};
+
+/**
+ * One timer or counter of one thread
+ */
+struct ProfileSiteStats_t {
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> sum;			/*ticks, or the counter total*/
+	std::atomic<uint64_t> max;
+	std::atomic<uint64_t> buckets[PROFILE_N_BUCKETS];
+};
+
+struct ProfileThread_t {
+	std::atomic<ProfileSiteStats_t*> sites[PROFILE_MAX_SITES];	/*allocated when the thread first hits a site*/
+	ProfileThread_t* next;
+};
+
+static ProfileSiteInfo_t siteInfo[PROFILE_MAX_SITES];
+static std::atomic<int> nSites(0);
+static std::atomic<ProfileThread_t*> threads(NULL);
+static thread_local ProfileThread_t* currentThread = NULL;
+
+/**
+ * the time stamp counter and the steady clock when the library was loaded, to convert ticks into ns
+ */
+static const uint64_t startTicks = profileTicks();
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+int registerProfileSite(const char* name, int kind) {
+	int id = nSites.fetch_add(1);
+	if (id >= PROFILE_MAX_SITES) {
+		nSites.store(PROFILE_MAX_SITES);
+		return -1;
+	}
+	siteInfo[id].kind = kind;
+	siteInfo[id].name.store(name, std::memory_order_release);
+	return id;
+}
+
+/**
+ * @description: same bucketing as the LatencyHistogram of the PluginHost, with fewer sub buckets
+ */
+static inline int bucketIndex(uint64_t value) {
+	if (value < 2 * PROFILE_SUB_BUCKETS) {
+		return value;
+	}
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - PROFILE_SUB_BUCKET_BITS;
+	int mantissa = value >> shift;
+	return 2 * PROFILE_SUB_BUCKETS + (shift - 1) * PROFILE_SUB_BUCKETS + (mantissa - PROFILE_SUB_BUCKETS);
+}
+
+static uint64_t bucketUpperBound(int index) {
+	if (index < 2 * PROFILE_SUB_BUCKETS) {
+		return index;
+	}
+	int shift = (index - 2 * PROFILE_SUB_BUCKETS) / PROFILE_SUB_BUCKETS + 1;
+	uint64_t mantissa = (index - 2 * PROFILE_SUB_BUCKETS) % PROFILE_SUB_BUCKETS + PROFILE_SUB_BUCKETS;
+	return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * @description: the stats of a site for the calling thread, allocating the thread block and the stats on first use
+ */
+static ProfileSiteStats_t* getSiteStats(int site) {
+	ProfileThread_t* thread = currentThread;
+	if (thread == NULL) {
+		thread = new ProfileThread_t;
+		for (int i = 0; i < PROFILE_MAX_SITES; i++) {
+			thread->sites[i].store(NULL, std::memory_order_relaxed);
+		}
+		thread->next = threads.load();
+		while (!threads.compare_exchange_weak(thread->next, thread)) {
+		}
+		currentThread = thread;
+	}
+	ProfileSiteStats_t* stats = thread->sites[site].load(std::memory_order_relaxed);
+	if (stats == NULL) {
+		stats = new ProfileSiteStats_t;
+		stats->count.store(0, std::memory_order_relaxed);
+		stats->sum.store(0, std::memory_order_relaxed);
+		stats->max.store(0, std::memory_order_relaxed);
+		for (int i = 0; i < PROFILE_N_BUCKETS; i++) {
+			stats->buckets[i].store(0, std::memory_order_relaxed);
+		}
+		thread->sites[site].store(stats, std::memory_order_release);
+	}
+	return stats;
+}
+
+/**
+ * @description: add to a value only this thread writes, without an atomic read-modify-write
+ */
+static inline void addRelaxed(std::atomic<uint64_t>* value, uint64_t n) {
+	value->store(value->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void recordProfileTicks(int site, uint64_t ticks) {
+	if (site < 0) {
+		return;
+	}
+	ProfileSiteStats_t* stats = getSiteStats(site);
+	addRelaxed(&stats->count, 1);
+	addRelaxed(&stats->sum, ticks);
+	addRelaxed(&stats->buckets[bucketIndex(ticks)], 1);
+	if (ticks > stats->max.load(std::memory_order_relaxed)) {
+		stats->max.store(ticks, std::memory_order_relaxed);
+	}
+}
+
+void addProfileCount(int site, int64_t n) {
+	if (site < 0) {
+		return;
+	}
+	ProfileSiteStats_t* stats = getSiteStats(site);
+	addRelaxed(&stats->count, 1);
+	addRelaxed(&stats->sum, (uint64_t)n);
+}
+
+void getProfileTotals(int site, uint64_t* count, uint64_t* sum) {
+	*count = 0;
+	*sum = 0;
+	if (site < 0 || site >= PROFILE_MAX_SITES) {
+		return;
+	}
+	for (ProfileThread_t* thread = threads.load(); thread != NULL; thread = thread->next) {
+		ProfileSiteStats_t* stats = thread->sites[site].load(std::memory_order_acquire);
+		if (stats) {
+			*count += stats->count.load(std::memory_order_relaxed);
+			*sum += stats->sum.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void resetProfile(void) {
+	for (ProfileThread_t* thread = threads.load(); thread != NULL; thread = thread->next) {
+		for (int s = 0; s < PROFILE_MAX_SITES; s++) {
+			ProfileSiteStats_t* stats = thread->sites[s].load(std::memory_order_acquire);
+			if (stats == NULL) {
+				continue;
+			}
+			stats->count.store(0, std::memory_order_relaxed);
+			stats->sum.store(0, std::memory_order_relaxed);
+			stats->max.store(0, std::memory_order_relaxed);
+			for (int i = 0; i < PROFILE_N_BUCKETS; i++) {
+				stats->buckets[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+/**
+ * @description: ns per tick of profileTicks, measured over the time since the library was loaded
+ */
+static double getNsPerTick(void) {
+#ifdef PROFILE_CLOCK_TSC
+	// make sure the two clocks are at least 10ms apart, or the ratio is noise
+	uint64_t ticks;
+	int64_t ns;
+	do {
+		ticks = profileTicks() - startTicks;
+		ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	} while (ns < 10000000);
+	return ticks ? (double)ns / ticks : 1.0;
+#else
+	return 1.0;
+#endif
+}
+
+void dumpProfile(FILE* fp) {
+	int n = nSites.load();
+	if (n > PROFILE_MAX_SITES) {
+		n = PROFILE_MAX_SITES;
+	}
+	double nsPerTick = getNsPerTick();
+	static uint64_t buckets[PROFILE_N_BUCKETS];
+
+	for (int s = 0; s < n; s++) {
+		const char* name = siteInfo[s].name.load(std::memory_order_acquire);
+		if (name == NULL) {
+			continue;
+		}
+		uint64_t count = 0;
+		uint64_t sum = 0;
+		uint64_t max = 0;
+		memset(buckets, 0, sizeof(buckets));
+		for (ProfileThread_t* thread = threads.load(); thread != NULL; thread = thread->next) {
+			ProfileSiteStats_t* stats = thread->sites[s].load(std::memory_order_acquire);
+			if (stats == NULL) {
+				continue;
+			}
+			count += stats->count.load(std::memory_order_relaxed);
+			sum += stats->sum.load(std::memory_order_relaxed);
+			uint64_t m = stats->max.load(std::memory_order_relaxed);
+			max = m > max ? m : max;
+			if (siteInfo[s].kind == PROFILE_SITE_TIMER) {
+				for (int i = 0; i < PROFILE_N_BUCKETS; i++) {
+					buckets[i] += stats->buckets[i].load(std::memory_order_relaxed);
+				}
+			}
+		}
+		if (count == 0) {
+			continue;
+		}
+		if (siteInfo[s].kind == PROFILE_SITE_COUNTER) {
+			fprintf(fp, "  %-24s count %llu total %lld\n", name, (unsigned long long)count, (long long)sum);
+			continue;
+		}
+
+		// the p50 and p99 are the upper bounds of the buckets they fall into, clamped to the max
+		uint64_t p[2] = {max, max};
+		double q[2] = {0.50, 0.99};
+		for (int k = 0; k < 2; k++) {
+			uint64_t target = (uint64_t)(q[k] * count + 0.5);
+			uint64_t seen = 0;
+			for (int i = 0; i < PROFILE_N_BUCKETS; i++) {
+				seen += buckets[i];
+				if (seen >= target && seen > 0) {
+					uint64_t bound = bucketUpperBound(i);
+					p[k] = bound < max ? bound : max;
+					break;
+				}
+			}
+		}
+		fprintf(fp, "  %-24s calls %llu mean %.2f us p50 %.2f us p99 %.2f us max %.2f us\n", name,
+				(unsigned long long)count, sum * nsPerTick / count / 1e3, p[0] * nsPerTick / 1e3,
+				p[1] * nsPerTick / 1e3, max * nsPerTick / 1e3);
+	}
+}
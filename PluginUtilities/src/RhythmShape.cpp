@@ -0,0 +1,42 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * RhythmShape.cpp
+ */
+
+#include "RhythmShape.h"
+
+RhythmShape::RhythmShape(Point centroid, int sideLength, int orientation) {
+	shapeType = SHAPE_RHYTHM;
+	updateShape(&centroid, &orientation);
+}
+
+RhythmShape::~RhythmShape() {
+}
+
+bool RhythmShape::isPointInsideShape(Point p) {
+	return false;
+}
+
+void RhythmShape::updateShape(Point* centroid, int* orientation) {
+	if (centroid) {
+		this->centroid = *centroid;
+	}
+	if (orientation) {
+		this->orientation = *orientation;
+	}
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Shape.cpp
+ *
+ *  Created on: Mar 6, 2017
+ *      Author: eski
+ */
+
+#include "Shape.h"
+#include <stddef.h>
+
+int Shape::sideLength = 0;
+
+Shape::Shape() {
+	orientation = 0;
+	vertices = NULL;
+	nVertices = 0;
+	area = 0;
+	shapeType = -1;
+}
+
+Shape::~Shape() {
+	if (vertices) {
+		delete [] vertices;
+		vertices = NULL;
+	}
+}
+
+const Point& Shape::getCentroid() const {
+	return centroid;
+}
+
+int Shape::getOrientation() const {
+	return orientation;
+}
@@ -0,0 +1,36 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * SoundUtils.cpp
+ *
+ *  Created on: Feb 23, 2017
+ *      Author: eski
+ */
+
+#include "SoundUtils.h"
+#include <stdio.h>
+
+void visualizeFft(uint8_t* fft, int nFftBins) {
+	printf("\033[1;1H\033[2J");
+	for (int i = 0; i < nFftBins; i++) {
+		printf("bin:%d:\t", i);
+		for (int j = 0; j < fft[i] / 10; j++) {
+			printf("*");
+		}
+		printf("\n");
+	}
+}
@@ -0,0 +1,55 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Square.cpp
+ */
+
+#include "Square.h"
+#include <math.h>
+
+Square::Square(Point centroid, int sideLength, int orientation) {
+	shapeType = SHAPE_SQUARE;
+	nVertices = 4;
+	vertices = new Point[nVertices];
+	updateShape(&centroid, &orientation);
+}
+
+Square::~Square() {
+}
+
+bool Square::isPointInsideShape(Point p) {
+	int half = sideLength / 2;
+	return fabs(p.x - centroid.x) < half && fabs(p.y - centroid.y) < half;
+}
+
+void Square::updateShape(Point* centroid, int* orientation) {
+	if (centroid) {
+		this->centroid = *centroid;
+	}
+	if (orientation) {
+		this->orientation = *orientation;
+	}
+
+	int half = sideLength / 2;
+	double cx = this->centroid.x;
+	double cy = this->centroid.y;
+	vertices[0] = Point(cx - half, cy - half);
+	vertices[1] = Point(cx + half, cy - half);
+	vertices[2] = Point(cx + half, cy + half);
+	vertices[3] = Point(cx - half, cy + half);
+	area = (double)sideLength * sideLength;
+}
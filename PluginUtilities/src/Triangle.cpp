@@ -0,0 +1,74 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Triangle.cpp
+ */
+
+#include "Triangle.h"
+#include <math.h>
+
+#define INSIDE_TOLERANCE 0.01	/*fraction of the area that the sub-triangle areas may differ by*/
+
+/**
+ * @description: area of the triangle with the given vertices
+ */
+static double getAreaOfTriangle(const Point& p1, const Point& p2, const Point& p3) {
+	return fabs(p1.x * (p2.y - p3.y) + p2.x * (p3.y - p1.y) + p3.x * (p1.y - p2.y)) / 2.0;
+}
+
+Triangle::Triangle(Point centroid, int sideLength, int orientation) {
+	shapeType = SHAPE_TRIANGLE;
+	nVertices = 3;
+	vertices = new Point[nVertices];
+	updateShape(&centroid, &orientation);
+}
+
+Triangle::~Triangle() {
+}
+
+bool Triangle::isPointInsideShape(Point p) {
+	double sum = getAreaOfTriangle(p, vertices[0], vertices[1]) +
+			getAreaOfTriangle(p, vertices[1], vertices[2]) +
+			getAreaOfTriangle(p, vertices[2], vertices[0]);
+	return fabs(area - sum) < area * INSIDE_TOLERANCE;
+}
+
+void Triangle::updateShape(Point* centroid, int* orientation) {
+	if (centroid) {
+		this->centroid = *centroid;
+	}
+	if (orientation) {
+		this->orientation = *orientation;
+	}
+
+	// distance from the centroid to a vertex
+	double h = sideLength / sqrt(3.0);
+	double cx = this->centroid.x;
+	double cy = this->centroid.y;
+
+	if (this->orientation % 120 == 0) {
+		vertices[0] = Point(cx, cy + (int)h);
+		vertices[1] = Point(cx + (int)(h * cos(7.0 * M_PI / 6.0)), cy + (int)(h * sin(7.0 * M_PI / 6.0)));
+		vertices[2] = Point(cx + (int)(h * cos(11.0 * M_PI / 6.0)), cy + (int)(h * sin(11.0 * M_PI / 6.0)));
+	}
+	else {
+		vertices[0] = Point(cx, cy - (int)h);
+		vertices[1] = Point(cx + (int)(h * cos(M_PI / 6.0)), cy + (int)(h * sin(M_PI / 6.0)));
+		vertices[2] = Point(cx + (int)(h * cos(5.0 * M_PI / 6.0)), cy + (int)(h * sin(5.0 * M_PI / 6.0)));
+	}
+	area = getAreaOfTriangle(vertices[0], vertices[1], vertices[2]);
+}
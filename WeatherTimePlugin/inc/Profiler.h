@@ -0,0 +1,158 @@
+/*
+    Copyright 2017 Nanoleaf Ltd.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Profiler.h
+ *
+ *  Scoped timers and counters for finding out where getPluginFrame spends its time.
+ *
+ *      void getPluginFrame(Frame_t* frames, int* nFrames, int* sleepTime) {
+ *          {
+ *              PROFILE_SCOPE("features");
+ *              ...
+ *          }
+ *          PROFILE_COUNT("sources added", nAdded);
+ *      }
+ *
+ *  Every PROFILE_SCOPE records its duration into a log-linear histogram, every PROFILE_COUNT adds
+ *  to a counter. Each thread writes only to its own histograms, so recording takes no lock and no
+ *  atomic read-modify-write. dumpProfile() sums the threads and prints calls, mean, p50, p99 and max
+ *  of every timer, and the total of every counter; the PluginHost calls it at the end of a run.
+ *
+ *  The macros only do something in files compiled with PROFILING_ENABLED defined, either
+ *  with -DPROFILING_ENABLED or with a #define before this header is included. Without it they
+ *  expand to nothing and cost nothing.
+ *
+ *  Durations are read from the time stamp counter on x86 and from CLOCK_MONOTONIC elsewhere.
+ */
+
+#ifndef INC_PROFILER_H_
+#define INC_PROFILER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_CLOCK_TSC
+#endif
+
+#define PROFILE_MAX_SITES 64				/*timers and counters together, further sites are ignored*/
+#define PROFILE_SUB_BUCKET_BITS 3
+#define PROFILE_SUB_BUCKETS (1 << PROFILE_SUB_BUCKET_BITS)
+#define PROFILE_N_BUCKETS (2 * PROFILE_SUB_BUCKETS + (64 - PROFILE_SUB_BUCKET_BITS - 1) * PROFILE_SUB_BUCKETS)
+#define PROFILE_SITE_TIMER 0
+#define PROFILE_SITE_COUNTER 1
+
+/**
+ * @description: read the profiling clock, in ticks of the time stamp counter or in ns
+ */
+static inline uint64_t profileTicks(void) {
+#ifdef PROFILE_CLOCK_TSC
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @description: register a timer or counter. Called once per call site by the macros
+ * @params name: label for the dump, must outlive the profiler, e.g. a string literal
+ * @params kind: PROFILE_SITE_TIMER or PROFILE_SITE_COUNTER
+ * @return: the id of the site, -1 if PROFILE_MAX_SITES are already taken
+ */
+int registerProfileSite(const char* name, int kind);
+
+/**
+ * @description: add one duration to the histogram of a timer, for the calling thread
+ */
+void recordProfileTicks(int site, uint64_t ticks);
+
+/**
+ * @description: add to a counter, for the calling thread
+ */
+void addProfileCount(int site, int64_t n);
+
+/**
+ * @description: totals of one site since the last reset, summed over the threads
+ * @params count: number of samples, or of PROFILE_COUNT calls
+ * @params sum: total ticks of a timer, or total of a counter
+ */
+void getProfileTotals(int site, uint64_t* count, uint64_t* sum);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @description: clear the histograms and counters of all threads. Samples recorded while it runs may be lost
+ */
+void resetProfile(void);
+
+/**
+ * @description: print every timer and counter that was hit since the last reset, summed over the threads
+ */
+void dumpProfile(FILE* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * A call site of PROFILE_SCOPE or PROFILE_COUNT, registered the first time it runs
+ */
+struct ProfileSite_t {
+	int id;
+	ProfileSite_t(const char* name, int kind) {
+		id = registerProfileSite(name, kind);
+	}
+};
+
+/**
+ * Times its own lifetime into a site
+ */
+class ProfileScope {
+	int site;
+	uint64_t start;
+public:
+	ProfileScope(const ProfileSite_t& s) {
+		site = s.id;
+		start = profileTicks();
+	}
+	~ProfileScope() {
+		recordProfileTicks(site, profileTicks() - start);
+	}
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PROFILING_ENABLED
+#define PROFILE_SCOPE(name) \
+	static ProfileSite_t PROFILE_CONCAT(profileSite, __LINE__)(name, PROFILE_SITE_TIMER); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileSite, __LINE__))
+#define PROFILE_COUNT(name, n) { \
+	static ProfileSite_t profileCounterSite(name, PROFILE_SITE_COUNTER); \
+	addProfileCount(profileCounterSite.id, n); \
+}
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n) {}
+#endif
+
+#endif /* INC_PROFILER_H_ */